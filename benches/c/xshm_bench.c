@@ -0,0 +1,277 @@
+/*
+ * C-драйвер бенчмарка xshm: тот же протокол, что и benches/ipc.rs, но через
+ * xshm.h — в замер входит FFI (handle-lookup, кэш приёма, копия в буфер C).
+ *
+ * Сборка (после `cargo build --release`):
+ *   MSVC:  cl /O2 /I include benches\c\xshm_bench.c target\release\xshm.lib ntdll.lib
+ *   MinGW: gcc -O2 -I include benches/c/xshm_bench.c -Ltarget/release -lxshm -lntdll
+ *          -lws2_32 -luserenv -lbcrypt -o xshm_bench.exe
+ *
+ * Запуск: xshm_bench.exe [iters] [messages]
+ * Родительский процесс — сервер, пир — тот же exe с аргументом `--peer <name>`.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <windows.h>
+
+#include "xshm.h"
+
+#define TAG_PING 1
+#define TAG_START 2
+#define TAG_DATA 3
+#define TAG_END 4
+#define TAG_ACK 5
+#define TAG_QUIT 6
+
+#define WARMUP_PINGS 1000
+#define RECV_TIMEOUT_MS 30000
+#define MAX_PAYLOAD MAX_MESSAGE_SIZE
+
+static const uint32_t SIZES[] = {9, 64, 512, 4096, 16384, 65535};
+
+static LARGE_INTEGER g_freq;
+
+static double elapsed_ns(LARGE_INTEGER start, LARGE_INTEGER end) {
+    return (double)(end.QuadPart - start.QuadPart) * 1e9 / (double)g_freq.QuadPart;
+}
+
+static int cmp_double(const void *a, const void *b) {
+    double x = *(const double *)a, y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+static double percentile(const double *sorted, size_t n, double p) {
+    size_t index = (size_t)((double)n * p);
+    return sorted[index < n ? index : n - 1] / 1000.0;
+}
+
+/* ─── общий транспорт: сервер и клиент отличаются только функциями ──────── */
+
+typedef struct endpoint_t {
+    void *handle;
+    enum shm_error_t (*send)(void *handle, const void *data, uint32_t size);
+    enum shm_error_t (*receive)(void *handle, void *buffer, uint32_t *size);
+    enum shm_error_t (*poll)(void *handle, uint32_t timeout_ms);
+} endpoint_t;
+
+static enum shm_error_t server_send(void *h, const void *d, uint32_t s) {
+    return shm_server_send((ServerHandle *)h, d, s);
+}
+static enum shm_error_t server_receive(void *h, void *b, uint32_t *s) {
+    return shm_server_receive((ServerHandle *)h, b, s);
+}
+static enum shm_error_t server_poll(void *h, uint32_t t) {
+    return shm_server_poll((ServerHandle *)h, t);
+}
+static enum shm_error_t client_send(void *h, const void *d, uint32_t s) {
+    return shm_client_send((ClientHandle *)h, d, s);
+}
+static enum shm_error_t client_receive(void *h, void *b, uint32_t *s) {
+    return shm_client_receive((ClientHandle *)h, b, s);
+}
+static enum shm_error_t client_poll(void *h, uint32_t t) {
+    return shm_client_poll((ClientHandle *)h, t);
+}
+
+/* Следующее сообщение пира; длина — в *size, 0 при таймауте/ошибке. */
+static int recv_message(const endpoint_t *ep, uint8_t *buffer, uint32_t *size) {
+    for (;;) {
+        uint32_t len = MAX_PAYLOAD;
+        enum shm_error_t err = ep->receive(ep->handle, buffer, &len);
+        if (err == SHM_SUCCESS) {
+            *size = len;
+            return 1;
+        }
+        if (err != SHM_ERROR_EMPTY) {
+            return 0;
+        }
+        err = ep->poll(ep->handle, RECV_TIMEOUT_MS);
+        if (err != SHM_SUCCESS) {
+            return 0;
+        }
+    }
+}
+
+static void send_ack(const endpoint_t *ep, uint64_t received) {
+    uint8_t ack[9];
+    ack[0] = TAG_ACK;
+    memcpy(ack + 1, &received, sizeof received);
+    ep->send(ep->handle, ack, sizeof ack);
+}
+
+/* ─── пир ─────────────────────────────────────────────────────────────────── */
+
+static int run_peer(const char *name) {
+    shm_endpoint_config_t cfg = {name};
+    ClientHandle *client = shm_client_connect(&cfg, NULL, 10000);
+    if (!client) {
+        fprintf(stderr, "peer: connect failed\n");
+        return 1;
+    }
+    endpoint_t ep = {client, client_send, client_receive, client_poll};
+    static uint8_t buffer[MAX_PAYLOAD];
+    uint64_t received = 0, ack_every = 1;
+    uint32_t len;
+    while (recv_message(&ep, buffer, &len)) {
+        switch (buffer[0]) {
+        case TAG_PING:
+            ep.send(ep.handle, buffer, len);
+            break;
+        case TAG_START:
+            memcpy(&ack_every, buffer + 1, sizeof ack_every);
+            received = 0;
+            break;
+        case TAG_DATA:
+            if (++received % ack_every == 0) {
+                send_ack(&ep, received);
+            }
+            break;
+        case TAG_END:
+            send_ack(&ep, received);
+            break;
+        case TAG_QUIT:
+            shm_client_disconnect(client);
+            return 0;
+        }
+    }
+    shm_client_disconnect(client);
+    return 1;
+}
+
+/* ─── сервер ──────────────────────────────────────────────────────────────── */
+
+static int spawn_peer(const char *name, PROCESS_INFORMATION *pi) {
+    char exe[MAX_PATH];
+    char cmdline[MAX_PATH * 2];
+    STARTUPINFOA si;
+    GetModuleFileNameA(NULL, exe, sizeof exe);
+    snprintf(cmdline, sizeof cmdline, "\"%s\" --peer %s", exe, name);
+    ZeroMemory(&si, sizeof si);
+    si.cb = sizeof si;
+    return CreateProcessA(exe, cmdline, NULL, NULL, FALSE, 0, NULL, NULL, &si, pi) != 0;
+}
+
+static int ping_pong(const endpoint_t *ep, uint8_t *buffer, uint32_t size, size_t iters,
+                     double *samples) {
+    static uint8_t ping[MAX_PAYLOAD];
+    memset(ping, 0, size);
+    ping[0] = TAG_PING;
+    for (uint64_t seq = 0; seq < WARMUP_PINGS + iters; ++seq) {
+        LARGE_INTEGER start, end;
+        uint32_t len;
+        memcpy(ping + 1, &seq, sizeof seq);
+        QueryPerformanceCounter(&start);
+        if (ep->send(ep->handle, ping, size) != SHM_SUCCESS) {
+            return 0;
+        }
+        do {
+            if (!recv_message(ep, buffer, &len)) {
+                return 0;
+            }
+        } while (len != size || buffer[0] != TAG_PING || memcmp(buffer + 1, &seq, sizeof seq));
+        QueryPerformanceCounter(&end);
+        if (seq >= WARMUP_PINGS) {
+            samples[seq - WARMUP_PINGS] = elapsed_ns(start, end);
+        }
+    }
+    return 1;
+}
+
+/* Поток с кредитным окном; секунды до подтверждения последнего сообщения. */
+static double stream(const endpoint_t *ep, uint8_t *buffer, uint32_t size, uint64_t total) {
+    static uint8_t data[MAX_PAYLOAD];
+    uint64_t window = (uint64_t)RING_CAPACITY / 2 / (size + 8);
+    window = window < 1 ? 1 : (window > 128 ? 128 : window);
+    uint64_t ack_every = window / 4 ? window / 4 : 1;
+    uint8_t start_msg[9] = {TAG_START};
+    uint8_t end_msg[2] = {TAG_END, 0};
+    memcpy(start_msg + 1, &ack_every, sizeof ack_every);
+    ep->send(ep->handle, start_msg, sizeof start_msg);
+
+    memset(data, 0xA5, size);
+    data[0] = TAG_DATA;
+    uint64_t sent = 0, acked = 0;
+    LARGE_INTEGER start, end;
+    QueryPerformanceCounter(&start);
+    while (acked < total) {
+        uint32_t len;
+        while (sent < total && sent - acked < window) {
+            ep->send(ep->handle, data, size);
+            ++sent;
+        }
+        if (sent == total) {
+            ep->send(ep->handle, end_msg, sizeof end_msg);
+            ++sent;
+        }
+        if (!recv_message(ep, buffer, &len)) {
+            return -1.0;
+        }
+        if (len == 9 && buffer[0] == TAG_ACK) {
+            memcpy(&acked, buffer + 1, sizeof acked);
+        }
+    }
+    QueryPerformanceCounter(&end);
+    return elapsed_ns(start, end) / 1e9;
+}
+
+int main(int argc, char **argv) {
+    QueryPerformanceFrequency(&g_freq);
+    if (argc >= 3 && strcmp(argv[1], "--peer") == 0) {
+        return run_peer(argv[2]);
+    }
+    size_t iters = argc >= 2 ? (size_t)strtoul(argv[1], NULL, 10) : 20000;
+    uint64_t messages = argc >= 3 ? strtoull(argv[2], NULL, 10) : 200000;
+
+    char name[64];
+    snprintf(name, sizeof name, "XSHM_BENCH_C_%lu", GetCurrentProcessId());
+    shm_endpoint_config_t cfg = {name};
+    ServerHandle *server = shm_server_start(&cfg, NULL);
+    if (!server) {
+        fprintf(stderr, "server start failed\n");
+        return 1;
+    }
+    PROCESS_INFORMATION pi;
+    if (!spawn_peer(name, &pi) || shm_server_wait_for_client(server, 10000) != SHM_SUCCESS) {
+        fprintf(stderr, "peer did not connect\n");
+        shm_server_stop(server);
+        return 1;
+    }
+    endpoint_t ep = {server, server_send, server_receive, server_poll};
+
+    static uint8_t buffer[MAX_PAYLOAD];
+    double *samples = (double *)malloc(iters * sizeof *samples);
+    printf("%-9s%7s %9s %9s %10s %9s %12s %8s\n", "mode", "size", "p50 us", "p99 us",
+           "p99.9 us", "max us", "msg/s", "GB/s");
+    for (size_t i = 0; i < sizeof SIZES / sizeof SIZES[0]; ++i) {
+        uint32_t size = SIZES[i];
+        uint64_t total = messages;
+        if (total * size > 512ull * 1024 * 1024) {
+            total = 512ull * 1024 * 1024 / size;
+        }
+        if (!ping_pong(&ep, buffer, size, iters, samples)) {
+            fprintf(stderr, "ping-pong failed at %u B\n", size);
+            break;
+        }
+        double secs = stream(&ep, buffer, size, total);
+        if (secs < 0) {
+            fprintf(stderr, "stream failed at %u B\n", size);
+            break;
+        }
+        qsort(samples, iters, sizeof *samples, cmp_double);
+        printf("%-9s%7u %9.2f %9.2f %10.2f %9.2f %12.0f %8.3f\n", "c-ffi", size,
+               percentile(samples, iters, 0.50), percentile(samples, iters, 0.99),
+               percentile(samples, iters, 0.999), percentile(samples, iters, 1.0),
+               (double)total / secs, (double)total * size / secs / 1e9);
+    }
+
+    uint8_t quit[2] = {TAG_QUIT, 0};
+    shm_server_send(server, quit, sizeof quit);
+    WaitForSingleObject(pi.hProcess, 5000);
+    CloseHandle(pi.hProcess);
+    CloseHandle(pi.hThread);
+    free(samples);
+    shm_server_stop(server);
+    return 0;
+}
@@ -0,0 +1,585 @@
+//! Кросс-процессный бенчмарк xshm: гистограммы RTT и пропускная способность.
+//!
+//! ```text
+//! cargo bench --bench ipc -- [raw|auto|multi|dispatch|all]...
+//!     [--sizes 8,64,512,4096,16384,65535] [--iters 20000]
+//!     [--messages 200000] [--spin-us 0] [--stream-threshold <bytes>|off]
+//! ```
+//!
+//! Родительский процесс — сервер, пир — этот же бинарник, перезапущенный с
+//! `--peer <mode> <name>`: сообщения идут между РАЗНЫМИ процессами, как в
+//! проде. Для каждого размера:
+//! - RTT: ping → эхо пира, p50/p99/p99.9/max по `iters` замерам;
+//! - пропускная способность: поток сообщений с кредитным окном (пир
+//!   подтверждает каждые `window / 4`), чтобы overwrite не вытеснял данные —
+//!   в зачёт идут только доставленные сообщения.
+//!
+//! В callback-режимах (auto/multi/dispatch) сообщение из `on_message`
+//! перекладывается в `mpsc` и забирается основным потоком — этот переход
+//! входит в замер, так чаще всего и устроено приложение. `--spin-us` задаёт
+//! `WaitStrategy` обеим сторонам (в raw — через `spin_wait_*`).
+//! `--stream-threshold` — порог non-temporal записи (`set_stream_threshold`)
+//! обеих сторон: прогон с `0` и с `off` на одних размерах показывает, с
+//! какого payload-а streaming выгоден на этом железе (особенно с пиром на
+//! другом NUMA-узле, `start /node 1`).
+
+use std::process::{Child, Command};
+use std::sync::mpsc::{self, Receiver, RecvTimeoutError, Sender};
+use std::sync::{Arc, Mutex};
+use std::time::{Duration, Instant};
+
+use xshm::{
+    AutoClient, AutoHandler, AutoOptions, AutoServer, ChannelGeometry, ChannelKind,
+    ClientRegistration, DispatchClient, DispatchClientHandler, DispatchClientOptions,
+    DispatchHandler, DispatchOptions, DispatchServer, MultiClient, MultiClientHandler,
+    MultiClientOptions, MultiHandler, MultiOptions, MultiServer, Result, SharedClient,
+    SharedServer, ShmError, WaitStrategy, DEFAULT_STREAM_THRESHOLD,
+};
+
+const TAG_PING: u8 = 1;
+const TAG_START: u8 = 2;
+const TAG_DATA: u8 = 3;
+const TAG_END: u8 = 4;
+const TAG_ACK: u8 = 5;
+const TAG_QUIT: u8 = 6;
+
+const MODES: [&str; 4] = ["raw", "auto", "multi", "dispatch"];
+const CONNECT_TIMEOUT: Duration = Duration::from_secs(10);
+const RECV_TIMEOUT: Duration = Duration::from_secs(30);
+const WARMUP_PINGS: usize = 1000;
+/// Верхняя граница объёма потока на один размер — 64 КБ кадры не гоняем
+/// по 200 000 штук.
+const STREAM_BYTES_LIMIT: usize = 512 * 1024 * 1024;
+
+#[derive(Clone)]
+struct Config {
+    sizes: Vec<usize>,
+    iters: usize,
+    messages: usize,
+    spin_us: u64,
+    stream_threshold: usize,
+}
+
+impl Config {
+    fn wait(&self) -> WaitStrategy {
+        WaitStrategy::spin_then_block(Duration::from_micros(self.spin_us), Duration::ZERO)
+    }
+}
+
+fn main() {
+    let args: Vec<String> = std::env::args().skip(1).collect();
+    // `cargo bench` добавляет `--bench` к аргументам harness = false бинарника
+    let args: Vec<String> = args.into_iter().filter(|a| a != "--bench").collect();
+
+    let mut config = Config {
+        sizes: vec![8, 64, 512, 4096, 16384, 65535],
+        iters: 20_000,
+        messages: 200_000,
+        spin_us: 0,
+        stream_threshold: DEFAULT_STREAM_THRESHOLD,
+    };
+    let mut modes = Vec::new();
+    let mut peer: Option<(String, String)> = None;
+    let mut i = 0;
+    while i < args.len() {
+        let value = || args.get(i + 1).expect("missing option value");
+        match args[i].as_str() {
+            "--peer" => {
+                peer = Some((value().clone(), args.get(i + 2).expect("peer name").clone()));
+                i += 1;
+            }
+            "--sizes" => {
+                config.sizes = value()
+                    .split(',')
+                    .map(|s| s.parse().expect("bad size"))
+                    .collect();
+            }
+            "--iters" => config.iters = value().parse().expect("bad --iters"),
+            "--messages" => config.messages = value().parse().expect("bad --messages"),
+            "--spin-us" => config.spin_us = value().parse().expect("bad --spin-us"),
+            "--stream-threshold" => {
+                config.stream_threshold = match value().as_str() {
+                    "off" => usize::MAX,
+                    bytes => bytes.parse().expect("bad --stream-threshold"),
+                }
+            }
+            "all" => modes.extend(MODES.iter().map(|m| m.to_string())),
+            mode if MODES.contains(&mode) => modes.push(mode.to_string()),
+            other => panic!("unknown argument {other:?}"),
+        }
+        i += if args[i].starts_with("--") { 2 } else { 1 };
+    }
+
+    xshm::set_stream_threshold(config.stream_threshold);
+
+    if let Some((mode, name)) = peer {
+        if let Err(err) = run_peer(&mode, &name, &config) {
+            eprintln!("peer {mode}: {err}");
+            std::process::exit(1);
+        }
+        return;
+    }
+
+    if modes.is_empty() {
+        modes.extend(MODES.iter().map(|m| m.to_string()));
+    }
+    println!(
+        "{:<9}{:>7} {:>9} {:>9} {:>10} {:>9} {:>12} {:>8}",
+        "mode", "size", "p50 us", "p99 us", "p99.9 us", "max us", "msg/s", "GB/s"
+    );
+    for mode in &modes {
+        if let Err(err) = run_mode(mode, &config) {
+            eprintln!("{mode}: {err}");
+        }
+    }
+}
+
+// ─── Транспорт ───────────────────────────────────────────────────────────────
+
+/// Одна сторона канала в любом из режимов.
+trait Endpoint {
+    fn send(&self, data: &[u8]) -> Result<()>;
+    /// Следующее сообщение пира в `buf`; `None` — таймаут.
+    fn recv(&mut self, buf: &mut Vec<u8>, timeout: Duration) -> Result<Option<usize>>;
+}
+
+struct RawServer {
+    server: SharedServer,
+    wait: WaitStrategy,
+}
+
+impl Endpoint for RawServer {
+    fn send(&self, data: &[u8]) -> Result<()> {
+        self.server.send_to_client(data).map(|_| ())
+    }
+
+    fn recv(&mut self, buf: &mut Vec<u8>, timeout: Duration) -> Result<Option<usize>> {
+        let deadline = Instant::now() + timeout;
+        loop {
+            match self.server.receive_from_client(buf) {
+                Ok(len) => return Ok(Some(len)),
+                Err(ShmError::QueueEmpty) => {}
+                Err(err) => return Err(err),
+            }
+            if self.server.spin_wait_client(&self.wait) {
+                continue;
+            }
+            let now = Instant::now();
+            if now >= deadline {
+                return Ok(None);
+            }
+            self.server.poll_client(Some(deadline - now))?;
+        }
+    }
+}
+
+struct RawClient {
+    client: SharedClient,
+    wait: WaitStrategy,
+}
+
+impl Endpoint for RawClient {
+    fn send(&self, data: &[u8]) -> Result<()> {
+        self.client.send_to_server(data).map(|_| ())
+    }
+
+    fn recv(&mut self, buf: &mut Vec<u8>, timeout: Duration) -> Result<Option<usize>> {
+        let deadline = Instant::now() + timeout;
+        loop {
+            match self.client.receive_from_server(buf) {
+                Ok(len) => return Ok(Some(len)),
+                Err(ShmError::QueueEmpty) => {}
+                Err(err) => return Err(err),
+            }
+            if self.client.spin_wait_server(&self.wait) {
+                continue;
+            }
+            let now = Instant::now();
+            if now >= deadline {
+                return Ok(None);
+            }
+            self.client.poll_server(Some(deadline - now))?;
+        }
+    }
+}
+
+type SendFn = Box<dyn Fn(&[u8]) -> Result<()>>;
+
+/// Callback-режимы: отправка через объект режима, приём — из `on_message`
+/// через `mpsc`.
+struct Callback {
+    send: SendFn,
+    inbox: Receiver<Vec<u8>>,
+}
+
+impl Endpoint for Callback {
+    fn send(&self, data: &[u8]) -> Result<()> {
+        (self.send)(data)
+    }
+
+    fn recv(&mut self, buf: &mut Vec<u8>, timeout: Duration) -> Result<Option<usize>> {
+        match self.inbox.recv_timeout(timeout) {
+            Ok(message) => {
+                buf.clear();
+                buf.extend_from_slice(&message);
+                Ok(Some(message.len()))
+            }
+            Err(RecvTimeoutError::Timeout) => Ok(None),
+            Err(RecvTimeoutError::Disconnected) => Err(ShmError::NotConnected),
+        }
+    }
+}
+
+/// Handler для всех callback-режимов: сообщения — в `inbox`, id
+/// подключившегося пира — в `connected`.
+struct Forward {
+    inbox: Mutex<Sender<Vec<u8>>>,
+    connected: Mutex<Sender<u32>>,
+}
+
+impl Forward {
+    fn new() -> (Arc<Self>, Receiver<Vec<u8>>, Receiver<u32>) {
+        let (inbox_tx, inbox_rx) = mpsc::channel();
+        let (connected_tx, connected_rx) = mpsc::channel();
+        let handler = Arc::new(Self {
+            inbox: Mutex::new(inbox_tx),
+            connected: Mutex::new(connected_tx),
+        });
+        (handler, inbox_rx, connected_rx)
+    }
+
+    fn message(&self, data: &[u8]) {
+        let _ = self.inbox.lock().unwrap().send(data.to_vec());
+    }
+
+    fn connect(&self, id: u32) {
+        let _ = self.connected.lock().unwrap().send(id);
+    }
+}
+
+impl AutoHandler for Forward {
+    fn on_connect(&self) {
+        self.connect(0);
+    }
+
+    fn on_message(&self, _direction: ChannelKind, payload: &[u8]) {
+        self.message(payload);
+    }
+}
+
+impl MultiHandler for Forward {
+    fn on_client_connect(&self, client_id: u32) {
+        self.connect(client_id);
+    }
+
+    fn on_client_disconnect(&self, _client_id: u32) {}
+
+    fn on_message(&self, _client_id: u32, data: &[u8]) {
+        self.message(data);
+    }
+}
+
+impl MultiClientHandler for Forward {
+    fn on_connect(&self, slot_id: u32) {
+        self.connect(slot_id);
+    }
+
+    fn on_disconnect(&self) {}
+
+    fn on_message(&self, data: &[u8]) {
+        self.message(data);
+    }
+}
+
+impl DispatchHandler for Forward {
+    fn on_client_connect(&self, client_id: u32, _info: &ClientRegistration) {
+        self.connect(client_id);
+    }
+
+    fn on_client_disconnect(&self, _client_id: u32) {}
+
+    fn on_message(&self, _client_id: u32, data: &[u8]) {
+        self.message(data);
+    }
+}
+
+impl DispatchClientHandler for Forward {
+    fn on_connect(&self, client_id: u32, _channel_name: &str) {
+        self.connect(client_id);
+    }
+
+    fn on_disconnect(&self) {}
+
+    fn on_message(&self, data: &[u8]) {
+        self.message(data);
+    }
+}
+
+fn wait_connected(connected: &Receiver<u32>) -> Result<u32> {
+    connected
+        .recv_timeout(CONNECT_TIMEOUT)
+        .map_err(|_| ShmError::Timeout)
+}
+
+fn auto_options(config: &Config) -> AutoOptions {
+    AutoOptions {
+        wait: config.wait(),
+        ..AutoOptions::default()
+    }
+}
+
+// ─── Сервер (родительский процесс) ───────────────────────────────────────────
+
+fn spawn_peer(mode: &str, name: &str, config: &Config) -> Result<Child> {
+    Command::new(std::env::current_exe().expect("current_exe"))
+        .args([
+            "--peer",
+            mode,
+            name,
+            "--spin-us",
+            &config.spin_us.to_string(),
+            "--stream-threshold",
+            &config.stream_threshold.to_string(),
+        ])
+        .spawn()
+        .map_err(|err| ShmError::WindowsError {
+            code: err.raw_os_error().unwrap_or(-1) as u32,
+            context: "spawn bench peer",
+        })
+}
+
+/// Поднимает серверную сторону режима и пира; возвращает готовый канал.
+fn start_server(mode: &str, name: &str, config: &Config) -> Result<(Box<dyn Endpoint>, Child)> {
+    match mode {
+        "raw" => {
+            let server = SharedServer::start_with(name, &ChannelGeometry::default())?;
+            let child = spawn_peer(mode, name, config)?;
+            server.wait_for_client(Some(CONNECT_TIMEOUT))?;
+            let endpoint = RawServer {
+                server,
+                wait: config.wait(),
+            };
+            Ok((Box::new(endpoint), child))
+        }
+        "auto" => {
+            let (handler, inbox, connected) = Forward::new();
+            let server = AutoServer::start(name, handler, auto_options(config))?;
+            let child = spawn_peer(mode, name, config)?;
+            wait_connected(&connected)?;
+            let send: SendFn = Box::new(move |data| server.send(data));
+            Ok((Box::new(Callback { send, inbox }), child))
+        }
+        "multi" => {
+            let (handler, inbox, connected) = Forward::new();
+            let options = MultiOptions {
+                max_clients: 1,
+                wait: config.wait(),
+                ..MultiOptions::default()
+            };
+            let server = MultiServer::start(name, handler, options)?;
+            let child = spawn_peer(mode, name, config)?;
+            let client_id = wait_connected(&connected)?;
+            let send: SendFn = Box::new(move |data| server.send_to(client_id, data));
+            Ok((Box::new(Callback { send, inbox }), child))
+        }
+        "dispatch" => {
+            let (handler, inbox, connected) = Forward::new();
+            let server = DispatchServer::start(name, handler, DispatchOptions::default())?;
+            let child = spawn_peer(mode, name, config)?;
+            let client_id = wait_connected(&connected)?;
+            let send: SendFn = Box::new(move |data| server.send_to(client_id, data));
+            Ok((Box::new(Callback { send, inbox }), child))
+        }
+        _ => Err(ShmError::InvalidConfig("unknown bench mode")),
+    }
+}
+
+fn run_mode(mode: &str, config: &Config) -> Result<()> {
+    let name = format!("XSHM_BENCH_{}_{}", mode.to_uppercase(), std::process::id());
+    let (mut endpoint, mut child) = start_server(mode, &name, config)?;
+    let mut buf = Vec::new();
+    let capacity = ChannelGeometry::default().s2c_capacity;
+
+    let result = (|| -> Result<()> {
+        for &size in &config.sizes {
+            let size = size.max(MIN_PAYLOAD);
+            let mut rtt = ping_pong(endpoint.as_mut(), &mut buf, size, config.iters)?;
+            let messages = config.messages.min(STREAM_BYTES_LIMIT / size).max(1000);
+            let elapsed = stream(endpoint.as_mut(), &mut buf, size, messages, capacity)?;
+            report(mode, size, &mut rtt, messages, elapsed);
+        }
+        Ok(())
+    })();
+
+    let _ = endpoint.send(&[TAG_QUIT, 0]);
+    let _ = child.wait();
+    result
+}
+
+/// Ping несёт номер (u64), поэтому меньше 9 байт не бывает.
+const MIN_PAYLOAD: usize = 9;
+
+fn ping_pong(
+    endpoint: &mut dyn Endpoint,
+    buf: &mut Vec<u8>,
+    size: usize,
+    iters: usize,
+) -> Result<Vec<u64>> {
+    let mut ping = vec![0u8; size];
+    ping[0] = TAG_PING;
+    let mut samples = Vec::with_capacity(iters);
+    for seq in 0..(WARMUP_PINGS + iters) as u64 {
+        ping[1..9].copy_from_slice(&seq.to_le_bytes());
+        let start = Instant::now();
+        endpoint.send(&ping)?;
+        loop {
+            let len = endpoint.recv(buf, RECV_TIMEOUT)?.ok_or(ShmError::Timeout)?;
+            if len == size && buf[0] == TAG_PING && buf[1..9] == seq.to_le_bytes() {
+                break;
+            }
+        }
+        if seq >= WARMUP_PINGS as u64 {
+            samples.push(start.elapsed().as_nanos() as u64);
+        }
+    }
+    Ok(samples)
+}
+
+/// Поток из `messages` сообщений с кредитным окном; время до подтверждения
+/// последнего.
+fn stream(
+    endpoint: &mut dyn Endpoint,
+    buf: &mut Vec<u8>,
+    size: usize,
+    messages: usize,
+    capacity: usize,
+) -> Result<Duration> {
+    // в полёте не больше половины кольца и не больше очереди отправки auto
+    let window = (capacity / 2 / (size + 8)).clamp(1, 128) as u64;
+    let ack_every = (window / 4).max(1);
+    let mut start_msg = [TAG_START, 0, 0, 0, 0, 0, 0, 0, 0];
+    start_msg[1..9].copy_from_slice(&ack_every.to_le_bytes());
+    endpoint.send(&start_msg)?;
+
+    let mut data = vec![0xA5u8; size];
+    data[0] = TAG_DATA;
+    let total = messages as u64;
+    let (mut sent, mut acked) = (0u64, 0u64);
+    let start = Instant::now();
+    while acked < total {
+        while sent < total && sent - acked < window {
+            endpoint.send(&data)?;
+            sent += 1;
+        }
+        if sent == total {
+            endpoint.send(&[TAG_END, 0])?;
+            sent += 1; // TAG_END отправляется один раз
+        }
+        let len = endpoint.recv(buf, RECV_TIMEOUT)?.ok_or(ShmError::Timeout)?;
+        if len == 9 && buf[0] == TAG_ACK {
+            acked = u64::from_le_bytes(buf[1..9].try_into().unwrap());
+        }
+    }
+    Ok(start.elapsed())
+}
+
+fn percentile(sorted: &[u64], p: f64) -> f64 {
+    let index = ((sorted.len() as f64 * p) as usize).min(sorted.len() - 1);
+    sorted[index] as f64 / 1000.0
+}
+
+fn report(mode: &str, size: usize, rtt: &mut [u64], messages: usize, elapsed: Duration) {
+    rtt.sort_unstable();
+    let secs = elapsed.as_secs_f64();
+    println!(
+        "{:<9}{:>7} {:>9.2} {:>9.2} {:>10.2} {:>9.2} {:>12.0} {:>8.3}",
+        mode,
+        size,
+        percentile(rtt, 0.50),
+        percentile(rtt, 0.99),
+        percentile(rtt, 0.999),
+        percentile(rtt, 1.0),
+        messages as f64 / secs,
+        (messages * size) as f64 / secs / 1e9
+    );
+}
+
+// ─── Пир (дочерний процесс) ──────────────────────────────────────────────────
+
+fn connect_peer(mode: &str, name: &str, config: &Config) -> Result<Box<dyn Endpoint>> {
+    match mode {
+        "raw" => {
+            let client = SharedClient::connect(name, CONNECT_TIMEOUT)?;
+            Ok(Box::new(RawClient {
+                client,
+                wait: config.wait(),
+            }))
+        }
+        "auto" => {
+            let (handler, inbox, connected) = Forward::new();
+            let client = AutoClient::connect(name, handler, auto_options(config))?;
+            wait_connected(&connected)?;
+            let send: SendFn = Box::new(move |data| client.send(data));
+            Ok(Box::new(Callback { send, inbox }))
+        }
+        "multi" => {
+            let (handler, inbox, connected) = Forward::new();
+            let client = MultiClient::connect(name, handler, MultiClientOptions::default())?;
+            wait_connected(&connected)?;
+            let send: SendFn = Box::new(move |data| client.send(data));
+            Ok(Box::new(Callback { send, inbox }))
+        }
+        "dispatch" => {
+            let (handler, inbox, _connected) = Forward::new();
+            let registration = ClientRegistration {
+                pid: std::process::id(),
+                revision: 1,
+                name: "xshm-bench".to_owned(),
+                topics: Vec::new(),
+            };
+            let client = DispatchClient::connect(
+                name,
+                registration,
+                handler,
+                DispatchClientOptions::default(),
+            )?;
+            let send: SendFn = Box::new(move |data| client.send(data));
+            Ok(Box::new(Callback { send, inbox }))
+        }
+        _ => Err(ShmError::InvalidConfig("unknown bench mode")),
+    }
+}
+
+/// Эхо для ping, подсчёт и подтверждения для потока.
+fn run_peer(mode: &str, name: &str, config: &Config) -> Result<()> {
+    let mut endpoint = connect_peer(mode, name, config)?;
+    let mut buf = Vec::new();
+    let (mut received, mut ack_every) = (0u64, 1u64);
+    loop {
+        let len = endpoint
+            .recv(&mut buf, RECV_TIMEOUT)?
+            .ok_or(ShmError::Timeout)?;
+        match buf[0] {
+            TAG_PING => endpoint.send(&buf[..len])?,
+            TAG_START => {
+                ack_every = u64::from_le_bytes(buf[1..9].try_into().unwrap());
+                received = 0;
+            }
+            TAG_DATA => {
+                received += 1;
+                if received % ack_every == 0 {
+                    send_ack(endpoint.as_ref(), received)?;
+                }
+            }
+            TAG_END => send_ack(endpoint.as_ref(), received)?,
+            TAG_QUIT => return Ok(()),
+            _ => return Err(ShmError::Corrupted),
+        }
+    }
+}
+
+fn send_ack(endpoint: &dyn Endpoint, received: u64) -> Result<()> {
+    let mut ack = [TAG_ACK, 0, 0, 0, 0, 0, 0, 0, 0];
+    ack[1..9].copy_from_slice(&received.to_le_bytes());
+    endpoint.send(&ack)
+}
@@ -18,26 +18,42 @@
 
 /**
  * Текущая версия протокола.
+ * 0x0002_0000: геометрия колец записывается в `ControlBlock`.
+ * 0x0003_0000: индексы producer/consumer в `RingHeader` на разных кэш-линиях.
  */
-#define SHARED_VERSION 65536
+#define SHARED_VERSION 196608
 
 /**
- * Размер каждого кольцевого буфера (байты).
+ * Размер каждого кольцевого буфера по умолчанию (байты).
  */
 #define RING_CAPACITY ((2 * 1024) * 1024)
 
 /**
  * Маска размера (так как это степень двойки).
+ * Сам ring берёт маску из геометрии канала; константа остаётся для C API.
  */
 #define RING_MASK ((uint32_t)RING_CAPACITY - 1)
 
 /**
- * Максимальное количество сообщений в очереди.
+ * Минимальная ёмкость кольца при выборе геометрии канала (байты).
+ */
+#define MIN_RING_CAPACITY (4 * 1024)
+
+/**
+ * Максимальная ёмкость кольца. Позиции — u32 с wrapping-арифметикой:
+ * `write - read` однозначен, пока ёмкость не превышает 2^31; берём 1 ГБ.
+ */
+#define MAX_RING_CAPACITY ((1024 * 1024) * 1024)
+
+/**
+ * Максимальное количество сообщений в очереди по умолчанию.
  */
 #define MAX_MESSAGES 500
 
 /**
- * Максимальный размер одного сообщения.
+ * Максимальный размер одного сообщения по умолчанию — предел u16-поля длины
+ * в коротком заголовке. Геометрия канала может поднять предел: сообщения
+ * длиннее пишутся длинным кадром (`MESSAGE_FLAG_LONG`).
  */
 #define MAX_MESSAGE_SIZE 65535
 
@@ -51,6 +67,16 @@
  */
 #define MESSAGE_HEADER_SIZE 4
 
+/**
+ * Размер заголовка длинного кадра: u16 length (0) + u16 flags + u32 length.
+ */
+#define LONG_MESSAGE_HEADER_SIZE 8
+
+/**
+ * Флаг заголовка: длина payload лежит в следующем u32, а не в u16-поле.
+ */
+#define MESSAGE_FLAG_LONG 1
+
 /**
  * Состояния handshake.
  */
@@ -103,11 +129,50 @@
 #define DEFAULT_MAX_CLIENTS 20
 
 /**
- * Жёсткий предел: NtWaitForMultipleObjects поддерживает максимум 64 хендла.
- * worker ждёт до 2 хендлов на подключённый слот => 2*N <= 64 => N <= 32;
- * берём 31 с запасом.
+ * Слотов на один поток-waiter: NtWaitForMultipleObjects поддерживает
+ * максимум 64 хендла, worker ждёт до 3 хендлов на подключённый слот
+ * (данные, disconnect, процесс-владелец) => 3*N <= 64 => N <= 21.
  */
-#define MAX_MULTI_CLIENTS 31
+#define SLOTS_PER_WAITER 21
+
+/**
+ * Жёсткий предел слотов одного `MultiServer` (`ceil(N / SLOTS_PER_WAITER)`
+ * потоков-waiter-ов). Клиент при захвате перебирает слоты по порядку, так
+ * что предел защищает и от бесконечного перебора.
+ */
+#define MAX_MULTI_CLIENTS 1024
+
+/**
+ * `shm_overflow_policy_t::mode`: вытеснять самые старые сообщения.
+ */
+#define SHM_OVERFLOW_OVERWRITE 0
+
+/**
+ * `shm_overflow_policy_t::mode`: вернуть `SHM_ERROR_FULL`.
+ */
+#define SHM_OVERFLOW_FAIL 1
+
+/**
+ * `shm_overflow_policy_t::mode`: ждать места до `timeout_ms`.
+ */
+#define SHM_OVERFLOW_BLOCK 2
+
+/**
+ * Число корзин `shm_histogram_t::buckets`.
+ */
+#define SHM_HISTOGRAM_BUCKETS 32
+
+/**
+ * Размер конверта кадра: correlation id и вид кадра.
+ */
+#define RPC_ENVELOPE_SIZE 8
+
+/**
+ * Код отказа, который клиент получает (`ShmError::RemoteFailed`), если
+ * ответ handler-а не влез в кольцо ответов (`max_message_size` сервера
+ * минус конверт). Прикладным кодам его не брать.
+ */
+#define RPC_FAULT_REPLY_TOO_LARGE UINT32_MAX
 
 typedef enum shm_error_t {
   SHM_SUCCESS = 0,
@@ -122,6 +187,8 @@ typedef enum shm_error_t {
   SHM_ERROR_PROTOCOL = -9,
   SHM_ERROR_FULL = -10,
   SHM_ERROR_NO_SLOT = -11,
+  SHM_ERROR_OVERWRITTEN = -12,
+  SHM_ERROR_REMOTE = -13,
 } shm_error_t;
 
 typedef enum shm_direction_t {
@@ -154,6 +221,25 @@ typedef struct shm_dispatch_callbacks_t {
   void *user_data;
 } shm_dispatch_callbacks_t;
 
+/**
+ * Выделение памяти секции (см. `SectionOptions`). Zero-initialized —
+ * обычные страницы без предпочтения узла.
+ */
+typedef struct shm_section_options_t {
+  /**
+   * Большие страницы (SEC_LARGE_PAGES) с откатом на обычные
+   */
+  bool large_pages;
+  /**
+   * Коснуться всех страниц при создании
+   */
+  bool prefault;
+  /**
+   * Предпочтительный NUMA-узел плюс один; 0 — без предпочтения
+   */
+  uint32_t numa_node;
+} shm_section_options_t;
+
 /**
  * Настройки сервера.
  */
@@ -162,6 +248,32 @@ typedef struct shm_dispatch_options_t {
   uint32_t channel_connect_timeout_ms;
   uint32_t poll_timeout_ms;
   uint32_t recv_batch;
+  /**
+   * Потоков общего I/O-пула для каналов клиентов; 0 — поток на клиента.
+   */
+  uint32_t io_threads;
+  /**
+   * Ёмкость общей broadcast-секции (байты, степень двойки, от 256 КБ —
+   * два сообщения `MAX_MESSAGE_SIZE`); 0 — `shm_dispatch_server_broadcast`
+   * пишет в канал каждого клиента.
+   */
+  uint32_t broadcast_capacity;
+  /**
+   * Выделение памяти каналов клиентов и broadcast-секции.
+   */
+  struct shm_section_options_t memory;
+  /**
+   * Лобби, принимающих регистрации параллельно (1..=64); 0 — 1.
+   */
+  uint32_t lobby_shards;
+  /**
+   * Запас заранее созданных каналов клиентов; 0 — без запаса.
+   */
+  uint32_t warm_channels;
+  /**
+   * Бюджет хода клиентского канала, мкс; 0 — фиксированная пачка.
+   */
+  uint32_t recv_budget_us;
 } shm_dispatch_options_t;
 
 typedef void DispatchClientHandle;
@@ -173,6 +285,12 @@ typedef struct shm_dispatch_registration_t {
   uint32_t pid;
   uint16_t revision;
   const char *name;
+  /**
+   * Топики подписки (`topic_count` штук); при `topic_count == 0` может
+   * быть null.
+   */
+  const uint32_t *topics;
+  uint32_t topic_count;
 } shm_dispatch_registration_t;
 
 /**
@@ -184,6 +302,11 @@ typedef struct shm_dispatch_client_callbacks_t {
   void (*on_message)(const void *data, uint32_t size, void *user_data);
   void (*on_error)(enum shm_error_t error, void *user_data);
   void *user_data;
+  /**
+   * Клиент отстал от broadcast-секции и пропустил `dropped` рассылок.
+   * Поле в конце структуры, чтобы не сдвигать прежние.
+   */
+  void (*on_overflow)(uint32_t dropped, void *user_data);
 } shm_dispatch_client_callbacks_t;
 
 /**
@@ -198,12 +321,102 @@ typedef struct shm_dispatch_client_options_t {
   uint32_t max_send_queue;
 } shm_dispatch_client_options_t;
 
+/**
+ * Геометрия колец канала (см. `ChannelGeometry`).
+ *
+ * Нулевое поле означает значение по умолчанию, поэтому zero-initialized
+ * структура эквивалентна `shm_channel_geometry_default()`.
+ */
+typedef struct shm_channel_geometry_t {
+  /**
+   * Ёмкость кольца server→client, байты (степень двойки, 4 КБ..1 ГБ)
+   */
+  uint32_t s2c_capacity;
+  /**
+   * Ёмкость кольца client→server, байты (степень двойки, 4 КБ..1 ГБ)
+   */
+  uint32_t c2s_capacity;
+  /**
+   * Предел числа сообщений в одном кольце
+   */
+  uint32_t max_messages;
+  /**
+   * Максимальный размер сообщения (больше 65535 — длинные кадры)
+   */
+  uint32_t max_message_size;
+  /**
+   * Выделение памяти сегмента (в конце структуры, чтобы не сдвигать
+   * прежние поля)
+   */
+  struct shm_section_options_t memory;
+  /**
+   * Дорожек на направление, включая основное кольцо (0 — одна, до 64,
+   * см. `ChannelGeometry::lanes`)
+   */
+  uint32_t lanes;
+  /**
+   * Размер слота колец фиксированных слотов (0 — кадры переменной длины,
+   * см. `ChannelGeometry::slot_size`); при нулевом `max_message_size`
+   * задаёт и его
+   */
+  uint32_t slot_size;
+} shm_channel_geometry_t;
+
+/**
+ * Стратегия ожидания worker-а (см. `WaitStrategy`): `spin_us` мкс
+ * busy-spin, затем `yield_us` мкс yield, затем событие. Нули — сразу
+ * событие (zero-initialized структура сохраняет прежнее поведение).
+ */
+typedef struct shm_wait_strategy_t {
+  uint32_t spin_us;
+  uint32_t yield_us;
+} shm_wait_strategy_t;
+
+/**
+ * Политика отправки при нехватке места (см. `OverflowPolicy`): `mode` —
+ * одна из `SHM_OVERFLOW_*`, `timeout_ms` — предел ожидания для
+ * `SHM_OVERFLOW_BLOCK` (`UINT32_MAX` — без предела). Zero-initialized
+ * структура сохраняет прежнее вытеснение.
+ */
+typedef struct shm_overflow_policy_t {
+  uint32_t mode;
+  uint32_t timeout_ms;
+} shm_overflow_policy_t;
+
 typedef struct shm_auto_options_t {
   uint32_t poll_timeout_ms;
   uint32_t reconnect_delay_ms;
   uint32_t connect_timeout_ms;
   uint32_t max_send_queue;
   uint32_t recv_batch;
+  /**
+   * Геометрия колец (учитывается только сервером)
+   */
+  struct shm_channel_geometry_t geometry;
+  /**
+   * Ожидание входящих сообщений worker-ом
+   */
+  struct shm_wait_strategy_t wait;
+  /**
+   * Полная очередь отправки / кольцо: вытеснение, `SHM_ERROR_FULL` или
+   * ожидание в `shm_*_send_auto`
+   */
+  struct shm_overflow_policy_t overflow;
+  /**
+   * Pull-режим: `on_message` не вызывается, входящие забираются
+   * `shm_*_receive_auto`/`shm_*_receive_batch_auto` по событию
+   * `shm_*_wait_handle_auto`
+   */
+  bool pull;
+  /**
+   * Бюджет пачки приёма, мкс (см. `AutoOptions::recv_budget`); 0 —
+   * фиксированная пачка `recv_batch`
+   */
+  uint32_t recv_budget_us;
+  /**
+   * Метки трассировки на исходящих сообщениях (см. `AutoOptions::trace`)
+   */
+  bool trace;
 } shm_auto_options_t;
 
 typedef void AutoServerHandle;
@@ -212,6 +425,24 @@ typedef struct shm_endpoint_config_t {
   const char *name;
 } shm_endpoint_config_t;
 
+/**
+ * Метка трассируемого сообщения (см. `MessageTrace`).
+ */
+typedef struct shm_message_trace_t {
+  /**
+   * Порядковый номер кадра в кольце отправителя
+   */
+  uint32_t sequence;
+  /**
+   * Метка постановки в очередь, тики QueryPerformanceCounter
+   */
+  uint64_t enqueued;
+  /**
+   * Ожидание до чтения, нс
+   */
+  uint64_t queued_ns;
+} shm_message_trace_t;
+
 typedef struct shm_callbacks_t {
   void (*on_connect)(void *user_data);
   void (*on_disconnect)(void *user_data);
@@ -224,6 +455,15 @@ typedef struct shm_callbacks_t {
                      uint32_t size,
                      void *user_data);
   void (*on_overflow)(enum shm_direction_t direction, uint32_t dropped, void *user_data);
+  /**
+   * Сообщение с меткой трассировки; без этого callback-а оно уходит в
+   * `on_message`
+   */
+  void (*on_traced_message)(enum shm_direction_t direction,
+                            const void *data,
+                            uint32_t size,
+                            const struct shm_message_trace_t *trace,
+                            void *user_data);
 } shm_callbacks_t;
 
 typedef struct shm_auto_stats_t {
@@ -233,18 +473,121 @@ typedef struct shm_auto_stats_t {
   uint64_t receive_overflows;
 } shm_auto_stats_t;
 
+/**
+ * log2-гистограмма: `buckets[0]` — нули, `buckets[i]` — значения из
+ * `[2^(i-1), 2^i)`, последняя корзина — всё, что больше.
+ */
+typedef struct shm_histogram_t {
+  uint64_t count;
+  uint64_t sum;
+  uint64_t max;
+  uint64_t buckets[SHM_HISTOGRAM_BUCKETS];
+} shm_histogram_t;
+
+/**
+ * Телеметрия одной стороны канала (см. `ChannelStatsSnapshot`).
+ */
+typedef struct shm_channel_stats_t {
+  /**
+   * Пик занятых байт / сообщений исходящего кольца
+   */
+  uint32_t high_water_bytes;
+  uint32_t high_water_messages;
+  /**
+   * Сообщений, вытесненных из исходящего кольца
+   */
+  uint64_t dropped_messages;
+  /**
+   * Пробуждений worker-а по data-событию и из них пустых
+   */
+  uint64_t wakeups;
+  uint64_t spurious_wakeups;
+  /**
+   * Сообщений за одно чтение worker-а
+   */
+  struct shm_histogram_t batch_sizes;
+  /**
+   * Задержка публикация → чтение входящего кольца, нс (сэмплы)
+   */
+  struct shm_histogram_t latency_ns;
+  /**
+   * Время раздачи пачки callback-ам, нс
+   */
+  struct shm_histogram_t handler_ns;
+  /**
+   * Ожидание трассируемых сообщений в очереди и кольце, нс
+   */
+  struct shm_histogram_t queue_delay_ns;
+} shm_channel_stats_t;
+
 typedef void AutoClientHandle;
 
 typedef void ServerHandle;
 
 typedef void ClientHandle;
 
+/**
+ * Участки кольца, выданные `shm_*_reserve` под одно сообщение.
+ *
+ * Payload пишется подряд: сначала `first_size` байт в `first`, затем
+ * остаток в `second`. `second` равен NULL (`second_size == 0`), если резерв
+ * не переходит через границу кольца.
+ */
+typedef struct shm_write_span_t {
+  void *first;
+  uint32_t first_size;
+  void *second;
+  uint32_t second_size;
+} shm_write_span_t;
+
+/**
+ * Участки payload, выданные `shm_*_peek` (та же раскладка, что и у
+ * `shm_write_span_t`, но только для чтения).
+ */
+typedef struct shm_read_span_t {
+  const void *first;
+  uint32_t first_size;
+  const void *second;
+  uint32_t second_size;
+} shm_read_span_t;
+
+/**
+ * Одно сообщение пачки для `shm_*_send_batch` (iovec-style).
+ */
+typedef struct shm_iovec_t {
+  const void *data;
+  uint32_t size;
+} shm_iovec_t;
+
+/**
+ * Handle блока кучи (см. `HeapHandle`); передаётся через кольцо как есть —
+ * 16 байт little-endian.
+ */
+typedef struct shm_heap_handle_t {
+  /**
+   * Смещение данных блока от начала секции
+   */
+  uint64_t offset;
+  /**
+   * Длина данных
+   */
+  uint32_t len;
+  /**
+   * Поколение блока на момент выделения
+   */
+  uint32_t generation;
+} shm_heap_handle_t;
+
+typedef void SharedHeapHandle;
+
 /**
  * Опции для мультиклиентного сервера
  */
 typedef struct shm_multi_options_t {
   /**
-   * Максимальное количество клиентов (по умолчанию 20)
+   * Максимальное количество клиентов (по умолчанию 20, до MAX_MULTI_CLIENTS).
+   * Больше SLOTS_PER_WAITER — callbacks разных клиентов приходят из разных
+   * потоков
    */
   uint32_t max_clients;
   /**
@@ -255,6 +598,32 @@ typedef struct shm_multi_options_t {
    * Количество сообщений за один цикл (по умолчанию 32)
    */
   uint32_t recv_batch;
+  /**
+   * Геометрия колец каждого слота (нулевые поля — значения по умолчанию)
+   */
+  struct shm_channel_geometry_t geometry;
+  /**
+   * Ожидание данных worker-ом (нули — сразу событие)
+   */
+  struct shm_wait_strategy_t wait;
+  /**
+   * Ёмкость общего кольца рассылки (байты, степень двойки); 0 —
+   * `shm_multi_server_broadcast` пишет в кольцо каждого слота
+   */
+  uint32_t broadcast_capacity;
+  /**
+   * Бюджет хода слота, мкс (см. `MultiOptions::recv_budget`); 0 —
+   * фиксированная пачка
+   */
+  uint32_t recv_budget_us;
+  /**
+   * Размер блока общей кучи (байты, кратен 4 КБ); 0 — 1 МБ
+   */
+  uint32_t heap_block_size;
+  /**
+   * Число блоков общей кучи (`shm_multi_server_heap`); 0 — кучи нет
+   */
+  uint32_t heap_blocks;
 } shm_multi_options_t;
 
 /**
@@ -329,6 +698,7 @@ typedef struct shm_multi_client_callbacks_t {
   void (*on_message)(const void *data, uint32_t size, void *user_data);
   /**
    * Вызывается при переполнении внутренней send-очереди (`max_send_queue`)
+   * или при отставании от общего кольца рассылки
    */
   void (*on_overflow)(uint32_t dropped, void *user_data);
   /**
@@ -346,6 +716,22 @@ typedef struct shm_multi_client_callbacks_t {
  */
 typedef void MultiClientHandle;
 
+/**
+ * Обработчик вызова на стороне сервера: ответ пишется в `reply` (не больше
+ * `reply_capacity` байт), его длина — в `*reply_size`. Возвращает 0 либо
+ * прикладной код отказа, который клиент получит как `SHM_ERROR_REMOTE`.
+ */
+typedef uint32_t (*shm_rpc_handler_fn)(const void *request,
+                                       uint32_t size,
+                                       void *reply,
+                                       uint32_t reply_capacity,
+                                       uint32_t *reply_size,
+                                       void *user_data);
+
+typedef void RpcServerHandle;
+
+typedef void RpcClientHandle;
+
 #ifdef __cplusplus
 extern "C" {
 #endif // __cplusplus
@@ -377,12 +763,66 @@ enum shm_error_t shm_dispatch_server_broadcast(DispatchServerHandle *handle,
                                                uint32_t size,
                                                uint32_t *sent_count);
 
+/**
+ * Публикует сообщение подписчикам топика; `sent_count` — сколько получили.
+ *
+ * # Safety
+ * `handle` обязан быть валидным. `data` обязан указывать на `size` байт. `sent_count` может быть null.
+ */
+enum shm_error_t shm_dispatch_server_publish(DispatchServerHandle *handle,
+                                             uint32_t topic,
+                                             const void *data,
+                                             uint32_t size,
+                                             uint32_t *sent_count);
+
+/**
+ * Подписывает клиента на топик; `SHM_ERROR_NOT_FOUND` — клиента нет.
+ *
+ * # Safety
+ * `handle` обязан быть валидным DispatchServerHandle.
+ */
+enum shm_error_t shm_dispatch_server_subscribe(DispatchServerHandle *handle,
+                                               uint32_t client_id,
+                                               uint32_t topic);
+
+/**
+ * Снимает подписку клиента; `false` — он не был подписан.
+ *
+ * # Safety
+ * `handle` обязан быть валидным DispatchServerHandle либо null.
+ */
+bool shm_dispatch_server_unsubscribe(DispatchServerHandle *handle,
+                                     uint32_t client_id,
+                                     uint32_t topic);
+
+/**
+ * Вес клиента в обходе каналов потока пула (1..=64, по умолчанию 1; см.
+ * `DispatchServer::set_client_weight`).
+ *
+ * # Safety
+ * `handle` обязан быть валидным DispatchServerHandle либо null.
+ */
+enum shm_error_t shm_dispatch_server_set_client_weight(DispatchServerHandle *handle,
+                                                       uint32_t client_id,
+                                                       uint32_t weight);
+
 /**
  * # Safety
  * `handle` обязан быть валидным DispatchServerHandle либо null.
  */
 uint32_t shm_dispatch_server_client_count(const DispatchServerHandle *handle);
 
+/**
+ * Телеметрия выделенного канала клиента; `false` — клиента нет или
+ * `out == NULL`.
+ *
+ * # Safety
+ * `handle` обязан быть валидным DispatchServerHandle либо null.
+ */
+bool shm_dispatch_server_client_stats(const DispatchServerHandle *handle,
+                                      uint32_t client_id,
+                                      struct shm_channel_stats_t *out);
+
 /**
  * # Safety
  * `handle` обязан быть валидным DispatchServerHandle либо null. Поглощает handle.
@@ -406,6 +846,15 @@ enum shm_error_t shm_dispatch_client_send(DispatchClientHandle *handle,
                                           const void *data,
                                           uint32_t size);
 
+/**
+ * Телеметрия выделенного канала на стороне клиента.
+ *
+ * # Safety
+ * `handle` обязан быть валидным DispatchClientHandle либо null.
+ */
+bool shm_dispatch_client_channel_stats(const DispatchClientHandle *handle,
+                                       struct shm_channel_stats_t *out);
+
 /**
  * # Safety
  * `handle` обязан быть валидным DispatchClientHandle либо null. Поглощает handle.
@@ -418,6 +867,14 @@ struct shm_dispatch_client_options_t shm_dispatch_client_options_default(void);
 
 struct shm_auto_options_t shm_auto_options_default(void);
 
+struct shm_channel_geometry_t shm_channel_geometry_default(void);
+
+/**
+ * Порог non-temporal записи payload-ов для всех каналов процесса (см.
+ * `set_stream_threshold`); `UINTPTR_MAX` — никогда.
+ */
+void shm_set_stream_threshold(uintptr_t bytes);
+
 AutoServerHandle *shm_server_start_auto(const struct shm_endpoint_config_t *config,
                                         const struct shm_callbacks_t *callbacks,
                                         const struct shm_auto_options_t *options);
@@ -426,6 +883,34 @@ enum shm_error_t shm_server_send_auto(AutoServerHandle *handle, const void *data
 
 bool shm_server_stats_auto(const AutoServerHandle *handle, struct shm_auto_stats_t *out);
 
+bool shm_server_channel_stats_auto(const AutoServerHandle *handle,
+                                   struct shm_channel_stats_t *out);
+
+/**
+ * Pull-режим: одно сообщение клиента на потоке вызывающего, семантика буфера
+ * как у `shm_server_receive`. `SHM_ERROR_EMPTY` — входящих нет, можно ждать
+ * `shm_server_wait_handle_auto`; `SHM_ERROR_INVALID_PARAM` — объект создан без
+ * `pull`.
+ */
+enum shm_error_t shm_server_receive_auto(AutoServerHandle *handle, void *buffer, uint32_t *size);
+
+/**
+ * Pull-режим: пачка сообщений, семантика как у `shm_server_receive_batch`.
+ */
+enum shm_error_t shm_server_receive_batch_auto(AutoServerHandle *handle,
+                                               void *buffer,
+                                               uint32_t buffer_size,
+                                               uint32_t *offsets,
+                                               uint32_t max_messages,
+                                               uint32_t *count);
+
+/**
+ * Pull-режим: HANDLE auto-reset события для `WaitForMultipleObjects` —
+ * после него повторять `shm_server_receive*_auto` до `SHM_ERROR_EMPTY`.
+ * Принадлежит объекту, закрывать нельзя; 0 — объект создан без `pull`.
+ */
+intptr_t shm_server_wait_handle_auto(const AutoServerHandle *handle);
+
 void shm_server_stop_auto(AutoServerHandle *handle);
 
 AutoClientHandle *shm_client_connect_auto(const struct shm_endpoint_config_t *config,
@@ -436,21 +921,131 @@ enum shm_error_t shm_client_send_auto(AutoClientHandle *handle, const void *data
 
 bool shm_client_stats_auto(const AutoClientHandle *handle, struct shm_auto_stats_t *out);
 
+bool shm_client_channel_stats_auto(const AutoClientHandle *handle,
+                                   struct shm_channel_stats_t *out);
+
+/**
+ * Pull-режим: одно сообщение сервера на потоке вызывающего, семантика буфера
+ * как у `shm_client_receive`. `SHM_ERROR_EMPTY` — входящих нет, можно ждать
+ * `shm_client_wait_handle_auto`; `SHM_ERROR_INVALID_PARAM` — объект создан без
+ * `pull`.
+ */
+enum shm_error_t shm_client_receive_auto(AutoClientHandle *handle, void *buffer, uint32_t *size);
+
+/**
+ * Pull-режим: пачка сообщений, семантика как у `shm_client_receive_batch`.
+ */
+enum shm_error_t shm_client_receive_batch_auto(AutoClientHandle *handle,
+                                               void *buffer,
+                                               uint32_t buffer_size,
+                                               uint32_t *offsets,
+                                               uint32_t max_messages,
+                                               uint32_t *count);
+
+/**
+ * Pull-режим: HANDLE auto-reset события для `WaitForMultipleObjects` —
+ * после него повторять `shm_client_receive*_auto` до `SHM_ERROR_EMPTY`.
+ * Принадлежит объекту, закрывать нельзя; 0 — объект создан без `pull`.
+ */
+intptr_t shm_client_wait_handle_auto(const AutoClientHandle *handle);
+
 void shm_client_disconnect_auto(AutoClientHandle *handle);
 
 ServerHandle *shm_server_start(const struct shm_endpoint_config_t *config,
                                const struct shm_callbacks_t *callbacks);
 
+/**
+ * Запуск сервера с заданной геометрией колец (`geometry` может быть NULL —
+ * геометрия по умолчанию). Клиент подхватывает её при подключении сам.
+ */
+ServerHandle *shm_server_start_with_geometry(const struct shm_endpoint_config_t *config,
+                                             const struct shm_callbacks_t *callbacks,
+                                             const struct shm_channel_geometry_t *geometry);
+
 enum shm_error_t shm_server_wait_for_client(ServerHandle *handle, uint32_t timeout_ms);
 
 void shm_server_stop(ServerHandle *handle);
 
+/**
+ * Политика `shm_server_send*`/`shm_server_reserve` при нехватке места в
+ * кольце (NULL — вытеснение по умолчанию). Можно звать из любого потока,
+ * в том числе во время отправки: она идёт по политике на момент вызова.
+ */
+enum shm_error_t shm_server_set_overflow_policy(ServerHandle *handle,
+                                                const struct shm_overflow_policy_t *policy);
+
+/**
+ * Кольцевая часть телеметрии канала (без worker-а пробуждения, пачки и
+ * время handler-а остаются нулевыми). Можно звать из любого потока.
+ */
+bool shm_server_channel_stats(ServerHandle *handle, struct shm_channel_stats_t *out);
+
 enum shm_error_t shm_server_send(ServerHandle *handle, const void *data, uint32_t size);
 
+/**
+ * Отправка пачки из `count` сообщений: все кадры копируются в кольцо и
+ * публикуются разом, клиент будится не больше одного раза. Размеры
+ * проверяются заранее — при ошибке не отправляется ничего.
+ */
+enum shm_error_t shm_server_send_batch(ServerHandle *handle,
+                                       const struct shm_iovec_t *messages,
+                                       uint32_t count);
+
 enum shm_error_t shm_server_receive(ServerHandle *handle, void *buffer, uint32_t *size);
 
+/**
+ * Пакетный приём: до `max_messages` сообщений суммарно не больше
+ * `buffer_size` байт подряд в `buffer`, границы — в `offsets`
+ * (`max_messages + 1` элементов). Из кольца сообщения забираются одним
+ * сдвигом read_pos.
+ */
+enum shm_error_t shm_server_receive_batch(ServerHandle *handle,
+                                          void *buffer,
+                                          uint32_t buffer_size,
+                                          uint32_t *offsets,
+                                          uint32_t max_messages,
+                                          uint32_t *count);
+
 enum shm_error_t shm_server_poll(ServerHandle *handle, uint32_t timeout_ms);
 
+/**
+ * Zero-copy чтение: выдаёт payload самого старого сообщения клиента прямо
+ * из кольца, не забирая его.
+ *
+ * Данные действительны только если последующий `shm_server_consume` вернул
+ * `SHM_SUCCESS`; `SHM_ERROR_OVERWRITTEN` означает, что сообщение вытеснено
+ * во время чтения — результат надо отбросить и повторить peek.
+ */
+enum shm_error_t shm_server_peek(ServerHandle *handle, struct shm_read_span_t *out);
+
+/**
+ * Забирает сообщение, выданное `shm_server_peek`.
+ */
+enum shm_error_t shm_server_consume(ServerHandle *handle);
+
+/**
+ * Zero-copy отправка: резервирует `size` байт прямо в кольце server→client.
+ *
+ * Участки для записи возвращаются в `out`; сообщение публикуется
+ * `shm_server_commit` либо отменяется `shm_server_cancel`. Пока резерв
+ * активен, повторный reserve и `shm_server_send` возвращают `SHM_ERROR_EXISTS`
+ * — с любого потока: отправки, резервы и commit на одном дескрипторе
+ * сериализуются, и резерв получает ровно один из гонящихся.
+ */
+enum shm_error_t shm_server_reserve(ServerHandle *handle,
+                                    uint32_t size,
+                                    struct shm_write_span_t *out);
+
+/**
+ * Публикует первые `size` байт активного резерва (`size` <= зарезервированного).
+ */
+enum shm_error_t shm_server_commit(ServerHandle *handle, uint32_t size);
+
+/**
+ * Отменяет активный резерв без публикации сообщения.
+ */
+enum shm_error_t shm_server_cancel(ServerHandle *handle);
+
 ClientHandle *shm_client_connect(const struct shm_endpoint_config_t *config,
                                  const struct shm_callbacks_t *callbacks,
                                  uint32_t timeout_ms);
@@ -459,12 +1054,75 @@ void shm_client_disconnect(ClientHandle *handle);
 
 bool shm_client_is_connected(const ClientHandle *handle);
 
+/**
+ * Политика `shm_client_send*`/`shm_client_reserve` при нехватке места
+ * (см. `shm_server_set_overflow_policy`).
+ */
+enum shm_error_t shm_client_set_overflow_policy(ClientHandle *handle,
+                                                const struct shm_overflow_policy_t *policy);
+
+/**
+ * См. `shm_server_channel_stats`.
+ */
+bool shm_client_channel_stats(const ClientHandle *handle, struct shm_channel_stats_t *out);
+
+/**
+ * Оценка квантиля `quantile` (0.0..1.0) гистограммы сверху — граница
+ * корзины, не больше `max`. 0 для NULL и пустой гистограммы.
+ */
+uint64_t shm_histogram_percentile(const struct shm_histogram_t *histogram, double quantile);
+
 enum shm_error_t shm_client_send(ClientHandle *handle, const void *data, uint32_t size);
 
+/**
+ * Отправка пачки сообщений серверу (см. `shm_server_send_batch`).
+ */
+enum shm_error_t shm_client_send_batch(ClientHandle *handle,
+                                       const struct shm_iovec_t *messages,
+                                       uint32_t count);
+
 enum shm_error_t shm_client_receive(ClientHandle *handle, void *buffer, uint32_t *size);
 
+/**
+ * Пакетный приём на стороне клиента, семантика как у
+ * `shm_server_receive_batch`.
+ */
+enum shm_error_t shm_client_receive_batch(ClientHandle *handle,
+                                          void *buffer,
+                                          uint32_t buffer_size,
+                                          uint32_t *offsets,
+                                          uint32_t max_messages,
+                                          uint32_t *count);
+
 enum shm_error_t shm_client_poll(ClientHandle *handle, uint32_t timeout_ms);
 
+/**
+ * Zero-copy чтение сообщения сервера (см. `shm_server_peek`).
+ */
+enum shm_error_t shm_client_peek(ClientHandle *handle, struct shm_read_span_t *out);
+
+/**
+ * Забирает сообщение, выданное `shm_client_peek`.
+ */
+enum shm_error_t shm_client_consume(ClientHandle *handle);
+
+/**
+ * Zero-copy отправка в кольцо client→server (см. `shm_server_reserve`).
+ */
+enum shm_error_t shm_client_reserve(ClientHandle *handle,
+                                    uint32_t size,
+                                    struct shm_write_span_t *out);
+
+/**
+ * Публикует первые `size` байт активного резерва клиента.
+ */
+enum shm_error_t shm_client_commit(ClientHandle *handle, uint32_t size);
+
+/**
+ * Отменяет активный резерв клиента без публикации сообщения.
+ */
+enum shm_error_t shm_client_cancel(ClientHandle *handle);
+
 /**
  * Получить event handles для передачи в kernel driver
  *
@@ -481,6 +1139,75 @@ enum shm_error_t shm_client_poll(ClientHandle *handle, uint32_t timeout_ms);
 bool shm_server_get_event_handles(ServerHandle *handle,
                                   struct EventHandles *out);
 
+/**
+ * Открывает кучу сервера `base_name`; null — кучи нет или секция
+ * непригодна. Закрывается `shm_heap_close`.
+ *
+ * # Safety
+ * `base_name` обязан быть валидной C-строкой либо null.
+ */
+SharedHeapHandle *shm_heap_open(const char *base_name);
+
+/**
+ * Выделяет блок под `size` байт: handle — в `*out`, адрес данных — в
+ * `*data`. Ссылку producer-а снимает `shm_heap_release` (свой или
+ * получателя). Свободных блоков нет — `SHM_ERROR_FULL`.
+ *
+ * # Safety
+ * `heap` обязан быть валидным SharedHeapHandle, `out` и `data` —
+ * валидными указателями.
+ */
+enum shm_error_t shm_heap_allocate(const SharedHeapHandle *heap,
+                                   uint32_t size,
+                                   struct shm_heap_handle_t *out,
+                                   void **data);
+
+/**
+ * Адрес данных блока (`handle->len` байт) — в `*data`; валиден, пока
+ * вызывающий держит ссылку. Блок освобождён — `SHM_ERROR_OVERWRITTEN`.
+ *
+ * # Safety
+ * `heap` обязан быть валидным SharedHeapHandle, `handle` и `data` —
+ * валидными указателями.
+ */
+enum shm_error_t shm_heap_get(const SharedHeapHandle *heap,
+                              const struct shm_heap_handle_t *handle,
+                              const void **data);
+
+/**
+ * Ещё одна ссылка на блок (перед отправкой handle-а каждому получателю).
+ *
+ * # Safety
+ * `heap` обязан быть валидным SharedHeapHandle, `handle` — валидным
+ * указателем.
+ */
+enum shm_error_t shm_heap_retain(const SharedHeapHandle *heap,
+                                 const struct shm_heap_handle_t *handle);
+
+/**
+ * Снимает ссылку; последняя возвращает блок в кучу.
+ *
+ * # Safety
+ * Как у `shm_heap_retain`.
+ */
+enum shm_error_t shm_heap_release(const SharedHeapHandle *heap,
+                                  const struct shm_heap_handle_t *handle);
+
+/**
+ * Сколько блоков свободно сейчас (0 при null).
+ *
+ * # Safety
+ * `heap` обязан быть валидным SharedHeapHandle либо null.
+ */
+uint32_t shm_heap_free_blocks(const SharedHeapHandle *heap);
+
+/**
+ * # Safety
+ * `heap` обязан быть handle-ом из `shm_heap_open` либо null (не кучей
+ * `shm_multi_server_heap`). Поглощает handle.
+ */
+void shm_heap_close(SharedHeapHandle *heap);
+
 /**
  * Получить опции по умолчанию
  */
@@ -552,6 +1279,22 @@ enum shm_error_t shm_multi_server_broadcast(MultiServerHandle *handle,
  */
 enum shm_error_t shm_multi_server_disconnect_client(MultiServerHandle *handle, uint32_t client_id);
 
+/**
+ * Вес клиента в круговом обходе слотов (1..=64, по умолчанию 1; см.
+ * `MultiServer::set_client_weight`)
+ *
+ * # Parameters
+ * - `handle`: Handle сервера
+ * - `client_id`: ID подключённого клиента
+ * - `weight`: Вес
+ *
+ * # Returns
+ * SHM_SUCCESS, SHM_ERROR_NOT_CONNECTED или SHM_ERROR_INVALID_PARAM
+ */
+enum shm_error_t shm_multi_server_set_client_weight(MultiServerHandle *handle,
+                                                    uint32_t client_id,
+                                                    uint32_t weight);
+
 /**
  * Получение количества подключённых клиентов
  *
@@ -563,6 +1306,18 @@ enum shm_error_t shm_multi_server_disconnect_client(MultiServerHandle *handle, u
  */
 uint32_t shm_multi_server_client_count(const MultiServerHandle *handle);
 
+/**
+ * Общая куча блоков сервера (`heap_blocks` в опциях)
+ *
+ * # Parameters
+ * - `handle`: Handle сервера
+ *
+ * # Returns
+ * Куча для функций `shm_heap_*`, валидна до `shm_multi_server_stop`
+ * (не закрывать через `shm_heap_close`), или NULL, если кучи нет
+ */
+const SharedHeapHandle *shm_multi_server_heap(const MultiServerHandle *handle);
+
 /**
  * Проверка подключения конкретного клиента
  *
@@ -575,6 +1330,21 @@ uint32_t shm_multi_server_client_count(const MultiServerHandle *handle);
  */
 bool shm_multi_server_is_client_connected(const MultiServerHandle *handle, uint32_t client_id);
 
+/**
+ * Телеметрия канала подключённого клиента (считается с его подключения)
+ *
+ * # Parameters
+ * - `handle`: Handle сервера
+ * - `client_id`: ID клиента
+ * - `out`: Куда записать статистику
+ *
+ * # Returns
+ * false если клиент не подключён или `out` == NULL
+ */
+bool shm_multi_server_client_stats(const MultiServerHandle *handle,
+                                   uint32_t client_id,
+                                   struct shm_channel_stats_t *out);
+
 /**
  * Получение списка подключённых клиентов
  *
@@ -690,6 +1460,108 @@ bool shm_multi_client_is_connected(const MultiClientHandle *handle);
  */
 void shm_multi_client_disconnect(MultiClientHandle *handle);
 
+/**
+ * Запускает RPC-сервер канала `name`; `handler` вызывается на сервисном
+ * потоке сервера. `options` может быть null.
+ *
+ * # Safety
+ * `name` обязан быть валидной C-строкой, `options` — валидным указателем
+ * либо null. `user_data` передаётся в `handler` как есть.
+ */
+RpcServerHandle *shm_rpc_server_start(const char *name,
+                                      shm_rpc_handler_fn handler,
+                                      void *user_data,
+                                      const struct shm_auto_options_t *options);
+
+/**
+ * # Safety
+ * `handle` обязан быть валидным RpcServerHandle либо null. Поглощает handle.
+ */
+void shm_rpc_server_stop(RpcServerHandle *handle);
+
+/**
+ * Подключается к RPC-серверу `name` (переподключение — автоматически).
+ *
+ * # Safety
+ * `name` обязан быть валидной C-строкой, `options` — валидным указателем
+ * либо null.
+ */
+RpcClientHandle *shm_rpc_client_connect(const char *name, const struct shm_auto_options_t *options);
+
+/**
+ * Синхронный вызов. `*reply_size` — на входе ёмкость `reply`, на выходе
+ * длина ответа; не влезший ответ — `SHM_ERROR_MEMORY`, и он теряется
+ * (ответ не длиннее `max_message_size` сервера минус 8 байт).
+ * `SHM_ERROR_REMOTE` — handler отказал, код в `*remote_code` (может быть
+ * null). `timeout_ms == UINT32_MAX` — без предела.
+ *
+ * # Safety
+ * `handle` обязан быть валидным RpcClientHandle, `request` — указывать на
+ * `size` байт (null при `size == 0`), `reply` — на `*reply_size` байт.
+ */
+enum shm_error_t shm_rpc_client_call(RpcClientHandle *handle,
+                                     const void *request,
+                                     uint32_t size,
+                                     void *reply,
+                                     uint32_t *reply_size,
+                                     uint32_t timeout_ms,
+                                     uint32_t *remote_code);
+
+/**
+ * Отправляет вызов без ожидания; id для `shm_rpc_client_wait`/`poll` — в
+ * `*call_id`.
+ *
+ * # Safety
+ * `handle` обязан быть валидным RpcClientHandle, `request` — указывать на
+ * `size` байт (null при `size == 0`), `call_id` — валиден.
+ */
+enum shm_error_t shm_rpc_client_submit(RpcClientHandle *handle,
+                                       const void *request,
+                                       uint32_t size,
+                                       uint32_t *call_id);
+
+/**
+ * Ждёт ответ на `call_id`, семантика буфера и ошибок — как у
+ * `shm_rpc_client_call`, но не влезший ответ сохраняется для повторного
+ * вызова с тем же id.
+ *
+ * # Safety
+ * Как у `shm_rpc_client_call`.
+ */
+enum shm_error_t shm_rpc_client_wait(RpcClientHandle *handle,
+                                     uint32_t call_id,
+                                     void *reply,
+                                     uint32_t *reply_size,
+                                     uint32_t timeout_ms,
+                                     uint32_t *remote_code);
+
+/**
+ * Неблокирующая проверка ответа на `call_id`: `SHM_ERROR_EMPTY` — ещё не
+ * пришёл; остальное — как у `shm_rpc_client_wait`.
+ *
+ * # Safety
+ * Как у `shm_rpc_client_call`.
+ */
+enum shm_error_t shm_rpc_client_poll(RpcClientHandle *handle,
+                                     uint32_t call_id,
+                                     void *reply,
+                                     uint32_t *reply_size,
+                                     uint32_t *remote_code);
+
+/**
+ * Снимает вызов: опоздавший ответ отбрасывается. `false` — id неизвестен.
+ *
+ * # Safety
+ * `handle` обязан быть валидным RpcClientHandle либо null.
+ */
+bool shm_rpc_client_cancel(RpcClientHandle *handle, uint32_t call_id);
+
+/**
+ * # Safety
+ * `handle` обязан быть валидным RpcClientHandle либо null. Поглощает handle.
+ */
+void shm_rpc_client_stop(RpcClientHandle *handle);
+
 #ifdef __cplusplus
 }  // extern "C"
 #endif  // __cplusplus
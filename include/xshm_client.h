@@ -67,6 +67,7 @@ static inline shm_dispatch_client_callbacks_t xshm_dispatch_client_callbacks_def
     cb.on_message = 0;
     cb.on_error = 0;
     cb.user_data = 0;
+    cb.on_overflow = 0;
     return cb;
 }
 
@@ -75,6 +76,16 @@ static inline shm_dispatch_registration_t xshm_dispatch_registration(uint32_t pi
     reg.pid = pid;
     reg.revision = revision;
     reg.name = name;
+    reg.topics = 0;
+    reg.topic_count = 0;
+    return reg;
+}
+
+static inline shm_dispatch_registration_t xshm_dispatch_registration_topics(uint32_t pid, uint16_t revision, const char *name,
+                                                                            const uint32_t *topics, uint32_t topic_count) {
+    shm_dispatch_registration_t reg = xshm_dispatch_registration(pid, revision, name);
+    reg.topics = topics;
+    reg.topic_count = topic_count;
     return reg;
 }
 
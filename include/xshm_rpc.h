@@ -0,0 +1,59 @@
+#ifndef XSHM_RPC_H
+#define XSHM_RPC_H
+
+#include "xshm.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// ============================================================================
+// RPC helpers
+// ============================================================================
+
+// Note: Types shm_rpc_handler_fn, RpcServerHandle, RpcClientHandle and all
+// shm_rpc_* functions are declared in xshm.h
+
+// Spin-фаза ожидания: сервисный поток сервера и ждущий вызов клиента крутятся
+// на кольце `spin_us` микросекунд, прежде чем уснуть на событии.
+static inline shm_auto_options_t xshm_rpc_options_default(uint32_t spin_us) {
+    shm_auto_options_t opts = shm_auto_options_default();
+    opts.wait.spin_us = spin_us;
+    opts.wait.yield_us = 0;
+    return opts;
+}
+
+// Наибольший ответ, который сервер с геометрией `geometry` может вернуть.
+static inline uint32_t xshm_rpc_max_reply_size(const shm_channel_geometry_t *geometry) {
+    uint32_t max = geometry->max_message_size;
+    if (max > MAX_MESSAGE_SIZE) {
+        max = MAX_MESSAGE_SIZE;
+    }
+    return max > RPC_ENVELOPE_SIZE ? max - RPC_ENVELOPE_SIZE : 0;
+}
+
+static inline RpcServerHandle *xshm_rpc_server_start(const char *name,
+                                                     shm_rpc_handler_fn handler,
+                                                     void *user_data) {
+    return shm_rpc_server_start(name, handler, user_data, 0);
+}
+
+static inline RpcClientHandle *xshm_rpc_client_connect(const char *name) {
+    return shm_rpc_client_connect(name, 0);
+}
+
+// Вызов без кода отказа: `SHM_ERROR_REMOTE` без подробностей.
+static inline shm_error_t xshm_rpc_call(RpcClientHandle *client,
+                                        const void *request,
+                                        uint32_t size,
+                                        void *reply,
+                                        uint32_t *reply_size,
+                                        uint32_t timeout_ms) {
+    return shm_rpc_client_call(client, request, size, reply, reply_size, timeout_ms, 0);
+}
+
+#ifdef __cplusplus
+}  // extern "C"
+#endif
+
+#endif /* XSHM_RPC_H */
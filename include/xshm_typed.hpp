@@ -0,0 +1,180 @@
+#ifndef XSHM_TYPED_HPP
+#define XSHM_TYPED_HPP
+
+#ifndef __cplusplus
+#error "xshm_typed.hpp requires C++"
+#endif
+
+#include <cassert>
+#include <cstdint>
+#include <new>
+#include <type_traits>
+
+#include "xshm.h"
+
+// ============================================================================
+// Typed channels: один POD-тип на канал поверх колец фиксированных слотов
+// ============================================================================
+
+namespace xshm {
+
+// Геометрия канала под сообщения `T`: кольца фиксированных слотов по
+// `sizeof(T)` байт (`shm_channel_geometry_t::slot_size`). Слот не переходит
+// границу кольца и начинается с кратного `sizeof(T)` смещения, поэтому `T`
+// лежит в кольце целиком и выровненным.
+template <typename T>
+inline shm_channel_geometry_t typed_geometry(uint32_t capacity) {
+    shm_channel_geometry_t geometry = shm_channel_geometry_default();
+    geometry.s2c_capacity = capacity;
+    geometry.c2s_capacity = capacity;
+    geometry.max_message_size = static_cast<uint32_t>(sizeof(T));
+    geometry.slot_size = static_cast<uint32_t>(sizeof(T));
+    return geometry;
+}
+
+// Сторона канала для `typed_channel`: сервер пишет в кольцо server→client
+// и читает client→server, клиент — наоборот.
+struct server_side {
+    static shm_error_t reserve(void *handle, uint32_t size, shm_write_span_t *out) {
+        return shm_server_reserve(handle, size, out);
+    }
+    static shm_error_t commit(void *handle, uint32_t size) {
+        return shm_server_commit(handle, size);
+    }
+    static shm_error_t peek(void *handle, shm_read_span_t *out) {
+        return shm_server_peek(handle, out);
+    }
+    static shm_error_t consume(void *handle) {
+        return shm_server_consume(handle);
+    }
+    static shm_error_t cancel(void *handle) {
+        return shm_server_cancel(handle);
+    }
+};
+
+struct client_side {
+    static shm_error_t reserve(void *handle, uint32_t size, shm_write_span_t *out) {
+        return shm_client_reserve(handle, size, out);
+    }
+    static shm_error_t commit(void *handle, uint32_t size) {
+        return shm_client_commit(handle, size);
+    }
+    static shm_error_t peek(void *handle, shm_read_span_t *out) {
+        return shm_client_peek(handle, out);
+    }
+    static shm_error_t consume(void *handle) {
+        return shm_client_consume(handle);
+    }
+    static shm_error_t cancel(void *handle) {
+        return shm_client_cancel(handle);
+    }
+};
+
+namespace detail {
+
+// Резерв, который отменяется, если до `commit` дело не дошло: исключение из
+// конструктора `T` или из `fill` иначе оставило бы резерв висеть, и любая
+// следующая отправка по handle получала бы `SHM_ERROR_EXISTS`.
+template <typename Side>
+class reservation_guard {
+public:
+    explicit reservation_guard(void *handle) : handle_(handle) {}
+    ~reservation_guard() {
+        if (handle_ != nullptr) {
+            Side::cancel(handle_);
+        }
+    }
+
+    shm_error_t commit(uint32_t size) {
+        void *handle = handle_;
+        handle_ = nullptr;
+        return Side::commit(handle, size);
+    }
+
+private:
+    reservation_guard(const reservation_guard &);
+    reservation_guard &operator=(const reservation_guard &);
+
+    void *handle_;
+};
+
+}  // namespace detail
+
+// Чтение и запись `T` прямо в слоте кольца: без длины кадра, без её
+// проверки и без копии через промежуточный буфер. Handle (`ServerHandle` /
+// `ClientHandle`) не принадлежит обёртке; канал должен быть создан с
+// `typed_geometry<T>` — peek в обычном канале выдал бы кадр другой длины.
+template <typename T, typename Side>
+class typed_channel {
+    static_assert(std::is_trivially_copyable<T>::value,
+                  "typed_channel<T>: T must be trivially copyable");
+    static_assert(sizeof(T) >= MIN_MESSAGE_SIZE, "typed_channel<T>: T is smaller than a message");
+    static_assert(alignof(T) <= 64, "typed_channel<T>: ring storage is 64-byte aligned");
+
+public:
+    explicit typed_channel(void *handle) : handle_(handle) {}
+
+    // Заполняет слот на месте: `fill(T &)` получает неинициализированный
+    // `T` в кольце, после него слот публикуется. Ошибки — как у
+    // `shm_*_reserve` (`SHM_ERROR_FULL`, `SHM_ERROR_EXISTS`, ...). Исключение
+    // из `fill` отменяет резерв и уходит вызывающему; слот не публикуется.
+    template <typename Fill>
+    shm_error_t emplace(Fill &&fill) {
+        shm_write_span_t span;
+        shm_error_t err = Side::reserve(handle_, sizeof(T), &span);
+        if (err != SHM_SUCCESS) {
+            return err;
+        }
+        detail::reservation_guard<Side> reservation(handle_);
+        assert(span.first_size == sizeof(T) && span.second_size == 0);
+        T *slot = ::new (span.first) T;
+        fill(*slot);
+        return reservation.commit(sizeof(T));
+    }
+
+    shm_error_t send(const T &value) {
+        return emplace([&value](T &slot) { slot = value; });
+    }
+
+    // Отдаёт `visit(const T &)` самое старое сообщение прямо из кольца и
+    // забирает его. `SHM_ERROR_OVERWRITTEN` — producer вытеснил слот во время
+    // `visit`: всё, что тот из него вынес, надо отбросить (следующий вызов
+    // выдаст следующее сообщение). `SHM_ERROR_EMPTY` — сообщений нет.
+    template <typename Visit>
+    shm_error_t consume(Visit &&visit) {
+        shm_read_span_t span;
+        shm_error_t err = Side::peek(handle_, &span);
+        if (err != SHM_SUCCESS) {
+            return err;
+        }
+        assert(span.first_size == sizeof(T) && span.second_size == 0);
+        visit(*static_cast<const T *>(span.first));
+        return Side::consume(handle_);
+    }
+
+    // Копия самого старого сообщения в `out`; вытесненное во время чтения
+    // перечитывается.
+    shm_error_t receive(T &out) {
+        for (;;) {
+            shm_error_t err = consume([&out](const T &slot) { out = slot; });
+            if (err != SHM_ERROR_OVERWRITTEN) {
+                return err;
+            }
+        }
+    }
+
+    void *handle() const { return handle_; }
+
+private:
+    void *handle_;
+};
+
+template <typename T>
+using typed_server_channel = typed_channel<T, server_side>;
+
+template <typename T>
+using typed_client_channel = typed_channel<T, client_side>;
+
+}  // namespace xshm
+
+#endif /* XSHM_TYPED_HPP */
@@ -1,17 +1,26 @@
-use std::collections::VecDeque;
-use std::sync::atomic::{AtomicBool, AtomicU64, Ordering};
+mod queue;
+
+use std::sync::atomic::{fence, AtomicBool, AtomicU64, AtomicUsize, Ordering};
 use std::sync::{Arc, Mutex};
 use std::thread::{self, JoinHandle};
-use std::time::Duration;
-
-use std::sync::mpsc::{self, Receiver, Sender};
+use std::time::{Duration, Instant};
 
+use crate::broadcast::BroadcastReceiver;
 use crate::client::SharedClient;
-use crate::constants::MAX_MESSAGE_SIZE;
+use crate::constants::{EVENT_DATA_SUFFIX, EVENT_SPACE_SUFFIX, MAX_MESSAGE_SIZE};
 use crate::error::{Result, ShmError};
+use crate::layout::ChannelGeometry;
+use crate::naming::{event_name, Direction};
+use crate::ring::{MessageBatch, OverflowPolicy};
+use crate::sched::AdaptiveBatch;
 use crate::server::SharedServer;
+use crate::stats::{ChannelStats, ChannelStatsSnapshot};
+use crate::trace::{self, MessageTrace, NO_CLIENT};
+use crate::wait::{write_with_backpressure, WaitStrategy, SHARED_SPACE_NAP};
 use crate::wait_delay;
-use crate::win::{self};
+use crate::win::{self, EventHandle};
+
+use queue::SendQueue;
 
 fn map_spawn_error(err: std::io::Error, context: &'static str) -> ShmError {
     let code = err.raw_os_error().map(|c| c as u32).unwrap_or(0xFFFFFFFF);
@@ -34,7 +43,7 @@ fn map_spawn_error(err: std::io::Error, context: &'static str) -> ShmError {
 /// уже видит `running=false` (устанавливается до этого вызова) и завершится
 /// сам -- безопасный detach силами ОС, не утечка (тред всё равно скоро
 /// вернёт управление и выйдет из своего цикла).
-fn join_unless_self(handle: JoinHandle<()>) {
+pub(crate) fn join_unless_self(handle: JoinHandle<()>) {
     if handle.thread().id() != thread::current().id() {
         let _ = handle.join();
     }
@@ -61,6 +70,11 @@ pub trait AutoHandler: Send + Sync + 'static {
     fn on_connect(&self) {}
     fn on_disconnect(&self) {}
     fn on_message(&self, _direction: ChannelKind, _payload: &[u8]) {}
+    /// Сообщение пришло с меткой трассировки (`AutoOptions::trace` у
+    /// отправителя). По умолчанию — обычный `on_message`.
+    fn on_traced_message(&self, direction: ChannelKind, payload: &[u8], _trace: MessageTrace) {
+        self.on_message(direction, payload);
+    }
     fn on_overflow(&self, _direction: ChannelKind, _count: u32) {}
     fn on_space_available(&self, _direction: ChannelKind) {}
     fn on_error(&self, _err: ShmError) {}
@@ -77,6 +91,45 @@ pub struct AutoOptions {
     pub connect_timeout: Duration,
     pub max_send_queue: usize,
     pub recv_batch: usize,
+    /// Бюджет времени на одну пачку приёма вместе с `on_message`. Ненулевой
+    /// — worker подбирает размер пачки по измеренной стоимости сообщения
+    /// (не больше `recv_batch`), чтобы медленный handler не задерживал
+    /// отправку. 0 — фиксированная пачка `recv_batch`.
+    pub recv_budget: Duration,
+    /// Что делать при нехватке места: `Overwrite` — очередь отправки и
+    /// кольцо вытесняют самые старые сообщения (прежнее поведение). `Fail` —
+    /// `send()` при полной очереди возвращает `QueueFull`, `Block` — ждёт
+    /// места до таймаута. В обоих случаях worker не вытесняет сообщения из
+    /// кольца, а ждёт, пока другая сторона его дочитает. Блокирующий `send()`
+    /// нельзя звать из callback-ов `AutoHandler`: их вызывает тот самый
+    /// worker, который освобождает очередь.
+    pub overflow: OverflowPolicy,
+    /// Геометрия колец канала. Используется только `AutoServer` — клиент
+    /// получает её от сервера через `ControlBlock`.
+    pub geometry: ChannelGeometry,
+    /// Как worker ждёт входящие сообщения (по умолчанию — сразу событие).
+    /// Очередь отправки и disconnect проверяются между фазами ожидания,
+    /// поэтому spin-бюджет стоит держать в микросекундах.
+    pub wait: WaitStrategy,
+    /// Базовое имя broadcast-секции, которую `AutoClient` читает вдобавок к
+    /// своему кольцу (сообщения приходят как `ServerToClient`, потери —
+    /// через `on_overflow`). Используется только клиентом; пробуждение —
+    /// общее с кольцом событие `s2c.data`.
+    pub broadcast: Option<String>,
+    /// Pull-режим: worker только отправляет и держит соединение
+    /// (handshake, переподключение, `on_connect`/`on_disconnect`/
+    /// `on_error`), а входящие сообщения забирает поток вызывающего через
+    /// `receive`/`receive_batch`, ожидая `wait_handle` в своём цикле.
+    /// `on_message` не вызывается, потери broadcast-секции видны только в
+    /// `receive_overflows`.
+    pub pull: bool,
+    /// Трассировка исходящих сообщений: каждое получает метку времени
+    /// `send()` и порядковый номер (`MessageTrace`), а принимающая сторона
+    /// — их ожидание в очереди отправки и в кольце в
+    /// `ChannelStatsSnapshot::queue_delay_ns` и `on_traced_message`. Обе
+    /// стороны должны быть версии, знающей трассируемые кадры. Сообщения
+    /// broadcast-секции не трассируются.
+    pub trace: bool,
 }
 
 impl Default for AutoOptions {
@@ -87,6 +140,13 @@ impl Default for AutoOptions {
             connect_timeout: Duration::from_secs(2),
             max_send_queue: 256,
             recv_batch: 32,
+            recv_budget: Duration::ZERO,
+            overflow: OverflowPolicy::Overwrite,
+            geometry: ChannelGeometry::default(),
+            wait: WaitStrategy::default(),
+            broadcast: None,
+            pull: false,
+            trace: false,
         }
     }
 }
@@ -97,6 +157,9 @@ pub struct AutoStatsSnapshot {
     pub send_overflows: u64,
     pub received_messages: u64,
     pub receive_overflows: u64,
+    /// Телеметрия канала за всё время жизни объекта, включая
+    /// переподключения клиента.
+    pub channel: ChannelStatsSnapshot,
 }
 
 #[derive(Default)]
@@ -105,6 +168,9 @@ struct AutoStats {
     send_overflows: AtomicU64,
     received_messages: AtomicU64,
     receive_overflows: AtomicU64,
+    /// Приёмник статистики колец; worker подключает его к каждому новому
+    /// `SharedServer`/`SharedClient`.
+    channel: Arc<ChannelStats>,
 }
 
 impl AutoStats {
@@ -114,58 +180,412 @@ impl AutoStats {
             send_overflows: self.send_overflows.load(Ordering::Relaxed),
             received_messages: self.received_messages.load(Ordering::Relaxed),
             receive_overflows: self.receive_overflows.load(Ordering::Relaxed),
+            channel: self.channel.snapshot(),
         }
     }
 }
 
-enum WorkerCommand {
-    Send(Vec<u8>),
-    Shutdown,
+/// Очередь отправки и пробуждение worker-а — общие для `send()` и потока.
+///
+/// `send()` не берёт блокировок: сообщение уходит в lock-free `SendQueue`, а
+/// `wake` ставится, только если worker объявил `parked` перед сном (та же
+/// пара fence-ов, что и у флага `spinning` в кольце), — пока worker занят,
+/// отправка обходится без syscall.
+///
+/// Отправители, ждущие места по `OverflowPolicy::Block`, объявляют себя в
+/// `blocked` по той же схеме: worker, выбрав сообщения из очереди, сигналит
+/// `space`, только если такие есть.
+struct Outbox {
+    queue: SendQueue,
+    parked: AtomicBool,
+    wake: EventHandle,
+    overflow: OverflowPolicy,
+    blocked: AtomicUsize,
+    space: EventHandle,
+    /// Сообщения в очереди несут хвост с меткой `send()` (`AutoOptions::trace`).
+    trace: bool,
 }
 
-struct SendQueue {
-    queue: Mutex<VecDeque<Vec<u8>>>,
+/// Хвост сообщения в очереди отправки с трассировкой: метка QPC.
+const STAMP_TRAILER: usize = 8;
+
+impl Outbox {
+    fn new(options: &AutoOptions) -> Result<Self> {
+        Ok(Self {
+            queue: SendQueue::new(options.max_send_queue),
+            parked: AtomicBool::new(false),
+            wake: EventHandle::create_local()?,
+            overflow: options.overflow,
+            blocked: AtomicUsize::new(0),
+            space: EventHandle::create_local()?,
+            trace: options.trace,
+        })
+    }
+
+    /// Копия сообщения для очереди; с трассировкой — с хвостом-меткой,
+    /// который снимает `process_send_queue`.
+    fn message(&self, data: &[u8]) -> Vec<u8> {
+        if !self.trace {
+            return data.to_vec();
+        }
+        let mut msg = Vec::with_capacity(data.len() + STAMP_TRAILER);
+        msg.extend_from_slice(data);
+        msg.extend_from_slice(&win::perf_counter().to_le_bytes());
+        msg
+    }
+
+    /// Payload сообщения из очереди и его метка.
+    fn split<'a>(&self, msg: &'a [u8]) -> (&'a [u8], Option<u64>) {
+        if !self.trace {
+            return (msg, None);
+        }
+        let (payload, trailer) = msg.split_at(msg.len() - STAMP_TRAILER);
+        let mut stamp = [0u8; STAMP_TRAILER];
+        stamp.copy_from_slice(trailer);
+        (payload, Some(u64::from_le_bytes(stamp)))
+    }
+
+    fn push(&self, msg: Vec<u8>, running: &AtomicBool) -> Result<()> {
+        match self.overflow {
+            OverflowPolicy::Overwrite => self.queue.push(msg),
+            OverflowPolicy::Fail => self.queue.try_push(msg).map_err(|_| ShmError::QueueFull)?,
+            OverflowPolicy::Block(timeout) => self.push_blocking(msg, timeout, running)?,
+        }
+        fence(Ordering::SeqCst);
+        if self.parked.load(Ordering::Relaxed) {
+            let _ = self.wake.set();
+        }
+        Ok(())
+    }
+
+    fn push_blocking(&self, msg: Vec<u8>, timeout: Duration, running: &AtomicBool) -> Result<()> {
+        let mut msg = match self.queue.try_push(msg) {
+            Ok(()) => return Ok(()),
+            Err(rejected) => rejected,
+        };
+        let deadline = Instant::now().checked_add(timeout);
+        self.blocked.fetch_add(1, Ordering::Relaxed);
+        // StoreLoad: либо worker увидит нас в `blocked`, либо мы увидим
+        // освобождённую им ячейку при повторной попытке.
+        fence(Ordering::SeqCst);
+        let result = loop {
+            match self.queue.try_push(msg) {
+                Ok(()) => break Ok(()),
+                Err(rejected) => msg = rejected,
+            }
+            if !running.load(Ordering::Acquire) {
+                break Err(ShmError::NotReady);
+            }
+            let remaining = match deadline {
+                Some(deadline) => {
+                    let remaining = deadline.saturating_duration_since(Instant::now());
+                    if remaining.is_zero() {
+                        break Err(ShmError::QueueFull);
+                    }
+                    Some(remaining)
+                }
+                None => None,
+            };
+            // Очередь полна — worker и так не спит, ждём, пока он её разгребёт.
+            if let Err(err) = self.space.wait(remaining) {
+                break Err(err);
+            }
+        };
+        self.blocked.fetch_sub(1, Ordering::Relaxed);
+        result
+    }
+
+    /// Worker выбрал сообщения из очереди: разбудить отправителя, ждущего
+    /// места. Достаточно одного — он сам сигналит следующему через worker
+    /// на его следующем проходе.
+    fn release_senders(&self) {
+        if !matches!(self.overflow, OverflowPolicy::Block(_)) {
+            return;
+        }
+        fence(Ordering::SeqCst);
+        if self.blocked.load(Ordering::Relaxed) > 0 {
+            let _ = self.space.set();
+        }
+    }
+
+    /// Worker собирается в `wait_any`. `false` — очередь уже не пуста, спать
+    /// нельзя.
+    fn park(&self) -> bool {
+        self.parked.store(true, Ordering::Relaxed);
+        fence(Ordering::SeqCst);
+        if self.queue.is_empty() {
+            return true;
+        }
+        self.parked.store(false, Ordering::Relaxed);
+        false
+    }
+
+    fn unpark(&self) {
+        self.parked.store(false, Ordering::Relaxed);
+    }
+
+    /// Разбудить worker безусловно (`stop`/`Drop`); заодно отпустить
+    /// заблокированных отправителей — они увидят `running == false`.
+    fn wake(&self) {
+        let _ = self.wake.set();
+        if self.blocked.load(Ordering::Relaxed) > 0 {
+            let _ = self.space.set();
+        }
+    }
+}
+
+/// Приём на потоке вызывающего (`AutoOptions::pull`).
+///
+/// Worker кладёт подключённый endpoint в слот и забирает его обратно перед
+/// любой сменой соединения. Вызывающий читает кольцо, не отпуская
+/// блокировку слота, поэтому, вынув `Arc` из слота, worker снова остаётся
+/// его единственным владельцем (`exclusive`). Блокировку worker берёт только
+/// при подключении и отключении — на горячем пути она всегда свободна.
+struct Inbox<E> {
+    slot: Mutex<InboxSlot<E>>,
+    /// Событие для цикла ожидания вызывающего: у сервера — своя копия
+    /// `c2s.data` (его сигналит сам клиент), у клиента — локальное событие,
+    /// которое worker взводит по `s2c.data` (события клиента меняются с
+    /// каждым переподключением). Взводится и при смене соединения.
+    ready: EventHandle,
+    /// Вызывающий наткнулся на повреждённое кольцо — worker сбросит
+    /// соединение.
+    fault: AtomicBool,
 }
 
-impl SendQueue {
-    fn new() -> Self {
+struct InboxSlot<E> {
+    endpoint: Option<Arc<E>>,
+    fanout: Option<BroadcastReceiver>,
+    /// Арена одиночного `receive` из broadcast-секции.
+    scratch: MessageBatch,
+}
+
+impl<E: ReceiveEndpoint> Inbox<E> {
+    fn new(ready: EventHandle) -> Self {
         Self {
-            queue: Mutex::new(VecDeque::new()),
+            slot: Mutex::new(InboxSlot {
+                endpoint: None,
+                fanout: None,
+                scratch: MessageBatch::new(),
+            }),
+            ready,
+            fault: AtomicBool::new(false),
         }
     }
 
-    fn push(&self, data: Vec<u8>) {
-        let mut guard = self.queue.lock().unwrap();
-        guard.push_back(data);
+    /// Соединение установлено: отдать endpoint вызывающему.
+    fn publish(&self, endpoint: Arc<E>, fanout: Option<BroadcastReceiver>) {
+        {
+            let mut slot = self.slot.lock().unwrap();
+            slot.endpoint = Some(endpoint);
+            slot.fanout = fanout;
+        }
+        self.fault.store(false, Ordering::Relaxed);
+        let _ = self.ready.set();
     }
 
-    fn pop(&self) -> Option<Vec<u8>> {
-        let mut guard = self.queue.lock().unwrap();
-        guard.pop_front()
+    /// Забрать endpoint у вызывающего; после возврата чужих ссылок на него нет.
+    fn withdraw(&self) {
+        let withdrawn = {
+            let mut slot = self.slot.lock().unwrap();
+            slot.fanout = None;
+            slot.endpoint.take()
+        };
+        if withdrawn.is_some() {
+            // вызывающий узнает об отключении из `receive`
+            let _ = self.ready.set();
+        }
     }
 
-    fn push_front(&self, data: Vec<u8>) {
-        let mut guard = self.queue.lock().unwrap();
-        guard.push_front(data);
+    fn take_fault(&self) -> bool {
+        self.fault.swap(false, Ordering::Acquire)
     }
 
-    fn len(&self) -> usize {
-        self.queue.lock().unwrap().len()
+    fn receive(&self, buffer: &mut Vec<u8>, stats: &AutoStats, outbox: &Outbox) -> Result<usize> {
+        let mut guard = self.slot.lock().unwrap();
+        let slot = &mut *guard;
+        let endpoint = slot.endpoint.as_ref().ok_or(ShmError::NotConnected)?;
+        let len = match endpoint.read_message(buffer) {
+            Err(ShmError::QueueEmpty) => {
+                pull_broadcast(&mut slot.fanout, &mut slot.scratch, 1, usize::MAX, stats)?;
+                let payload = slot.scratch.get(0).unwrap_or_default();
+                buffer.clear();
+                buffer.extend_from_slice(payload);
+                payload.len()
+            }
+            Err(ShmError::Corrupted) => return Err(self.fail(outbox)),
+            other => other?,
+        };
+        stats.received_messages.fetch_add(1, Ordering::Relaxed);
+        stats.channel.record_batch(1);
+        Ok(len)
+    }
+
+    fn receive_batch(
+        &self,
+        batch: &mut MessageBatch,
+        max_messages: usize,
+        max_bytes: usize,
+        stats: &AutoStats,
+        outbox: &Outbox,
+    ) -> Result<usize> {
+        let max_messages = max_messages.max(1);
+        let mut guard = self.slot.lock().unwrap();
+        let slot = &mut *guard;
+        let endpoint = slot.endpoint.as_ref().ok_or(ShmError::NotConnected)?;
+        let count = match endpoint.read_batch(batch, max_messages, max_bytes) {
+            Err(ShmError::QueueEmpty) => {
+                pull_broadcast(&mut slot.fanout, batch, max_messages, max_bytes, stats)?
+            }
+            Err(ShmError::Corrupted) => return Err(self.fail(outbox)),
+            other => other?,
+        };
+        stats
+            .received_messages
+            .fetch_add(count as u64, Ordering::Relaxed);
+        stats.channel.record_batch(count);
+        Ok(count)
+    }
+
+    /// Активное ожидание входящих по `strategy` под блокировкой слота:
+    /// бюджет — микросекунды, а worker берёт её только при смене соединения.
+    fn spin_wait(&self, strategy: &WaitStrategy) -> bool {
+        let slot = self.slot.lock().unwrap();
+        slot.endpoint
+            .as_ref()
+            .map_or(false, |endpoint| endpoint.spin_wait(strategy))
+    }
+
+    fn fail(&self, outbox: &Outbox) -> ShmError {
+        self.fault.store(true, Ordering::Release);
+        let _ = outbox.wake.set();
+        ShmError::Corrupted
     }
 }
 
+impl<E: ReceiveEndpoint + SendEndpoint> Inbox<E> {
+    /// Запись в исходящее кольцо на потоке вызывающего. Блокировка слота
+    /// заодно сериализует нескольких вызывающих: producer у кольца один.
+    fn send(&self, data: &[u8], stats: &AutoStats) -> Result<()> {
+        let slot = self.slot.lock().unwrap();
+        let endpoint = slot.endpoint.as_ref().ok_or(ShmError::NotConnected)?;
+        let outcome = endpoint.write(data, None)?;
+        stats.sent_messages.fetch_add(1, Ordering::Relaxed);
+        stats
+            .send_overflows
+            .fetch_add(outcome.overwritten as u64, Ordering::Relaxed);
+        Ok(())
+    }
+}
+
+/// Пачка из broadcast-секции для pull-режима, когда кольцо пусто.
+fn pull_broadcast(
+    fanout: &mut Option<BroadcastReceiver>,
+    batch: &mut MessageBatch,
+    max_messages: usize,
+    max_bytes: usize,
+    stats: &AutoStats,
+) -> Result<usize> {
+    let Some(receiver) = fanout.as_mut() else {
+        return Err(ShmError::QueueEmpty);
+    };
+    match receiver.receive_batch(batch, max_messages, max_bytes) {
+        Ok((count, dropped)) => {
+            stats
+                .receive_overflows
+                .fetch_add(dropped, Ordering::Relaxed);
+            if count == 0 {
+                Err(ShmError::QueueEmpty)
+            } else {
+                Ok(count)
+            }
+        }
+        Err(ShmError::QueueEmpty) => Err(ShmError::QueueEmpty),
+        Err(err) => {
+            // Секция повреждена — дальше только собственное кольцо.
+            *fanout = None;
+            Err(err)
+        }
+    }
+}
+
+/// Endpoint в единоличном владении worker-а: в pull-режиме сначала
+/// забирается у вызывающего.
+fn exclusive<'a, E: ReceiveEndpoint>(
+    endpoint: &'a mut Arc<E>,
+    inbox: Option<&Inbox<E>>,
+) -> &'a mut E {
+    if let Some(inbox) = inbox {
+        inbox.withdraw();
+    }
+    Arc::get_mut(endpoint).expect("endpoint is shared only through the inbox")
+}
+
+/// Pull-приём недоступен: объект создан без `AutoOptions::pull`.
+const NOT_PULL: ShmError = ShmError::InvalidConfig("receive requires AutoOptions::pull");
+
 pub struct AutoServer {
-    cmd_tx: Sender<WorkerCommand>,
+    outbox: Arc<Outbox>,
     join: Mutex<Option<JoinHandle<()>>>,
     stats: Arc<AutoStats>,
     running: Arc<AtomicBool>,
+    /// Предел размера сообщения из геометрии канала (проверяется до очереди).
+    max_message_size: usize,
+    /// Своя копия события `s2c.data`: будит клиента после публикации в
+    /// broadcast-секции, не трогая `SharedServer` worker-потока.
+    client_data: EventHandle,
+    inbox: Option<Arc<Inbox<SharedServer>>>,
+    /// Pull-режим: своя копия события `s2c.space` для `send_direct_with`.
+    space: Option<EventHandle>,
 }
 
 impl AutoServer {
     pub fn start(name: &str, handler: Arc<dyn AutoHandler>, options: AutoOptions) -> Result<Self> {
-        let mut server = SharedServer::start(name)?;
-        let (tx, rx) = mpsc::channel();
+        let server = SharedServer::start_with(name, &options.geometry)?;
+        Self::start_on(name, server, handler, options)
+    }
+
+    /// Как `start`, но поверх уже созданного канала `name` (запас
+    /// dispatch-сервера); геометрия `server` должна совпадать с
+    /// `options.geometry`.
+    pub(crate) fn start_on(
+        name: &str,
+        mut server: SharedServer,
+        handler: Arc<dyn AutoHandler>,
+        options: AutoOptions,
+    ) -> Result<Self> {
         let stats = Arc::new(AutoStats::default());
+        server.set_overflow_policy(ring_policy(options.overflow));
+        server.set_tracing(options.trace);
+        server.set_stats(stats.channel.clone());
+        let client_data = EventHandle::open(&event_name(
+            name,
+            Direction::ServerToClient,
+            EVENT_DATA_SUFFIX,
+        ))?;
+        let max_message_size = options.geometry.max_message_size;
+        let outbox = Arc::new(Outbox::new(&options)?);
+        let join_outbox = outbox.clone();
+        let inbox = if options.pull {
+            let ready = EventHandle::open(&event_name(
+                name,
+                Direction::ClientToServer,
+                EVENT_DATA_SUFFIX,
+            ))?;
+            Some(Arc::new(Inbox::new(ready)))
+        } else {
+            None
+        };
+        let space = if options.pull {
+            Some(EventHandle::open(&event_name(
+                name,
+                Direction::ServerToClient,
+                EVENT_SPACE_SUFFIX,
+            ))?)
+        } else {
+            None
+        };
+        let join_inbox = inbox.clone();
         let running = Arc::new(AtomicBool::new(true));
         let join_running = running.clone();
         let join_stats = stats.clone();
@@ -185,20 +605,25 @@ impl AutoServer {
             .spawn(move || {
                 server_worker(
                     &name_str,
-                    &mut server,
+                    Arc::new(server),
                     join_handler,
                     options,
-                    rx,
+                    &join_outbox,
+                    join_inbox.as_deref(),
                     join_stats,
                     join_running,
                 );
             })
             .map_err(|err| map_spawn_error(err, "spawn server worker"))?;
         Ok(Self {
-            cmd_tx: tx,
+            outbox,
             join: Mutex::new(Some(join)),
             stats,
             running,
+            max_message_size,
+            client_data,
+            inbox,
+            space,
         })
     }
 
@@ -206,25 +631,97 @@ impl AutoServer {
         if !self.running.load(Ordering::Acquire) {
             return Err(ShmError::NotReady);
         }
-        let msg = data.to_vec();
-        self.cmd_tx
-            .send(WorkerCommand::Send(msg))
-            .map_err(|_| ShmError::NotReady)
+        if data.len() > self.max_message_size {
+            return Err(ShmError::MessageTooLarge);
+        }
+        self.outbox.push(self.outbox.message(data), &self.running)
     }
 
     pub fn stop(&self) {
-        let _ = self.cmd_tx.send(WorkerCommand::Shutdown);
+        self.running.store(false, Ordering::Release);
+        self.outbox.wake();
     }
 
     pub fn stats(&self) -> AutoStatsSnapshot {
         self.stats.snapshot()
     }
+
+    /// Pull-режим: забирает сообщение клиента в `buffer` на потоке
+    /// вызывающего. `QueueEmpty` — входящих нет, можно ждать `wait_handle`;
+    /// `NotConnected` — клиента сейчас нет.
+    pub fn receive(&self, buffer: &mut Vec<u8>) -> Result<usize> {
+        let inbox = self.inbox.as_deref().ok_or(NOT_PULL)?;
+        inbox.receive(buffer, &self.stats, &self.outbox)
+    }
+
+    /// Pull-режим: до `max_messages` сообщений одним сдвигом `read_pos`
+    /// (см. [`SharedServer::receive_batch_from_client`]).
+    pub fn receive_batch(
+        &self,
+        batch: &mut MessageBatch,
+        max_messages: usize,
+        max_bytes: usize,
+    ) -> Result<usize> {
+        let inbox = self.inbox.as_deref().ok_or(NOT_PULL)?;
+        inbox.receive_batch(batch, max_messages, max_bytes, &self.stats, &self.outbox)
+    }
+
+    /// Pull-режим: auto-reset событие, по которому стоит повторить
+    /// `receive`. Сигналится, только когда данные приходят в опустошённое
+    /// кольцо, поэтому перед ожиданием нужно дочитать до `QueueEmpty`.
+    /// Живёт, пока жив `AutoServer`.
+    pub fn wait_handle(&self) -> Option<isize> {
+        self.inbox.as_deref().map(|inbox| inbox.ready.raw_handle())
+    }
+
+    /// Pull-режим: запись в кольцо клиента прямо на потоке вызывающего,
+    /// без очереди и пробуждения worker-а. Нельзя смешивать с `send`: у
+    /// кольца должен остаться один producer. Полное кольцо — `QueueFull`
+    /// (кроме `OverflowPolicy::Overwrite`).
+    pub(crate) fn send_direct(&self, data: &[u8]) -> Result<()> {
+        let inbox = self.inbox.as_deref().ok_or(NOT_PULL)?;
+        if !self.running.load(Ordering::Acquire) {
+            return Err(ShmError::NotReady);
+        }
+        if data.len() > self.max_message_size {
+            return Err(ShmError::MessageTooLarge);
+        }
+        inbox.send(data, &self.stats)
+    }
+
+    /// `send_direct`, который при полном кольце ждёт места по `policy` (см.
+    /// [`write_with_backpressure`]) на событии `s2c.space`. Событие делит с
+    /// worker-ом, поэтому одно ожидание — не дольше `SHARED_SPACE_NAP`: так
+    /// и остановка канала замечается за миллисекунду.
+    pub(crate) fn send_direct_with(&self, data: &[u8], policy: OverflowPolicy) -> Result<()> {
+        let space = self.space.as_ref().ok_or(NOT_PULL)?;
+        write_with_backpressure(policy, Some(space), Some(SHARED_SPACE_NAP), || {
+            self.send_direct(data)
+        })
+    }
+
+    /// Pull-режим: крутится по `strategy`, пока клиент не пришлёт данные
+    /// (см. [`SharedServer::spin_wait_client`]); без клиента — сразу `false`.
+    pub(crate) fn spin_wait(&self, strategy: &WaitStrategy) -> bool {
+        self.inbox
+            .as_deref()
+            .map_or(false, |inbox| inbox.spin_wait(strategy))
+    }
+
+    /// Будит клиента после записи в broadcast-секцию. Без клиента событие
+    /// просто останется взведённым — лишний проход worker'а безвреден.
+    pub(crate) fn notify_client(&self) -> Result<()> {
+        if !self.running.load(Ordering::Acquire) {
+            return Err(ShmError::NotReady);
+        }
+        self.client_data.set()
+    }
 }
 
 impl Drop for AutoServer {
     fn drop(&mut self) {
         self.running.store(false, Ordering::Release);
-        let _ = self.cmd_tx.send(WorkerCommand::Shutdown);
+        self.outbox.wake();
         if let Some(handle) = self.join.lock().unwrap().take() {
             join_unless_self(handle);
         }
@@ -232,109 +729,152 @@ impl Drop for AutoServer {
 }
 
 fn server_worker(
-    _name: &str,
-    server: &mut SharedServer,
+    name: &str,
+    mut server: Arc<SharedServer>,
     handler: Arc<dyn AutoHandler>,
     options: AutoOptions,
-    cmd_rx: Receiver<WorkerCommand>,
+    outbox: &Outbox,
+    inbox: Option<&Inbox<SharedServer>>,
     stats: Arc<AutoStats>,
     running: Arc<AtomicBool>,
 ) {
-    let send_queue = SendQueue::new();
-    let mut buffer = Vec::with_capacity(MAX_MESSAGE_SIZE);
+    // Сообщение, которое кольцо не приняло, ждёт здесь, а не в голове
+    // lock-free очереди (push_front в ней невозможен).
+    let mut retry: Option<Vec<u8>> = None;
+    let mut batch = MessageBatch::with_capacity(MAX_MESSAGE_SIZE, options.recv_batch);
+    let mut sizer = AdaptiveBatch::new(options.recv_batch, options.recv_budget);
     // Anonymous режим не поддерживается в auto-mode
     let server_events = server
         .events()
         .expect("Anonymous mode not supported in auto-mode");
+    // `c2s.data` — последним: в pull-режиме его ждёт поток вызывающего.
     let handles = [
         server_events.disconnect.raw_handle(),
-        server_events.c2s.data.raw_handle(),
         server_events.s2c.space.raw_handle(),
+        outbox.wake.raw_handle(),
+        server_events.c2s.data.raw_handle(),
     ];
+    let wait_set = if inbox.is_some() {
+        &handles[..3]
+    } else {
+        &handles[..]
+    };
 
     let mut connected = false;
+    // Проход после пробуждения по `c2s.data` — для счёта ложных пробуждений.
+    let mut woken = false;
 
     while running.load(Ordering::Acquire) {
         if !connected {
-            match server.wait_for_client(Some(options.poll_timeout)) {
+            match exclusive(&mut server, inbox).wait_for_client(Some(options.poll_timeout)) {
                 Ok(_) => {
                     connected = true;
                     handler.on_connect();
+                    trace::connected(name, NO_CLIENT);
+                    if let Some(inbox) = inbox {
+                        inbox.publish(server.clone(), None);
+                    }
                 }
-                Err(ShmError::Timeout) => {
-                    drain_commands(&send_queue, &cmd_rx, &options, &running);
-                    continue;
-                }
+                Err(ShmError::Timeout) => continue,
                 Err(err) => {
                     handler.on_error(err.clone());
-                    drain_commands(&send_queue, &cmd_rx, &options, &running);
                     continue;
                 }
             }
         }
 
-        drain_commands(&send_queue, &cmd_rx, &options, &running);
-
-        if !connected {
-            continue;
-        }
-
         process_send_queue(
-            server,
-            &send_queue,
+            name,
+            &*server,
+            outbox,
+            &mut retry,
             &handler,
             &stats,
             ChannelKind::ServerToClient,
         );
+        outbox.release_senders();
 
-        let outcome = process_receive_queue(
-            server,
-            &handler,
-            &stats,
-            &mut buffer,
-            options.recv_batch,
-            ChannelKind::ClientToServer,
-        );
-        if outcome.fatal {
-            handler.on_disconnect();
-            server.mark_disconnected();
-            connected = false;
-            continue;
+        if let Some(inbox) = inbox {
+            if inbox.take_fault() {
+                handler.on_error(ShmError::Corrupted);
+                handler.on_disconnect();
+                trace::disconnected(name, NO_CLIENT);
+                exclusive(&mut server, Some(inbox)).mark_disconnected();
+                connected = false;
+                continue;
+            }
+        } else {
+            let started = sizer.begin();
+            let outcome = process_receive_queue(
+                &*server,
+                &handler,
+                &stats,
+                &mut batch,
+                sizer.limit(),
+                ChannelKind::ClientToServer,
+            );
+            sizer.finish(started, outcome.received);
+            if std::mem::take(&mut woken) {
+                stats.channel.record_wakeup(outcome.received == 0);
+            }
+            if outcome.fatal {
+                handler.on_disconnect();
+                trace::disconnected(name, NO_CLIENT);
+                exclusive(&mut server, inbox).mark_disconnected();
+                connected = false;
+                continue;
+            }
+            if outcome.more_pending || server.spin_wait_client(&options.wait) {
+                // Ещё есть данные — не блокируемся, сразу следующий проход.
+                continue;
+            }
         }
-        if outcome.more_pending {
-            // Ещё есть данные — не блокируемся, сразу следующий проход.
+        // Голова очереди ждёт места в кольце (`retry`) — новые сообщения
+        // её не сдвинут, спим до `space`, а не до первого `send()`.
+        if retry.is_none() && !outbox.park() {
             continue;
         }
 
-        match win::wait_any(&handles, Some(options.poll_timeout)) {
+        let signaled = win::wait_any(wait_set, Some(options.poll_timeout));
+        outbox.unpark();
+        match signaled {
             Ok(Some(0)) => {
                 handler.on_disconnect();
-                server.mark_disconnected();
+                trace::disconnected(name, NO_CLIENT);
+                exclusive(&mut server, inbox).mark_disconnected();
                 connected = false;
             }
             Ok(Some(1)) => {
+                handler.on_space_available(ChannelKind::ServerToClient);
+            }
+            Ok(Some(3)) => {
                 // data available, loop will read
+                woken = true;
             }
-            Ok(Some(2)) => {
-                handler.on_space_available(ChannelKind::ServerToClient);
+            Ok(Some(_)) => {
+                // wake — в очереди отправки новые сообщения
             }
-            Ok(Some(_)) => {}
             Ok(None) => {}
             Err(err) => {
                 handler.on_error(err.clone());
                 handler.on_disconnect();
-                server.mark_disconnected();
+                trace::disconnected(name, NO_CLIENT);
+                exclusive(&mut server, inbox).mark_disconnected();
                 connected = false;
             }
         }
     }
+    if let Some(inbox) = inbox {
+        inbox.withdraw();
+    }
 }
 
 pub struct AutoClient {
-    cmd_tx: Sender<WorkerCommand>,
+    outbox: Arc<Outbox>,
     join: Mutex<Option<JoinHandle<()>>>,
     stats: Arc<AutoStats>,
     running: Arc<AtomicBool>,
+    inbox: Option<Arc<Inbox<SharedClient>>>,
 }
 
 impl AutoClient {
@@ -343,7 +883,14 @@ impl AutoClient {
         handler: Arc<dyn AutoHandler>,
         options: AutoOptions,
     ) -> Result<Self> {
-        let (tx, rx) = mpsc::channel();
+        let outbox = Arc::new(Outbox::new(&options)?);
+        let join_outbox = outbox.clone();
+        let inbox = if options.pull {
+            Some(Arc::new(Inbox::new(EventHandle::create_local()?)))
+        } else {
+            None
+        };
+        let join_inbox = inbox.clone();
         let stats = Arc::new(AutoStats::default());
         let running = Arc::new(AtomicBool::new(true));
         let join_stats = stats.clone();
@@ -358,7 +905,8 @@ impl AutoClient {
                     &name_str,
                     handler_clone,
                     options,
-                    rx,
+                    &join_outbox,
+                    join_inbox.as_deref(),
                     join_stats,
                     join_running,
                 );
@@ -366,10 +914,11 @@ impl AutoClient {
             .map_err(|err| map_spawn_error(err, "spawn client worker"))?;
 
         Ok(Self {
-            cmd_tx: tx,
+            outbox,
             join: Mutex::new(Some(join)),
             stats,
             running,
+            inbox,
         })
     }
 
@@ -377,25 +926,67 @@ impl AutoClient {
         if !self.running.load(Ordering::Acquire) {
             return Err(ShmError::NotReady);
         }
-        let msg = data.to_vec();
-        self.cmd_tx
-            .send(WorkerCommand::Send(msg))
-            .map_err(|_| ShmError::NotReady)
+        self.outbox.push(self.outbox.message(data), &self.running)
     }
 
     pub fn stop(&self) {
-        let _ = self.cmd_tx.send(WorkerCommand::Shutdown);
+        self.running.store(false, Ordering::Release);
+        self.outbox.wake();
     }
 
     pub fn stats(&self) -> AutoStatsSnapshot {
         self.stats.snapshot()
     }
+
+    /// Pull-режим: сообщение сервера (из кольца, затем из broadcast-секции)
+    /// на потоке вызывающего (см. [`AutoServer::receive`]).
+    pub fn receive(&self, buffer: &mut Vec<u8>) -> Result<usize> {
+        let inbox = self.inbox.as_deref().ok_or(NOT_PULL)?;
+        inbox.receive(buffer, &self.stats, &self.outbox)
+    }
+
+    /// Pull-режим: пачка сообщений сервера (см. [`AutoServer::receive_batch`]).
+    pub fn receive_batch(
+        &self,
+        batch: &mut MessageBatch,
+        max_messages: usize,
+        max_bytes: usize,
+    ) -> Result<usize> {
+        let inbox = self.inbox.as_deref().ok_or(NOT_PULL)?;
+        inbox.receive_batch(batch, max_messages, max_bytes, &self.stats, &self.outbox)
+    }
+
+    /// Pull-режим: событие готовности (см. [`AutoServer::wait_handle`]).
+    /// Одно на всё время жизни клиента, переподключения его не меняют;
+    /// взводит его worker, поэтому пробуждение на один переход дольше, чем
+    /// у сервера.
+    pub fn wait_handle(&self) -> Option<isize> {
+        self.inbox.as_deref().map(|inbox| inbox.ready.raw_handle())
+    }
+
+    /// Pull-режим: запись в кольцо сервера на потоке вызывающего (см.
+    /// [`AutoServer::send_direct`]).
+    pub(crate) fn send_direct(&self, data: &[u8]) -> Result<()> {
+        let inbox = self.inbox.as_deref().ok_or(NOT_PULL)?;
+        if !self.running.load(Ordering::Acquire) {
+            return Err(ShmError::NotReady);
+        }
+        inbox.send(data, &self.stats)
+    }
+
+    /// Pull-режим: активное ожидание данных сервера в кольце (broadcast-
+    /// секция не проверяется).
+    pub(crate) fn spin_wait(&self, strategy: &WaitStrategy) -> bool {
+        self.inbox
+            .as_deref()
+            .map_or(false, |inbox| inbox.spin_wait(strategy))
+    }
 }
 
 impl Drop for AutoClient {
     fn drop(&mut self) {
         self.running.store(false, Ordering::Release);
-        let _ = self.cmd_tx.send(WorkerCommand::Shutdown);
+        self.outbox.wake();
         if let Some(handle) = self.join.lock().unwrap().take() {
             join_unless_self(handle);
         }
@@ -406,14 +997,24 @@ fn client_worker(
     name: &str,
     handler: Arc<dyn AutoHandler>,
     options: AutoOptions,
-    cmd_rx: Receiver<WorkerCommand>,
+    outbox: &Outbox,
+    inbox: Option<&Inbox<SharedClient>>,
     stats: Arc<AutoStats>,
     running: Arc<AtomicBool>,
 ) {
-    let send_queue = SendQueue::new();
-    let mut buffer = Vec::with_capacity(MAX_MESSAGE_SIZE);
+    // Сообщение, которое кольцо не приняло, ждёт здесь, а не в голове
+    // lock-free очереди (push_front в ней невозможен).
+    let mut retry: Option<Vec<u8>> = None;
+    let mut batch = MessageBatch::with_capacity(MAX_MESSAGE_SIZE, options.recv_batch);
+    let mut sizer = AdaptiveBatch::new(options.recv_batch, options.recv_budget);
 
     while running.load(Ordering::Acquire) {
+        // Открываем до handshake: курсор встаёт на текущий хвост, и всё, что
+        // сервер опубликует после подключения, гарантированно будет видно.
+        let mut fanout = options
+            .broadcast
+            .as_deref()
+            .and_then(|base| BroadcastReceiver::open(base).ok());
         let mut client = match SharedClient::connect(name, options.connect_timeout) {
             Ok(client) => client,
             Err(err) => {
@@ -425,63 +1026,131 @@ fn client_worker(
             }
         };
 
+        client.set_overflow_policy(ring_policy(options.overflow));
+        client.set_tracing(options.trace);
+        client.set_stats(stats.channel.clone());
+        let mut client = Arc::new(client);
         handler.on_connect();
+        trace::connected(name, NO_CLIENT);
         // SharedClient всегда использует named events (не anonymous)
         let client_events = client.events();
         let handles = [
             client_events.disconnect.raw_handle(),
             client_events.s2c.data.raw_handle(),
             client_events.c2s.space.raw_handle(),
+            outbox.wake.raw_handle(),
         ];
+        if let Some(inbox) = inbox {
+            inbox.publish(client.clone(), fanout.take());
+        }
 
+        let mut woken = false;
         loop {
             if !running.load(Ordering::Acquire) {
                 break;
             }
 
-            drain_commands(&send_queue, &cmd_rx, &options, &running);
             process_send_queue(
-                &client,
-                &send_queue,
+                name,
+                &*client,
+                outbox,
+                &mut retry,
                 &handler,
                 &stats,
                 ChannelKind::ClientToServer,
             );
-            let outcome = process_receive_queue(
-                &client,
-                &handler,
-                &stats,
-                &mut buffer,
-                options.recv_batch,
-                ChannelKind::ServerToClient,
-            );
-            if outcome.fatal {
-                handler.on_disconnect();
-                client.mark_disconnected();
-                break;
+            outbox.release_senders();
+            if let Some(inbox) = inbox {
+                if inbox.take_fault() {
+                    handler.on_error(ShmError::Corrupted);
+                    handler.on_disconnect();
+                    trace::disconnected(name, NO_CLIENT);
+                    exclusive(&mut client, Some(inbox)).mark_disconnected();
+                    break;
+                }
+            } else {
+                let started = sizer.begin();
+                let limit = sizer.limit();
+                let outcome = process_receive_queue(
+                    &*client,
+                    &handler,
+                    &stats,
+                    &mut batch,
+                    limit,
+                    ChannelKind::ServerToClient,
+                );
+                if outcome.fatal {
+                    handler.on_disconnect();
+                    trace::disconnected(name, NO_CLIENT);
+                    exclusive(&mut client, inbox).mark_disconnected();
+                    break;
+                }
+                let mut more_pending = outcome.more_pending;
+                let mut received = outcome.received;
+                if let Some(receiver) = fanout.as_mut() {
+                    match process_broadcast(name, receiver, &handler, &stats, &mut batch, limit) {
+                        Ok(count) => {
+                            more_pending |= count >= limit;
+                            received += count;
+                        }
+                        Err(err) => {
+                            // Секция повреждена — дальше только собственное кольцо.
+                            handler.on_error(err);
+                            fanout = None;
+                        }
+                    }
+                }
+                sizer.finish(started, received);
+                // s2c.data будит и для кольца, и для broadcast-секции
+                if std::mem::take(&mut woken) {
+                    stats.channel.record_wakeup(received == 0);
+                }
+                if more_pending || client.spin_wait_server(&options.wait) {
+                    continue;
+                }
+                if fanout
+                    .as_ref()
+                    .map_or(false, BroadcastReceiver::has_pending)
+                {
+                    continue;
+                }
             }
-            if outcome.more_pending {
+            if retry.is_none() && !outbox.park() {
                 continue;
             }
 
-            match win::wait_any(&handles, Some(options.poll_timeout)) {
+            let signaled = win::wait_any(&handles, Some(options.poll_timeout));
+            outbox.unpark();
+            match signaled {
                 Ok(Some(0)) => {
                     handler.on_disconnect();
-                    client.mark_disconnected();
+                    trace::disconnected(name, NO_CLIENT);
+                    exclusive(&mut client, inbox).mark_disconnected();
                     break;
                 }
-                Ok(Some(1)) => {}
+                Ok(Some(1)) => match inbox {
+                    // события клиента живут до переподключения — вызывающий
+                    // ждёт своё, постоянное
+                    Some(inbox) => {
+                        let _ = inbox.ready.set();
+                    }
+                    None => woken = true,
+                },
                 Ok(Some(2)) => handler.on_space_available(ChannelKind::ClientToServer),
                 Ok(Some(_)) => {}
                 Ok(None) => {}
                 Err(err) => {
                     handler.on_error(err.clone());
                     handler.on_disconnect();
-                    client.mark_disconnected();
+                    trace::disconnected(name, NO_CLIENT);
+                    exclusive(&mut client, inbox).mark_disconnected();
                     break;
                 }
             }
         }
+        if let Some(inbox) = inbox {
+            inbox.withdraw();
+        }
 
         if !wait_delay(&running, options.reconnect_delay) {
             break;
@@ -489,39 +1158,30 @@ fn client_worker(
     }
 }
 
-fn drain_commands(
-    queue: &SendQueue,
-    rx: &Receiver<WorkerCommand>,
-    options: &AutoOptions,
-    running: &Arc<AtomicBool>,
-) {
-    while let Ok(cmd) = rx.try_recv() {
-        match cmd {
-            WorkerCommand::Send(msg) => {
-                if queue.len() >= options.max_send_queue {
-                    // drop oldest (overwrite semantics)
-                    let _ = queue.pop();
-                }
-                queue.push(msg);
-            }
-            WorkerCommand::Shutdown => {
-                running.store(false, Ordering::Release);
-            }
-        }
+/// Политика кольца под политику `AutoOptions::overflow`: worker сам ждёт
+/// места на `space` (сообщение ждёт в `retry`), поэтому кольцу достаточно
+/// не вытеснять.
+fn ring_policy(overflow: OverflowPolicy) -> OverflowPolicy {
+    match overflow {
+        OverflowPolicy::Overwrite => OverflowPolicy::Overwrite,
+        OverflowPolicy::Fail | OverflowPolicy::Block(_) => OverflowPolicy::Fail,
     }
 }
 
 fn process_send_queue<E>(
+    name: &str,
     endpoint: &E,
-    queue: &SendQueue,
+    outbox: &Outbox,
+    retry: &mut Option<Vec<u8>>,
     handler: &Arc<dyn AutoHandler>,
     stats: &Arc<AutoStats>,
     direction: ChannelKind,
 ) where
     E: SendEndpoint,
 {
-    while let Some(msg) = queue.pop() {
-        match endpoint.write(&msg) {
+    while let Some(msg) = retry.take().or_else(|| outbox.queue.pop()) {
+        let (payload, enqueued) = outbox.split(&msg);
+        match endpoint.write(payload, enqueued) {
             Ok(outcome) => {
                 stats.sent_messages.fetch_add(1, Ordering::Relaxed);
                 if outcome.overwritten > 0 {
@@ -529,15 +1189,23 @@ fn process_send_queue<E>(
                         .send_overflows
                         .fetch_add(outcome.overwritten as u64, Ordering::Relaxed);
                     handler.on_overflow(direction, outcome.overwritten);
+                    trace::overflowed(name, NO_CLIENT, outcome.overwritten);
                 }
             }
             Err(ShmError::QueueFull) => {
-                queue.push_front(msg);
+                // Кольцо без вытеснения полно: ждём `space` от другой стороны.
+                *retry = Some(msg);
                 break;
             }
+            Err(err @ (ShmError::MessageTooSmall | ShmError::MessageTooLarge)) => {
+                // Размер не пройдёт и при повторе (у клиента предел известен
+                // только после подключения) — сообщение отбрасывается, иначе
+                // оно навсегда заблокировало бы голову очереди.
+                handler.on_error(err);
+            }
             Err(err) => {
                 handler.on_error(err.clone());
-                queue.push_front(msg);
+                *retry = Some(msg);
                 break;
             }
         }
@@ -550,85 +1218,179 @@ struct ReceiveOutcome {
     fatal: bool,
     /// Батч упёрся в лимит, в кольце вероятно ещё есть данные — не спать.
     more_pending: bool,
+    /// Сколько сообщений отдано handler-у.
+    received: usize,
 }
 
-/// Обрабатывает до `batch` сообщений за вызов.
+/// Обрабатывает до `batch` сообщений за вызов: кольцо дренится одним
+/// `read_batch` (один коммит read_pos), затем handler получает срезы арены.
 fn process_receive_queue<R>(
     endpoint: &R,
     handler: &Arc<dyn AutoHandler>,
     stats: &Arc<AutoStats>,
-    buffer: &mut Vec<u8>,
+    messages: &mut MessageBatch,
     batch: usize,
     direction: ChannelKind,
 ) -> ReceiveOutcome
 where
     R: ReceiveEndpoint,
 {
-    let mut drained = false;
-    for _ in 0..batch.max(1) {
-        match endpoint.read(buffer) {
-            Ok(len) => {
-                stats.received_messages.fetch_add(1, Ordering::Relaxed);
-                handler.on_message(direction, &buffer[..len]);
-            }
-            Err(ShmError::QueueEmpty) => {
-                drained = true;
-                break;
+    let batch = batch.max(1);
+    match endpoint.read_batch(messages, batch, usize::MAX) {
+        Ok(count) => {
+            stats
+                .received_messages
+                .fetch_add(count as u64, Ordering::Relaxed);
+            deliver(handler, stats, messages, direction);
+            ReceiveOutcome {
+                fatal: false,
+                more_pending: count >= batch,
+                received: count,
             }
-            Err(ShmError::NotConnected) | Err(ShmError::NotReady) | Err(ShmError::Timeout) => {
-                drained = true;
-                break;
+        }
+        Err(ShmError::QueueEmpty)
+        | Err(ShmError::NotConnected)
+        | Err(ShmError::NotReady)
+        | Err(ShmError::Timeout) => ReceiveOutcome {
+            fatal: false,
+            more_pending: false,
+            received: 0,
+        },
+        Err(ref err @ ShmError::Corrupted) => {
+            handler.on_error(err.clone());
+            ReceiveOutcome {
+                fatal: true,
+                more_pending: false,
+                received: 0,
             }
-            Err(ref err @ ShmError::Corrupted) => {
-                handler.on_error(err.clone());
-                return ReceiveOutcome {
-                    fatal: true,
-                    more_pending: false,
-                };
+        }
+        Err(err) => {
+            handler.on_error(err.clone());
+            ReceiveOutcome {
+                fatal: false,
+                more_pending: false,
+                received: 0,
             }
-            Err(err) => {
-                handler.on_error(err.clone());
-                drained = true;
-                break;
+        }
+    }
+}
+
+/// Один батч из broadcast-секции; возвращает число принятых сообщений.
+fn process_broadcast(
+    name: &str,
+    receiver: &mut BroadcastReceiver,
+    handler: &Arc<dyn AutoHandler>,
+    stats: &Arc<AutoStats>,
+    messages: &mut MessageBatch,
+    batch: usize,
+) -> Result<usize> {
+    let batch = batch.max(1);
+    match receiver.receive_batch(messages, batch, usize::MAX) {
+        Ok((count, dropped)) => {
+            if dropped > 0 {
+                stats
+                    .receive_overflows
+                    .fetch_add(dropped, Ordering::Relaxed);
+                let dropped = dropped.min(u32::MAX as u64) as u32;
+                handler.on_overflow(ChannelKind::ServerToClient, dropped);
+                trace::overflowed(name, NO_CLIENT, dropped);
             }
+            stats
+                .received_messages
+                .fetch_add(count as u64, Ordering::Relaxed);
+            deliver(handler, stats, messages, ChannelKind::ServerToClient);
+            Ok(count)
         }
+        Err(ShmError::QueueEmpty) => Ok(0),
+        Err(err) => Err(err),
     }
-    ReceiveOutcome {
-        fatal: false,
-        more_pending: !drained,
+}
+
+/// Раздаёт пачку handler-у, записывая её размер и время в callback-ах.
+fn deliver(
+    handler: &Arc<dyn AutoHandler>,
+    stats: &AutoStats,
+    messages: &MessageBatch,
+    direction: ChannelKind,
+) {
+    if messages.is_empty() {
+        return;
     }
+    stats.channel.record_batch(messages.len());
+    stats.channel.time_handler(|| {
+        for (index, data) in messages.iter().enumerate() {
+            match messages.trace(index) {
+                Some(trace) => handler.on_traced_message(direction, data, trace),
+                None => handler.on_message(direction, data),
+            }
+        }
+    });
 }
 
 trait SendEndpoint {
-    fn write(&self, data: &[u8]) -> Result<crate::ring::WriteOutcome>;
+    /// `enqueued` — метка постановки в очередь трассируемого сообщения.
+    fn write(&self, data: &[u8], enqueued: Option<u64>) -> Result<crate::ring::WriteOutcome>;
 }
 
 trait ReceiveEndpoint {
-    fn read(&self, buffer: &mut Vec<u8>) -> Result<usize>;
+    fn read_message(&self, buffer: &mut Vec<u8>) -> Result<usize>;
+    fn read_batch(
+        &self,
+        batch: &mut MessageBatch,
+        max_messages: usize,
+        max_bytes: usize,
+    ) -> Result<usize>;
+    fn spin_wait(&self, strategy: &WaitStrategy) -> bool;
 }
 
 impl SendEndpoint for SharedServer {
-    fn write(&self, data: &[u8]) -> Result<crate::ring::WriteOutcome> {
-        self.send_to_client(data)
+    fn write(&self, data: &[u8], enqueued: Option<u64>) -> Result<crate::ring::WriteOutcome> {
+        self.send_to_client_at(data, enqueued)
     }
 }
 
 impl ReceiveEndpoint for SharedServer {
-    fn read(&self, buffer: &mut Vec<u8>) -> Result<usize> {
+    fn read_message(&self, buffer: &mut Vec<u8>) -> Result<usize> {
         self.receive_from_client(buffer)
     }
+
+    fn read_batch(
+        &self,
+        batch: &mut MessageBatch,
+        max_messages: usize,
+        max_bytes: usize,
+    ) -> Result<usize> {
+        self.receive_batch_from_client(batch, max_messages, max_bytes)
+    }
+
+    fn spin_wait(&self, strategy: &WaitStrategy) -> bool {
+        self.spin_wait_client(strategy)
+    }
 }
 
 impl SendEndpoint for SharedClient {
-    fn write(&self, data: &[u8]) -> Result<crate::ring::WriteOutcome> {
-        self.send_to_server(data)
+    fn write(&self, data: &[u8], enqueued: Option<u64>) -> Result<crate::ring::WriteOutcome> {
+        self.send_to_server_at(data, enqueued)
     }
 }
 
 impl ReceiveEndpoint for SharedClient {
-    fn read(&self, buffer: &mut Vec<u8>) -> Result<usize> {
+    fn read_message(&self, buffer: &mut Vec<u8>) -> Result<usize> {
         self.receive_from_server(buffer)
     }
+
+    fn read_batch(
+        &self,
+        batch: &mut MessageBatch,
+        max_messages: usize,
+        max_bytes: usize,
+    ) -> Result<usize> {
+        self.receive_batch_from_server(batch, max_messages, max_bytes)
+    }
+
+    fn spin_wait(&self, strategy: &WaitStrategy) -> bool {
+        self.spin_wait_server(strategy)
+    }
 }
 
 #[cfg(test)]
@@ -657,6 +1419,104 @@ mod tests {
     struct NoopHandler;
     impl AutoHandler for NoopHandler {}
 
+    struct CountingHandler(AtomicUsize);
+    impl AutoHandler for CountingHandler {
+        fn on_message(&self, _direction: ChannelKind, _payload: &[u8]) {
+            self.0.fetch_add(1, Ordering::Relaxed);
+        }
+    }
+
+    /// Pull-режим: входящие забирает поток теста по `wait_handle`, а
+    /// `on_message` не вызывается ни на одной из сторон.
+    #[test]
+    fn pull_mode_delivers_to_caller_thread() {
+        let name = format!("TEST_AUTO_PULL_{}", std::process::id());
+        let handler = Arc::new(CountingHandler(AtomicUsize::new(0)));
+        let options = AutoOptions {
+            pull: true,
+            ..AutoOptions::default()
+        };
+        let server = AutoServer::start(&name, handler.clone(), options.clone()).expect("start");
+        let client = AutoClient::connect(&name, handler.clone(), options).expect("connect");
+        let server_ready = server.wait_handle().expect("pull server");
+        let client_ready = client.wait_handle().expect("pull client");
+
+        for i in 0..8u8 {
+            client.send(&[i; 4]).unwrap();
+        }
+        let mut batch = MessageBatch::new();
+        let mut received = Vec::new();
+        let deadline = Instant::now() + Duration::from_secs(5);
+        while received.len() < 8 && Instant::now() < deadline {
+            match server.receive_batch(&mut batch, 4, usize::MAX) {
+                Ok(count) => {
+                    assert!(count <= 4);
+                    received.extend(batch.iter().map(|msg| msg[0]));
+                }
+                Err(ShmError::QueueEmpty | ShmError::NotConnected) => {
+                    let _ = win::wait_any(&[server_ready], Some(Duration::from_millis(50)));
+                }
+                Err(err) => panic!("server receive failed: {err}"),
+            }
+        }
+        assert_eq!(received, (0..8).collect::<Vec<u8>>());
+
+        server.send(b"pong").unwrap();
+        let mut buffer = Vec::new();
+        loop {
+            assert!(Instant::now() < deadline, "client did not receive reply");
+            match client.receive(&mut buffer) {
+                Ok(len) => {
+                    assert_eq!(&buffer[..len], b"pong");
+                    break;
+                }
+                Err(ShmError::QueueEmpty | ShmError::NotConnected) => {
+                    let _ = win::wait_any(&[client_ready], Some(Duration::from_millis(50)));
+                }
+                Err(err) => panic!("client receive failed: {err}"),
+            }
+        }
+        assert_eq!(handler.0.load(Ordering::Relaxed), 0);
+        assert_eq!(server.stats().received_messages, 8);
+        assert_eq!(client.stats().received_messages, 1);
+    }
+
+    struct TracingHandler(Mutex<Vec<MessageTrace>>);
+    impl AutoHandler for TracingHandler {
+        fn on_traced_message(&self, _direction: ChannelKind, _payload: &[u8], trace: MessageTrace) {
+            self.0.lock().unwrap().push(trace);
+        }
+    }
+
+    /// С `AutoOptions::trace` метка ставится при `send` и доходит до
+    /// `on_traced_message` с последовательными номерами.
+    #[test]
+    fn traced_messages_reach_handler_in_sequence() {
+        let name = format!("TEST_AUTO_TRACE_{}", std::process::id());
+        let handler = Arc::new(TracingHandler(Mutex::new(Vec::new())));
+        let options = AutoOptions {
+            trace: true,
+            ..AutoOptions::default()
+        };
+        let server = AutoServer::start(&name, handler.clone(), options.clone()).expect("start");
+        let client = AutoClient::connect(&name, Arc::new(NoopHandler), options).expect("connect");
+        for i in 0..4u8 {
+            client.send(&[i; 8]).unwrap();
+        }
+        let deadline = Instant::now() + Duration::from_secs(5);
+        while handler.0.lock().unwrap().len() < 4 {
+            assert!(Instant::now() < deadline, "traced messages not delivered");
+            std::thread::sleep(Duration::from_millis(5));
+        }
+        let traces = handler.0.lock().unwrap();
+        for pair in traces.windows(2) {
+            assert_eq!(pair[1].sequence, pair[0].sequence.wrapping_add(1));
+            assert!(pair[1].enqueued >= pair[0].enqueued);
+        }
+        drop(traces);
+        assert!(server.stats().channel.queue_delay_ns.count >= 4);
+    }
+
     /// Регрессия (аудит 2026-07-10): `Drop for AutoServer`/`AutoClient`
     /// раньше безусловно джойнил `worker_handle` -- если Drop вызывается ИЗ
     /// СОБСТВЕННОГО worker-потока (пользовательский `AutoHandler` синхронно
@@ -0,0 +1,231 @@
+//! Ограниченная lock-free очередь отправки auto-режима.
+//!
+//! Массив ячеек с порядковыми номерами (схема Вьюкова): producer и consumer
+//! резервируют позицию одним CAS, а готовность ячейки публикуется её `seq`.
+//! Писать могут любые потоки процесса, читает worker — но при переполнении
+//! producer сам вытесняет самое старое сообщение, поэтому `pop` тоже
+//! многопоточный.
+
+use std::cell::UnsafeCell;
+use std::mem::MaybeUninit;
+use std::sync::atomic::{AtomicUsize, Ordering};
+
+/// Индекс на отдельной кэш-линии: `head` пишет worker, `tail` — отправители.
+#[repr(align(64))]
+struct PaddedIndex(AtomicUsize);
+
+struct Cell {
+    /// `2 * pos` — ячейка свободна для записи позиции `pos`; `2 * pos + 1` —
+    /// в ней лежит сообщение позиции `pos`. Удвоение нужно, чтобы состояния
+    /// не совпадали при очереди из одной ячейки.
+    seq: AtomicUsize,
+    value: UnsafeCell<MaybeUninit<Vec<u8>>>,
+}
+
+pub(crate) struct SendQueue {
+    head: PaddedIndex,
+    tail: PaddedIndex,
+    cells: Box<[Cell]>,
+}
+
+unsafe impl Send for SendQueue {}
+unsafe impl Sync for SendQueue {}
+
+impl SendQueue {
+    /// Очередь ровно на `bound` сообщений (не меньше одного — как и прежний
+    /// `VecDeque`, который при `max_send_queue = 0` хранил последнее).
+    pub(crate) fn new(bound: usize) -> Self {
+        let cells = (0..bound.max(1))
+            .map(|i| Cell {
+                seq: AtomicUsize::new(2 * i),
+                value: UnsafeCell::new(MaybeUninit::uninit()),
+            })
+            .collect();
+        Self {
+            head: PaddedIndex(AtomicUsize::new(0)),
+            tail: PaddedIndex(AtomicUsize::new(0)),
+            cells,
+        }
+    }
+
+    /// Ставит сообщение в хвост; если очередь полна — выбрасывает самое
+    /// старое (overwrite-семантика, как у колец).
+    pub(crate) fn push(&self, mut msg: Vec<u8>) {
+        loop {
+            match self.try_push(msg) {
+                Ok(()) => return,
+                Err(rejected) => {
+                    msg = rejected;
+                    drop(self.pop());
+                }
+            }
+        }
+    }
+
+    /// Ставит сообщение в хвост, если есть место; иначе возвращает его.
+    pub(crate) fn try_push(&self, msg: Vec<u8>) -> Result<(), Vec<u8>> {
+        let mut pos = self.tail.0.load(Ordering::Relaxed);
+        loop {
+            let cell = self.cell(pos);
+            let seq = cell.seq.load(Ordering::Acquire);
+            let diff = seq as isize - (2 * pos) as isize;
+            if diff == 0 {
+                match self.tail.0.compare_exchange_weak(
+                    pos,
+                    pos + 1,
+                    Ordering::Relaxed,
+                    Ordering::Relaxed,
+                ) {
+                    Ok(_) => {
+                        unsafe { (*cell.value.get()).write(msg) };
+                        cell.seq.store(2 * pos + 1, Ordering::Release);
+                        return Ok(());
+                    }
+                    Err(current) => pos = current,
+                }
+            } else if diff < 0 {
+                // Ячейку ещё не освободил consumer — очередь полна.
+                return Err(msg);
+            } else {
+                pos = self.tail.0.load(Ordering::Relaxed);
+            }
+        }
+    }
+
+    pub(crate) fn pop(&self) -> Option<Vec<u8>> {
+        let mut pos = self.head.0.load(Ordering::Relaxed);
+        loop {
+            let cell = self.cell(pos);
+            let seq = cell.seq.load(Ordering::Acquire);
+            let diff = seq as isize - (2 * pos + 1) as isize;
+            if diff == 0 {
+                match self.head.0.compare_exchange_weak(
+                    pos,
+                    pos + 1,
+                    Ordering::Relaxed,
+                    Ordering::Relaxed,
+                ) {
+                    Ok(_) => {
+                        let msg = unsafe { (*cell.value.get()).assume_init_read() };
+                        cell.seq
+                            .store(2 * (pos + self.cells.len()), Ordering::Release);
+                        return Some(msg);
+                    }
+                    Err(current) => pos = current,
+                }
+            } else if diff < 0 {
+                return None;
+            } else {
+                pos = self.head.0.load(Ordering::Relaxed);
+            }
+        }
+    }
+
+    /// Нет опубликованного сообщения в голове. Запись, зарезервированная, но
+    /// ещё не опубликованная, считается отсутствующей.
+    pub(crate) fn is_empty(&self) -> bool {
+        let pos = self.head.0.load(Ordering::Acquire);
+        self.cell(pos).seq.load(Ordering::Acquire) != 2 * pos + 1
+    }
+
+    fn cell(&self, pos: usize) -> &Cell {
+        &self.cells[pos % self.cells.len()]
+    }
+}
+
+impl Drop for SendQueue {
+    fn drop(&mut self) {
+        while self.pop().is_some() {}
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use std::sync::Arc;
+    use std::thread;
+
+    #[test]
+    fn fifo_order() {
+        let queue = SendQueue::new(4);
+        assert!(queue.is_empty());
+        for i in 0..3u8 {
+            queue.push(vec![i]);
+        }
+        assert!(!queue.is_empty());
+        for i in 0..3u8 {
+            assert_eq!(queue.pop(), Some(vec![i]));
+        }
+        assert_eq!(queue.pop(), None);
+        assert!(queue.is_empty());
+    }
+
+    #[test]
+    fn full_queue_drops_oldest() {
+        let queue = SendQueue::new(3);
+        for i in 0..5u8 {
+            queue.push(vec![i]);
+        }
+        for i in 2..5u8 {
+            assert_eq!(queue.pop(), Some(vec![i]));
+        }
+        assert_eq!(queue.pop(), None);
+
+        let single = SendQueue::new(0);
+        single.push(vec![1]);
+        single.push(vec![2]);
+        assert_eq!(single.pop(), Some(vec![2]));
+        assert_eq!(single.pop(), None);
+    }
+
+    /// Несколько отправителей и читатель одновременно: сообщения каждого
+    /// отправителя приходят без дублей и по возрастанию. Возвращает число
+    /// принятых сообщений.
+    fn run_producers(bound: usize, producers: usize, per_producer: u32) -> u64 {
+        let queue = Arc::new(SendQueue::new(bound));
+        let handles: Vec<_> = (0..producers)
+            .map(|id| {
+                let queue = queue.clone();
+                thread::spawn(move || {
+                    for seq in 0..per_producer {
+                        let mut msg = vec![id as u8];
+                        msg.extend_from_slice(&seq.to_le_bytes());
+                        queue.push(msg);
+                    }
+                })
+            })
+            .collect();
+
+        let mut last = vec![None::<u32>; producers];
+        let mut received = 0u64;
+        let mut finished = false;
+        loop {
+            match queue.pop() {
+                Some(msg) => {
+                    let id = msg[0] as usize;
+                    let seq = u32::from_le_bytes(msg[1..5].try_into().unwrap());
+                    assert!(last[id].map_or(true, |prev| seq > prev));
+                    last[id] = Some(seq);
+                    received += 1;
+                }
+                None if finished => break,
+                None => finished = handles.iter().all(|h| h.is_finished()),
+            }
+        }
+        for handle in handles {
+            handle.join().unwrap();
+        }
+        received
+    }
+
+    #[test]
+    fn concurrent_producers_lose_nothing_below_bound() {
+        assert_eq!(run_producers(4 * 20_000, 4, 20_000), 4 * 20_000);
+    }
+
+    #[test]
+    fn concurrent_producers_with_eviction_keep_order() {
+        let received = run_producers(64, 4, 20_000);
+        assert!(received > 0 && received <= 4 * 20_000);
+    }
+}
@@ -0,0 +1,625 @@
+//! Fan-out кольцо рассылки: один producer, сколько угодно читателей.
+//!
+//! `broadcast` в multi/dispatch раньше записывал одно и то же сообщение в
+//! кольцо каждого клиента — N копий payload-а на одну рассылку. Здесь сервер
+//! пишет сообщение один раз в отдельную секцию `{base}_BCAST`, а каждый
+//! клиент читает её своим локальным курсором. Producer никого не ждёт:
+//! читатель, отставший больше чем на ёмкость, перескакивает на последнее
+//! сообщение и узнаёт число пропущенных по разрыву порядковых номеров.
+//!
+//! Запись ограждена двумя позициями: `tail_intent` — докуда producer
+//! собирается писать, `tail` — докуда записано. Читатель копирует запись и
+//! потом проверяет, что `tail_intent` не ушёл дальше его курсора больше чем
+//! на ёмкость, — иначе копия могла быть перезаписана и отбрасывается (тот же
+//! seqlock-приём, что и в `RingBuffer::read_message`).
+
+use std::ptr::NonNull;
+use std::sync::atomic::{fence, Ordering};
+
+use crate::constants::{
+    BROADCAST_MAGIC, BROADCAST_VERSION, MAX_RING_CAPACITY, MIN_MESSAGE_SIZE, MIN_RING_CAPACITY,
+};
+use crate::copy::copy_to_shared;
+use crate::error::{Result, ShmError};
+use crate::layout::{broadcast_mapping_size, BroadcastHeader};
+use crate::naming::{broadcast_name, mapping_name};
+use crate::ring::MessageBatch;
+use crate::win::{Mapping, SectionOptions};
+
+/// Заголовок записи. Записи выровнены на его размер, поэтому до конца
+/// кольца всегда остаётся место хотя бы под заголовок padding-а.
+#[repr(C)]
+#[derive(Clone, Copy)]
+struct RecordHeader {
+    /// Длина payload (сообщение) или всей записи (padding).
+    len: u32,
+    kind: u32,
+    /// Порядковый номер сообщения (у padding — 0).
+    seq: u64,
+}
+
+const RECORD_HEADER_SIZE: usize = std::mem::size_of::<RecordHeader>();
+const RECORD_MESSAGE: u32 = 1;
+/// Хвост кольца, куда не влезла следующая запись: читатель пропускает его
+/// до нуля, так что payload никогда не переносится через границу.
+const RECORD_PADDING: u32 = 2;
+
+const fn record_size(len: usize) -> usize {
+    (RECORD_HEADER_SIZE + len + RECORD_HEADER_SIZE - 1) & !(RECORD_HEADER_SIZE - 1)
+}
+
+/// Проверка ёмкости секции под сообщения до `max_message_size` байт.
+///
+/// В кольцо должны влезать две записи максимального размера — иначе каждое
+/// длинное сообщение затирало бы предыдущее ещё до того, как его успел
+/// скопировать хоть один читатель.
+pub fn validate_capacity(capacity: usize, max_message_size: usize) -> Result<()> {
+    if !capacity.is_power_of_two() || !(MIN_RING_CAPACITY..=MAX_RING_CAPACITY).contains(&capacity) {
+        return Err(ShmError::InvalidConfig(
+            "broadcast capacity must be a power of two in 4 KB..=1 GB",
+        ));
+    }
+    if max_message_size < MIN_MESSAGE_SIZE || 2 * record_size(max_message_size) > capacity {
+        return Err(ShmError::InvalidConfig(
+            "broadcast capacity must hold two max_message_size messages",
+        ));
+    }
+    Ok(())
+}
+
+/// Позиция одного читателя: живёт в его процессе, в секцию не пишется.
+#[derive(Debug, Clone, Copy, PartialEq, Eq)]
+pub struct BroadcastCursor {
+    position: u64,
+    next_seq: u64,
+}
+
+/// Кольцо рассылки поверх заголовка и данных секции.
+pub struct BroadcastRing {
+    header: NonNull<BroadcastHeader>,
+    data: NonNull<u8>,
+    capacity: usize,
+    max_message_size: usize,
+}
+
+unsafe impl Send for BroadcastRing {}
+unsafe impl Sync for BroadcastRing {}
+
+impl BroadcastRing {
+    /// # Safety
+    /// `header` указывает на заголовок, за которым лежат `capacity` байт
+    /// данных; память выровнена на 64 байта и живёт не меньше self, пределы
+    /// проверены `validate_capacity`.
+    pub unsafe fn new(
+        header: *mut BroadcastHeader,
+        capacity: usize,
+        max_message_size: usize,
+    ) -> Self {
+        debug_assert!(validate_capacity(capacity, max_message_size).is_ok());
+        let header = NonNull::new(header).expect("broadcast header pointer must be valid");
+        // SAFETY: данные идут сразу за заголовком (инвариант вызывающего).
+        let data = unsafe { NonNull::new_unchecked(header.as_ptr().add(1) as *mut u8) };
+        Self {
+            header,
+            data,
+            capacity,
+            max_message_size,
+        }
+    }
+
+    fn header(&self) -> &BroadcastHeader {
+        unsafe { self.header.as_ref() }
+    }
+
+    /// Заголовок новой секции: позиции в ноль, `magic` — последним, чтобы
+    /// открывший секцию читатель не увидел её недописанной.
+    pub fn init(&self) {
+        // SAFETY: единственный владелец на этапе инициализации (секцию ещё
+        // никто не открыл — magic не записан).
+        let header = unsafe { &mut *self.header.as_ptr() };
+        header.version = BROADCAST_VERSION;
+        header.capacity = self.capacity as u32;
+        header.max_message_size = self.max_message_size as u32;
+        header.reserved = [0; 12];
+        for index in [
+            &header.producer.tail_intent,
+            &header.producer.tail,
+            &header.producer.latest,
+            &header.producer.published,
+        ] {
+            index.store(0, Ordering::Relaxed);
+        }
+        header.magic.store(BROADCAST_MAGIC, Ordering::Release);
+    }
+
+    fn offset(&self, position: u64) -> usize {
+        position as usize & (self.capacity - 1)
+    }
+
+    /// # Safety
+    /// `offset` выровнен на `RECORD_HEADER_SIZE` и меньше `capacity`.
+    unsafe fn read_record(&self, offset: usize) -> RecordHeader {
+        // SAFETY: заголовок целиком внутри данных (выравнивание записей);
+        // producer может писать его параллельно — результат проверяет
+        // `intact`.
+        unsafe { std::ptr::read_volatile(self.data.as_ptr().add(offset) as *const RecordHeader) }
+    }
+
+    /// # Safety
+    /// См. `read_record`.
+    unsafe fn write_record(&self, offset: usize, record: RecordHeader) {
+        // SAFETY: см. read_record.
+        unsafe {
+            std::ptr::write_volatile(self.data.as_ptr().add(offset) as *mut RecordHeader, record)
+        };
+    }
+
+    /// Публикует сообщение всем читателям. Producer у кольца один: вызовы
+    /// должны быть сериализованы вызывающим кодом.
+    pub fn publish(&self, payload: &[u8]) -> Result<()> {
+        let len = payload.len();
+        if len < MIN_MESSAGE_SIZE {
+            return Err(ShmError::MessageTooSmall);
+        }
+        if len > self.max_message_size {
+            return Err(ShmError::MessageTooLarge);
+        }
+
+        let producer = &self.header().producer;
+        let tail = producer.tail.load(Ordering::Relaxed);
+        let offset = self.offset(tail);
+        let to_end = self.capacity - offset;
+        let record = record_size(len);
+        let padding = if record > to_end { to_end } else { 0 };
+        let start = tail + padding as u64;
+        let seq = producer.published.load(Ordering::Relaxed);
+
+        producer
+            .tail_intent
+            .store(start + record as u64, Ordering::Relaxed);
+        // Читатель, скопировавший хоть байт из записей ниже, должен увидеть
+        // и новый tail_intent — иначе не заметит, что копия испорчена.
+        fence(Ordering::Release);
+
+        let at = self.offset(start);
+        // SAFETY: offset и at выровнены на RECORD_HEADER_SIZE; запись
+        // [at, at + record) не пересекает границу кольца по построению
+        // padding-а.
+        unsafe {
+            if padding > 0 {
+                self.write_record(
+                    offset,
+                    RecordHeader {
+                        len: padding as u32,
+                        kind: RECORD_PADDING,
+                        seq: 0,
+                    },
+                );
+            }
+            self.write_record(
+                at,
+                RecordHeader {
+                    len: len as u32,
+                    kind: RECORD_MESSAGE,
+                    seq,
+                },
+            );
+            copy_to_shared(self.data.as_ptr().add(at + RECORD_HEADER_SIZE), payload);
+        }
+
+        producer.published.store(seq + 1, Ordering::Relaxed);
+        producer.latest.store(start, Ordering::Release);
+        producer
+            .tail
+            .store(start + record as u64, Ordering::Release);
+        Ok(())
+    }
+
+    /// Не затёрта ли запись, начинающаяся с `position`, к этому моменту.
+    fn intact(&self, position: u64) -> bool {
+        // Пара к Release-fence в publish: чтения копии не уходят за загрузку.
+        fence(Ordering::Acquire);
+        let intent = self.header().producer.tail_intent.load(Ordering::Relaxed);
+        intent.wrapping_sub(position) <= self.capacity as u64
+    }
+
+    /// Курсор нового читателя: он получит только сообщения, опубликованные
+    /// после подключения.
+    pub fn attach(&self) -> BroadcastCursor {
+        let producer = &self.header().producer;
+        loop {
+            let tail = producer.tail.load(Ordering::Acquire);
+            if tail == 0 {
+                return BroadcastCursor {
+                    position: 0,
+                    next_seq: 0,
+                };
+            }
+            // Номер следующего сообщения берём из последнего опубликованного:
+            // пара (tail, published) одним чтением не снимается.
+            let latest = producer.latest.load(Ordering::Acquire);
+            // SAFETY: позиции записей выровнены, offset < capacity.
+            let record = unsafe { self.read_record(self.offset(latest)) };
+            if !self.intact(latest) {
+                continue;
+            }
+            if record.kind == RECORD_MESSAGE && (record.len as usize) <= self.max_message_size {
+                return BroadcastCursor {
+                    position: latest + record_size(record.len as usize) as u64,
+                    next_seq: record.seq + 1,
+                };
+            }
+            // Нецелостный заголовок в целой записи — секция испорчена;
+            // начинаем с хвоста без учёта пропусков.
+            return BroadcastCursor {
+                position: tail,
+                next_seq: producer.published.load(Ordering::Acquire),
+            };
+        }
+    }
+
+    /// Есть ли для курсора непрочитанные сообщения.
+    pub fn has_pending(&self, cursor: &BroadcastCursor) -> bool {
+        self.header().producer.tail.load(Ordering::Acquire) != cursor.position
+    }
+
+    /// Забирает до `max_messages` сообщений в `batch`. Возвращает число
+    /// сообщений и сколько пропущено с прошлого вызова (курсор обогнали).
+    /// Пачка обрывается перед сообщением, с которым арена превысила бы
+    /// `max_bytes` (первое сообщение берётся всегда).
+    pub fn read_batch(
+        &self,
+        cursor: &mut BroadcastCursor,
+        batch: &mut MessageBatch,
+        max_messages: usize,
+        max_bytes: usize,
+    ) -> Result<(usize, u64)> {
+        batch.clear();
+        let producer = &self.header().producer;
+        let mut dropped = 0u64;
+
+        while batch.len() < max_messages.max(1) {
+            let tail = producer.tail.load(Ordering::Acquire);
+            if cursor.position == tail {
+                break;
+            }
+            if tail.wrapping_sub(cursor.position) > self.capacity as u64 {
+                // Обогнали: старые записи уже затёрты.
+                cursor.position = producer.latest.load(Ordering::Acquire);
+                continue;
+            }
+
+            let offset = self.offset(cursor.position);
+            // SAFETY: позиции записей выровнены, offset < capacity.
+            let record = unsafe { self.read_record(offset) };
+            let len = record.len as usize;
+            let size = match record.kind {
+                RECORD_PADDING if len == self.capacity - offset => Some(len),
+                RECORD_MESSAGE
+                    if (MIN_MESSAGE_SIZE..=self.max_message_size).contains(&len)
+                        && offset + RECORD_HEADER_SIZE + len <= self.capacity =>
+                {
+                    if !batch.is_empty() && batch.as_bytes().len() + len > max_bytes {
+                        // запись останется следующему вызову
+                        break;
+                    }
+                    // SAFETY: payload целиком внутри данных (проверено выше).
+                    let payload = unsafe {
+                        std::slice::from_raw_parts(
+                            self.data.as_ptr().add(offset + RECORD_HEADER_SIZE),
+                            len,
+                        )
+                    };
+                    batch.push(payload);
+                    Some(record_size(len))
+                }
+                _ => None,
+            };
+
+            if !self.intact(cursor.position) {
+                if size.is_some() && record.kind == RECORD_MESSAGE {
+                    batch.pop();
+                }
+                cursor.position = producer.latest.load(Ordering::Acquire);
+                continue;
+            }
+            let Some(size) = size else {
+                return Err(ShmError::Corrupted);
+            };
+            cursor.position += size as u64;
+
+            if record.kind == RECORD_MESSAGE {
+                if record.seq < cursor.next_seq {
+                    // Перескок на latest мог вернуть уже прочитанное.
+                    batch.pop();
+                    continue;
+                }
+                dropped += record.seq - cursor.next_seq;
+                cursor.next_seq = record.seq + 1;
+            }
+        }
+
+        if batch.is_empty() && dropped == 0 {
+            Err(ShmError::QueueEmpty)
+        } else {
+            Ok((batch.len(), dropped))
+        }
+    }
+}
+
+/// Серверная сторона: создаёт секцию `{base}_BCAST` и публикует в неё.
+pub struct BroadcastSender {
+    _mapping: Mapping,
+    ring: BroadcastRing,
+}
+
+impl BroadcastSender {
+    pub fn create(
+        base: &str,
+        capacity: usize,
+        max_message_size: usize,
+        memory: &SectionOptions,
+    ) -> Result<Self> {
+        validate_capacity(capacity, max_message_size)?;
+        memory.validate()?;
+        let mapping = Mapping::create(
+            &mapping_name(&broadcast_name(base)),
+            broadcast_mapping_size(capacity),
+            memory,
+        )?;
+        // SAFETY: секция создана под заголовок + capacity, view выровнен на
+        // страницу и живёт, пока жив self (_mapping).
+        let ring = unsafe {
+            BroadcastRing::new(
+                mapping.as_ptr() as *mut BroadcastHeader,
+                capacity,
+                max_message_size,
+            )
+        };
+        ring.init();
+        Ok(Self {
+            _mapping: mapping,
+            ring,
+        })
+    }
+
+    /// См. [`BroadcastRing::publish`]; `&mut` — producer у кольца один.
+    pub fn publish(&mut self, payload: &[u8]) -> Result<()> {
+        self.ring.publish(payload)
+    }
+}
+
+/// Клиентская сторона: читает секцию рассылки своим курсором.
+pub struct BroadcastReceiver {
+    _mapping: Mapping,
+    ring: BroadcastRing,
+    cursor: BroadcastCursor,
+}
+
+impl BroadcastReceiver {
+    /// Открывает секцию рассылки сервера `base`. Ошибка — сервер запущен
+    /// без рассылки (секции нет) или секция непригодна.
+    pub fn open(base: &str) -> Result<Self> {
+        let mapping = Mapping::open(&mapping_name(&broadcast_name(base)))?;
+        if mapping.size() < broadcast_mapping_size(0) {
+            return Err(ShmError::Corrupted);
+        }
+        // SAFETY: маппинг не меньше заголовка (проверено выше).
+        let header = unsafe { &*(mapping.as_ptr() as *const BroadcastHeader) };
+        if header.magic.load(Ordering::Acquire) != BROADCAST_MAGIC {
+            return Err(ShmError::Corrupted);
+        }
+        if header.version != BROADCAST_VERSION {
+            return Err(ShmError::HandshakeFailed);
+        }
+        let capacity = header.capacity as usize;
+        let max_message_size = header.max_message_size as usize;
+        if validate_capacity(capacity, max_message_size).is_err()
+            || broadcast_mapping_size(capacity) > mapping.size()
+        {
+            return Err(ShmError::Corrupted);
+        }
+        // SAFETY: пределы проверены против заголовка и размера маппинга.
+        let ring = unsafe {
+            BroadcastRing::new(
+                mapping.as_ptr() as *mut BroadcastHeader,
+                capacity,
+                max_message_size,
+            )
+        };
+        let cursor = ring.attach();
+        Ok(Self {
+            _mapping: mapping,
+            ring,
+            cursor,
+        })
+    }
+
+    /// См. [`BroadcastRing::read_batch`].
+    pub fn receive_batch(
+        &mut self,
+        batch: &mut MessageBatch,
+        max_messages: usize,
+        max_bytes: usize,
+    ) -> Result<(usize, u64)> {
+        self.ring
+            .read_batch(&mut self.cursor, batch, max_messages, max_bytes)
+    }
+
+    pub fn has_pending(&self) -> bool {
+        self.ring.has_pending(&self.cursor)
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use std::sync::Arc;
+    use std::thread;
+
+    const CAPACITY: usize = 4096;
+
+    #[repr(C, align(64))]
+    struct Section {
+        header: BroadcastHeader,
+        data: [u8; CAPACITY],
+    }
+
+    /// Секция в куче вместо shared memory — логика кольца та же.
+    fn section(max_message_size: usize) -> (Box<Section>, BroadcastRing) {
+        // SAFETY: все поля — целые и атомики, нули для них валидны.
+        let mut section: Box<Section> = Box::new(unsafe { std::mem::zeroed() });
+        let ring = unsafe { BroadcastRing::new(&mut section.header, CAPACITY, max_message_size) };
+        ring.init();
+        (section, ring)
+    }
+
+    #[test]
+    fn capacity_validation() {
+        assert!(validate_capacity(CAPACITY, 1024).is_ok());
+        // две записи по 16 + 2032 байт ровно заполняют 4 КБ
+        assert!(validate_capacity(CAPACITY, 2032).is_ok());
+        assert!(validate_capacity(CAPACITY, 2033).is_err());
+        assert!(validate_capacity(3000, 64).is_err());
+        assert!(validate_capacity(CAPACITY, 1).is_err());
+    }
+
+    #[test]
+    fn every_reader_gets_every_message() {
+        let (_section, ring) = section(256);
+        let mut first = ring.attach();
+        let mut second = ring.attach();
+        let mut batch = MessageBatch::new();
+
+        // Больше ёмкости в сумме — с переходом через границу кольца.
+        for round in 0..40u8 {
+            let msg = vec![round; 100 + round as usize];
+            ring.publish(&msg).unwrap();
+            for cursor in [&mut first, &mut second] {
+                assert_eq!(
+                    ring.read_batch(cursor, &mut batch, 8, usize::MAX).unwrap(),
+                    (1, 0)
+                );
+                assert_eq!(batch.get(0), Some(msg.as_slice()));
+            }
+        }
+        assert_eq!(
+            ring.read_batch(&mut first, &mut batch, 8, usize::MAX),
+            Err(ShmError::QueueEmpty)
+        );
+    }
+
+    #[test]
+    fn late_reader_starts_at_tail() {
+        let (_section, ring) = section(256);
+        ring.publish(b"old").unwrap();
+        let mut cursor = ring.attach();
+        let mut batch = MessageBatch::new();
+        assert!(!ring.has_pending(&cursor));
+        ring.publish(b"new").unwrap();
+        assert!(ring.has_pending(&cursor));
+        assert_eq!(
+            ring.read_batch(&mut cursor, &mut batch, 8, usize::MAX)
+                .unwrap(),
+            (1, 0)
+        );
+        assert_eq!(batch.get(0), Some(&b"new"[..]));
+    }
+
+    #[test]
+    fn batch_stops_at_byte_limit() {
+        let (_section, ring) = section(256);
+        let mut cursor = ring.attach();
+        let mut batch = MessageBatch::new();
+        for round in 0..3u8 {
+            ring.publish(&[round; 100]).unwrap();
+        }
+        assert_eq!(
+            ring.read_batch(&mut cursor, &mut batch, 8, 250).unwrap(),
+            (2, 0)
+        );
+        // первое сообщение берётся и сверх лимита
+        assert_eq!(
+            ring.read_batch(&mut cursor, &mut batch, 8, 10).unwrap(),
+            (1, 0)
+        );
+        assert_eq!(batch.get(0), Some(&[2u8; 100][..]));
+    }
+
+    #[test]
+    fn lapped_reader_skips_to_latest_and_counts_drops() {
+        let (_section, ring) = section(256);
+        let mut slow = ring.attach();
+        let mut batch = MessageBatch::new();
+        // 100 записей по 128 байт — кольцо 4 КБ обогнано втрое.
+        for seq in 0..100u32 {
+            let mut msg = vec![0u8; 112];
+            msg[..4].copy_from_slice(&seq.to_le_bytes());
+            ring.publish(&msg).unwrap();
+        }
+        let (count, dropped) = ring
+            .read_batch(&mut slow, &mut batch, 64, usize::MAX)
+            .unwrap();
+        assert_eq!(count, 1, "only the latest message survives");
+        assert_eq!(dropped, 99);
+        assert_eq!(&batch.get(0).unwrap()[..4], &99u32.to_le_bytes());
+        assert_eq!(
+            ring.read_batch(&mut slow, &mut batch, 64, usize::MAX),
+            Err(ShmError::QueueEmpty)
+        );
+    }
+
+    #[test]
+    fn oversized_and_tiny_messages_are_rejected() {
+        let (_section, ring) = section(256);
+        assert_eq!(ring.publish(&[0; 257]), Err(ShmError::MessageTooLarge));
+        assert_eq!(ring.publish(&[0; 1]), Err(ShmError::MessageTooSmall));
+    }
+
+    /// Читатели параллельно с producer-ом: у каждого номера строго растут,
+    /// а принятые вместе с пропущенными дают ровно число опубликованных.
+    #[test]
+    fn concurrent_readers_see_ordered_messages() {
+        const MESSAGES: u32 = 50_000;
+        let (section, ring) = section(256);
+        let ring = Arc::new(ring);
+        let readers: Vec<_> = (0..3)
+            .map(|_| {
+                let ring = ring.clone();
+                let mut cursor = ring.attach();
+                thread::spawn(move || {
+                    let mut batch = MessageBatch::new();
+                    let mut last = None::<u32>;
+                    let (mut received, mut dropped) = (0u64, 0u64);
+                    while last != Some(MESSAGES - 1) {
+                        match ring.read_batch(&mut cursor, &mut batch, 16, usize::MAX) {
+                            Ok((_, lost)) => {
+                                dropped += lost;
+                                for msg in batch.iter() {
+                                    let seq = u32::from_le_bytes(msg[..4].try_into().unwrap());
+                                    assert!(msg[4..].iter().all(|&b| b == seq as u8));
+                                    assert!(last.map_or(true, |prev| seq > prev));
+                                    last = Some(seq);
+                                    received += 1;
+                                }
+                            }
+                            Err(ShmError::QueueEmpty) => thread::yield_now(),
+                            Err(err) => panic!("{err}"),
+                        }
+                    }
+                    received + dropped
+                })
+            })
+            .collect();
+
+        for seq in 0..MESSAGES {
+            let mut msg = vec![seq as u8; 4 + (seq % 200) as usize];
+            msg[..4].copy_from_slice(&seq.to_le_bytes());
+            ring.publish(&msg).unwrap();
+        }
+        for reader in readers {
+            assert_eq!(reader.join().unwrap(), MESSAGES as u64);
+        }
+        drop(section);
+    }
+}
@@ -1,4 +1,5 @@
-use std::sync::atomic::Ordering;
+use std::sync::atomic::{AtomicBool, AtomicUsize, Ordering};
+use std::sync::Arc;
 use std::time::Duration;
 
 use crate::constants::{
@@ -6,9 +7,15 @@ use crate::constants::{
 };
 use crate::error::{Result, ShmError};
 use crate::events::SharedEvents;
+use crate::lanes::{space_nap, LaneSet, RxLanes};
 use crate::naming::mapping_name;
-use crate::ring::{RingBuffer, WriteOutcome};
+use crate::ring::{
+    AtomicOverflowPolicy, MessageBatch, OverflowPolicy, PeekedMessage, RingBuffer, WriteOutcome,
+    WriteReservation,
+};
 use crate::shared::SharedView;
+use crate::stats::{ChannelStats, ChannelStatsSnapshot};
+use crate::wait::{write_batch_with_backpressure, write_with_backpressure, WaitStrategy};
 use crate::win::Mapping;
 
 pub struct SharedClient {
@@ -18,7 +25,14 @@ pub struct SharedClient {
     events: SharedEvents,
     ring_tx: RingBuffer,
     ring_rx: RingBuffer,
+    /// Дорожки 1.. каждого направления (см. `SharedServer`).
+    tx_lanes: Vec<RingBuffer>,
+    rx_lanes: Vec<RingBuffer>,
+    lane_claims: Box<[AtomicBool]>,
+    rx_cursor: AtomicUsize,
     connected: bool,
+    /// Политика записи в кольцо client→server при нехватке места.
+    overflow: AtomicOverflowPolicy,
 }
 
 unsafe impl Send for SharedClient {}
@@ -37,6 +51,12 @@ impl SharedClient {
         if control.version != SHARED_VERSION {
             return Err(ShmError::HandshakeFailed);
         }
+        // Геометрию колец выбирает сервер; доверять ей можно только после
+        // проверки, что описанный ею layout целиком лежит внутри маппинга.
+        let geometry = control.geometry();
+        if geometry.validate().is_err() || geometry.mapping_size() > mapping.size() {
+            return Err(ShmError::Corrupted);
+        }
 
         let events = SharedEvents::open(name)?;
 
@@ -101,18 +121,29 @@ impl SharedClient {
                 .store(HANDSHAKE_SERVER_READY, Ordering::Release);
         }
 
-        let ring_tx = unsafe { RingBuffer::new(view.ring_header_b(), view.ring_buffer_b()) };
-        let ring_rx = unsafe { RingBuffer::new(view.ring_header_a(), view.ring_buffer_a()) };
+        // SAFETY: геометрия проверена против размера маппинга выше.
+        let ring_tx = unsafe { view.ring_b() };
+        let ring_rx = unsafe { view.ring_a() };
+        let (rx_lanes, tx_lanes): (Vec<_>, Vec<_>) = (1..geometry.lanes)
+            .map(|lane| unsafe { view.lane_rings(lane) })
+            .unzip();
+        let lane_claims = tx_lanes.iter().map(|_| AtomicBool::new(false)).collect();
 
-        let client = Self {
+        let mut client = Self {
             _name: name.to_owned(),
             _mapping: mapping,
             view,
             events,
             ring_tx,
             ring_rx,
+            tx_lanes,
+            rx_lanes,
+            lane_claims,
+            rx_cursor: AtomicUsize::new(0),
             connected: true,
+            overflow: AtomicOverflowPolicy::new(OverflowPolicy::Overwrite),
         };
+        client.set_stats(Arc::default());
 
         Ok(client)
     }
@@ -129,6 +160,66 @@ impl SharedClient {
         self.connected = false;
     }
 
+    /// Политика отправки серверу при нехватке места в кольце
+    /// (см. [`crate::SharedServer::set_overflow_policy`]).
+    pub fn set_overflow_policy(&self, policy: OverflowPolicy) {
+        self.overflow.store(policy);
+        for ring in std::iter::once(&self.ring_tx).chain(&self.tx_lanes) {
+            ring.set_overwrite(policy == OverflowPolicy::Overwrite);
+        }
+    }
+
+    pub fn overflow_policy(&self) -> OverflowPolicy {
+        self.overflow.load()
+    }
+
+    /// Трассировка кадров client→server (см.
+    /// [`crate::SharedServer::set_tracing`]).
+    pub fn set_tracing(&mut self, trace: bool) {
+        for ring in std::iter::once(&mut self.ring_tx).chain(&mut self.tx_lanes) {
+            ring.set_trace(trace);
+        }
+    }
+
+    /// Статистика канала на стороне клиента (см.
+    /// [`crate::SharedServer::channel_stats`]).
+    pub fn channel_stats(&self) -> ChannelStatsSnapshot {
+        self.ring_tx.stats().snapshot()
+    }
+
+    /// Подменяет приёмник статистики обоих колец — чтобы счёт переживал
+    /// переподключение или был виден владельцу worker-а.
+    pub(crate) fn set_stats(&mut self, stats: Arc<ChannelStats>) {
+        for ring in self.rx_lanes.iter_mut().chain(&mut self.tx_lanes) {
+            ring.set_stats(stats.clone());
+        }
+        self.ring_rx.set_stats(stats.clone());
+        self.ring_tx.set_stats(stats);
+    }
+
+    /// Кольца server→client всех дорожек.
+    fn rx(&self) -> RxLanes<'_> {
+        RxLanes {
+            main: &self.ring_rx,
+            extra: &self.rx_lanes,
+            cursor: &self.rx_cursor,
+            space: Some(&self.events.s2c.space),
+        }
+    }
+
+    /// Дорожки client→server для многопоточной отправки (см.
+    /// [`crate::SharedServer::lanes`]).
+    pub fn lanes(&self) -> Result<LaneSet<'_>> {
+        self.ensure_connected()?;
+        Ok(LaneSet::new(
+            &self.tx_lanes,
+            &self.lane_claims,
+            self.overflow.load(),
+            Some(&self.events.c2s.space),
+            Some(&self.events.c2s.data),
+        ))
+    }
+
     fn ensure_connected(&self) -> Result<()> {
         if !self.connected {
             Err(ShmError::NotConnected)
@@ -138,18 +229,111 @@ impl SharedClient {
     }
 
     pub fn send_to_server(&self, payload: &[u8]) -> Result<WriteOutcome> {
+        self.send_to_server_at(payload, None)
+    }
+
+    /// `send_to_server` с меткой постановки в очередь (см.
+    /// `SharedServer::send_to_client_at`).
+    pub(crate) fn send_to_server_at(
+        &self,
+        payload: &[u8],
+        enqueued: Option<u64>,
+    ) -> Result<WriteOutcome> {
+        self.ensure_connected()?;
+        let space = Some(&self.events.c2s.space);
+        let nap = space_nap(&self.tx_lanes);
+        let policy = self.overflow.load();
+        let result = write_with_backpressure(policy, space, nap, || {
+            self.ring_tx.write_message_at(payload, enqueued)
+        })?;
+        if result.wake_consumer {
+            let _ = self.events.c2s.data.set();
+        }
+        Ok(result)
+    }
+
+    /// Отправка пачки сообщений одной публикацией
+    /// (см. [`crate::SharedServer::send_batch_to_client`]).
+    pub fn send_batch_to_server(&self, messages: &[&[u8]]) -> Result<WriteOutcome> {
+        self.ensure_connected()?;
+        write_batch_with_backpressure(
+            &self.ring_tx,
+            self.overflow.load(),
+            Some(&self.events.c2s.space),
+            space_nap(&self.tx_lanes),
+            Some(&self.events.c2s.data),
+            messages,
+        )
+    }
+
+    /// Zero-copy отправка: резерв `len` байт прямо в кольце client→server
+    /// (см. [`crate::SharedServer::reserve_to_client`]).
+    pub fn reserve_to_server(&self, len: usize) -> Result<WriteReservation> {
         self.ensure_connected()?;
-        let result = self.ring_tx.write_message(payload)?;
-        if result.was_empty {
+        let space = Some(&self.events.c2s.space);
+        let nap = space_nap(&self.tx_lanes);
+        let policy = self.overflow.load();
+        write_with_backpressure(policy, space, nap, || self.ring_tx.reserve(len))
+    }
+
+    /// Участки кольца client→server под payload резерва (второй — при переносе).
+    pub fn reserved_spans<'a>(
+        &'a self,
+        reservation: &'a mut WriteReservation,
+    ) -> (&'a mut [u8], &'a mut [u8]) {
+        self.ring_tx.reservation_spans(reservation)
+    }
+
+    /// Публикует первые `used` байт резерва как одно сообщение серверу.
+    pub fn commit_to_server(
+        &self,
+        reservation: WriteReservation,
+        used: usize,
+    ) -> Result<WriteOutcome> {
+        self.ensure_connected()?;
+        let result = self.ring_tx.commit(reservation, used)?;
+        if result.wake_consumer {
             let _ = self.events.c2s.data.set();
         }
         Ok(result)
     }
 
+    /// Следующее сообщение сервера (см.
+    /// [`crate::SharedServer::receive_from_client`]).
     pub fn receive_from_server(&self, buffer: &mut Vec<u8>) -> Result<usize> {
         self.ensure_connected()?;
-        let len = self.ring_rx.read_message(buffer)?;
-        if self.ring_rx.message_count() == 0 {
+        self.rx().read_message(buffer)
+    }
+
+    /// Забирает до `max_messages` сообщений сервера в `batch` одним сдвигом
+    /// `read_pos` (см. [`crate::SharedServer::receive_batch_from_client`]).
+    pub fn receive_batch_from_server(
+        &self,
+        batch: &mut MessageBatch,
+        max_messages: usize,
+        max_bytes: usize,
+    ) -> Result<usize> {
+        self.ensure_connected()?;
+        self.rx().read_batch(batch, max_messages, max_bytes)
+    }
+
+    /// Zero-copy чтение: самое старое сообщение сервера без копирования,
+    /// только дорожка 0 (см. [`crate::SharedServer::peek_from_client`]).
+    pub fn peek_from_server(&self) -> Result<PeekedMessage> {
+        self.ensure_connected()?;
+        self.ring_rx.peek()
+    }
+
+    /// Участки кольца server→client с payload подсмотренного сообщения.
+    pub fn peeked_spans<'a>(&'a self, message: &'a PeekedMessage) -> (&'a [u8], &'a [u8]) {
+        self.ring_rx.peeked_spans(message)
+    }
+
+    /// Забирает подсмотренное сообщение; `Err(Overwritten)` — его вытеснили.
+    pub fn consume_from_server(&self, message: PeekedMessage) -> Result<usize> {
+        self.ensure_connected()?;
+        let len = self.ring_rx.consume(message)?;
+        if self.ring_rx.is_empty() {
             let _ = self.events.s2c.space.set();
         }
         Ok(len)
@@ -157,11 +341,24 @@ impl SharedClient {
 
     pub fn poll_server(&self, timeout: Option<Duration>) -> Result<bool> {
         self.ensure_connected()?;
-        if !self.ring_rx.is_empty() {
+        if self.rx().has_data() {
             return Ok(true);
         }
         self.events.s2c.data.wait(timeout)
     }
+
+    /// Активное ожидание данных сервера по `strategy` (spin, затем yield). Пока
+    /// оно идёт — и дальше, пока данные обрабатываются, — сервер не сигналит
+    /// data-событие. `true` — данные есть; `false` — бюджет исчерпан, кольцо
+    /// пусто, флаг снят, и можно блокироваться на `s2c.data`.
+    pub fn spin_wait_server(&self, strategy: &WaitStrategy) -> bool {
+        let rx = self.rx();
+        if strategy.is_blocking() {
+            return rx.has_data();
+        }
+        rx.start_spinning();
+        strategy.spin_until(|| rx.has_data()) || rx.stop_spinning()
+    }
 }
 
 impl Drop for SharedClient {
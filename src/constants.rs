@@ -1,22 +1,65 @@
 /// Общее «магическое» значение для сегмента.
 pub const SHARED_MAGIC: u32 = 0x5853_484d; // 'XSHM'
 /// Текущая версия протокола.
-pub const SHARED_VERSION: u32 = 0x0001_0000;
+/// 0x0002_0000: геометрия колец записывается в `ControlBlock`.
+/// 0x0003_0000: индексы producer/consumer в `RingHeader` на разных кэш-линиях.
+pub const SHARED_VERSION: u32 = 0x0003_0000;
 
-/// Размер каждого кольцевого буфера (байты).
+/// Размер каждого кольцевого буфера по умолчанию (байты).
 pub const RING_CAPACITY: usize = 2 * 1024 * 1024;
 /// Маска размера (так как это степень двойки).
+/// Сам ring берёт маску из геометрии канала; константа остаётся для C API.
+#[allow(dead_code)]
 pub const RING_MASK: u32 = (RING_CAPACITY as u32) - 1;
 
-/// Максимальное количество сообщений в очереди.
+/// Минимальная ёмкость кольца при выборе геометрии канала (байты).
+pub const MIN_RING_CAPACITY: usize = 4 * 1024;
+/// Максимальная ёмкость кольца. Позиции — u32 с wrapping-арифметикой:
+/// `write - read` однозначен, пока ёмкость не превышает 2^31; берём 1 ГБ.
+pub const MAX_RING_CAPACITY: usize = 1024 * 1024 * 1024;
+
+/// Предел числа дорожек (колец) на направление канала, см.
+/// `ChannelGeometry::lanes`.
+pub const MAX_LANES: u32 = 64;
+
+/// Максимальное количество сообщений в очереди по умолчанию.
 pub const MAX_MESSAGES: u32 = 500;
-/// Максимальный размер одного сообщения.
+/// Максимальный размер одного сообщения по умолчанию — предел u16-поля длины
+/// в коротком заголовке. Геометрия канала может поднять предел: сообщения
+/// длиннее пишутся длинным кадром (`MESSAGE_FLAG_LONG`).
 pub const MAX_MESSAGE_SIZE: usize = 65_535;
 /// Минимальный размер сообщения.
 pub const MIN_MESSAGE_SIZE: usize = 2;
 
 /// Размер служебного заголовка сообщения (байты).
 pub const MESSAGE_HEADER_SIZE: usize = 4; // u16 length + u16 flags/reserved
+/// Размер заголовка длинного кадра: u16 length (0) + u16 flags + u32 length.
+pub const LONG_MESSAGE_HEADER_SIZE: usize = 8;
+/// Флаг заголовка: длина payload лежит в следующем u32, а не в u16-поле.
+pub const MESSAGE_FLAG_LONG: u16 = 0x0001;
+/// Флаг заголовка: за заголовком (коротким или длинным) лежит расширение
+/// трассировки — метка постановки в очередь и порядковый номер.
+pub const MESSAGE_FLAG_TRACED: u16 = 0x0002;
+/// Размер расширения трассировки: u64 метка QPC + u32 номер + u32 резерв.
+pub const TRACE_EXTENSION_SIZE: usize = 16;
+
+/// «Магия» секции fan-out рассылки (`broadcast`): 'XSBC'.
+pub const BROADCAST_MAGIC: u32 = 0x5853_4243;
+/// Версия layout-а секции рассылки.
+pub const BROADCAST_VERSION: u32 = 0x0001_0000;
+/// Суффикс имени секции рассылки: `{base}_BCAST`.
+pub const BROADCAST_SECTION_SUFFIX: &str = "BCAST";
+
+/// «Магия» секции общей кучи блоков (`heap`): 'XSHP'.
+pub const HEAP_MAGIC: u32 = 0x5853_4850;
+/// Версия layout-а секции кучи.
+pub const HEAP_VERSION: u32 = 0x0001_0000;
+/// Суффикс имени секции кучи: `{base}_HEAP`.
+pub const HEAP_SECTION_SUFFIX: &str = "HEAP";
+/// Выравнивание блоков кучи и шаг их размера — страница.
+pub const HEAP_BLOCK_ALIGN: usize = 4096;
+/// Предел числа блоков кучи.
+pub const MAX_HEAP_BLOCKS: u32 = 1 << 20;
 
 /// Имя события для данных, поступающих от сервера к клиенту.
 pub const EVENT_DATA_SUFFIX: &str = "DATA";
@@ -51,3 +94,18 @@ pub const CLAIM_FREE: u32 = 0;
 /// упавший ПОСЛЕ завершения handshake (но не освободивший claim), иначе
 /// навсегда лишает сервер слота — событий от мёртвого процесса не будет.
 pub const RESERVED_OWNER_PID_INDEX: usize = 1;
+
+/// Индекс в reserved[] ЛОББИ dispatch-сервера: число шардов лобби
+/// (`DispatchOptions::lobby_shards`). Пишется сервером после создания
+/// каждого лобби; клиент читает его из лобби под базовым именем. Захват
+/// шарда — те же `RESERVED_CLAIM_INDEX`/`RESERVED_OWNER_PID_INDEX`.
+pub const RESERVED_LOBBY_SHARDS_INDEX: usize = 2;
+
+/// Индекс в reserved[] СЕГМЕНТА КАНАЛА: число дорожек на направление
+/// (`ChannelGeometry::lanes`). Пишется сервером вместе с геометрией; ноль
+/// (сегмент старой версии) — одна дорожка.
+pub const RESERVED_LANES_INDEX: usize = 3;
+
+/// Индекс в reserved[] СЕГМЕНТА КАНАЛА: размер слота колец фиксированных
+/// слотов (`ChannelGeometry::slot_size`); ноль — кадры переменной длины.
+pub const RESERVED_SLOT_SIZE_INDEX: usize = 4;
@@ -0,0 +1,239 @@
+//! Копирование payload-ов в разделяемую память и из неё.
+//!
+//! Обычные сообщения копирует `memcpy` — на наших размерах его не обогнать.
+//! Крупные producer пишет non-temporal store-ами (AVX, иначе SSE2):
+//! строки не вытесняют его кэш и не требуют read-for-ownership, что при
+//! consumer-е на другом сокете почти вдвое режет трафик по шине. Порог —
+//! `stream_threshold()`, общий для процесса: выгода зависит от того, где
+//! живёт consumer, и ниже порога (тот же L3) streaming только мешает.
+//! Consumer крупные сообщения читает блоками по странице, заранее
+//! запрашивая следующую (`prefetch`): аппаратный prefetcher на границе
+//! страницы останавливается.
+//!
+//! Non-temporal store-ы слабо упорядочены даже относительно обычных,
+//! поэтому streaming-ядро обрамлено `sfence`: в начале — чтобы не обогнать
+//! предшествующие store-ы (отметки seqlock-а перед перезаписью), в конце —
+//! чтобы публикация `write_pos` (Release) видела данные целиком.
+
+use std::sync::atomic::{AtomicUsize, Ordering};
+
+/// Порог streaming-записи по умолчанию: заметно больше L2, так что
+/// настоящие сообщения канала в кэше producer-а не задержатся.
+pub const DEFAULT_STREAM_THRESHOLD: usize = 256 * 1024;
+
+/// Сообщения от этого размера читаются с prefetch-ем следующего блока.
+const PREFETCH_THRESHOLD: usize = 16 * 1024;
+const PREFETCH_BLOCK: usize = 4096;
+const CACHE_LINE: usize = 64;
+
+static STREAM_THRESHOLD: AtomicUsize = AtomicUsize::new(DEFAULT_STREAM_THRESHOLD);
+
+/// Payload от `bytes` байт пишется в кольцо non-temporal store-ами;
+/// `usize::MAX` — никогда. Действует на все каналы процесса со
+/// следующей записи. Точку перелома под своё железо показывает
+/// `cargo bench --bench ipc -- raw --stream-threshold <N>`.
+pub fn set_stream_threshold(bytes: usize) {
+    STREAM_THRESHOLD.store(bytes, Ordering::Relaxed);
+}
+
+pub fn stream_threshold() -> usize {
+    STREAM_THRESHOLD.load(Ordering::Relaxed)
+}
+
+/// Копирует `src` в разделяемую память по `dst`.
+///
+/// # Safety
+/// `dst` валиден на запись `src.len()` байт и не пересекается с `src`.
+pub(crate) unsafe fn copy_to_shared(dst: *mut u8, src: &[u8]) {
+    #[cfg(any(target_arch = "x86", target_arch = "x86_64"))]
+    if src.len() >= stream_threshold() {
+        // SAFETY: требования ядер совпадают с требованиями этой функции,
+        // набор инструкций проверен перед вызовом.
+        unsafe {
+            if is_x86_feature_detected!("avx") {
+                return simd::stream_avx(dst, src.as_ptr(), src.len());
+            }
+            if is_x86_feature_detected!("sse2") {
+                return simd::stream_sse2(dst, src.as_ptr(), src.len());
+            }
+        }
+    }
+    // SAFETY: см. контракт функции.
+    unsafe { dst.copy_from_nonoverlapping(src.as_ptr(), src.len()) };
+}
+
+/// Дописывает `src` из разделяемой памяти в конец `out`.
+pub(crate) fn extend_from_shared(out: &mut Vec<u8>, src: &[u8]) {
+    #[cfg(any(target_arch = "x86", target_arch = "x86_64"))]
+    if src.len() >= PREFETCH_THRESHOLD && is_x86_feature_detected!("sse") {
+        out.reserve(src.len());
+        let len = out.len();
+        // SAFETY: reserve выше дал место под src.len() байт за len; Vec и
+        // разделяемая память не пересекаются. Байты инициализированы
+        // копией до set_len.
+        unsafe {
+            simd::copy_prefetched(out.as_mut_ptr().add(len), src.as_ptr(), src.len());
+            out.set_len(len + src.len());
+        }
+        return;
+    }
+    out.extend_from_slice(src);
+}
+
+#[cfg(any(target_arch = "x86", target_arch = "x86_64"))]
+#[allow(unused_unsafe)] // часть интринсиков в target_feature-функциях safe
+mod simd {
+    #[cfg(target_arch = "x86")]
+    use std::arch::x86::*;
+    #[cfg(target_arch = "x86_64")]
+    use std::arch::x86_64::*;
+
+    use super::{CACHE_LINE, PREFETCH_BLOCK};
+
+    /// # Safety
+    /// Как у `copy_to_shared`, плюс процессор поддерживает AVX.
+    #[target_feature(enable = "avx")]
+    pub(super) unsafe fn stream_avx(dst: *mut u8, src: *const u8, len: usize) {
+        const LANE: usize = 32;
+        // Поток store-ов требует выровненного адреса: голову — обычной копией.
+        let head = dst.align_offset(LANE).min(len);
+        let mut offset = head;
+        // SAFETY: все обращения в пределах [0, len) обоих буферов; dst + offset
+        // выровнен на LANE после головы.
+        unsafe {
+            _mm_sfence();
+            dst.copy_from_nonoverlapping(src, head);
+            while offset + 4 * LANE <= len {
+                let s = src.add(offset) as *const __m256i;
+                let d = dst.add(offset) as *mut __m256i;
+                let (a, b) = (_mm256_loadu_si256(s), _mm256_loadu_si256(s.add(1)));
+                let (c, e) = (_mm256_loadu_si256(s.add(2)), _mm256_loadu_si256(s.add(3)));
+                _mm256_stream_si256(d, a);
+                _mm256_stream_si256(d.add(1), b);
+                _mm256_stream_si256(d.add(2), c);
+                _mm256_stream_si256(d.add(3), e);
+                offset += 4 * LANE;
+            }
+            while offset + LANE <= len {
+                let v = _mm256_loadu_si256(src.add(offset) as *const __m256i);
+                _mm256_stream_si256(dst.add(offset) as *mut __m256i, v);
+                offset += LANE;
+            }
+            dst.add(offset)
+                .copy_from_nonoverlapping(src.add(offset), len - offset);
+            _mm_sfence();
+        }
+    }
+
+    /// # Safety
+    /// Как у `copy_to_shared`, плюс процессор поддерживает SSE2.
+    #[target_feature(enable = "sse2")]
+    pub(super) unsafe fn stream_sse2(dst: *mut u8, src: *const u8, len: usize) {
+        const LANE: usize = 16;
+        let head = dst.align_offset(LANE).min(len);
+        let mut offset = head;
+        // SAFETY: см. stream_avx.
+        unsafe {
+            _mm_sfence();
+            dst.copy_from_nonoverlapping(src, head);
+            while offset + 4 * LANE <= len {
+                let s = src.add(offset) as *const __m128i;
+                let d = dst.add(offset) as *mut __m128i;
+                let (a, b) = (_mm_loadu_si128(s), _mm_loadu_si128(s.add(1)));
+                let (c, e) = (_mm_loadu_si128(s.add(2)), _mm_loadu_si128(s.add(3)));
+                _mm_stream_si128(d, a);
+                _mm_stream_si128(d.add(1), b);
+                _mm_stream_si128(d.add(2), c);
+                _mm_stream_si128(d.add(3), e);
+                offset += 4 * LANE;
+            }
+            while offset + LANE <= len {
+                let v = _mm_loadu_si128(src.add(offset) as *const __m128i);
+                _mm_stream_si128(dst.add(offset) as *mut __m128i, v);
+                offset += LANE;
+            }
+            dst.add(offset)
+                .copy_from_nonoverlapping(src.add(offset), len - offset);
+            _mm_sfence();
+        }
+    }
+
+    /// Копия блоками по странице: перед копированием блока запрашиваются
+    /// строки следующего.
+    ///
+    /// # Safety
+    /// `dst` валиден на запись, `src` — на чтение `len` байт, буферы не
+    /// пересекаются; процессор поддерживает SSE.
+    #[target_feature(enable = "sse")]
+    pub(super) unsafe fn copy_prefetched(dst: *mut u8, src: *const u8, len: usize) {
+        let mut offset = 0;
+        while offset < len {
+            let block = PREFETCH_BLOCK.min(len - offset);
+            let next_end = (offset + 2 * PREFETCH_BLOCK).min(len);
+            // SAFETY: prefetch и копия — в пределах [0, len).
+            unsafe {
+                let mut line = offset + block;
+                while line < next_end {
+                    _mm_prefetch::<_MM_HINT_T0>(src.add(line) as *const i8);
+                    line += CACHE_LINE;
+                }
+                dst.add(offset)
+                    .copy_from_nonoverlapping(src.add(offset), block);
+            }
+            offset += block;
+        }
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    fn pattern(len: usize) -> Vec<u8> {
+        (0..len).map(|i| (i * 31 + 7) as u8).collect()
+    }
+
+    /// Ядра на всех сочетаниях выравнивания и хвоста копируют байт в байт и
+    /// не пишут за границу.
+    #[cfg(any(target_arch = "x86", target_arch = "x86_64"))]
+    #[test]
+    fn stream_kernels_copy_exactly() {
+        let src = pattern(1000);
+        let mut kernels: Vec<unsafe fn(*mut u8, *const u8, usize)> = vec![simd::stream_sse2];
+        if is_x86_feature_detected!("avx") {
+            kernels.push(simd::stream_avx);
+        }
+        for kernel in kernels {
+            for misalign in 0..40 {
+                for len in [0, 1, 15, 31, 32, 33, 127, 128, 129, 500, 1000 - 40] {
+                    let mut dst = vec![0xEEu8; 1100];
+                    // SAFETY: misalign + len < dst.len(), src не короче len.
+                    unsafe { kernel(dst.as_mut_ptr().add(misalign), src.as_ptr(), len) };
+                    assert_eq!(&dst[misalign..misalign + len], &src[..len]);
+                    assert!(dst[..misalign].iter().all(|&b| b == 0xEE));
+                    assert!(dst[misalign + len..].iter().all(|&b| b == 0xEE));
+                }
+            }
+        }
+    }
+
+    #[test]
+    fn extend_from_shared_appends_large_and_small() {
+        let large = pattern(3 * PREFETCH_BLOCK + 100 + PREFETCH_THRESHOLD);
+        let mut out = b"head".to_vec();
+        extend_from_shared(&mut out, &large);
+        extend_from_shared(&mut out, b"tail");
+        assert_eq!(&out[..4], b"head");
+        assert_eq!(&out[4..4 + large.len()], &large[..]);
+        assert_eq!(&out[4 + large.len()..], b"tail");
+    }
+
+    #[test]
+    fn copy_to_shared_streams_above_threshold() {
+        let src = pattern(DEFAULT_STREAM_THRESHOLD + 77);
+        let mut dst = vec![0u8; src.len() + 1];
+        // SAFETY: dst длиннее src на байт (невыровненная запись).
+        unsafe { copy_to_shared(dst.as_mut_ptr().add(1), &src) };
+        assert_eq!(&dst[1..], &src[..]);
+    }
+}
@@ -10,7 +10,7 @@ use std::time::Duration;
 
 use crate::constants::MAX_MESSAGE_SIZE;
 use crate::error::ShmError;
-use crate::ffi::shm_error_t;
+use crate::ffi::{shm_channel_stats_t, shm_error_t, shm_section_options_t, write_channel_stats};
 
 use super::{
     ClientRegistration, DispatchClient, DispatchClientHandler, DispatchClientOptions,
@@ -25,6 +25,10 @@ pub struct shm_dispatch_registration_t {
     pub pid: u32,
     pub revision: u16,
     pub name: *const c_char,
+    /// Топики подписки (`topic_count` штук); при `topic_count == 0` может
+    /// быть null.
+    pub topics: *const u32,
+    pub topic_count: u32,
 }
 
 /// Callbacks на стороне сервера.
@@ -58,6 +62,9 @@ pub struct shm_dispatch_client_callbacks_t {
     pub on_message: Option<extern "C" fn(data: *const c_void, size: u32, user_data: *mut c_void)>,
     pub on_error: Option<extern "C" fn(error: shm_error_t, user_data: *mut c_void)>,
     pub user_data: *mut c_void,
+    /// Клиент отстал от broadcast-секции и пропустил `dropped` рассылок.
+    /// Поле в конце структуры, чтобы не сдвигать прежние.
+    pub on_overflow: Option<extern "C" fn(dropped: u32, user_data: *mut c_void)>,
 }
 
 /// Настройки сервера.
@@ -68,6 +75,20 @@ pub struct shm_dispatch_options_t {
     pub channel_connect_timeout_ms: u32,
     pub poll_timeout_ms: u32,
     pub recv_batch: u32,
+    /// Потоков общего I/O-пула для каналов клиентов; 0 — поток на клиента.
+    pub io_threads: u32,
+    /// Ёмкость общей broadcast-секции (байты, степень двойки, от 256 КБ —
+    /// два сообщения `MAX_MESSAGE_SIZE`); 0 — `shm_dispatch_server_broadcast`
+    /// пишет в канал каждого клиента.
+    pub broadcast_capacity: u32,
+    /// Выделение памяти каналов клиентов и broadcast-секции.
+    pub memory: shm_section_options_t,
+    /// Лобби, принимающих регистрации параллельно (1..=64); 0 — 1.
+    pub lobby_shards: u32,
+    /// Запас заранее созданных каналов клиентов; 0 — без запаса.
+    pub warm_channels: u32,
+    /// Бюджет хода клиентского канала, мкс; 0 — фиксированная пачка.
+    pub recv_budget_us: u32,
 }
 
 impl Default for shm_dispatch_options_t {
@@ -77,6 +98,12 @@ impl Default for shm_dispatch_options_t {
             channel_connect_timeout_ms: 30000,
             poll_timeout_ms: 50,
             recv_batch: 32,
+            io_threads: 0,
+            broadcast_capacity: 0,
+            memory: shm_section_options_t::default(),
+            lobby_shards: 1,
+            warm_channels: 0,
+            recv_budget_us: 0,
         }
     }
 }
@@ -203,6 +230,12 @@ impl DispatchClientHandler for FfiDispatchClientHandler {
             cb(err.into(), self.callbacks.user_data);
         }
     }
+
+    fn on_overflow(&self, dropped: u32) {
+        if let Some(cb) = self.callbacks.on_overflow {
+            cb(dropped, self.callbacks.user_data);
+        }
+    }
 }
 
 // ─── Вспомогательные функции ──────────────────────────────────────────────────
@@ -250,6 +283,12 @@ unsafe fn to_dispatch_options(ptr: *const shm_dispatch_options_t) -> DispatchOpt
         channel_connect_timeout: Duration::from_millis(opts.channel_connect_timeout_ms as u64),
         poll_timeout: Duration::from_millis(opts.poll_timeout_ms as u64),
         recv_batch: opts.recv_batch as usize,
+        io_threads: opts.io_threads as usize,
+        broadcast_capacity: opts.broadcast_capacity as usize,
+        memory: opts.memory.into(),
+        lobby_shards: opts.lobby_shards.max(1) as usize,
+        warm_channels: opts.warm_channels as usize,
+        recv_budget: Duration::from_micros(opts.recv_budget_us as u64),
     }
 }
 
@@ -357,6 +396,92 @@ pub unsafe extern "C" fn shm_dispatch_server_broadcast(
     }
 }
 
+/// Публикует сообщение подписчикам топика; `sent_count` — сколько получили.
+///
+/// # Safety
+/// `handle` обязан быть валидным. `data` обязан указывать на `size` байт. `sent_count` может быть null.
+#[unsafe(no_mangle)]
+pub unsafe extern "C" fn shm_dispatch_server_publish(
+    handle: *mut DispatchServerHandle,
+    topic: u32,
+    data: *const c_void,
+    size: u32,
+    sent_count: *mut u32,
+) -> shm_error_t {
+    if handle.is_null() || data.is_null() || size == 0 || size as usize > MAX_MESSAGE_SIZE {
+        return shm_error_t::SHM_ERROR_INVALID_PARAM;
+    }
+    let state = unsafe { &*(handle as *const DispatchServerState) };
+    let slice = unsafe { std::slice::from_raw_parts(data as *const u8, size as usize) };
+    match state.inner.publish(topic, slice) {
+        Ok(count) => {
+            if !sent_count.is_null() {
+                unsafe { *sent_count = count };
+            }
+            shm_error_t::SHM_SUCCESS
+        }
+        Err(err) => err.into(),
+    }
+}
+
+/// Подписывает клиента на топик; `SHM_ERROR_NOT_FOUND` — клиента нет.
+///
+/// # Safety
+/// `handle` обязан быть валидным DispatchServerHandle.
+#[unsafe(no_mangle)]
+pub unsafe extern "C" fn shm_dispatch_server_subscribe(
+    handle: *mut DispatchServerHandle,
+    client_id: u32,
+    topic: u32,
+) -> shm_error_t {
+    if handle.is_null() {
+        return shm_error_t::SHM_ERROR_INVALID_PARAM;
+    }
+    let state = unsafe { &*(handle as *const DispatchServerState) };
+    match state.inner.subscribe(client_id, topic) {
+        Ok(()) => shm_error_t::SHM_SUCCESS,
+        Err(err) => err.into(),
+    }
+}
+
+/// Снимает подписку клиента; `false` — он не был подписан.
+///
+/// # Safety
+/// `handle` обязан быть валидным DispatchServerHandle либо null.
+#[unsafe(no_mangle)]
+pub unsafe extern "C" fn shm_dispatch_server_unsubscribe(
+    handle: *mut DispatchServerHandle,
+    client_id: u32,
+    topic: u32,
+) -> bool {
+    if handle.is_null() {
+        return false;
+    }
+    let state = unsafe { &*(handle as *const DispatchServerState) };
+    state.inner.unsubscribe(client_id, topic)
+}
+
+/// Вес клиента в обходе каналов потока пула (1..=64, по умолчанию 1; см.
+/// `DispatchServer::set_client_weight`).
+///
+/// # Safety
+/// `handle` обязан быть валидным DispatchServerHandle либо null.
+#[unsafe(no_mangle)]
+pub unsafe extern "C" fn shm_dispatch_server_set_client_weight(
+    handle: *mut DispatchServerHandle,
+    client_id: u32,
+    weight: u32,
+) -> shm_error_t {
+    if handle.is_null() {
+        return shm_error_t::SHM_ERROR_INVALID_PARAM;
+    }
+    let state = unsafe { &*(handle as *const DispatchServerState) };
+    match state.inner.set_client_weight(client_id, weight) {
+        Ok(()) => shm_error_t::SHM_SUCCESS,
+        Err(err) => err.into(),
+    }
+}
+
 /// # Safety
 /// `handle` обязан быть валидным DispatchServerHandle либо null.
 #[unsafe(no_mangle)]
@@ -370,6 +495,27 @@ pub unsafe extern "C" fn shm_dispatch_server_client_count(
     state.inner.client_count()
 }
 
+/// Телеметрия выделенного канала клиента; `false` — клиента нет или
+/// `out == NULL`.
+///
+/// # Safety
+/// `handle` обязан быть валидным DispatchServerHandle либо null.
+#[unsafe(no_mangle)]
+pub unsafe extern "C" fn shm_dispatch_server_client_stats(
+    handle: *const DispatchServerHandle,
+    client_id: u32,
+    out: *mut shm_channel_stats_t,
+) -> bool {
+    if handle.is_null() {
+        return false;
+    }
+    let state = unsafe { &*(handle as *const DispatchServerState) };
+    match state.inner.client_stats(client_id) {
+        Some(stats) => write_channel_stats(out, stats),
+        None => false,
+    }
+}
+
 /// # Safety
 /// `handle` обязан быть валидным DispatchServerHandle либо null. Поглощает handle.
 #[unsafe(no_mangle)]
@@ -412,10 +558,17 @@ pub unsafe extern "C" fn shm_dispatch_client_connect(
 
     let reg_val = unsafe { &*reg };
     let proc_name = unsafe { to_rust_str(reg_val.name) }.unwrap_or_default();
+    let topics = if reg_val.topics.is_null() || reg_val.topic_count == 0 {
+        Vec::new()
+    } else {
+        let count = reg_val.topic_count as usize;
+        unsafe { std::slice::from_raw_parts(reg_val.topics, count) }.to_vec()
+    };
     let registration = ClientRegistration {
         pid: reg_val.pid,
         revision: reg_val.revision,
         name: proc_name,
+        topics,
     };
 
     let callbacks_val = unsafe { *callbacks };
@@ -456,6 +609,25 @@ pub unsafe extern "C" fn shm_dispatch_client_send(
     }
 }
 
+/// Телеметрия выделенного канала на стороне клиента.
+///
+/// # Safety
+/// `handle` обязан быть валидным DispatchClientHandle либо null.
+#[unsafe(no_mangle)]
+pub unsafe extern "C" fn shm_dispatch_client_channel_stats(
+    handle: *const DispatchClientHandle,
+    out: *mut shm_channel_stats_t,
+) -> bool {
+    if handle.is_null() {
+        return false;
+    }
+    let state = unsafe { &*(handle as *const DispatchClientState) };
+    match state.inner.channel_stats() {
+        Some(stats) => write_channel_stats(out, stats),
+        None => false,
+    }
+}
+
 /// # Safety
 /// `handle` обязан быть валидным DispatchClientHandle либо null. Поглощает handle.
 #[unsafe(no_mangle)]
@@ -0,0 +1,152 @@
+//! Шарды лобби dispatch-сервера.
+//!
+//! Handshake на одном лобби `SharedServer` строго последователен, и при
+//! массовом переподключении клиенты выстраиваются в очередь на нём. Сервер
+//! поднимает `DispatchOptions::lobby_shards` лобби, у каждого свой поток:
+//! шард 0 живёт под базовым именем, остальные — под
+//! `{base}_L{i}`. Число шардов сервер публикует в control block каждого
+//! лобби (`RESERVED_LOBBY_SHARDS_INDEX`).
+//!
+//! Клиент читает число шардов из лобби под базовым именем и захватывает
+//! свободный шард тем же CAS-ом, что и слоты multi-режима
+//! (`RESERVED_CLAIM_INDEX`). Обход начинается со случайного шарда, так
+//! что конкурентные клиенты расходятся по разным лобби. Захват снимает
+//! только сервер: после ответа клиенту он ждёт, пока тот отключится, и лишь
+//! затем сбрасывает лобби (`finish`). Иначе следующий клиент мог бы начать
+//! handshake, пока предыдущий ещё читает ответ. Захват клиента, который
+//! упал, не дойдя до handshake, сервер снимает сам (`ClaimWatch`).
+
+use std::sync::atomic::Ordering;
+use std::thread;
+use std::time::{Duration, Instant};
+
+use crate::constants::{
+    CLAIM_FREE, RESERVED_CLAIM_INDEX, RESERVED_LOBBY_SHARDS_INDEX, RESERVED_OWNER_PID_INDEX,
+};
+use crate::error::{Result, ShmError};
+use crate::multi::{next_claim_token, try_claim_slot};
+use crate::naming::mapping_name;
+use crate::server::SharedServer;
+use crate::shared::SharedView;
+use crate::win::{self, Mapping};
+
+/// Предел `DispatchOptions::lobby_shards`: клиент обходит шарды по кругу.
+pub const MAX_LOBBY_SHARDS: usize = 64;
+
+/// Пауза клиента между обходами, когда все шарды заняты.
+const CLAIM_RETRY: Duration = Duration::from_millis(1);
+
+/// Имя лобби шарда `shard`.
+pub(super) fn shard_name(base: &str, shard: usize) -> String {
+    if shard == 0 {
+        base.to_owned()
+    } else {
+        format!("{base}_L{shard}")
+    }
+}
+
+/// Публикует число шардов в только что созданном лобби.
+pub(super) fn publish_shards(lobby: &SharedServer, shards: usize) {
+    lobby.view().control_block().reserved[RESERVED_LOBBY_SHARDS_INDEX]
+        .store(shards as u32, Ordering::Release);
+}
+
+/// Клиент: захватывает свободный шард лобби сервера `base`, возвращает имя
+/// лобби. Ждёт, пока шард освободится, не дольше `timeout`.
+pub(super) fn claim(base: &str, timeout: Duration) -> Result<String> {
+    let shards = {
+        let mapping = Mapping::open(&mapping_name(base))?;
+        let view = unsafe { SharedView::new(mapping.as_ptr()) };
+        let published = view.control_block().reserved[RESERVED_LOBBY_SHARDS_INDEX]
+            .load(Ordering::Acquire) as usize;
+        published.clamp(1, MAX_LOBBY_SHARDS)
+    };
+    let token = next_claim_token();
+    let first = token as usize % shards;
+    let start = Instant::now();
+    loop {
+        for k in 0..shards {
+            let name = shard_name(base, (first + k) % shards);
+            // Err — шард ещё не поднят (или пересоздаётся): пробуем следующий.
+            if try_claim_slot(&name, token).unwrap_or(false) {
+                return Ok(name);
+            }
+        }
+        if start.elapsed() >= timeout {
+            return Err(ShmError::Timeout);
+        }
+        thread::sleep(CLAIM_RETRY);
+    }
+}
+
+/// Сервер: клиент обслужен — дождаться его отключения (не дольше
+/// `timeout`), сбросить лобби и снять захват.
+pub(super) fn finish(lobby: &mut SharedServer, timeout: Duration, poll: Duration) {
+    if let Some(events) = lobby.events() {
+        let deadline = Instant::now() + timeout;
+        loop {
+            let remaining = deadline.saturating_duration_since(Instant::now());
+            if remaining.is_zero() || events.disconnect.wait(Some(remaining.min(poll))) != Ok(false)
+            {
+                break;
+            }
+        }
+    }
+    lobby.mark_disconnected();
+    // Клиент уже ушёл: оставшееся событие отключения — от него же, и
+    // следующему клиенту оно не должно достаться.
+    if let Some(events) = lobby.events() {
+        let _ = events.disconnect.wait(Some(Duration::ZERO));
+    }
+    lobby.view().control_block().reserved[RESERVED_CLAIM_INDEX]
+        .store(CLAIM_FREE, Ordering::Release);
+}
+
+/// Сервер: следит за захватом простаивающего лобби. Захват без handshake
+/// дольше `timeout` или от завершившегося процесса снимается.
+#[derive(Default)]
+pub(super) struct ClaimWatch {
+    seen: Option<(u32, Instant)>,
+}
+
+impl ClaimWatch {
+    pub(super) fn check(&mut self, lobby: &SharedServer, timeout: Duration) {
+        let control = lobby.view().control_block();
+        let claim = control.reserved[RESERVED_CLAIM_INDEX].load(Ordering::Acquire);
+        if claim == CLAIM_FREE {
+            self.seen = None;
+            return;
+        }
+        match self.seen {
+            Some((token, since)) if token == claim => {
+                let owner = control.reserved[RESERVED_OWNER_PID_INDEX].load(Ordering::Acquire);
+                if since.elapsed() >= timeout || !win::is_process_alive(owner) {
+                    let _ = control.reserved[RESERVED_CLAIM_INDEX].compare_exchange(
+                        claim,
+                        CLAIM_FREE,
+                        Ordering::AcqRel,
+                        Ordering::Acquire,
+                    );
+                    self.seen = None;
+                }
+            }
+            _ => self.seen = Some((claim, Instant::now())),
+        }
+    }
+
+    /// Лобби обслужило клиента: захват снят `finish`.
+    pub(super) fn reset(&mut self) {
+        self.seen = None;
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    #[test]
+    fn shard_zero_keeps_base_name() {
+        assert_eq!(shard_name("NxT", 0), "NxT");
+        assert_eq!(shard_name("NxT", 3), "NxT_L3");
+    }
+}
@@ -13,23 +13,38 @@
 //!     ↓
 //! Обмен 1:1 на выделенном канале
 //! ```
+//!
+//! Кроме адресных `send_to` и `broadcast` сервер маршрутизирует по топикам:
+//! клиент перечисляет их в `ClientRegistration::topics`, сервер меняет
+//! подписки `subscribe`/`unsubscribe`, а `publish(topic, data)` пишет только
+//! подписчикам (см. `topics::TopicIndex`).
 
 pub mod ffi;
+mod lobby;
+mod pool;
 pub mod protocol;
+mod topics;
+mod warm;
 
 use std::collections::HashMap;
-use std::sync::atomic::{AtomicBool, AtomicU32, Ordering};
+use std::sync::atomic::{AtomicBool, AtomicU32, AtomicUsize, Ordering};
 use std::sync::{Arc, Condvar, Mutex, RwLock};
 use std::thread::{self, JoinHandle};
 use std::time::Duration;
 
 use crate::auto::{AutoClient, AutoHandler, AutoOptions, AutoServer, ChannelKind};
+use crate::broadcast::BroadcastSender;
 use crate::client::SharedClient;
 use crate::constants::MAX_MESSAGE_SIZE;
 use crate::error::{Result, ShmError};
+use crate::layout::ChannelGeometry;
 use crate::server::SharedServer;
+use crate::stats::ChannelStatsSnapshot;
+use crate::trace;
 use crate::wait_delay;
+use crate::win::SectionOptions;
 
+pub use lobby::MAX_LOBBY_SHARDS;
 pub use protocol::{RegistrationRequest, RegistrationResponse};
 
 // ─── Public types ────────────────────────────────────────────────────────────
@@ -40,6 +55,10 @@ pub struct ClientRegistration {
     pub pid: u32,
     pub revision: u16,
     pub name: String,
+    /// Топики, на которые клиент подписан с момента подключения (не больше
+    /// `protocol::MAX_REGISTRATION_TOPICS`, лишние отбрасываются). Дальше
+    /// подписками управляет сервер; `client_info` возвращает исходный список.
+    pub topics: Vec<u32>,
 }
 
 /// Callback-интерфейс для событий DispatchServer.
@@ -74,6 +93,11 @@ pub trait DispatchClientHandler: Send + Sync + 'static {
     fn on_error(&self, err: ShmError) {
         let _ = err;
     }
+
+    /// Клиент отстал от broadcast-секции и пропустил `dropped` рассылок.
+    fn on_overflow(&self, dropped: u32) {
+        let _ = dropped;
+    }
 }
 
 /// Настройки DispatchServer.
@@ -87,6 +111,38 @@ pub struct DispatchOptions {
     pub poll_timeout: Duration,
     /// Количество сообщений за один цикл на каждом клиентском канале.
     pub recv_batch: usize,
+    /// Бюджет времени на ход клиентского канала (пачка вместе с
+    /// `on_message`). Ненулевой — пачка подбирается по стоимости сообщения,
+    /// не больше `recv_batch` (с `io_threads > 0` — × вес клиента). 0 —
+    /// фиксированная пачка.
+    pub recv_budget: Duration,
+    /// Потоков общего I/O-пула для выделенных каналов. 0 — свой `AutoServer`
+    /// с потоком на каждого клиента (прежнее поведение). Иначе каналы
+    /// раздаются потокам пула (каждому — наименее загруженный поток, события
+    /// ждёт его порт завершения), а `send_to` пишет прямо в кольцо канала.
+    /// Разумное значение — `std::thread::available_parallelism()`.
+    pub io_threads: usize,
+    /// Ёмкость broadcast-секции в байтах (степень двойки, от 256 KiB: секция
+    /// должна вмещать два сообщения `MAX_MESSAGE_SIZE`, как каналы клиентов).
+    /// 0 — `broadcast` пишет копию в кольцо каждого клиента (прежнее поведение).
+    /// Иначе сообщение пишется один раз в общую секцию `{name}_BCAST`, а
+    /// клиентам уходит только пробуждение. Порядок относительно `send_to`
+    /// не гарантируется.
+    pub broadcast_capacity: usize,
+    /// Выделение памяти секций каналов клиентов и broadcast-секции (лобби —
+    /// всегда на обычных страницах).
+    pub memory: SectionOptions,
+    /// Лобби, принимающих регистрации параллельно (1..=`MAX_LOBBY_SHARDS`),
+    /// у каждого свой поток. Клиент сам выбирает свободное (см. `lobby`);
+    /// при массовом переподключении handshake-и идут одновременно, а не
+    /// в очередь на единственном лобби.
+    pub lobby_shards: usize,
+    /// Запас заранее созданных (и pre-fault-нутых) выделенных каналов. 0 —
+    /// канал создаётся на регистрации (прежнее поведение). Иначе регистрация
+    /// забирает готовый канал, а фоновый поток доливает запас каналами с
+    /// новыми именами. Канал отключившегося клиента в запас не возвращается:
+    /// его имя знает прежний клиент.
+    pub warm_channels: usize,
 }
 
 impl Default for DispatchOptions {
@@ -96,6 +152,12 @@ impl Default for DispatchOptions {
             channel_connect_timeout: Duration::from_secs(30),
             poll_timeout: Duration::from_millis(50),
             recv_batch: 32,
+            recv_budget: Duration::ZERO,
+            io_threads: 0,
+            broadcast_capacity: 0,
+            memory: SectionOptions::DEFAULT,
+            lobby_shards: 1,
+            warm_channels: 0,
         }
     }
 }
@@ -132,9 +194,54 @@ impl Default for DispatchClientOptions {
 
 // ─── DispatchServer ──────────────────────────────────────────────────────────
 
+/// Транспорт выделенного канала.
+enum ClientChannel {
+    /// Собственный `AutoServer` со своим worker-потоком.
+    Auto(AutoServer),
+    /// Канал, обслуживаемый потоком общего пула (`DispatchOptions::io_threads`).
+    Pooled(Arc<pool::PooledChannel>),
+}
+
+impl ClientChannel {
+    fn send(&self, data: &[u8]) -> Result<()> {
+        match self {
+            Self::Auto(server) => server.send(data),
+            Self::Pooled(channel) => channel.send(data),
+        }
+    }
+
+    fn notify(&self) -> Result<()> {
+        match self {
+            Self::Auto(server) => server.notify_client(),
+            Self::Pooled(channel) => channel.notify(),
+        }
+    }
+
+    fn stats(&self) -> ChannelStatsSnapshot {
+        match self {
+            Self::Auto(server) => server.stats().channel,
+            Self::Pooled(channel) => channel.stats(),
+        }
+    }
+
+    fn stop(&self) {
+        match self {
+            Self::Auto(server) => server.stop(),
+            Self::Pooled(channel) => channel.stop(),
+        }
+    }
+
+    /// У `AutoServer` свой поток на канал — делить его не с кем.
+    fn set_weight(&self, weight: u32) {
+        if let Self::Pooled(channel) = self {
+            channel.set_weight(weight);
+        }
+    }
+}
+
 /// Активный клиент на выделенном канале.
 struct DispatchedClient {
-    server: AutoServer,
+    channel: ClientChannel,
     info: ClientRegistration,
     channel_name: String,
     /// Устанавливается в true, когда отключение уже обработано (предотвращает двойное уведомление).
@@ -144,18 +251,90 @@ struct DispatchedClient {
 /// Общая карта клиентов, доступная и серверу, и proxy-обработчикам.
 type ClientMap = Arc<RwLock<HashMap<u32, DispatchedClient>>>;
 
+/// Индекс подписок. Порядок блокировок — карта клиентов, затем индекс.
+type TopicMap = Arc<RwLock<topics::TopicIndex>>;
+
+/// Вносит клиента в карту и подписывает на топики регистрации под одним
+/// write-локом карты: отключение (`remove_registered`) не вклинится между
+/// ними, и в индексе не останется подписок ушедшего клиента.
+fn insert_registered(
+    clients: &ClientMap,
+    topics: &TopicMap,
+    client_id: u32,
+    client: DispatchedClient,
+) {
+    let mut clients = clients.write().unwrap();
+    if !client.info.topics.is_empty() {
+        let mut index = topics.write().unwrap();
+        for &topic in &client.info.topics {
+            index.subscribe(topic, client_id);
+        }
+    }
+    clients.insert(client_id, client);
+}
+
+/// Убирает клиента из карты (под её write-локом у вызывающего) вместе со
+/// всеми его подписками.
+fn remove_registered(
+    clients: &mut HashMap<u32, DispatchedClient>,
+    topics: &TopicMap,
+    client_id: u32,
+) -> Option<DispatchedClient> {
+    let removed = clients.remove(&client_id);
+    if removed.is_some() {
+        topics.write().unwrap().remove_client(client_id);
+    }
+    removed
+}
+
+/// Клиент, который может читать broadcast-секцию, но ещё не учтён в карте:
+/// получил ответ лобби и не внесён в неё. Пока такие есть, `publish` не
+/// пишет в общую секцию — сообщение топика прочёл бы и не подписанный на
+/// него клиент.
+struct UnlistedReader(Arc<AtomicUsize>);
+
+impl UnlistedReader {
+    /// Вызывается под write-локом карты: `publish`, уже решивший писать в
+    /// секцию под read-локом, дописывает до того, как клиент её откроет.
+    fn new(count: &Arc<AtomicUsize>) -> Self {
+        count.fetch_add(1, Ordering::AcqRel);
+        Self(Arc::clone(count))
+    }
+}
+
+impl Drop for UnlistedReader {
+    fn drop(&mut self) {
+        self.0.fetch_sub(1, Ordering::AcqRel);
+    }
+}
+
 /// Центральный dispatch-сервер — одно лобби, динамические каналы на клиента.
 pub struct DispatchServer {
     base_name: String,
     clients: ClientMap,
+    topics: TopicMap,
     running: Arc<AtomicBool>,
     next_client_id: Arc<AtomicU32>,
-    worker_handle: Mutex<Option<JoinHandle<()>>>,
+    /// Потоки шардов лобби (`DispatchOptions::lobby_shards`).
+    worker_handles: Mutex<Vec<JoinHandle<()>>>,
     /// Потоки, ожидающие подключения клиента к выделенному каналу (см.
     /// `handle_lobby_client`) -- обязаны быть заджойнены в `stop()` ДО
     /// возврата, иначе `on_client_connect` мог бы выстрелить уже после того,
     /// как C-вызывающий код счёл сервер остановленным и освободил user_data.
     pending_connects: Mutex<Vec<JoinHandle<()>>>,
+    /// Общий I/O-пул; `None` при `io_threads == 0`.
+    pool: Option<pool::IoPool>,
+    /// Общая broadcast-секция; `None` при `broadcast_capacity == 0`.
+    fanout: Option<Mutex<BroadcastSender>>,
+    /// Число живых `UnlistedReader`.
+    unlisted: Arc<AtomicUsize>,
+    /// `disconnect_client` уже отключал клиента. Его процесс может и дальше
+    /// читать открытую секцию, а пересоздать её под тем же именем нельзя,
+    /// пока она у кого-то открыта, поэтому до конца жизни сервера топики
+    /// идут только по каналам клиентов.
+    evicted: AtomicBool,
+    /// Запас готовых каналов; `None` при `warm_channels == 0`.
+    warm: Option<Arc<warm::WarmPool>>,
     handler: Arc<dyn DispatchHandler>,
     options: DispatchOptions,
 }
@@ -167,39 +346,133 @@ impl DispatchServer {
         handler: Arc<dyn DispatchHandler>,
         options: DispatchOptions,
     ) -> Result<Arc<Self>> {
+        options.memory.validate()?;
+        if options.lobby_shards == 0 || options.lobby_shards > MAX_LOBBY_SHARDS {
+            return Err(ShmError::InvalidConfig(
+                "lobby_shards must be in 1..=MAX_LOBBY_SHARDS",
+            ));
+        }
+        let fanout = if options.broadcast_capacity > 0 {
+            Some(Mutex::new(BroadcastSender::create(
+                name,
+                options.broadcast_capacity,
+                MAX_MESSAGE_SIZE,
+                &options.memory,
+            )?))
+        } else {
+            None
+        };
         let running = Arc::new(AtomicBool::new(true));
+        let clients: ClientMap = Arc::new(RwLock::new(HashMap::new()));
+        let topics: TopicMap = Arc::default();
+        let warm = (options.warm_channels > 0)
+            .then(|| Arc::new(warm::WarmPool::new(options.warm_channels)));
+
+        let pool = if options.io_threads > 0 {
+            let pool = pool::IoPool::start(
+                name,
+                options.io_threads,
+                handler.clone(),
+                clients.clone(),
+                topics.clone(),
+                running.clone(),
+                options.poll_timeout,
+                options.recv_batch,
+                options.recv_budget,
+            );
+            match pool {
+                Ok(pool) => Some(pool),
+                Err(err) => {
+                    running.store(false, Ordering::Release);
+                    return Err(err);
+                }
+            }
+        } else {
+            None
+        };
 
         let server = Arc::new(Self {
             base_name: name.to_owned(),
-            clients: Arc::new(RwLock::new(HashMap::new())),
+            clients,
+            topics,
             running,
             next_client_id: Arc::new(AtomicU32::new(1)),
-            worker_handle: Mutex::new(None),
+            worker_handles: Mutex::new(Vec::new()),
             pending_connects: Mutex::new(Vec::new()),
+            pool,
+            fanout,
+            unlisted: Arc::default(),
+            evicted: AtomicBool::new(false),
+            warm,
             handler,
             options,
         });
 
-        let server_clone = server.clone();
-        let name_owned = name.to_owned();
-        // Имя потока только в debug (короткий непрозрачный тег `xsd-{name}`,
-        // чтобы локальные трейсы совпадали с сегментом), анонимно в release,
-        // чтобы Process Explorer / Process Hacker не показывал
-        // "xshm-dispatch-…" как заметный маркер в хост-процессе.
-        #[cfg_attr(not(debug_assertions), allow(unused_mut))]
-        let mut builder = thread::Builder::new();
-        #[cfg(debug_assertions)]
-        {
-            builder = builder.name(format!("xsd-{name}"));
+        // Запас наполняется до возврата: первый же шторм регистраций
+        // получает готовые каналы.
+        if let Some(warm) = &server.warm {
+            let geometry = server.warm_geometry();
+            for _ in 0..server.options.warm_channels {
+                let name = server.generate_channel_name();
+                match SharedServer::start_with(&name, &geometry) {
+                    Ok(channel) => warm.put(warm::WarmChannel {
+                        name,
+                        server: channel,
+                    }),
+                    Err(err) => {
+                        server.stop();
+                        return Err(err);
+                    }
+                }
+            }
+        }
+
+        for shard in 0..server.options.lobby_shards {
+            let server_clone = server.clone();
+            // Имя потока только в debug (короткий непрозрачный тег
+            // `xsd-{лобби}`, чтобы локальные трейсы совпадали с сегментом),
+            // анонимно в release, чтобы Process Explorer / Process Hacker не
+            // показывал "xshm-dispatch-…" как заметный маркер в хост-процессе.
+            #[cfg_attr(not(debug_assertions), allow(unused_mut))]
+            let mut builder = thread::Builder::new();
+            #[cfg(debug_assertions)]
+            {
+                builder = builder.name(format!("xsd-{}", lobby::shard_name(name, shard)));
+            }
+            let spawned = builder.spawn(move || server_clone.worker_loop(shard));
+            match spawned {
+                Ok(handle) => server.worker_handles.lock().unwrap().push(handle),
+                Err(e) => {
+                    // Уже запущенные шарды держат клон Arc<Self>: без stop()
+                    // они пережили бы ошибку старта.
+                    server.stop();
+                    return Err(ShmError::WindowsError {
+                        code: e.raw_os_error().unwrap_or(-1) as u32,
+                        context: "spawn dispatch worker",
+                    });
+                }
+            }
         }
-        let handle = builder
-            .spawn(move || server_clone.worker_loop(&name_owned))
-            .map_err(|e| ShmError::WindowsError {
-                code: e.raw_os_error().unwrap_or(-1) as u32,
-                context: "spawn dispatch worker",
-            })?;
 
-        *server.worker_handle.lock().unwrap() = Some(handle);
+        if server.warm.is_some() {
+            let server_clone = server.clone();
+            #[cfg_attr(not(debug_assertions), allow(unused_mut))]
+            let mut builder = thread::Builder::new();
+            #[cfg(debug_assertions)]
+            {
+                builder = builder.name(format!("xsw-{name}"));
+            }
+            match builder.spawn(move || server_clone.warm_loop()) {
+                Ok(handle) => server.worker_handles.lock().unwrap().push(handle),
+                Err(e) => {
+                    server.stop();
+                    return Err(ShmError::WindowsError {
+                        code: e.raw_os_error().unwrap_or(-1) as u32,
+                        context: "spawn dispatch warm filler",
+                    });
+                }
+            }
+        }
 
         Ok(server)
     }
@@ -208,28 +481,118 @@ impl DispatchServer {
     pub fn send_to(&self, client_id: u32, data: &[u8]) -> Result<()> {
         let clients = self.clients.read().unwrap();
         let client = clients.get(&client_id).ok_or(ShmError::NotConnected)?;
-        client.server.send(data)
+        client.channel.send(data)
     }
 
     /// Рассылает сообщение всем подключённым клиентам.
+    ///
+    /// С broadcast-секцией payload копируется один раз, а каждому клиенту
+    /// достаётся только `SetEvent`; возвращается число разбуженных клиентов.
     pub fn broadcast(&self, data: &[u8]) -> Result<u32> {
+        if let Some(fanout) = &self.fanout {
+            fanout.lock().unwrap().publish(data)?;
+        }
         let clients = self.clients.read().unwrap();
         let mut sent = 0u32;
         for client in clients.values() {
-            if client.server.send(data).is_ok() {
+            let delivered = if self.fanout.is_some() {
+                client.channel.notify()
+            } else {
+                client.channel.send(data)
+            };
+            if delivered.is_ok() {
+                sent += 1;
+            }
+        }
+        Ok(sent)
+    }
+
+    /// Публикует сообщение в топик: получают только его подписчики.
+    ///
+    /// Копия payload-а пишется в кольцо каждого подписчика. Если подписаны
+    /// все подключённые клиенты, есть broadcast-секция, нет клиентов посреди
+    /// регистрации (`UnlistedReader`) и никого не отключал
+    /// `disconnect_client`, сообщение, как в `broadcast`, пишется в секцию
+    /// один раз, а подписчикам уходит только
+    /// пробуждение; порядок таких публикаций относительно остальных, как и у
+    /// `broadcast`, не гарантируется. Возвращает число получивших.
+    pub fn publish(&self, topic: u32, data: &[u8]) -> Result<u32> {
+        let clients = self.clients.read().unwrap();
+        let index = self.topics.read().unwrap();
+        let ids = index.subscribers(topic);
+        let everyone = self.fanout.is_some()
+            && !clients.is_empty()
+            && self.unlisted.load(Ordering::Acquire) == 0
+            && !self.evicted.load(Ordering::Acquire)
+            && ids.len() >= clients.len()
+            && clients.keys().all(|id| ids.binary_search(id).is_ok());
+        if everyone {
+            if let Some(fanout) = &self.fanout {
+                fanout.lock().unwrap().publish(data)?;
+            }
+        }
+        let mut sent = 0u32;
+        for &id in ids {
+            let Some(client) = clients.get(&id) else {
+                continue;
+            };
+            let delivered = if everyone {
+                client.channel.notify()
+            } else {
+                client.channel.send(data)
+            };
+            if delivered.is_ok() {
                 sent += 1;
             }
         }
         Ok(sent)
     }
 
-    /// Отключает конкретного клиента и уничтожает его канал.
+    /// Подписывает подключённого клиента на топик. Повторная подписка — no-op.
+    pub fn subscribe(&self, client_id: u32, topic: u32) -> Result<()> {
+        let clients = self.clients.read().unwrap();
+        if !clients.contains_key(&client_id) {
+            return Err(ShmError::NotConnected);
+        }
+        self.topics.write().unwrap().subscribe(topic, client_id);
+        Ok(())
+    }
+
+    /// Снимает подписку клиента; `false` — он не был подписан.
+    pub fn unsubscribe(&self, client_id: u32, topic: u32) -> bool {
+        self.topics.write().unwrap().unsubscribe(topic, client_id)
+    }
+
+    /// Подключённые подписчики топика в порядке возрастания ID.
+    pub fn subscribers(&self, topic: u32) -> Vec<u32> {
+        let clients = self.clients.read().unwrap();
+        let index = self.topics.read().unwrap();
+        index
+            .subscribers(topic)
+            .iter()
+            .copied()
+            .filter(|id| clients.contains_key(id))
+            .collect()
+    }
+
+    /// Отключает конкретного клиента и уничтожает его канал. С этого
+    /// момента `publish` не пользуется общей секцией (см. `evicted`).
     pub fn disconnect_client(&self, client_id: u32) -> Result<()> {
-        let removed = self.clients.write().unwrap().remove(&client_id);
+        let removed = {
+            let mut clients = self.clients.write().unwrap();
+            let removed = remove_registered(&mut clients, &self.topics, client_id);
+            if removed.is_some() {
+                // под write-локом: `publish`, уже выбравший секцию под
+                // read-локом, дописал до того, как клиент исчез из карты
+                self.evicted.store(true, Ordering::Release);
+            }
+            removed
+        };
         if let Some(client) = removed {
             // Помечаем как отключённого, чтобы AutoProxyHandler не уведомил повторно
             client.disconnected.store(true, Ordering::Release);
-            client.server.stop();
+            client.channel.stop();
+            trace::disconnected(&client.channel_name, client_id);
             self.handler.on_client_disconnect(client_id);
             Ok(())
         } else {
@@ -261,6 +624,27 @@ impl DispatchServer {
             .map(|c| c.info.clone())
     }
 
+    /// Статистика выделенного канала клиента (см. `ChannelStatsSnapshot`).
+    pub fn client_stats(&self, client_id: u32) -> Option<ChannelStatsSnapshot> {
+        self.clients
+            .read()
+            .unwrap()
+            .get(&client_id)
+            .map(|c| c.channel.stats())
+    }
+
+    /// Вес клиента в обходе горячих каналов потока пула (1..=`MAX_CLIENT_WEIGHT`,
+    /// по умолчанию 1): за ход клиент отдаёт до `weight` пачек. Без
+    /// `io_threads` у каждого клиента свой поток, и вес ни на что не
+    /// влияет.
+    pub fn set_client_weight(&self, client_id: u32, weight: u32) -> Result<()> {
+        let weight = crate::sched::check_weight(weight)?;
+        let clients = self.clients.read().unwrap();
+        let client = clients.get(&client_id).ok_or(ShmError::NotConnected)?;
+        client.channel.set_weight(weight);
+        Ok(())
+    }
+
     /// Возвращает имя канала клиента. Названо `channel_name` (не `client_channel`)
     /// для единообразия с `MultiServer::channel_name` (0.6.0, аудит API).
     pub fn channel_name(&self, client_id: u32) -> Option<String> {
@@ -286,7 +670,11 @@ impl DispatchServer {
         // фикс, что и для MultiServer::stop() (аудит 2026-07-10): worker
         // держит собственный клон Arc<Self>, поэтому расчёт только на Drop
         // гонял бы точно так же.
-        if let Some(handle) = self.worker_handle.lock().unwrap().take() {
+        if let Some(warm) = &self.warm {
+            warm.wake();
+        }
+        let workers: Vec<_> = self.worker_handles.lock().unwrap().drain(..).collect();
+        for handle in workers {
             let _ = handle.join();
         }
         // Lobby worker уже остановлен -> новых pending-connect потоков не
@@ -297,6 +685,9 @@ impl DispatchServer {
         for handle in pending {
             let _ = handle.join();
         }
+        if let Some(pool) = &self.pool {
+            pool.join();
+        }
     }
 
     /// Базовое имя dispatch-сервера.
@@ -333,20 +724,79 @@ impl DispatchServer {
         format!("{:016x}", hasher.finish())
     }
 
-    /// Главный worker loop — принимает клиентов через лобби.
+    /// Геометрия выделенного канала клиента: кольца по умолчанию, память — по
+    /// `DispatchOptions::memory`.
+    fn channel_geometry(&self) -> ChannelGeometry {
+        ChannelGeometry {
+            memory: self.options.memory,
+            ..ChannelGeometry::default()
+        }
+    }
+
+    /// Геометрия канала из запаса: та же, но секция pre-fault-ится сразу —
+    /// ради этого запас и держится.
+    fn warm_geometry(&self) -> ChannelGeometry {
+        let mut geometry = self.channel_geometry();
+        geometry.memory.prefault = true;
+        geometry
+    }
+
+    /// Канал для нового клиента: из запаса, а если он пуст — новый.
+    fn new_channel(&self) -> Result<(String, SharedServer)> {
+        if let Some(channel) = self.warm.as_ref().and_then(|warm| warm.take()) {
+            return Ok((channel.name, channel.server));
+        }
+        let name = self.generate_channel_name();
+        let server = SharedServer::start_with(&name, &self.channel_geometry())?;
+        Ok((name, server))
+    }
+
+    /// Фоновый поток запаса: доливает каналы, которые забрали регистрации.
+    fn warm_loop(&self) {
+        let Some(warm) = &self.warm else {
+            return;
+        };
+        let geometry = self.warm_geometry();
+        while self.running.load(Ordering::Acquire) {
+            let deficit = warm.wait_deficit(self.options.poll_timeout);
+            for _ in 0..deficit {
+                if !self.running.load(Ordering::Acquire) {
+                    return;
+                }
+                let name = self.generate_channel_name();
+                match SharedServer::start_with(&name, &geometry) {
+                    Ok(server) => warm.put(warm::WarmChannel { name, server }),
+                    Err(err) => {
+                        self.handler.on_error(None, err);
+                        if !wait_delay(&self.running, self.options.poll_timeout) {
+                            return;
+                        }
+                        break;
+                    }
+                }
+            }
+        }
+    }
+
+    /// Worker loop шарда лобби — принимает клиентов через своё лобби.
     ///
-    /// Сам lobby-handshake (single-client протокол) неизбежно последователен,
-    /// но обрабатывается быстро (только чтение регистрации + ответ). Ожидание
+    /// Сам lobby-handshake (single-client протокол) на одном лобби неизбежно
+    /// последователен, но обрабатывается быстро (только чтение регистрации +
+    /// ответ), а шарды (`lobby_shards`) работают параллельно. Ожидание
     /// подключения клиента к его выделенному каналу (до `channel_connect_timeout`,
     /// по умолчанию 30с) вынесено в отдельный поток (см. `handle_lobby_client`),
     /// поэтому один медленный клиент больше не блокирует регистрацию остальных.
-    fn worker_loop(&self, base_name: &str) {
+    fn worker_loop(&self, shard: usize) {
+        let lobby_name = lobby::shard_name(&self.base_name, shard);
         let mut buffer = Vec::with_capacity(MAX_MESSAGE_SIZE);
 
         while self.running.load(Ordering::Acquire) {
             // Создаём лобби (или пересоздаём при ошибке)
-            let mut lobby_server = match SharedServer::start(base_name) {
-                Ok(s) => s,
+            let mut lobby_server = match SharedServer::start(&lobby_name) {
+                Ok(s) => {
+                    lobby::publish_shards(&s, self.options.lobby_shards);
+                    s
+                }
                 Err(err) => {
                     self.handler.on_error(None, err);
                     if !wait_delay(&self.running, self.options.poll_timeout) {
@@ -357,16 +807,25 @@ impl DispatchServer {
             };
 
             // Внутренний цикл: последовательный приём клиентов через лобби
+            let mut claim = lobby::ClaimWatch::default();
             while self.running.load(Ordering::Acquire) {
                 match lobby_server.wait_for_client(Some(self.options.poll_timeout)) {
                     Ok(()) => {
                         // Клиент подключился — обрабатываем регистрацию
                         self.handle_lobby_client(&mut lobby_server, &mut buffer);
 
-                        // Сбрасываем лобби для следующего клиента
-                        lobby_server.mark_disconnected();
+                        // Сбрасываем лобби для следующего клиента, когда
+                        // этот дочитает ответ и отключится
+                        lobby::finish(
+                            &mut lobby_server,
+                            self.options.lobby_timeout,
+                            self.options.poll_timeout,
+                        );
+                        claim.reset();
+                    }
+                    Err(ShmError::Timeout) => {
+                        claim.check(&lobby_server, self.options.lobby_timeout);
                     }
-                    Err(ShmError::Timeout) => continue,
                     Err(ShmError::AlreadyConnected) => {
                         lobby_server.mark_disconnected();
                     }
@@ -382,9 +841,11 @@ impl DispatchServer {
         let mut clients = self.clients.write().unwrap();
         for (id, client) in clients.drain() {
             client.disconnected.store(true, Ordering::Release);
-            client.server.stop();
+            client.channel.stop();
+            trace::disconnected(&client.channel_name, id);
             self.handler.on_client_disconnect(id);
         }
+        self.topics.write().unwrap().clear();
     }
 
     /// Обрабатывает одного клиента в лобби: читает регистрацию, создаёт канал, отвечает.
@@ -440,14 +901,24 @@ impl DispatchServer {
         };
 
         let client_id = self.next_client_id.fetch_add(1, Ordering::Relaxed);
-        let channel_name = self.generate_channel_name();
+        // До ответа лобби: клиент откроет broadcast-секцию сразу после него.
+        let unlisted = {
+            let _clients = self.clients.write().unwrap();
+            UnlistedReader::new(&self.unlisted)
+        };
 
         let info = ClientRegistration {
             pid: request.pid,
             revision: request.revision,
             name: request.name.clone(),
+            topics: request.topics,
         };
 
+        if let Some(pool) = &self.pool {
+            self.register_pooled(pool, lobby, client_id, info, unlisted);
+            return;
+        }
+
         // Создаём AutoServer для выделенного канала этого клиента
         let connect_signal = Arc::new((Mutex::new(false), Condvar::new()));
 
@@ -455,6 +926,7 @@ impl DispatchServer {
             client_id,
             handler: self.handler.clone(),
             clients: Arc::clone(&self.clients),
+            topics: Arc::clone(&self.topics),
             connect_signal: connect_signal.clone(),
         });
 
@@ -462,11 +934,16 @@ impl DispatchServer {
             connect_timeout: self.options.channel_connect_timeout,
             poll_timeout: self.options.poll_timeout,
             recv_batch: self.options.recv_batch,
+            recv_budget: self.options.recv_budget,
+            geometry: self.channel_geometry(),
             ..AutoOptions::default()
         };
 
-        let auto_server = match AutoServer::start(&channel_name, proxy_handler, auto_options) {
-            Ok(s) => s,
+        let started = self.new_channel().and_then(|(name, server)| {
+            AutoServer::start_on(&name, server, proxy_handler, auto_options).map(|s| (name, s))
+        });
+        let (channel_name, auto_server) = match started {
+            Ok(started) => started,
             Err(err) => {
                 self.handler.on_error(None, err);
                 let reject = protocol::encode_response(&RegistrationResponse {
@@ -505,6 +982,7 @@ impl DispatchServer {
         // сразу после этого — лобби готово к следующему клиенту немедленно.
         let handler = self.handler.clone();
         let clients_map = Arc::clone(&self.clients);
+        let topics = Arc::clone(&self.topics);
         let running = Arc::clone(&self.running);
         let channel_connect_timeout = self.options.channel_connect_timeout;
         let poll_timeout = self.options.poll_timeout;
@@ -542,15 +1020,18 @@ impl DispatchServer {
                 return;
             }
 
-            clients_map.write().unwrap().insert(
+            insert_registered(
+                &clients_map,
+                &topics,
                 client_id,
                 DispatchedClient {
-                    server: auto_server,
+                    channel: ClientChannel::Auto(auto_server),
                     info: info.clone(),
                     channel_name,
                     disconnected: AtomicBool::new(false),
                 },
             );
+            drop(unlisted);
 
             handler.on_client_connect(client_id, &info);
         });
@@ -562,18 +1043,69 @@ impl DispatchServer {
         pending.retain(|h| !h.is_finished());
         pending.push(join_handle);
     }
+
+    /// Вариант `handle_lobby_client` для общего I/O-пула: канал сразу уходит
+    /// потоку пула, который сам дождётся подключения (до
+    /// `channel_connect_timeout`) — отдельный поток на ожидание не нужен.
+    fn register_pooled(
+        &self,
+        pool: &pool::IoPool,
+        lobby: &SharedServer,
+        client_id: u32,
+        info: ClientRegistration,
+        unlisted: UnlistedReader,
+    ) {
+        let added = self.new_channel().and_then(|(channel_name, server)| {
+            let timeout = self.options.channel_connect_timeout;
+            let name = channel_name.clone();
+            pool.add(client_id, server, info, name, timeout, unlisted)
+                .map(|()| channel_name)
+        });
+        let response = match added {
+            Ok(channel_name) => RegistrationResponse {
+                status: protocol::STATUS_OK,
+                client_id,
+                channel_name,
+            },
+            Err(err) => {
+                self.handler.on_error(None, err);
+                RegistrationResponse {
+                    status: protocol::STATUS_REJECTED,
+                    client_id: 0,
+                    channel_name: String::new(),
+                }
+            }
+        };
+
+        // Если ответ не дошёл, зарегистрированный канал никто не откроет —
+        // поток пула снимет его по channel_connect_timeout.
+        if let Err(err) = lobby.send_to_client(&protocol::encode_response(&response)) {
+            self.handler.on_error(None, err);
+            return;
+        }
+        if let Some(events) = lobby.events() {
+            let _ = events.s2c.data.set();
+        }
+    }
 }
 
 impl Drop for DispatchServer {
     fn drop(&mut self) {
         self.running.store(false, Ordering::Release);
-        if let Some(handle) = self.worker_handle.lock().unwrap().take() {
+        if let Some(warm) = &self.warm {
+            warm.wake();
+        }
+        let workers: Vec<_> = self.worker_handles.lock().unwrap().drain(..).collect();
+        for handle in workers {
             let _ = handle.join();
         }
         let pending: Vec<_> = self.pending_connects.lock().unwrap().drain(..).collect();
         for handle in pending {
             let _ = handle.join();
         }
+        if let Some(pool) = &self.pool {
+            pool.join();
+        }
     }
 }
 
@@ -583,6 +1115,7 @@ struct AutoProxyHandler {
     client_id: u32,
     handler: Arc<dyn DispatchHandler>,
     clients: ClientMap,
+    topics: TopicMap,
     connect_signal: Arc<(Mutex<bool>, Condvar)>,
 }
 
@@ -614,7 +1147,7 @@ impl AutoHandler for AutoProxyHandler {
                     .compare_exchange(false, true, Ordering::AcqRel, Ordering::Relaxed)
                     .is_ok()
                 {
-                    clients.remove(&self.client_id)
+                    remove_registered(&mut clients, &self.topics, self.client_id)
                 } else {
                     None
                 }
@@ -685,6 +1218,9 @@ impl DispatchClient {
             poll_timeout: options.poll_timeout,
             max_send_queue: options.max_send_queue,
             recv_batch: options.recv_batch,
+            // Секции может не быть (broadcast_capacity == 0) — тогда клиент
+            // молча читает только своё кольцо.
+            broadcast: Some(name.to_owned()),
             ..AutoOptions::default()
         };
 
@@ -727,6 +1263,15 @@ impl DispatchClient {
         self.running.load(Ordering::Acquire) && self.auto_client.lock().unwrap().is_some()
     }
 
+    /// Статистика выделенного канала на стороне клиента; `None` после `stop`.
+    pub fn channel_stats(&self) -> Option<ChannelStatsSnapshot> {
+        self.auto_client
+            .lock()
+            .unwrap()
+            .as_ref()
+            .map(|client| client.stats().channel)
+    }
+
     /// Останавливает клиента и отключается.
     pub fn stop(&self) {
         self.running.store(false, Ordering::Release);
@@ -756,13 +1301,18 @@ fn lobby_register(
     options: &DispatchClientOptions,
     buffer: &mut Vec<u8>,
 ) -> Result<(u32, String)> {
-    let client = SharedClient::connect(base_name, options.lobby_timeout)?;
+    // Свободный шард лобби; его захват снимет сервер, когда обслужит нас.
+    let start = std::time::Instant::now();
+    let lobby_name = lobby::claim(base_name, options.lobby_timeout)?;
+    let remaining = options.lobby_timeout.saturating_sub(start.elapsed());
+    let client = SharedClient::connect(&lobby_name, remaining)?;
 
     // Отправляем запрос на регистрацию
     let request = protocol::encode_request(&RegistrationRequest {
         pid: registration.pid,
         revision: registration.revision,
         name: registration.name.clone(),
+        topics: registration.topics.clone(),
     });
     client.send_to_server(&request)?;
 
@@ -819,6 +1369,13 @@ impl AutoHandler for DispatchClientProxy {
     fn on_error(&self, err: ShmError) {
         self.handler.on_error(err);
     }
+
+    fn on_overflow(&self, direction: ChannelKind, count: u32) {
+        // ServerToClient у клиента — только отставание от broadcast-секции.
+        if direction == ChannelKind::ServerToClient {
+            self.handler.on_overflow(count);
+        }
+    }
 }
 
 // ─── Tests ───────────────────────────────────────────────────────────────────
@@ -826,6 +1383,7 @@ impl AutoHandler for DispatchClientProxy {
 #[cfg(test)]
 mod tests {
     use super::*;
+    use crate::broadcast::BroadcastReceiver;
     use std::sync::atomic::AtomicU32;
 
     struct TestServerHandler {
@@ -899,8 +1457,8 @@ mod tests {
         server.stop();
 
         assert!(
-            server.worker_handle.lock().unwrap().is_none(),
-            "stop() должен забрать и заджойнить worker_handle синхронно"
+            server.worker_handles.lock().unwrap().is_empty(),
+            "stop() должен забрать и заджойнить worker_handles синхронно"
         );
 
         // Повторный stop() — идемпотентен, не паникует и не виснет.
@@ -934,6 +1492,7 @@ mod tests {
             pid: 12345,
             revision: 1,
             name: "test.exe".into(),
+            topics: Vec::new(),
         };
 
         let client = DispatchClient::connect(
@@ -976,6 +1535,65 @@ mod tests {
         server.stop();
     }
 
+    /// То же, что `dispatch_roundtrip`, но каналы обслуживает общий пул
+    /// I/O-потоков: приём, отправка и отключение без потока на клиента.
+    #[test]
+    fn dispatch_roundtrip_pooled() {
+        let name = format!("TEST_DISPATCH_POOL_{}", std::process::id());
+
+        let server_handler = Arc::new(TestServerHandler::new());
+        let options = DispatchOptions {
+            io_threads: 2,
+            ..Default::default()
+        };
+        let server =
+            DispatchServer::start(&name, server_handler.clone(), options).expect("server start");
+
+        thread::sleep(Duration::from_millis(100));
+
+        let client_handler = Arc::new(TestClientHandler::new());
+        let registration = ClientRegistration {
+            pid: 777,
+            revision: 1,
+            name: "pooled.exe".into(),
+            topics: Vec::new(),
+        };
+        let client = DispatchClient::connect(
+            &name,
+            registration,
+            client_handler.clone(),
+            DispatchClientOptions::default(),
+        )
+        .expect("client connect");
+
+        let start = std::time::Instant::now();
+        while server_handler.connects.load(Ordering::Relaxed) == 0
+            && start.elapsed() < Duration::from_secs(5)
+        {
+            thread::sleep(Duration::from_millis(50));
+        }
+        assert_eq!(server_handler.connects.load(Ordering::Relaxed), 1);
+        assert_eq!(server.client_count(), 1);
+
+        client.send(b"hello").expect("client send");
+        thread::sleep(Duration::from_millis(200));
+        assert!(server_handler.messages.load(Ordering::Relaxed) >= 1);
+
+        let clients = server.connected_clients();
+        server.send_to(clients[0], b"world").expect("server send");
+        thread::sleep(Duration::from_millis(200));
+        assert!(client_handler.messages.load(Ordering::Relaxed) >= 1);
+
+        client.stop();
+        let start = std::time::Instant::now();
+        while server.client_count() > 0 && start.elapsed() < Duration::from_secs(5) {
+            thread::sleep(Duration::from_millis(50));
+        }
+        assert_eq!(server.client_count(), 0);
+        assert_eq!(server_handler.disconnects.load(Ordering::Relaxed), 1);
+        server.stop();
+    }
+
     #[test]
     fn dispatch_disconnect_no_double_notify() {
         let name = format!("TEST_DISPATCH_DC_{}", std::process::id());
@@ -992,6 +1610,7 @@ mod tests {
             pid: 99999,
             revision: 1,
             name: "dc_test.exe".into(),
+            topics: Vec::new(),
         };
 
         let client = DispatchClient::connect(
@@ -1043,6 +1662,7 @@ mod tests {
                 pid: 1000 + i,
                 revision: 1,
                 name: format!("client_{i}.exe"),
+                topics: Vec::new(),
             };
             let client = DispatchClient::connect(
                 &name,
@@ -1114,6 +1734,7 @@ mod tests {
             pid: 55555,
             revision: 1,
             name: "deadlock_test.exe".into(),
+            topics: Vec::new(),
         };
         let client = DispatchClient::connect(
             &name,
@@ -1172,6 +1793,7 @@ mod tests {
             pid: 111,
             revision: 1,
             name: "stalled.exe".into(),
+            topics: Vec::new(),
         };
         let (_id_a, _channel_a) =
             lobby_register(&name, &reg_a, &DispatchClientOptions::default(), &mut buffer)
@@ -1186,6 +1808,7 @@ mod tests {
             pid: 222,
             revision: 1,
             name: "prompt.exe".into(),
+            topics: Vec::new(),
         };
         let client_b = DispatchClient::connect(
             &name,
@@ -1206,6 +1829,257 @@ mod tests {
         server.stop();
     }
 
+    /// Шторм регистраций на шардированном лобби: конкурентные клиенты
+    /// захватывают разные шарды и все получают канал.
+    #[test]
+    fn sharded_lobby_accepts_concurrent_registrations() {
+        let name = format!("TEST_DISPATCH_SHARDS_{}", std::process::id());
+        let server_handler = Arc::new(TestServerHandler::new());
+        let options = DispatchOptions {
+            lobby_shards: 4,
+            ..Default::default()
+        };
+        let server =
+            DispatchServer::start(&name, server_handler.clone(), options).expect("server start");
+        thread::sleep(Duration::from_millis(100));
+
+        let workers: Vec<_> = (0..16)
+            .map(|i| {
+                let name = name.clone();
+                thread::spawn(move || {
+                    let registration = ClientRegistration {
+                        pid: i,
+                        revision: 1,
+                        name: format!("storm{i}.exe"),
+                        topics: Vec::new(),
+                    };
+                    DispatchClient::connect(
+                        &name,
+                        registration,
+                        Arc::new(TestClientHandler::new()),
+                        DispatchClientOptions::default(),
+                    )
+                })
+            })
+            .collect();
+        let clients: Vec<_> = workers
+            .into_iter()
+            .map(|w| w.join().unwrap().expect("client connect"))
+            .collect();
+
+        let mut ids: Vec<_> = clients.iter().map(DispatchClient::client_id).collect();
+        ids.sort_unstable();
+        ids.dedup();
+        assert_eq!(ids.len(), 16);
+
+        let start = std::time::Instant::now();
+        while server.client_count() < 16 && start.elapsed() < Duration::from_secs(5) {
+            thread::sleep(Duration::from_millis(50));
+        }
+        assert_eq!(server.client_count(), 16);
+
+        drop(clients);
+        server.stop();
+    }
+
+    #[test]
+    fn lobby_shards_are_validated() {
+        for lobby_shards in [0, MAX_LOBBY_SHARDS + 1] {
+            let options = DispatchOptions {
+                lobby_shards,
+                ..Default::default()
+            };
+            let handler = Arc::new(TestServerHandler::new());
+            assert!(matches!(
+                DispatchServer::start("TEST_DISPATCH_BAD_SHARDS", handler, options),
+                Err(ShmError::InvalidConfig(_))
+            ));
+        }
+    }
+
+    /// В broadcast-секцию должны влезать два сообщения `MAX_MESSAGE_SIZE`:
+    /// меньше 256 KiB — `InvalidConfig` ещё до создания секции.
+    #[test]
+    fn broadcast_capacity_must_hold_two_max_messages() {
+        let options = DispatchOptions {
+            broadcast_capacity: 128 * 1024,
+            ..Default::default()
+        };
+        let handler = Arc::new(TestServerHandler::new());
+        assert!(matches!(
+            DispatchServer::start("TEST_DISPATCH_SMALL_BCAST", handler, options),
+            Err(ShmError::InvalidConfig(_))
+        ));
+        assert!(crate::broadcast::validate_capacity(256 * 1024, MAX_MESSAGE_SIZE).is_ok());
+    }
+
+    /// Регистрации с запасом каналов: каждый следующий клиент получает
+    /// готовый канал с новым именем и обменивается сообщениями как обычно.
+    #[test]
+    fn warm_channels_serve_reconnects() {
+        let name = format!("TEST_DISPATCH_WARM_{}", std::process::id());
+        let server_handler = Arc::new(TestServerHandler::new());
+        let options = DispatchOptions {
+            io_threads: 1,
+            warm_channels: 2,
+            ..Default::default()
+        };
+        let server =
+            DispatchServer::start(&name, server_handler.clone(), options).expect("server start");
+        thread::sleep(Duration::from_millis(100));
+
+        for round in 1..=3 {
+            let client_handler = Arc::new(TestClientHandler::new());
+            let registration = ClientRegistration {
+                pid: round,
+                revision: 1,
+                name: format!("warm{round}.exe"),
+                topics: Vec::new(),
+            };
+            let client = DispatchClient::connect(
+                &name,
+                registration,
+                client_handler.clone(),
+                DispatchClientOptions::default(),
+            )
+            .expect("client connect");
+
+            let start = std::time::Instant::now();
+            while server_handler.connects.load(Ordering::Relaxed) < round
+                && start.elapsed() < Duration::from_secs(5)
+            {
+                thread::sleep(Duration::from_millis(50));
+            }
+            assert_eq!(server_handler.connects.load(Ordering::Relaxed), round);
+
+            let client_id = client.client_id();
+            server.send_to(client_id, b"warm").expect("server send");
+            client.send(b"hello").expect("client send");
+            let start = std::time::Instant::now();
+            while client_handler.messages.load(Ordering::Relaxed) == 0
+                && start.elapsed() < Duration::from_secs(5)
+            {
+                thread::sleep(Duration::from_millis(50));
+            }
+            assert_eq!(client_handler.messages.load(Ordering::Relaxed), 1);
+
+            client.stop();
+            let start = std::time::Instant::now();
+            while server_handler.disconnects.load(Ordering::Relaxed) < round
+                && start.elapsed() < Duration::from_secs(5)
+            {
+                thread::sleep(Duration::from_millis(50));
+            }
+            assert_eq!(server_handler.disconnects.load(Ordering::Relaxed), round);
+        }
+        assert!(server_handler.messages.load(Ordering::Relaxed) >= 3);
+
+        server.stop();
+    }
+
+    /// `publish` доходит только до подписчиков: подписка из регистрации и
+    /// выданная сервером позже, снятие подписки.
+    #[test]
+    fn publish_routes_to_subscribers_only() {
+        let name = format!("TEST_DISPATCH_TOPIC_{}", std::process::id());
+        let server_handler = Arc::new(TestServerHandler::new());
+        let server =
+            DispatchServer::start(&name, server_handler.clone(), DispatchOptions::default())
+                .expect("server start");
+        thread::sleep(Duration::from_millis(100));
+
+        let connect = |topics: Vec<u32>| {
+            let handler = Arc::new(TestClientHandler::new());
+            let registration = ClientRegistration {
+                pid: std::process::id(),
+                revision: 1,
+                name: "topics.exe".into(),
+                topics,
+            };
+            let client = DispatchClient::connect(
+                &name,
+                registration,
+                handler.clone(),
+                DispatchClientOptions::default(),
+            )
+            .expect("client connect");
+            (client, handler)
+        };
+        let (first, first_handler) = connect(vec![7]);
+        let (second, second_handler) = connect(Vec::new());
+
+        let start = std::time::Instant::now();
+        while server.client_count() < 2 && start.elapsed() < Duration::from_secs(5) {
+            thread::sleep(Duration::from_millis(50));
+        }
+        assert_eq!(server.subscribers(7), [first.client_id()]);
+
+        assert_eq!(server.publish(7, b"seven").unwrap(), 1);
+        assert_eq!(server.publish(8, b"eight").unwrap(), 0);
+        server.subscribe(second.client_id(), 8).unwrap();
+        assert_eq!(server.publish(8, b"eight").unwrap(), 1);
+        assert!(server.unsubscribe(first.client_id(), 7));
+        assert_eq!(server.publish(7, b"seven").unwrap(), 0);
+        assert!(server.subscribe(u32::MAX, 7).is_err());
+
+        thread::sleep(Duration::from_millis(200));
+        assert_eq!(first_handler.messages.load(Ordering::Relaxed), 1);
+        assert_eq!(second_handler.messages.load(Ordering::Relaxed), 1);
+
+        first.stop();
+        second.stop();
+        server.stop();
+    }
+
+    /// Отключённый `disconnect_client` процесс может читать секцию и дальше,
+    /// поэтому после него публикация в топик всех оставшихся клиентов не
+    /// сдвигает позицию записи секции.
+    #[test]
+    fn publish_skips_section_after_forced_disconnect() {
+        let name = format!("TEST_DISPATCH_EVICT_{}", std::process::id());
+        let server_handler = Arc::new(TestServerHandler::new());
+        let server =
+            DispatchServer::start(&name, server_handler.clone(), DispatchOptions::default())
+                .expect("server start");
+        thread::sleep(Duration::from_millis(100));
+
+        let connect = || {
+            let registration = ClientRegistration {
+                pid: std::process::id(),
+                revision: 1,
+                name: "evict.exe".into(),
+                topics: vec![5],
+            };
+            DispatchClient::connect(
+                &name,
+                registration,
+                Arc::new(TestClientHandler::new()),
+                DispatchClientOptions::default(),
+            )
+            .expect("client connect")
+        };
+        let kept = connect();
+        let evicted = connect();
+        let start = std::time::Instant::now();
+        while server.client_count() < 2 && start.elapsed() < Duration::from_secs(5) {
+            thread::sleep(Duration::from_millis(50));
+        }
+
+        // подписаны все — сообщение идёт через секцию
+        let reader = BroadcastReceiver::open(&name).expect("open section");
+        assert_eq!(server.publish(5, b"both").unwrap(), 2);
+        assert!(reader.has_pending());
+
+        server.disconnect_client(evicted.client_id()).unwrap();
+        let reader = BroadcastReceiver::open(&name).expect("open section");
+        assert_eq!(server.publish(5, b"kept").unwrap(), 1);
+        assert!(!reader.has_pending());
+
+        kept.stop();
+        evicted.stop();
+        server.stop();
+    }
+
     /// Регрессия (аудит 2026-07-10): имена каналов не должны предсказуемо
     /// выводиться из известных клиенту входов (`client_id`/примерное время
     /// регистрации) -- иначе враждебный локальный процесс мог бы вычислить
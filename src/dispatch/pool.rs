@@ -0,0 +1,581 @@
+//! Общий пул I/O-потоков dispatch-сервера (`DispatchOptions::io_threads`).
+//!
+//! Вместо `AutoServer` с собственным потоком на каждого клиента выделенные
+//! каналы раздаются потокам пула. У каждого потока свой порт завершения:
+//! события каналов (`connect_req`, пока клиент не подключился, затем
+//! `c2s.data` и `disconnect`) ждёт ядро через wait completion packets, а
+//! поток забирает сработавшие пачкой из порта — без предела в 64 хендла
+//! `NtWaitForMultipleObjects`, так что потоков ровно `io_threads`. Отправка
+//! идёт прямо в кольцо под мьютексом канала (как `MultiServer::send_to`) —
+//! без очереди и без потока на ожидание подключения. Канал отключившегося
+//! клиента закрывается: его имя знает прежний клиент, и повторная выдача
+//! позволила бы тому занять канал раньше нового (запас доливается каналами
+//! с новыми именами).
+
+use std::sync::atomic::{AtomicBool, AtomicU32, AtomicUsize, Ordering};
+use std::sync::{Arc, Mutex};
+use std::thread::{self, JoinHandle};
+use std::time::{Duration, Instant};
+
+use super::{
+    insert_registered, remove_registered, ClientChannel, ClientMap, ClientRegistration,
+    DispatchHandler, DispatchedClient, TopicMap, UnlistedReader,
+};
+use crate::error::{Result, ShmError};
+use crate::sched::{Intake, DEFAULT_CLIENT_WEIGHT};
+use crate::server::SharedServer;
+use crate::stats::{ChannelStats, ChannelStatsSnapshot};
+use crate::trace;
+use crate::win::{Completion, CompletionPort, WaitPacket};
+
+/// Ключ пакета-пробуждения потока (ключи каналов — индексы слотов).
+const WAKE_KEY: usize = usize::MAX;
+
+/// Выделенный канал клиента, обслуживаемый пулом.
+pub(super) struct PooledChannel {
+    server: Mutex<SharedServer>,
+    /// Канал снят сервером (`disconnect_client`/остановка) — поток пула
+    /// выбрасывает его без callback-ов: уведомление уже отправлено.
+    closed: AtomicBool,
+    worker: Arc<IoWorker>,
+    /// Статистика канала (подключена к кольцам `server`) — поток пула пишет
+    /// её, не беря мьютекс канала.
+    stats: Arc<ChannelStats>,
+    /// Вес клиента в обходе горячих каналов потока (`set_client_weight`).
+    weight: AtomicU32,
+}
+
+impl PooledChannel {
+    pub(super) fn send(&self, data: &[u8]) -> Result<()> {
+        self.server.lock().unwrap().send_to_client(data).map(|_| ())
+    }
+
+    /// Будит клиента после записи в broadcast-секцию.
+    pub(super) fn notify(&self) -> Result<()> {
+        self.server.lock().unwrap().notify_client()
+    }
+
+    pub(super) fn stats(&self) -> ChannelStatsSnapshot {
+        self.stats.snapshot()
+    }
+
+    pub(super) fn set_weight(&self, weight: u32) {
+        self.weight.store(weight, Ordering::Relaxed);
+    }
+
+    pub(super) fn stop(&self) {
+        self.closed.store(true, Ordering::Release);
+        self.worker.wake();
+    }
+}
+
+/// Регистрация, переданная потоку пула: ждёт подключения клиента к каналу.
+struct Pending {
+    info: ClientRegistration,
+    channel_name: String,
+    deadline: Instant,
+    /// Держит `publish` от общей секции, пока клиент не внесён в карту.
+    _unlisted: UnlistedReader,
+}
+
+/// Что ждёт wait-пакет; лежит в младших битах контекста пакета.
+#[derive(Clone, Copy, PartialEq, Eq)]
+enum Source {
+    Connect = 0,
+    Data = 1,
+    Disconnect = 2,
+}
+
+impl Source {
+    fn context(self, generation: usize) -> usize {
+        generation << 2 | self as usize
+    }
+
+    fn decode(context: usize) -> Option<(Source, usize)> {
+        let source = match context & 3 {
+            0 => Source::Connect,
+            1 => Source::Data,
+            2 => Source::Disconnect,
+            _ => return None,
+        };
+        Some((source, context >> 2))
+    }
+}
+
+struct Entry {
+    client_id: u32,
+    channel: Arc<PooledChannel>,
+    /// `Some` — клиент ещё не подключился к каналу.
+    pending: Option<Pending>,
+    /// Сырые хендлы событий канала (живут, пока жив `channel`).
+    connect_req: isize,
+    data: isize,
+    disconnect: isize,
+    /// Ждёт `connect_req`, после подключения — `c2s.data`.
+    primary: WaitPacket,
+    /// Ждёт `disconnect` после подключения.
+    hangup: WaitPacket,
+    /// Поколение слота: пакет, поставленный до снятия канала, не попадёт в
+    /// канал, занявший слот после него.
+    generation: usize,
+    /// `primary` связан с `c2s.data` и ещё не сработал.
+    data_armed: bool,
+    /// Пачка заполнилась до recv_batch: data-событие повторно не придёт,
+    /// канал опрашивается без ожидания, пока не опустеет.
+    hot: bool,
+}
+
+impl Entry {
+    fn arm(&mut self, source: Source, port: &CompletionPort, key: usize) -> Result<()> {
+        let context = source.context(self.generation);
+        match source {
+            Source::Connect => self.primary.associate(port, self.connect_req, key, context),
+            Source::Data => {
+                self.primary.associate(port, self.data, key, context)?;
+                self.data_armed = true;
+                Ok(())
+            }
+            Source::Disconnect => self.hangup.associate(port, self.disconnect, key, context),
+        }
+    }
+}
+
+struct IoWorker {
+    inbox: Mutex<Vec<Entry>>,
+    /// Порт потока: wait-пакеты его каналов и пробуждения (`WAKE_KEY`).
+    port: CompletionPort,
+    /// Каналов за потоком, включая ещё не подключённые.
+    load: AtomicUsize,
+}
+
+impl IoWorker {
+    fn wake(&self) {
+        let _ = self.port.post(WAKE_KEY, 0);
+    }
+}
+
+/// Общее для всех потоков пула.
+struct PoolContext {
+    name: String,
+    handler: Arc<dyn DispatchHandler>,
+    clients: ClientMap,
+    topics: TopicMap,
+    running: Arc<AtomicBool>,
+    poll_timeout: Duration,
+    recv_batch: usize,
+    recv_budget: Duration,
+}
+
+pub(super) struct IoPool {
+    context: Arc<PoolContext>,
+    workers: Mutex<Vec<Arc<IoWorker>>>,
+    handles: Mutex<Vec<JoinHandle<()>>>,
+}
+
+impl IoPool {
+    pub(super) fn start(
+        name: &str,
+        threads: usize,
+        handler: Arc<dyn DispatchHandler>,
+        clients: ClientMap,
+        topics: TopicMap,
+        running: Arc<AtomicBool>,
+        poll_timeout: Duration,
+        recv_batch: usize,
+        recv_budget: Duration,
+    ) -> Result<Self> {
+        let pool = Self {
+            context: Arc::new(PoolContext {
+                name: name.to_owned(),
+                handler,
+                clients,
+                topics,
+                running,
+                poll_timeout,
+                recv_batch,
+                recv_budget,
+            }),
+            workers: Mutex::new(Vec::new()),
+            handles: Mutex::new(Vec::new()),
+        };
+        {
+            let mut workers = pool.workers.lock().unwrap();
+            for _ in 0..threads.max(1) {
+                let worker = pool.spawn_worker(workers.len())?;
+                workers.push(worker);
+            }
+        }
+        Ok(pool)
+    }
+
+    /// Отдаёт канал наименее загруженному потоку.
+    pub(super) fn add(
+        &self,
+        client_id: u32,
+        mut server: SharedServer,
+        info: ClientRegistration,
+        channel_name: String,
+        connect_timeout: Duration,
+        unlisted: UnlistedReader,
+    ) -> Result<()> {
+        let worker = self
+            .workers
+            .lock()
+            .unwrap()
+            .iter()
+            .min_by_key(|worker| worker.load.load(Ordering::Relaxed))
+            .cloned()
+            .ok_or(ShmError::NotReady)?;
+
+        // Каналы пула всегда именованные
+        let events = server
+            .events()
+            .expect("Anonymous mode not supported in dispatch pool");
+        let (connect_req, data, disconnect) = (
+            events.connect_req.raw_handle(),
+            events.c2s.data.raw_handle(),
+            events.disconnect.raw_handle(),
+        );
+        let primary = WaitPacket::create()?;
+        let hangup = WaitPacket::create()?;
+        let stats = Arc::new(ChannelStats::default());
+        server.set_stats(stats.clone());
+        let entry = Entry {
+            client_id,
+            channel: Arc::new(PooledChannel {
+                server: Mutex::new(server),
+                closed: AtomicBool::new(false),
+                worker: worker.clone(),
+                stats,
+                weight: AtomicU32::new(DEFAULT_CLIENT_WEIGHT),
+            }),
+            pending: Some(Pending {
+                info,
+                channel_name,
+                deadline: Instant::now() + connect_timeout,
+                _unlisted: unlisted,
+            }),
+            connect_req,
+            data,
+            disconnect,
+            primary,
+            hangup,
+            generation: 0,
+            data_armed: false,
+            hot: false,
+        };
+        worker.load.fetch_add(1, Ordering::Relaxed);
+        worker.inbox.lock().unwrap().push(entry);
+        worker.wake();
+        Ok(())
+    }
+
+    /// Дожидается выхода всех потоков пула (после сброса `running`).
+    pub(super) fn join(&self) {
+        for worker in self.workers.lock().unwrap().iter() {
+            worker.wake();
+        }
+        let handles: Vec<_> = self.handles.lock().unwrap().drain(..).collect();
+        for handle in handles {
+            let _ = handle.join();
+        }
+    }
+
+    fn spawn_worker(
+        &self,
+        #[cfg_attr(not(debug_assertions), allow(unused_variables))] index: usize,
+    ) -> Result<Arc<IoWorker>> {
+        let worker = Arc::new(IoWorker {
+            inbox: Mutex::new(Vec::new()),
+            port: CompletionPort::create()?,
+            load: AtomicUsize::new(0),
+        });
+        let context = self.context.clone();
+        let thread_worker = worker.clone();
+        // Имя потока только в debug — по той же причине, что и у lobby worker.
+        #[cfg_attr(not(debug_assertions), allow(unused_mut))]
+        let mut builder = thread::Builder::new();
+        #[cfg(debug_assertions)]
+        {
+            builder = builder.name(format!("xsd-io-{}-{}", context.name, index));
+        }
+        let handle = builder
+            .spawn(move || io_loop(&thread_worker, &context))
+            .map_err(|e| ShmError::WindowsError {
+                code: e.raw_os_error().unwrap_or(-1) as u32,
+                context: "spawn dispatch io worker",
+            })?;
+        self.handles.lock().unwrap().push(handle);
+        Ok(worker)
+    }
+}
+
+/// Каналы потока по стабильным индексам: индекс слота — ключ его пакетов в
+/// порту, поэтому снятие канала не сдвигает остальные.
+#[derive(Default)]
+struct Slots {
+    entries: Vec<Option<Entry>>,
+    free: Vec<usize>,
+    next_generation: usize,
+}
+
+impl Slots {
+    fn insert(&mut self, mut entry: Entry) -> usize {
+        self.next_generation = self.next_generation.wrapping_add(1) & (usize::MAX >> 2);
+        entry.generation = self.next_generation;
+        match self.free.pop() {
+            Some(index) => {
+                self.entries[index] = Some(entry);
+                index
+            }
+            None => {
+                self.entries.push(Some(entry));
+                self.entries.len() - 1
+            }
+        }
+    }
+
+    /// Слот `index`, если в нём всё ещё канал поколения `generation`.
+    fn get_mut(&mut self, index: usize, generation: usize) -> Option<&mut Entry> {
+        self.entries
+            .get_mut(index)?
+            .as_mut()
+            .filter(|entry| entry.generation == generation)
+    }
+
+    /// Снимает канал; его wait-пакеты отменяются вместе с поставленными.
+    fn remove(&mut self, index: usize) -> Option<Entry> {
+        let entry = self.entries[index].take();
+        if entry.is_some() {
+            self.free.push(index);
+        }
+        entry
+    }
+}
+
+fn io_loop(worker: &IoWorker, context: &PoolContext) {
+    let mut intake = Intake::new(context.recv_batch, context.recv_budget);
+    let mut slots = Slots::default();
+    let mut completions: Vec<Completion> = Vec::new();
+
+    while context.running.load(Ordering::Acquire) {
+        let added = std::mem::take(&mut *worker.inbox.lock().unwrap());
+        for entry in added {
+            let index = slots.insert(entry);
+            arm(&mut slots, index, Source::Connect, worker, context);
+        }
+
+        let now = Instant::now();
+        let mut removed = 0;
+        for index in 0..slots.entries.len() {
+            let expired = slots.entries[index].as_ref().map_or(false, |entry| {
+                entry.channel.closed.load(Ordering::Acquire)
+                    || entry.pending.as_ref().map_or(false, |p| now >= p.deadline)
+            });
+            if expired {
+                slots.remove(index);
+                removed += 1;
+            }
+        }
+        if removed > 0 {
+            worker.load.fetch_sub(removed, Ordering::Relaxed);
+        }
+
+        let busy = slots.entries.iter().flatten().any(|entry| entry.hot);
+        let timeout = if busy {
+            Duration::ZERO
+        } else {
+            context.poll_timeout
+        };
+
+        match worker.port.remove(&mut completions, Some(timeout)) {
+            Ok(()) if completions.is_empty() && !busy => {
+                // Страховка на случай потерянного сигнала, как и раньше у
+                // NtWaitForMultipleObjects по таймауту.
+                poll_connected(&mut slots, context, &mut intake);
+            }
+            Ok(()) => {
+                for &completion in &completions {
+                    on_completion(completion, &mut slots, worker, context, &mut intake);
+                }
+            }
+            Err(err) => context.handler.on_error(None, err),
+        }
+
+        for index in 0..slots.entries.len() {
+            let Some(entry) = slots.entries[index].as_mut() else {
+                continue;
+            };
+            if entry.hot && !receive(entry, context, &mut intake, false) {
+                entry.hot = false;
+                if !entry.data_armed {
+                    arm(&mut slots, index, Source::Data, worker, context);
+                }
+            }
+        }
+    }
+}
+
+/// Связывает wait-пакет канала с портом потока. Ошибку видит handler; канал
+/// тогда держится только на страховочном опросе по таймауту.
+fn arm(slots: &mut Slots, index: usize, source: Source, worker: &IoWorker, context: &PoolContext) {
+    let Some(entry) = slots.entries[index].as_mut() else {
+        return;
+    };
+    if let Err(err) = entry.arm(source, &worker.port, index) {
+        context.handler.on_error(Some(entry.client_id), err);
+    }
+}
+
+fn on_completion(
+    completion: Completion,
+    slots: &mut Slots,
+    worker: &IoWorker,
+    context: &PoolContext,
+    intake: &mut Intake,
+) {
+    if completion.key == WAKE_KEY {
+        return;
+    }
+    let Some((source, generation)) = Source::decode(completion.context) else {
+        return;
+    };
+    let index = completion.key;
+    // Канал уже снят в этом же проходе — пакет устарел.
+    let Some(entry) = slots.get_mut(index, generation) else {
+        return;
+    };
+    match source {
+        Source::Connect => {
+            if accept(entry, context) {
+                arm(slots, index, Source::Data, worker, context);
+                arm(slots, index, Source::Disconnect, worker, context);
+            } else if entry.pending.is_some() {
+                arm(slots, index, Source::Connect, worker, context);
+            }
+        }
+        Source::Data => {
+            entry.data_armed = false;
+            if receive(entry, context, intake, true) {
+                entry.hot = true;
+            } else {
+                arm(slots, index, Source::Data, worker, context);
+            }
+        }
+        Source::Disconnect => {
+            disconnect(entry, context);
+            slots.remove(index);
+            worker.load.fetch_sub(1, Ordering::Relaxed);
+        }
+    }
+}
+
+/// Handshake на канале; `true` — клиент подключён и внесён в карту.
+fn accept(entry: &mut Entry, context: &PoolContext) -> bool {
+    if entry.pending.is_none() {
+        return false;
+    }
+    if let Err(err) = entry.channel.server.lock().unwrap().accept_client() {
+        context.handler.on_error(Some(entry.client_id), err);
+        return false;
+    }
+    let Some(pending) = entry.pending.take() else {
+        return false;
+    };
+    trace::connected(&pending.channel_name, entry.client_id);
+    insert_registered(
+        &context.clients,
+        &context.topics,
+        entry.client_id,
+        DispatchedClient {
+            channel: ClientChannel::Pooled(entry.channel.clone()),
+            info: pending.info.clone(),
+            channel_name: pending.channel_name,
+            disconnected: AtomicBool::new(false),
+        },
+    );
+    context
+        .handler
+        .on_client_connect(entry.client_id, &pending.info);
+    true
+}
+
+/// Пачка сообщений канала в handler; `true` — пачка заполнена до хода
+/// канала (`recv_batch` × вес, с `recv_budget` — по бюджету), в кольце
+/// могут остаться сообщения. `woken` — чтение по data-событию канала.
+fn receive(entry: &Entry, context: &PoolContext, intake: &mut Intake, woken: bool) -> bool {
+    if entry.pending.is_some() || entry.channel.closed.load(Ordering::Acquire) {
+        return false;
+    }
+    let Intake { batch, sizer } = intake;
+    let quantum = sizer.quantum(entry.channel.weight.load(Ordering::Relaxed));
+    let started = sizer.begin();
+    batch.clear();
+    let result = entry
+        .channel
+        .server
+        .lock()
+        .unwrap()
+        .receive_batch_from_client(batch, quantum, usize::MAX);
+    let stats = &entry.channel.stats;
+    if woken {
+        stats.record_wakeup(batch.is_empty());
+    }
+    if !batch.is_empty() {
+        stats.record_batch(batch.len());
+        stats.time_handler(|| {
+            for data in batch.iter() {
+                context.handler.on_message(entry.client_id, data);
+            }
+        });
+    }
+    sizer.finish(started, batch.len());
+    match result {
+        Ok(count) => count >= quantum,
+        Err(ShmError::QueueEmpty) => false,
+        Err(err) => {
+            context.handler.on_error(Some(entry.client_id), err);
+            false
+        }
+    }
+}
+
+/// Опрос всех подключённых каналов; заполнившие пачку становятся `hot`.
+fn poll_connected(slots: &mut Slots, context: &PoolContext, intake: &mut Intake) {
+    for entry in slots.entries.iter_mut().flatten() {
+        if receive(entry, context, intake, false) {
+            entry.hot = true;
+        }
+    }
+}
+
+/// Клиент отключился сам: убираем канал из карты (если его не убрали раньше
+/// через `disconnect_client`) и уведомляем handler.
+fn disconnect(entry: &mut Entry, context: &PoolContext) {
+    if entry.pending.is_some() || entry.channel.closed.load(Ordering::Acquire) {
+        return;
+    }
+    entry.channel.server.lock().unwrap().mark_disconnected();
+
+    // Тот же протокол, что и у AutoProxyHandler::on_disconnect: единственное
+    // уведомление обеспечивает CAS `disconnected` под write-локом карты.
+    let removed = {
+        let mut clients = context.clients.write().unwrap();
+        match clients.get(&entry.client_id) {
+            Some(client)
+                if client
+                    .disconnected
+                    .compare_exchange(false, true, Ordering::AcqRel, Ordering::Relaxed)
+                    .is_ok() =>
+            {
+                remove_registered(&mut clients, &context.topics, entry.client_id)
+            }
+            _ => None,
+        }
+    };
+    if let Some(client) = removed {
+        trace::disconnected(&client.channel_name, entry.client_id);
+        drop(client);
+        context.handler.on_client_disconnect(entry.client_id);
+    }
+}
@@ -8,13 +8,15 @@ use crate::error::{Result, ShmError};
 // ─── Константы ────────────────────────────────────────────────────────────────
 
 const DISPATCH_MAGIC: u32 = 0x4449_5350; // 'DISP'
-const DISPATCH_VERSION: u8 = 2; // v2: убрано поле bits
+const DISPATCH_VERSION: u8 = 3; // v3: подписки на топики в запросе
 
 const MSG_TYPE_REQUEST: u8 = 1;
 const MSG_TYPE_RESPONSE: u8 = 2;
 
 const MAX_NAME_LEN: usize = 64;
 const MAX_CHANNEL_NAME_LEN: usize = 64;
+/// Сколько топиков клиент может перечислить при регистрации.
+pub const MAX_REGISTRATION_TOPICS: usize = 256;
 
 /// Статус ответа: успех.
 pub const STATUS_OK: u8 = 0;
@@ -25,30 +27,34 @@ pub const STATUS_REJECTED: u8 = 1;
 
 /// Данные, отправляемые клиентом во время регистрации в лобби.
 ///
-/// Поля: имя процесса, PID, ревизия.
+/// Поля: имя процесса, PID, ревизия, топики подписки.
 #[derive(Debug, Clone)]
 pub struct RegistrationRequest {
     pub pid: u32,
     pub revision: u16,
     pub name: String,
+    pub topics: Vec<u32>,
 }
 
 /// Кодирует запрос регистрации в байты.
 ///
-/// Layout (v2):
+/// Layout (v3):
 /// ```text
 /// [0..4]   magic: u32 LE = 0x44495350
-/// [4..5]   version: u8 = 2
+/// [4..5]   version: u8 = 3
 /// [5..6]   msg_type: u8 = 1
 /// [6..10]  pid: u32 LE
 /// [10..12] revision: u16 LE
 /// [12..13] name_len: u8
-/// [13..]   name: UTF-8 байты (максимум 64)
+/// [13..N]  name: UTF-8 байты (максимум 64)
+/// [N..N+2] topic_count: u16 LE (максимум 256)
+/// [N+2..]  topics: u32 LE × topic_count
 /// ```
 pub fn encode_request(req: &RegistrationRequest) -> Vec<u8> {
     let name_bytes = req.name.as_bytes();
     let name_len = name_bytes.len().min(MAX_NAME_LEN) as u8;
-    let total = 13 + name_len as usize;
+    let topics = &req.topics[..req.topics.len().min(MAX_REGISTRATION_TOPICS)];
+    let total = 15 + name_len as usize + 4 * topics.len();
     let mut buf = Vec::with_capacity(total);
 
     buf.extend_from_slice(&DISPATCH_MAGIC.to_le_bytes());
@@ -58,6 +64,10 @@ pub fn encode_request(req: &RegistrationRequest) -> Vec<u8> {
     buf.extend_from_slice(&req.revision.to_le_bytes());
     buf.push(name_len);
     buf.extend_from_slice(&name_bytes[..name_len as usize]);
+    buf.extend_from_slice(&(topics.len() as u16).to_le_bytes());
+    for topic in topics {
+        buf.extend_from_slice(&topic.to_le_bytes());
+    }
 
     buf
 }
@@ -87,16 +97,30 @@ pub fn decode_request(data: &[u8]) -> Result<RegistrationRequest> {
     let revision = u16::from_le_bytes([data[10], data[11]]);
     let name_len = data[12] as usize;
 
-    if data.len() < 13 + name_len {
+    let topics_at = 13 + name_len;
+    if data.len() < topics_at + 2 {
         return Err(ShmError::MessageTooSmall);
     }
 
-    let name = String::from_utf8_lossy(&data[13..13 + name_len]).into_owned();
+    let name = String::from_utf8_lossy(&data[13..topics_at]).into_owned();
+
+    let topic_count = u16::from_le_bytes([data[topics_at], data[topics_at + 1]]) as usize;
+    if topic_count > MAX_REGISTRATION_TOPICS {
+        return Err(ShmError::HandshakeFailed);
+    }
+    let topic_bytes = data
+        .get(topics_at + 2..topics_at + 2 + 4 * topic_count)
+        .ok_or(ShmError::MessageTooSmall)?;
+    let topics = topic_bytes
+        .chunks_exact(4)
+        .map(|b| u32::from_le_bytes([b[0], b[1], b[2], b[3]]))
+        .collect();
 
     Ok(RegistrationRequest {
         pid,
         revision,
         name,
+        topics,
     })
 }
 
@@ -112,10 +136,10 @@ pub struct RegistrationResponse {
 
 /// Кодирует ответ регистрации в байты.
 ///
-/// Layout (v2):
+/// Layout (v3, не менялся с v2):
 /// ```text
 /// [0..4]   magic: u32 LE = 0x44495350
-/// [4..5]   version: u8 = 2
+/// [4..5]   version: u8 = 3
 /// [5..6]   msg_type: u8 = 2
 /// [6..7]   status: u8
 /// [7..11]  client_id: u32 LE
@@ -187,12 +211,14 @@ mod tests {
             pid: 12345,
             revision: 7,
             name: "l2.exe".to_string(),
+            topics: vec![1, 0xDEAD_BEEF],
         };
         let encoded = encode_request(&req);
         let decoded = decode_request(&encoded).unwrap();
         assert_eq!(decoded.pid, 12345);
         assert_eq!(decoded.revision, 7);
         assert_eq!(decoded.name, "l2.exe");
+        assert_eq!(decoded.topics, [1, 0xDEAD_BEEF]);
     }
 
     #[test]
@@ -201,6 +227,7 @@ mod tests {
             pid: 1,
             revision: 0,
             name: String::new(),
+            topics: Vec::new(),
         };
         let encoded = encode_request(&req);
         let decoded = decode_request(&encoded).unwrap();
@@ -215,12 +242,33 @@ mod tests {
             pid: 42,
             revision: 1,
             name: long_name,
+            topics: Vec::new(),
         };
         let encoded = encode_request(&req);
         let decoded = decode_request(&encoded).unwrap();
         assert_eq!(decoded.name.len(), MAX_NAME_LEN);
     }
 
+    #[test]
+    fn request_topics_truncated_and_checked() {
+        let req = RegistrationRequest {
+            pid: 42,
+            revision: 1,
+            name: "x".into(),
+            topics: (0..1000).collect(),
+        };
+        let encoded = encode_request(&req);
+        let decoded = decode_request(&encoded).unwrap();
+        assert_eq!(decoded.topics.len(), MAX_REGISTRATION_TOPICS);
+        assert_eq!(decoded.topics[255], 255);
+
+        // Обрезанный список топиков и запрос предыдущей версии не проходят.
+        assert!(decode_request(&encoded[..encoded.len() - 1]).is_err());
+        let mut old = encoded.clone();
+        old[4] = 2;
+        assert!(decode_request(&old).is_err());
+    }
+
     #[test]
     fn response_roundtrip() {
         let resp = RegistrationResponse {
@@ -0,0 +1,131 @@
+//! Индекс подписок dispatch-сервера: топик → отсортированные ID клиентов.
+//!
+//! `publish` смотрит в индекс по топику и пишет только подписчикам, не
+//! перебирая карту клиентов. Списки — отсортированные `Vec<u32>`: подписка
+//! меняется редко, а обход плотного массива на каждой публикации дешевле
+//! хеш-множества. Рядом хранятся топики каждого клиента: отключение снимает
+//! все его подписки сразу (`remove_client`), и ни ID ушедших клиентов, ни
+//! опустевшие топики в индексе не копятся.
+
+use std::collections::HashMap;
+
+#[derive(Default)]
+pub(super) struct TopicIndex {
+    subscribers: HashMap<u32, Vec<u32>>,
+    /// Обратный индекс: клиент → его топики (отсортированы).
+    topics: HashMap<u32, Vec<u32>>,
+}
+
+/// Вставка в отсортированный список; `false` — значение уже было.
+fn insert_sorted(list: &mut Vec<u32>, value: u32) -> bool {
+    match list.binary_search(&value) {
+        Ok(_) => false,
+        Err(at) => {
+            list.insert(at, value);
+            true
+        }
+    }
+}
+
+/// Удаляет `value` из списка под ключом `key`, опустевший список — вместе с
+/// ключом; `false` — значения не было.
+fn remove_sorted(map: &mut HashMap<u32, Vec<u32>>, key: u32, value: u32) -> bool {
+    let Some(list) = map.get_mut(&key) else {
+        return false;
+    };
+    let Ok(at) = list.binary_search(&value) else {
+        return false;
+    };
+    list.remove(at);
+    if list.is_empty() {
+        map.remove(&key);
+    }
+    true
+}
+
+impl TopicIndex {
+    /// `false` — клиент уже был подписан.
+    pub(super) fn subscribe(&mut self, topic: u32, client_id: u32) -> bool {
+        let added = insert_sorted(self.subscribers.entry(topic).or_default(), client_id);
+        if added {
+            insert_sorted(self.topics.entry(client_id).or_default(), topic);
+        }
+        added
+    }
+
+    /// `false` — клиент не был подписан.
+    pub(super) fn unsubscribe(&mut self, topic: u32, client_id: u32) -> bool {
+        let removed = remove_sorted(&mut self.subscribers, topic, client_id);
+        if removed {
+            remove_sorted(&mut self.topics, client_id, topic);
+        }
+        removed
+    }
+
+    pub(super) fn subscribers(&self, topic: u32) -> &[u32] {
+        self.subscribers.get(&topic).map_or(&[], Vec::as_slice)
+    }
+
+    /// Снимает все подписки отключившегося клиента.
+    pub(super) fn remove_client(&mut self, client_id: u32) {
+        for topic in self.topics.remove(&client_id).unwrap_or_default() {
+            remove_sorted(&mut self.subscribers, topic, client_id);
+        }
+    }
+
+    pub(super) fn clear(&mut self) {
+        self.subscribers.clear();
+        self.topics.clear();
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    #[test]
+    fn subscriptions_stay_sorted_and_unique() {
+        let mut index = TopicIndex::default();
+        assert!(index.subscribe(7, 3));
+        assert!(index.subscribe(7, 1));
+        assert!(index.subscribe(7, 2));
+        assert!(!index.subscribe(7, 1));
+        assert!(index.subscribe(8, 1));
+        assert_eq!(index.subscribers(7), [1, 2, 3]);
+        assert_eq!(index.subscribers(9), [] as [u32; 0]);
+
+        assert!(index.unsubscribe(7, 2));
+        assert!(!index.unsubscribe(7, 2));
+        assert!(!index.unsubscribe(9, 1));
+        assert_eq!(index.subscribers(7), [1, 3]);
+        assert_eq!(index.topics[&1], [7, 8]);
+        assert!(!index.topics.contains_key(&2));
+
+        index.remove_client(1);
+        index.remove_client(1);
+        assert_eq!(index.subscribers(7), [3]);
+        assert!(!index.subscribers.contains_key(&8));
+        assert!(!index.topics.contains_key(&1));
+    }
+
+    /// Клиенты приходят и уходят, подписываясь на топики, в которые никто не
+    /// публикует: после их ухода индекс пуст, а не растёт с каждым клиентом.
+    #[test]
+    fn churn_leaves_no_stale_entries() {
+        let mut index = TopicIndex::default();
+        index.subscribe(1, 0);
+        for client_id in 1..1000u32 {
+            for topic in [1, 100 + client_id, 5000 + client_id % 7] {
+                index.subscribe(topic, client_id);
+            }
+            index.remove_client(client_id);
+        }
+        assert_eq!(index.subscribers.len(), 1);
+        assert_eq!(index.subscribers(1), [0]);
+        assert_eq!(index.topics.len(), 1);
+
+        index.remove_client(0);
+        assert!(index.subscribers.is_empty());
+        assert!(index.topics.is_empty());
+    }
+}
@@ -0,0 +1,69 @@
+//! Запас заранее созданных выделенных каналов (`DispatchOptions::warm_channels`).
+//!
+//! Секция и пять именованных событий канала — это `NtCreateSection` и пять
+//! `NtCreateEvent`, плюс page fault-ы первых сообщений; на регистрации они
+//! дороже всего остального handshake. Сервер держит запас таких каналов
+//! готовыми (секция сразу pre-fault-ится): регистрация забирает канал из
+//! запаса, а фоновый поток (`DispatchServer::warm_loop`) доливает его до
+//! цели. Каналы в запас не возвращаются: имя выданного канала знает его
+//! клиент, поэтому каждый канал из запаса получает новое имя
+//! (`generate_channel_name`).
+
+use std::sync::{Condvar, Mutex};
+use std::time::Duration;
+
+use crate::server::SharedServer;
+
+/// Созданный, но никому не выданный канал.
+pub(super) struct WarmChannel {
+    pub(super) name: String,
+    pub(super) server: SharedServer,
+}
+
+pub(super) struct WarmPool {
+    ready: Mutex<Vec<WarmChannel>>,
+    /// Будит доливающий поток, когда запас просел.
+    drained: Condvar,
+    target: usize,
+}
+
+impl WarmPool {
+    pub(super) fn new(target: usize) -> Self {
+        Self {
+            ready: Mutex::new(Vec::with_capacity(target)),
+            drained: Condvar::new(),
+            target,
+        }
+    }
+
+    /// Готовый канал; `None` — запас пуст, канал создаёт вызывающий.
+    pub(super) fn take(&self) -> Option<WarmChannel> {
+        let channel = self.ready.lock().unwrap().pop();
+        self.drained.notify_one();
+        channel
+    }
+
+    /// Кладёт канал в запас; сверх цели канал закрывается.
+    pub(super) fn put(&self, channel: WarmChannel) {
+        let mut ready = self.ready.lock().unwrap();
+        if ready.len() < self.target {
+            ready.push(channel);
+        }
+    }
+
+    /// Сколько каналов не хватает до цели. Ждёт не дольше `timeout`, пока
+    /// запас полон.
+    pub(super) fn wait_deficit(&self, timeout: Duration) -> usize {
+        let ready = self.ready.lock().unwrap();
+        let (ready, _) = self
+            .drained
+            .wait_timeout_while(ready, timeout, |ready| ready.len() >= self.target)
+            .unwrap();
+        self.target.saturating_sub(ready.len())
+    }
+
+    /// Будит доливающий поток (остановка сервера).
+    pub(super) fn wake(&self) {
+        self.drained.notify_all();
+    }
+}
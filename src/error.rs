@@ -28,6 +28,10 @@ pub enum ShmError {
     /// Сообщение превышает допустимый размер.
     #[error("message is too large")]
     MessageTooLarge,
+    /// Подсмотренное (peek) сообщение вытеснено producer-ом до consume;
+    /// прочитанные через spans данные недействительны.
+    #[error("peeked message was overwritten before consume")]
+    Overwritten,
     /// Формат данных в буфере повреждён или некорректен.
     #[error("shared ring buffer is corrupted")]
     Corrupted,
@@ -48,4 +52,10 @@ pub enum ShmError {
     /// Некорректная конфигурация (например, недопустимое число клиентов).
     #[error("invalid configuration: {0}")]
     InvalidConfig(&'static str),
+    /// RPC-handler другой стороны отклонил вызов с прикладным кодом.
+    #[error("remote call failed with code {0}")]
+    RemoteFailed(u32),
+    /// RPC-вызова с таким id нет: не отправлялся, уже забран, снят или истёк.
+    #[error("unknown rpc call id")]
+    UnknownCall,
 }
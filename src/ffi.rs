@@ -16,13 +16,41 @@ use crate::auto::{
 use crate::client::SharedClient;
 use crate::constants::MAX_MESSAGE_SIZE;
 use crate::error::{Result, ShmError};
+use crate::layout::ChannelGeometry;
+use crate::ring::{MessageBatch, OverflowPolicy, PeekedMessage, WriteReservation};
 use crate::server::SharedServer;
+use crate::stats::{ChannelStatsSnapshot, HistogramSnapshot, HISTOGRAM_BUCKETS};
+use crate::trace::MessageTrace;
+use crate::wait::WaitStrategy;
+use crate::win::SectionOptions;
 
 #[repr(C)]
 pub struct shm_endpoint_config_t {
     pub name: *const c_char,
 }
 
+/// Метка трассируемого сообщения (см. `MessageTrace`).
+#[repr(C)]
+#[derive(Clone, Copy, Default)]
+pub struct shm_message_trace_t {
+    /// Порядковый номер кадра в кольце отправителя
+    pub sequence: u32,
+    /// Метка постановки в очередь, тики QueryPerformanceCounter
+    pub enqueued: u64,
+    /// Ожидание до чтения, нс
+    pub queued_ns: u64,
+}
+
+impl From<MessageTrace> for shm_message_trace_t {
+    fn from(value: MessageTrace) -> Self {
+        Self {
+            sequence: value.sequence,
+            enqueued: value.enqueued,
+            queued_ns: value.queued_ns,
+        }
+    }
+}
+
 #[repr(C)]
 #[derive(Clone, Copy)]
 pub struct shm_callbacks_t {
@@ -42,6 +70,17 @@ pub struct shm_callbacks_t {
     >,
     pub on_overflow:
         Option<extern "C" fn(direction: shm_direction_t, dropped: u32, user_data: *mut c_void)>,
+    /// Сообщение с меткой трассировки; без этого callback-а оно уходит в
+    /// `on_message`
+    pub on_traced_message: Option<
+        extern "C" fn(
+            direction: shm_direction_t,
+            data: *const c_void,
+            size: u32,
+            trace: *const shm_message_trace_t,
+            user_data: *mut c_void,
+        ),
+    >,
 }
 
 #[repr(C)]
@@ -60,6 +99,8 @@ pub enum shm_error_t {
     SHM_ERROR_PROTOCOL = -9,
     SHM_ERROR_FULL = -10,
     SHM_ERROR_NO_SLOT = -11,
+    SHM_ERROR_OVERWRITTEN = -12,
+    SHM_ERROR_REMOTE = -13,
 }
 
 impl From<ShmError> for shm_error_t {
@@ -78,6 +119,9 @@ impl From<ShmError> for shm_error_t {
             ShmError::WindowsError { .. } => shm_error_t::SHM_ERROR_ACCESS,
             ShmError::InvalidConfig(_) => shm_error_t::SHM_ERROR_INVALID_PARAM,
             ShmError::NoFreeSlot => shm_error_t::SHM_ERROR_NO_SLOT,
+            ShmError::Overwritten => shm_error_t::SHM_ERROR_OVERWRITTEN,
+            ShmError::RemoteFailed(_) => shm_error_t::SHM_ERROR_REMOTE,
+            ShmError::UnknownCall => shm_error_t::SHM_ERROR_INVALID_PARAM,
         }
     }
 }
@@ -283,6 +327,150 @@ mod recv_cache_tests {
         shm_client_disconnect(client);
         shm_server_stop(server);
     }
+
+    /// Исключение из `fill` в `typed_channel::emplace` (xshm_typed.hpp)
+    /// снимает резерв через `shm_*_cancel`; зависший резерв навсегда
+    /// закрывал бы handle для отправки (`SHM_ERROR_EXISTS`).
+    #[test]
+    fn cancelled_reserve_frees_the_write_side() {
+        let name = unique_name("CANCEL");
+        const SLOT: u32 = 48;
+
+        let server_thread = {
+            let name = name.clone();
+            thread::spawn(move || {
+                let name_c = CString::new(name).unwrap();
+                let config = shm_endpoint_config_t {
+                    name: name_c.as_ptr(),
+                };
+                let geometry = shm_channel_geometry_t {
+                    max_message_size: SLOT,
+                    slot_size: SLOT,
+                    ..shm_channel_geometry_default()
+                };
+                let server = shm_server_start_with_geometry(&config, std::ptr::null(), &geometry);
+                assert!(!server.is_null());
+                assert_eq!(
+                    shm_server_wait_for_client(server, 5000),
+                    shm_error_t::SHM_SUCCESS
+                );
+                server as usize
+            })
+        };
+
+        thread::sleep(StdDuration::from_millis(50));
+
+        let name_c = CString::new(name).unwrap();
+        let config = shm_endpoint_config_t {
+            name: name_c.as_ptr(),
+        };
+        let client = shm_client_connect(&config, std::ptr::null(), 5000);
+        assert!(!client.is_null());
+        let server = server_thread.join().unwrap() as *mut ServerHandle;
+
+        let quote = [7u8; SLOT as usize];
+        let mut span = std::mem::MaybeUninit::<shm_write_span_t>::uninit();
+        assert_eq!(
+            shm_server_reserve(server, SLOT, span.as_mut_ptr()),
+            shm_error_t::SHM_SUCCESS
+        );
+        assert_eq!(
+            shm_server_send(server, quote.as_ptr() as *const c_void, SLOT),
+            shm_error_t::SHM_ERROR_EXISTS
+        );
+
+        // путь исключения: cancel вместо commit, слот не публикуется
+        assert_eq!(shm_server_cancel(server), shm_error_t::SHM_SUCCESS);
+        assert_eq!(
+            shm_server_send(server, quote.as_ptr() as *const c_void, SLOT),
+            shm_error_t::SHM_SUCCESS
+        );
+
+        assert_eq!(shm_client_poll(client, 5000), shm_error_t::SHM_SUCCESS);
+        let mut buf = [0u8; 64];
+        let mut size = buf.len() as u32;
+        let result = shm_client_receive(client, buf.as_mut_ptr() as *mut c_void, &mut size);
+        assert_eq!(result, shm_error_t::SHM_SUCCESS);
+        assert_eq!(&buf[..size as usize], &quote);
+        let mut size = buf.len() as u32;
+        let result = shm_client_receive(client, buf.as_mut_ptr() as *mut c_void, &mut size);
+        assert_eq!(result, shm_error_t::SHM_ERROR_EMPTY);
+
+        shm_client_disconnect(client);
+        shm_server_stop(server);
+    }
+
+    /// Резерв с нескольких потоков на одном handle: проверка и захват — под
+    /// одной блокировкой, поэтому резерв получает ровно один поток, а
+    /// кольцо — одно сообщение.
+    #[test]
+    fn racing_reserves_get_a_single_reservation() {
+        let name = unique_name("RESERVE_RACE");
+        const THREADS: usize = 8;
+
+        let server_thread = {
+            let name = name.clone();
+            thread::spawn(move || {
+                let name_c = CString::new(name).unwrap();
+                let config = shm_endpoint_config_t {
+                    name: name_c.as_ptr(),
+                };
+                let server = shm_server_start(&config, std::ptr::null());
+                assert!(!server.is_null());
+                assert_eq!(
+                    shm_server_wait_for_client(server, 5000),
+                    shm_error_t::SHM_SUCCESS
+                );
+                server as usize
+            })
+        };
+
+        thread::sleep(StdDuration::from_millis(50));
+
+        let name_c = CString::new(name).unwrap();
+        let config = shm_endpoint_config_t {
+            name: name_c.as_ptr(),
+        };
+        let client = shm_client_connect(&config, std::ptr::null(), 5000);
+        assert!(!client.is_null());
+        let server = server_thread.join().unwrap();
+
+        let start = Arc::new(std::sync::Barrier::new(THREADS));
+        let racers: Vec<_> = (0..THREADS)
+            .map(|_| {
+                let start = start.clone();
+                thread::spawn(move || {
+                    let mut span = std::mem::MaybeUninit::<shm_write_span_t>::uninit();
+                    start.wait();
+                    shm_server_reserve(server as *mut ServerHandle, 16, span.as_mut_ptr())
+                })
+            })
+            .collect();
+        let results: Vec<_> = racers.into_iter().map(|t| t.join().unwrap()).collect();
+        let won = results
+            .iter()
+            .filter(|&&r| r == shm_error_t::SHM_SUCCESS)
+            .count();
+        assert_eq!(won, 1, "{results:?}");
+        assert!(results
+            .iter()
+            .all(|&r| r == shm_error_t::SHM_SUCCESS || r == shm_error_t::SHM_ERROR_EXISTS));
+
+        let server = server as *mut ServerHandle;
+        assert_eq!(shm_server_commit(server, 16), shm_error_t::SHM_SUCCESS);
+        assert_eq!(shm_client_poll(client, 5000), shm_error_t::SHM_SUCCESS);
+        let mut buf = [0u8; 64];
+        let mut size = buf.len() as u32;
+        let result = shm_client_receive(client, buf.as_mut_ptr() as *mut c_void, &mut size);
+        assert_eq!(result, shm_error_t::SHM_SUCCESS);
+        assert_eq!(size, 16);
+        let mut size = buf.len() as u32;
+        let result = shm_client_receive(client, buf.as_mut_ptr() as *mut c_void, &mut size);
+        assert_eq!(result, shm_error_t::SHM_ERROR_EMPTY);
+
+        shm_client_disconnect(client);
+        shm_server_stop(server);
+    }
 }
 
 #[repr(C)]
@@ -293,6 +481,147 @@ pub enum shm_direction_t {
     SHM_DIR_CLIENT_TO_SERVER = 1,
 }
 
+/// Выделение памяти секции (см. `SectionOptions`). Zero-initialized —
+/// обычные страницы без предпочтения узла.
+#[repr(C)]
+#[derive(Clone, Copy, Default)]
+pub struct shm_section_options_t {
+    /// Большие страницы (SEC_LARGE_PAGES) с откатом на обычные
+    pub large_pages: bool,
+    /// Коснуться всех страниц при создании
+    pub prefault: bool,
+    /// Предпочтительный NUMA-узел плюс один; 0 — без предпочтения
+    pub numa_node: u32,
+}
+
+impl From<shm_section_options_t> for SectionOptions {
+    fn from(value: shm_section_options_t) -> Self {
+        SectionOptions {
+            large_pages: value.large_pages,
+            prefault: value.prefault,
+            numa_node: value.numa_node.checked_sub(1),
+        }
+    }
+}
+
+/// Геометрия колец канала (см. `ChannelGeometry`).
+///
+/// Нулевое поле означает значение по умолчанию, поэтому zero-initialized
+/// структура эквивалентна `shm_channel_geometry_default()`.
+#[repr(C)]
+#[derive(Clone, Copy)]
+pub struct shm_channel_geometry_t {
+    /// Ёмкость кольца server→client, байты (степень двойки, 4 КБ..1 ГБ)
+    pub s2c_capacity: u32,
+    /// Ёмкость кольца client→server, байты (степень двойки, 4 КБ..1 ГБ)
+    pub c2s_capacity: u32,
+    /// Предел числа сообщений в одном кольце
+    pub max_messages: u32,
+    /// Максимальный размер сообщения (больше 65535 — длинные кадры)
+    pub max_message_size: u32,
+    /// Выделение памяти сегмента (в конце структуры, чтобы не сдвигать
+    /// прежние поля)
+    pub memory: shm_section_options_t,
+    /// Дорожек на направление, включая основное кольцо (0 — одна, до 64,
+    /// см. `ChannelGeometry::lanes`)
+    pub lanes: u32,
+    /// Размер слота колец фиксированных слотов (0 — кадры переменной длины,
+    /// см. `ChannelGeometry::slot_size`); при нулевом `max_message_size`
+    /// задаёт и его
+    pub slot_size: u32,
+}
+
+impl Default for shm_channel_geometry_t {
+    fn default() -> Self {
+        let geometry = ChannelGeometry::default();
+        Self {
+            s2c_capacity: geometry.s2c_capacity as u32,
+            c2s_capacity: geometry.c2s_capacity as u32,
+            max_messages: geometry.max_messages,
+            max_message_size: geometry.max_message_size as u32,
+            memory: shm_section_options_t::default(),
+            lanes: geometry.lanes,
+            slot_size: geometry.slot_size,
+        }
+    }
+}
+
+impl From<shm_channel_geometry_t> for ChannelGeometry {
+    fn from(value: shm_channel_geometry_t) -> Self {
+        let defaults = ChannelGeometry::default();
+        let or_default = |v: u32, d: usize| if v == 0 { d } else { v as usize };
+        ChannelGeometry {
+            s2c_capacity: or_default(value.s2c_capacity, defaults.s2c_capacity),
+            c2s_capacity: or_default(value.c2s_capacity, defaults.c2s_capacity),
+            max_messages: if value.max_messages == 0 {
+                defaults.max_messages
+            } else {
+                value.max_messages
+            },
+            max_message_size: match (value.max_message_size, value.slot_size) {
+                (0, 0) => defaults.max_message_size,
+                (0, slot_size) => slot_size as usize,
+                (max, _) => max as usize,
+            },
+            lanes: value.lanes.max(1),
+            slot_size: value.slot_size,
+            memory: value.memory.into(),
+        }
+    }
+}
+
+/// Стратегия ожидания worker-а (см. `WaitStrategy`): `spin_us` мкс
+/// busy-spin, затем `yield_us` мкс yield, затем событие. Нули — сразу
+/// событие (zero-initialized структура сохраняет прежнее поведение).
+#[repr(C)]
+#[derive(Clone, Copy, Default)]
+pub struct shm_wait_strategy_t {
+    pub spin_us: u32,
+    pub yield_us: u32,
+}
+
+impl From<shm_wait_strategy_t> for WaitStrategy {
+    fn from(value: shm_wait_strategy_t) -> Self {
+        WaitStrategy::spin_then_block(
+            Duration::from_micros(value.spin_us as u64),
+            Duration::from_micros(value.yield_us as u64),
+        )
+    }
+}
+
+/// `shm_overflow_policy_t::mode`: вытеснять самые старые сообщения.
+pub const SHM_OVERFLOW_OVERWRITE: u32 = 0;
+/// `shm_overflow_policy_t::mode`: вернуть `SHM_ERROR_FULL`.
+pub const SHM_OVERFLOW_FAIL: u32 = 1;
+/// `shm_overflow_policy_t::mode`: ждать места до `timeout_ms`.
+pub const SHM_OVERFLOW_BLOCK: u32 = 2;
+
+/// Политика отправки при нехватке места (см. `OverflowPolicy`): `mode` —
+/// одна из `SHM_OVERFLOW_*`, `timeout_ms` — предел ожидания для
+/// `SHM_OVERFLOW_BLOCK` (`UINT32_MAX` — без предела). Zero-initialized
+/// структура сохраняет прежнее вытеснение.
+#[repr(C)]
+#[derive(Clone, Copy, Default)]
+pub struct shm_overflow_policy_t {
+    pub mode: u32,
+    pub timeout_ms: u32,
+}
+
+impl shm_overflow_policy_t {
+    fn to_policy(self) -> Option<OverflowPolicy> {
+        match self.mode {
+            SHM_OVERFLOW_OVERWRITE => Some(OverflowPolicy::Overwrite),
+            SHM_OVERFLOW_FAIL => Some(OverflowPolicy::Fail),
+            SHM_OVERFLOW_BLOCK => Some(OverflowPolicy::Block(if self.timeout_ms == u32::MAX {
+                Duration::MAX
+            } else {
+                Duration::from_millis(self.timeout_ms as u64)
+            })),
+            _ => None,
+        }
+    }
+}
+
 #[repr(C)]
 #[derive(Clone, Copy)]
 pub struct shm_auto_options_t {
@@ -301,6 +630,22 @@ pub struct shm_auto_options_t {
     pub connect_timeout_ms: u32,
     pub max_send_queue: u32,
     pub recv_batch: u32,
+    /// Геометрия колец (учитывается только сервером)
+    pub geometry: shm_channel_geometry_t,
+    /// Ожидание входящих сообщений worker-ом
+    pub wait: shm_wait_strategy_t,
+    /// Полная очередь отправки / кольцо: вытеснение, `SHM_ERROR_FULL` или
+    /// ожидание в `shm_*_send_auto`
+    pub overflow: shm_overflow_policy_t,
+    /// Pull-режим: `on_message` не вызывается, входящие забираются
+    /// `shm_*_receive_auto`/`shm_*_receive_batch_auto` по событию
+    /// `shm_*_wait_handle_auto`
+    pub pull: bool,
+    /// Бюджет пачки приёма, мкс (см. `AutoOptions::recv_budget`); 0 —
+    /// фиксированная пачка `recv_batch`
+    pub recv_budget_us: u32,
+    /// Метки трассировки на исходящих сообщениях (см. `AutoOptions::trace`)
+    pub trace: bool,
 }
 
 impl Default for shm_auto_options_t {
@@ -311,6 +656,12 @@ impl Default for shm_auto_options_t {
             connect_timeout_ms: 2000,
             max_send_queue: 256,
             recv_batch: 32,
+            geometry: shm_channel_geometry_t::default(),
+            wait: shm_wait_strategy_t::default(),
+            overflow: shm_overflow_policy_t::default(),
+            pull: false,
+            recv_budget_us: 0,
+            trace: false,
         }
     }
 }
@@ -324,6 +675,127 @@ pub struct shm_auto_stats_t {
     pub receive_overflows: u64,
 }
 
+/// Число корзин `shm_histogram_t::buckets`.
+pub const SHM_HISTOGRAM_BUCKETS: u32 = HISTOGRAM_BUCKETS as u32;
+
+/// log2-гистограмма: `buckets[0]` — нули, `buckets[i]` — значения из
+/// `[2^(i-1), 2^i)`, последняя корзина — всё, что больше.
+#[repr(C)]
+#[derive(Clone, Copy)]
+pub struct shm_histogram_t {
+    pub count: u64,
+    pub sum: u64,
+    pub max: u64,
+    pub buckets: [u64; HISTOGRAM_BUCKETS],
+}
+
+impl From<HistogramSnapshot> for shm_histogram_t {
+    fn from(value: HistogramSnapshot) -> Self {
+        Self {
+            count: value.count,
+            sum: value.sum,
+            max: value.max,
+            buckets: value.buckets,
+        }
+    }
+}
+
+/// Телеметрия одной стороны канала (см. `ChannelStatsSnapshot`).
+#[repr(C)]
+#[derive(Clone, Copy)]
+pub struct shm_channel_stats_t {
+    /// Пик занятых байт / сообщений исходящего кольца
+    pub high_water_bytes: u32,
+    pub high_water_messages: u32,
+    /// Сообщений, вытесненных из исходящего кольца
+    pub dropped_messages: u64,
+    /// Пробуждений worker-а по data-событию и из них пустых
+    pub wakeups: u64,
+    pub spurious_wakeups: u64,
+    /// Сообщений за одно чтение worker-а
+    pub batch_sizes: shm_histogram_t,
+    /// Задержка публикация → чтение входящего кольца, нс (сэмплы)
+    pub latency_ns: shm_histogram_t,
+    /// Время раздачи пачки callback-ам, нс
+    pub handler_ns: shm_histogram_t,
+    /// Ожидание трассируемых сообщений в очереди и кольце, нс
+    pub queue_delay_ns: shm_histogram_t,
+}
+
+pub(crate) fn write_channel_stats(
+    dst: *mut shm_channel_stats_t,
+    stats: ChannelStatsSnapshot,
+) -> bool {
+    if dst.is_null() {
+        return false;
+    }
+    unsafe {
+        *dst = shm_channel_stats_t {
+            high_water_bytes: stats.high_water_bytes,
+            high_water_messages: stats.high_water_messages,
+            dropped_messages: stats.dropped_messages,
+            wakeups: stats.wakeups,
+            spurious_wakeups: stats.spurious_wakeups,
+            batch_sizes: stats.batch_sizes.into(),
+            latency_ns: stats.latency_ns.into(),
+            handler_ns: stats.handler_ns.into(),
+            queue_delay_ns: stats.queue_delay_ns.into(),
+        };
+    }
+    true
+}
+
+/// Участки кольца, выданные `shm_*_reserve` под одно сообщение.
+///
+/// Payload пишется подряд: сначала `first_size` байт в `first`, затем
+/// остаток в `second`. `second` равен NULL (`second_size == 0`), если резерв
+/// не переходит через границу кольца.
+#[repr(C)]
+#[derive(Clone, Copy)]
+pub struct shm_write_span_t {
+    pub first: *mut c_void,
+    pub first_size: u32,
+    pub second: *mut c_void,
+    pub second_size: u32,
+}
+
+/// Участки payload, выданные `shm_*_peek` (та же раскладка, что и у
+/// `shm_write_span_t`, но только для чтения).
+#[repr(C)]
+#[derive(Clone, Copy)]
+pub struct shm_read_span_t {
+    pub first: *const c_void,
+    pub first_size: u32,
+    pub second: *const c_void,
+    pub second_size: u32,
+}
+
+/// Одно сообщение пачки для `shm_*_send_batch` (iovec-style).
+#[repr(C)]
+#[derive(Clone, Copy)]
+pub struct shm_iovec_t {
+    pub data: *const c_void,
+    pub size: u32,
+}
+
+/// Срезы сообщений пачки; `None`, если массив или любое сообщение невалидны
+/// (NULL-данные либо нулевой размер — как у одиночного send).
+fn batch_slices<'a>(messages: *const shm_iovec_t, count: u32) -> Option<Vec<&'a [u8]>> {
+    if messages.is_null() || count == 0 {
+        return None;
+    }
+    let items = unsafe { std::slice::from_raw_parts(messages, count as usize) };
+    items
+        .iter()
+        .map(|item| {
+            if item.data.is_null() || item.size == 0 {
+                return None;
+            }
+            Some(unsafe { std::slice::from_raw_parts(item.data as *const u8, item.size as usize) })
+        })
+        .collect()
+}
+
 fn to_rust_str(ptr: *const c_char) -> Result<String> {
     if ptr.is_null() {
         return Err(ShmError::NotReady);
@@ -340,9 +812,16 @@ fn to_rust_str(ptr: *const c_char) -> Result<String> {
 /// оно остаётся в `buffer`, а `pending_len` помечает его как недоставленное:
 /// следующий вызов receive сначала отдаёт его из кэша и только затем читает
 /// новое сообщение из ring buffer.
+///
+/// `peeked` — сообщение, выданное `shm_*_peek` и ещё не забранное
+/// `shm_*_consume`; обычный receive отменяет такой peek.
+///
+/// `batch` — арена пакетного приёма, переиспользуется между вызовами.
 struct RecvCache {
     buffer: Vec<u8>,
     pending_len: Option<usize>,
+    peeked: Option<PeekedMessage>,
+    batch: MessageBatch,
 }
 
 impl RecvCache {
@@ -350,7 +829,97 @@ impl RecvCache {
         Self {
             buffer: Vec::with_capacity(MAX_MESSAGE_SIZE),
             pending_len: None,
+            peeked: None,
+            batch: MessageBatch::new(),
+        }
+    }
+
+    /// Общая часть `shm_*_receive`: сначала недоставленное сообщение из
+    /// кэша, иначе новое через `read`; копия в `buffer` ёмкостью `*size`.
+    fn receive(
+        &mut self,
+        read: impl FnOnce(&mut Vec<u8>) -> Result<usize>,
+        buffer: *mut c_void,
+        size: *mut u32,
+    ) -> shm_error_t {
+        let capacity = unsafe { *size } as usize;
+        if capacity == 0 {
+            return shm_error_t::SHM_ERROR_INVALID_PARAM;
+        }
+        self.peeked = None;
+        let len = match self.pending_len.take() {
+            Some(pending_len) => pending_len,
+            None => match read(&mut self.buffer) {
+                Ok(len) => len,
+                Err(err) => return err.into(),
+            },
+        };
+        if len > capacity {
+            self.pending_len = Some(len);
+            return shm_error_t::SHM_ERROR_MEMORY;
+        }
+        unsafe {
+            std::ptr::copy_nonoverlapping(self.buffer.as_ptr(), buffer as *mut u8, len);
+            *size = len as u32;
+        }
+        shm_error_t::SHM_SUCCESS
+    }
+
+    /// Общая часть `shm_*_receive_batch`: вычитывает пачку через `read`
+    /// (`read_batch` с лимитом байт = размер буфера C), копирует арену
+    /// одним memcpy и заполняет `offsets` (`max_messages + 1` элементов,
+    /// сообщение `i` лежит в `buffer[offsets[i]..offsets[i + 1]]`).
+    ///
+    /// Первое сообщение, не влезающее в буфер целиком, уходит в `pending_len`
+    /// (как у одиночного receive) и даёт `SHM_ERROR_MEMORY`; недоставленное
+    /// сообщение из кэша отдаётся первым, пачкой из одного.
+    fn receive_batch(
+        &mut self,
+        read: impl FnOnce(&mut MessageBatch, usize, usize) -> Result<usize>,
+        buffer: *mut c_void,
+        buffer_size: u32,
+        offsets: *mut u32,
+        max_messages: u32,
+        count: *mut u32,
+    ) -> shm_error_t {
+        let capacity = buffer_size as usize;
+        self.peeked = None;
+        if let Some(len) = self.pending_len.take() {
+            if len > capacity {
+                self.pending_len = Some(len);
+                return shm_error_t::SHM_ERROR_MEMORY;
+            }
+            unsafe {
+                std::ptr::copy_nonoverlapping(self.buffer.as_ptr(), buffer as *mut u8, len);
+                *offsets = 0;
+                *offsets.add(1) = len as u32;
+                *count = 1;
+            }
+            return shm_error_t::SHM_SUCCESS;
+        }
+
+        let received = match read(&mut self.batch, max_messages as usize, capacity) {
+            Ok(received) => received,
+            Err(err) => return err.into(),
+        };
+        let bytes = self.batch.as_bytes();
+        if bytes.len() > capacity {
+            // read_batch берёт первое сообщение всегда — значит, оно одно
+            // и в буфер C не влезает
+            self.buffer.clear();
+            self.buffer.extend_from_slice(bytes);
+            self.pending_len = Some(bytes.len());
+            return shm_error_t::SHM_ERROR_MEMORY;
+        }
+        unsafe {
+            std::ptr::copy_nonoverlapping(bytes.as_ptr(), buffer as *mut u8, bytes.len());
+            *offsets = 0;
+            for (index, &end) in self.batch.ends().iter().enumerate() {
+                *offsets.add(index + 1) = end as u32;
+            }
+            *count = received as u32;
         }
+        shm_error_t::SHM_SUCCESS
     }
 }
 
@@ -358,11 +927,18 @@ struct ServerState {
     inner: SharedServer,
     callbacks: Option<shm_callbacks_t>,
     recv_cache: Mutex<RecvCache>,
+    /// Активный zero-copy резерв (`shm_server_reserve` .. `shm_server_commit`).
+    /// Заодно замок пишущей стороны: отправка, пачка, резерв и commit держат
+    /// его всю операцию, поэтому кольцо (SPSC) видит одного producer-а, со
+    /// скольких бы потоков ни звали дескриптор.
+    reservation: Mutex<Option<WriteReservation>>,
 }
 
 struct ClientState {
     inner: SharedClient,
     recv_cache: Mutex<RecvCache>,
+    /// См. `ServerState::reservation`.
+    reservation: Mutex<Option<WriteReservation>>,
 }
 
 pub type ServerHandle = c_void;
@@ -374,12 +950,15 @@ struct AutoServerState {
     inner: AutoServer,
     _callbacks: Option<shm_callbacks_t>,
     _handler: Arc<FfiHandler>,
+    /// Приём в pull-режиме (`shm_server_receive_auto`).
+    recv_cache: Mutex<RecvCache>,
 }
 
 struct AutoClientState {
     inner: AutoClient,
     _callbacks: Option<shm_callbacks_t>,
     _handler: Arc<FfiHandler>,
+    recv_cache: Mutex<RecvCache>,
 }
 
 #[derive(Clone)]
@@ -429,6 +1008,7 @@ impl Default for shm_callbacks_t {
             user_data: null_mut(),
             on_message: None,
             on_overflow: None,
+            on_traced_message: None,
         }
     }
 }
@@ -459,6 +1039,21 @@ impl AutoHandler for FfiHandler {
         }
     }
 
+    fn on_traced_message(&self, direction: ChannelKind, payload: &[u8], trace: MessageTrace) {
+        if let Some(cb) = self.callbacks.on_traced_message {
+            let trace = shm_message_trace_t::from(trace);
+            cb(
+                direction.into(),
+                payload.as_ptr() as *const c_void,
+                payload.len() as u32,
+                &trace,
+                self.callbacks.user_data,
+            );
+        } else {
+            self.on_message(direction, payload);
+        }
+    }
+
     fn on_overflow(&self, direction: ChannelKind, dropped: u32) {
         if let Some(cb) = self.callbacks.on_overflow {
             cb(direction.into(), dropped, self.callbacks.user_data);
@@ -487,7 +1082,7 @@ impl From<ChannelKind> for shm_direction_t {
     }
 }
 
-fn ffi_auto_options(ptr: *const shm_auto_options_t) -> AutoOptions {
+pub(crate) fn ffi_auto_options(ptr: *const shm_auto_options_t) -> AutoOptions {
     if ptr.is_null() {
         return AutoOptions::default();
     }
@@ -498,6 +1093,14 @@ fn ffi_auto_options(ptr: *const shm_auto_options_t) -> AutoOptions {
         connect_timeout: Duration::from_millis(opts.connect_timeout_ms as u64),
         max_send_queue: opts.max_send_queue as usize,
         recv_batch: opts.recv_batch as usize,
+        recv_budget: Duration::from_micros(opts.recv_budget_us as u64),
+        geometry: opts.geometry.into(),
+        wait: opts.wait.into(),
+        // неизвестный режим — прежнее поведение, как у нулевых полей
+        overflow: opts.overflow.to_policy().unwrap_or_default(),
+        broadcast: None,
+        pull: opts.pull,
+        trace: opts.trace,
     }
 }
 
@@ -521,6 +1124,18 @@ pub extern "C" fn shm_auto_options_default() -> shm_auto_options_t {
     shm_auto_options_t::default()
 }
 
+#[unsafe(no_mangle)]
+pub extern "C" fn shm_channel_geometry_default() -> shm_channel_geometry_t {
+    shm_channel_geometry_t::default()
+}
+
+/// Порог non-temporal записи payload-ов для всех каналов процесса (см.
+/// `set_stream_threshold`); `UINTPTR_MAX` — никогда.
+#[unsafe(no_mangle)]
+pub extern "C" fn shm_set_stream_threshold(bytes: usize) {
+    crate::copy::set_stream_threshold(bytes);
+}
+
 #[unsafe(no_mangle)]
 pub extern "C" fn shm_server_start_auto(
     config: *const shm_endpoint_config_t,
@@ -549,6 +1164,7 @@ pub extern "C" fn shm_server_start_auto(
             inner,
             _callbacks: Some(callbacks_val),
             _handler: handler,
+            recv_cache: Mutex::new(RecvCache::new()),
         })) as *mut AutoServerHandle,
         Err(err) => {
             if let Some(cb) = callbacks_val.on_error {
@@ -565,7 +1181,7 @@ pub extern "C" fn shm_server_send_auto(
     data: *const c_void,
     size: u32,
 ) -> shm_error_t {
-    if handle.is_null() || data.is_null() || size == 0 || size as usize > MAX_MESSAGE_SIZE {
+    if handle.is_null() || data.is_null() || size == 0 {
         return shm_error_t::SHM_ERROR_INVALID_PARAM;
     }
     let state = unsafe { &*auto_server_state_from(handle) };
@@ -588,6 +1204,79 @@ pub extern "C" fn shm_server_stats_auto(
     write_stats(out, state.inner.stats())
 }
 
+#[unsafe(no_mangle)]
+pub extern "C" fn shm_server_channel_stats_auto(
+    handle: *const AutoServerHandle,
+    out: *mut shm_channel_stats_t,
+) -> bool {
+    if handle.is_null() {
+        return false;
+    }
+    let state = unsafe { &*auto_server_state_from_const(handle) };
+    write_channel_stats(out, state.inner.stats().channel)
+}
+
+/// Pull-режим: одно сообщение клиента на потоке вызывающего, семантика буфера
+/// как у `shm_server_receive`. `SHM_ERROR_EMPTY` — входящих нет, можно ждать
+/// `shm_server_wait_handle_auto`; `SHM_ERROR_INVALID_PARAM` — объект создан без
+/// `pull`.
+#[unsafe(no_mangle)]
+pub extern "C" fn shm_server_receive_auto(
+    handle: *mut AutoServerHandle,
+    buffer: *mut c_void,
+    size: *mut u32,
+) -> shm_error_t {
+    if handle.is_null() || buffer.is_null() || size.is_null() {
+        return shm_error_t::SHM_ERROR_INVALID_PARAM;
+    }
+    let state = unsafe { &*auto_server_state_from(handle) };
+    let mut cache = state.recv_cache.lock().unwrap();
+    cache.receive(|buffer| state.inner.receive(buffer), buffer, size)
+}
+
+/// Pull-режим: пачка сообщений, семантика как у `shm_server_receive_batch`.
+#[unsafe(no_mangle)]
+pub extern "C" fn shm_server_receive_batch_auto(
+    handle: *mut AutoServerHandle,
+    buffer: *mut c_void,
+    buffer_size: u32,
+    offsets: *mut u32,
+    max_messages: u32,
+    count: *mut u32,
+) -> shm_error_t {
+    if handle.is_null()
+        || buffer.is_null()
+        || offsets.is_null()
+        || count.is_null()
+        || buffer_size == 0
+        || max_messages == 0
+    {
+        return shm_error_t::SHM_ERROR_INVALID_PARAM;
+    }
+    let state = unsafe { &*auto_server_state_from(handle) };
+    let mut cache = state.recv_cache.lock().unwrap();
+    cache.receive_batch(
+        |batch, max_messages, max_bytes| state.inner.receive_batch(batch, max_messages, max_bytes),
+        buffer,
+        buffer_size,
+        offsets,
+        max_messages,
+        count,
+    )
+}
+
+/// Pull-режим: HANDLE auto-reset события для `WaitForMultipleObjects` —
+/// после него повторять `shm_server_receive*_auto` до `SHM_ERROR_EMPTY`.
+/// Принадлежит объекту, закрывать нельзя; 0 — объект создан без `pull`.
+#[unsafe(no_mangle)]
+pub extern "C" fn shm_server_wait_handle_auto(handle: *const AutoServerHandle) -> isize {
+    if handle.is_null() {
+        return 0;
+    }
+    let state = unsafe { &*auto_server_state_from_const(handle) };
+    state.inner.wait_handle().unwrap_or(0)
+}
+
 #[unsafe(no_mangle)]
 pub extern "C" fn shm_server_stop_auto(handle: *mut AutoServerHandle) {
     if handle.is_null() {
@@ -626,6 +1315,7 @@ pub extern "C" fn shm_client_connect_auto(
             inner,
             _callbacks: Some(callbacks_val),
             _handler: handler,
+            recv_cache: Mutex::new(RecvCache::new()),
         })) as *mut AutoClientHandle,
         Err(err) => {
             if let Some(cb) = callbacks_val.on_error {
@@ -642,7 +1332,7 @@ pub extern "C" fn shm_client_send_auto(
     data: *const c_void,
     size: u32,
 ) -> shm_error_t {
-    if handle.is_null() || data.is_null() || size == 0 || size as usize > MAX_MESSAGE_SIZE {
+    if handle.is_null() || data.is_null() || size == 0 {
         return shm_error_t::SHM_ERROR_INVALID_PARAM;
     }
     let state = unsafe { &*auto_client_state_from(handle) };
@@ -666,12 +1356,85 @@ pub extern "C" fn shm_client_stats_auto(
 }
 
 #[unsafe(no_mangle)]
-pub extern "C" fn shm_client_disconnect_auto(handle: *mut AutoClientHandle) {
+pub extern "C" fn shm_client_channel_stats_auto(
+    handle: *const AutoClientHandle,
+    out: *mut shm_channel_stats_t,
+) -> bool {
     if handle.is_null() {
-        return;
+        return false;
     }
-    unsafe {
-        drop(Box::from_raw(auto_client_state_from(handle)));
+    let state = unsafe { &*auto_client_state_from_const(handle) };
+    write_channel_stats(out, state.inner.stats().channel)
+}
+
+/// Pull-режим: одно сообщение сервера на потоке вызывающего, семантика буфера
+/// как у `shm_client_receive`. `SHM_ERROR_EMPTY` — входящих нет, можно ждать
+/// `shm_client_wait_handle_auto`; `SHM_ERROR_INVALID_PARAM` — объект создан без
+/// `pull`.
+#[unsafe(no_mangle)]
+pub extern "C" fn shm_client_receive_auto(
+    handle: *mut AutoClientHandle,
+    buffer: *mut c_void,
+    size: *mut u32,
+) -> shm_error_t {
+    if handle.is_null() || buffer.is_null() || size.is_null() {
+        return shm_error_t::SHM_ERROR_INVALID_PARAM;
+    }
+    let state = unsafe { &*auto_client_state_from(handle) };
+    let mut cache = state.recv_cache.lock().unwrap();
+    cache.receive(|buffer| state.inner.receive(buffer), buffer, size)
+}
+
+/// Pull-режим: пачка сообщений, семантика как у `shm_client_receive_batch`.
+#[unsafe(no_mangle)]
+pub extern "C" fn shm_client_receive_batch_auto(
+    handle: *mut AutoClientHandle,
+    buffer: *mut c_void,
+    buffer_size: u32,
+    offsets: *mut u32,
+    max_messages: u32,
+    count: *mut u32,
+) -> shm_error_t {
+    if handle.is_null()
+        || buffer.is_null()
+        || offsets.is_null()
+        || count.is_null()
+        || buffer_size == 0
+        || max_messages == 0
+    {
+        return shm_error_t::SHM_ERROR_INVALID_PARAM;
+    }
+    let state = unsafe { &*auto_client_state_from(handle) };
+    let mut cache = state.recv_cache.lock().unwrap();
+    cache.receive_batch(
+        |batch, max_messages, max_bytes| state.inner.receive_batch(batch, max_messages, max_bytes),
+        buffer,
+        buffer_size,
+        offsets,
+        max_messages,
+        count,
+    )
+}
+
+/// Pull-режим: HANDLE auto-reset события для `WaitForMultipleObjects` —
+/// после него повторять `shm_client_receive*_auto` до `SHM_ERROR_EMPTY`.
+/// Принадлежит объекту, закрывать нельзя; 0 — объект создан без `pull`.
+#[unsafe(no_mangle)]
+pub extern "C" fn shm_client_wait_handle_auto(handle: *const AutoClientHandle) -> isize {
+    if handle.is_null() {
+        return 0;
+    }
+    let state = unsafe { &*auto_client_state_from_const(handle) };
+    state.inner.wait_handle().unwrap_or(0)
+}
+
+#[unsafe(no_mangle)]
+pub extern "C" fn shm_client_disconnect_auto(handle: *mut AutoClientHandle) {
+    if handle.is_null() {
+        return;
+    }
+    unsafe {
+        drop(Box::from_raw(auto_client_state_from(handle)));
     }
 }
 
@@ -679,6 +1442,17 @@ pub extern "C" fn shm_client_disconnect_auto(handle: *mut AutoClientHandle) {
 pub extern "C" fn shm_server_start(
     config: *const shm_endpoint_config_t,
     callbacks: *const shm_callbacks_t,
+) -> *mut ServerHandle {
+    shm_server_start_with_geometry(config, callbacks, std::ptr::null())
+}
+
+/// Запуск сервера с заданной геометрией колец (`geometry` может быть NULL —
+/// геометрия по умолчанию). Клиент подхватывает её при подключении сам.
+#[unsafe(no_mangle)]
+pub extern "C" fn shm_server_start_with_geometry(
+    config: *const shm_endpoint_config_t,
+    callbacks: *const shm_callbacks_t,
+    geometry: *const shm_channel_geometry_t,
 ) -> *mut ServerHandle {
     if config.is_null() {
         return null_mut();
@@ -693,12 +1467,18 @@ pub extern "C" fn shm_server_start(
     } else {
         Some(unsafe { *callbacks })
     };
+    let geometry: ChannelGeometry = if geometry.is_null() {
+        ChannelGeometry::default()
+    } else {
+        unsafe { *geometry }.into()
+    };
 
-    match SharedServer::start(&name) {
+    match SharedServer::start_with(&name, &geometry) {
         Ok(server) => Box::into_raw(Box::new(ServerState {
             inner: server,
             callbacks,
             recv_cache: Mutex::new(RecvCache::new()),
+            reservation: Mutex::new(None),
         })) as *mut ServerHandle,
         Err(err) => {
             let code: shm_error_t = err.into();
@@ -720,7 +1500,7 @@ pub extern "C" fn shm_server_wait_for_client(
     if handle.is_null() {
         return shm_error_t::SHM_ERROR_INVALID_PARAM;
     }
-    let state = unsafe { &mut *server_state_from(handle) };
+    let state = unsafe { &*server_state_from(handle) };
     let timeout = if timeout_ms == u32::MAX {
         None
     } else {
@@ -762,16 +1542,59 @@ pub extern "C" fn shm_server_stop(handle: *mut ServerHandle) {
     }
 }
 
+/// Политика `shm_server_send*`/`shm_server_reserve` при нехватке места в
+/// кольце (NULL — вытеснение по умолчанию). Можно звать из любого потока,
+/// в том числе во время отправки: она идёт по политике на момент вызова.
+#[unsafe(no_mangle)]
+pub extern "C" fn shm_server_set_overflow_policy(
+    handle: *mut ServerHandle,
+    policy: *const shm_overflow_policy_t,
+) -> shm_error_t {
+    if handle.is_null() {
+        return shm_error_t::SHM_ERROR_INVALID_PARAM;
+    }
+    let policy = if policy.is_null() {
+        shm_overflow_policy_t::default()
+    } else {
+        unsafe { *policy }
+    };
+    let Some(policy) = policy.to_policy() else {
+        return shm_error_t::SHM_ERROR_INVALID_PARAM;
+    };
+    let state = unsafe { &*server_state_from(handle) };
+    state.inner.set_overflow_policy(policy);
+    shm_error_t::SHM_SUCCESS
+}
+
+/// Кольцевая часть телеметрии канала (без worker-а пробуждения, пачки и
+/// время handler-а остаются нулевыми). Можно звать из любого потока.
+#[unsafe(no_mangle)]
+pub extern "C" fn shm_server_channel_stats(
+    handle: *mut ServerHandle,
+    out: *mut shm_channel_stats_t,
+) -> bool {
+    if handle.is_null() {
+        return false;
+    }
+    let state = unsafe { &*server_state_from(handle) };
+    write_channel_stats(out, state.inner.channel_stats())
+}
+
 #[unsafe(no_mangle)]
 pub extern "C" fn shm_server_send(
     handle: *mut ServerHandle,
     data: *const c_void,
     size: u32,
 ) -> shm_error_t {
-    if handle.is_null() || data.is_null() || size == 0 || size as usize > MAX_MESSAGE_SIZE {
+    if handle.is_null() || data.is_null() || size == 0 {
         return shm_error_t::SHM_ERROR_INVALID_PARAM;
     }
     let state = unsafe { &*server_state_from(handle) };
+    let slot = state.reservation.lock().unwrap();
+    if slot.is_some() {
+        // запись поверх незакоммиченного резерва испортила бы его (кольцо SPSC)
+        return shm_error_t::SHM_ERROR_EXISTS;
+    }
     let slice = unsafe { std::slice::from_raw_parts(data as *const u8, size as usize) };
     match state.inner.send_to_client(slice) {
         Ok(_) => shm_error_t::SHM_SUCCESS,
@@ -779,6 +1602,32 @@ pub extern "C" fn shm_server_send(
     }
 }
 
+/// Отправка пачки из `count` сообщений: все кадры копируются в кольцо и
+/// публикуются разом, клиент будится не больше одного раза. Размеры
+/// проверяются заранее — при ошибке не отправляется ничего.
+#[unsafe(no_mangle)]
+pub extern "C" fn shm_server_send_batch(
+    handle: *mut ServerHandle,
+    messages: *const shm_iovec_t,
+    count: u32,
+) -> shm_error_t {
+    if handle.is_null() {
+        return shm_error_t::SHM_ERROR_INVALID_PARAM;
+    }
+    let Some(batch) = batch_slices(messages, count) else {
+        return shm_error_t::SHM_ERROR_INVALID_PARAM;
+    };
+    let state = unsafe { &*server_state_from(handle) };
+    let slot = state.reservation.lock().unwrap();
+    if slot.is_some() {
+        return shm_error_t::SHM_ERROR_EXISTS;
+    }
+    match state.inner.send_batch_to_client(&batch) {
+        Ok(_) => shm_error_t::SHM_SUCCESS,
+        Err(err) => err.into(),
+    }
+}
+
 #[unsafe(no_mangle)]
 pub extern "C" fn shm_server_receive(
     handle: *mut ServerHandle,
@@ -789,28 +1638,50 @@ pub extern "C" fn shm_server_receive(
         return shm_error_t::SHM_ERROR_INVALID_PARAM;
     }
     let state = unsafe { &*server_state_from(handle) };
-    let capacity = unsafe { *size } as usize;
-    if capacity == 0 {
+    let mut cache = state.recv_cache.lock().unwrap();
+    cache.receive(
+        |buffer| state.inner.receive_from_client(buffer),
+        buffer,
+        size,
+    )
+}
+
+/// Пакетный приём: до `max_messages` сообщений суммарно не больше
+/// `buffer_size` байт подряд в `buffer`, границы — в `offsets`
+/// (`max_messages + 1` элементов). Из кольца сообщения забираются одним
+/// сдвигом read_pos.
+#[unsafe(no_mangle)]
+pub extern "C" fn shm_server_receive_batch(
+    handle: *mut ServerHandle,
+    buffer: *mut c_void,
+    buffer_size: u32,
+    offsets: *mut u32,
+    max_messages: u32,
+    count: *mut u32,
+) -> shm_error_t {
+    if handle.is_null()
+        || buffer.is_null()
+        || offsets.is_null()
+        || count.is_null()
+        || buffer_size == 0
+        || max_messages == 0
+    {
         return shm_error_t::SHM_ERROR_INVALID_PARAM;
     }
-
+    let state = unsafe { &*server_state_from(handle) };
     let mut cache = state.recv_cache.lock().unwrap();
-    let len = match cache.pending_len.take() {
-        Some(pending_len) => pending_len,
-        None => match state.inner.receive_from_client(&mut cache.buffer) {
-            Ok(len) => len,
-            Err(err) => return err.into(),
+    cache.receive_batch(
+        |batch, max_messages, max_bytes| {
+            state
+                .inner
+                .receive_batch_from_client(batch, max_messages, max_bytes)
         },
-    };
-    if len > capacity {
-        cache.pending_len = Some(len);
-        return shm_error_t::SHM_ERROR_MEMORY;
-    }
-    unsafe {
-        std::ptr::copy_nonoverlapping(cache.buffer.as_ptr(), buffer as *mut u8, len);
-        *size = len as u32;
-    }
-    shm_error_t::SHM_SUCCESS
+        buffer,
+        buffer_size,
+        offsets,
+        max_messages,
+        count,
+    )
 }
 
 #[unsafe(no_mangle)]
@@ -831,6 +1702,149 @@ pub extern "C" fn shm_server_poll(handle: *mut ServerHandle, timeout_ms: u32) ->
     }
 }
 
+fn write_spans(dst: *mut shm_write_span_t, first: &mut [u8], second: &mut [u8]) {
+    unsafe {
+        *dst = shm_write_span_t {
+            first: first.as_mut_ptr() as *mut c_void,
+            first_size: first.len() as u32,
+            second: if second.is_empty() {
+                null_mut()
+            } else {
+                second.as_mut_ptr() as *mut c_void
+            },
+            second_size: second.len() as u32,
+        };
+    }
+}
+
+/// Zero-copy отправка: резервирует `size` байт прямо в кольце server→client.
+///
+/// Участки для записи возвращаются в `out`; сообщение публикуется
+/// `shm_server_commit` либо отменяется `shm_server_cancel`. Пока резерв
+/// активен, повторный reserve и `shm_server_send` возвращают `SHM_ERROR_EXISTS`
+/// — с любого потока: отправки, резервы и commit на одном дескрипторе
+/// сериализуются, и резерв получает ровно один из гонящихся.
+#[unsafe(no_mangle)]
+pub extern "C" fn shm_server_reserve(
+    handle: *mut ServerHandle,
+    size: u32,
+    out: *mut shm_write_span_t,
+) -> shm_error_t {
+    if handle.is_null() || out.is_null() || size == 0 {
+        return shm_error_t::SHM_ERROR_INVALID_PARAM;
+    }
+    let state = unsafe { &*server_state_from(handle) };
+    let mut slot = state.reservation.lock().unwrap();
+    if slot.is_some() {
+        return shm_error_t::SHM_ERROR_EXISTS;
+    }
+    let mut reservation = match state.inner.reserve_to_client(size as usize) {
+        Ok(reservation) => reservation,
+        Err(err) => return err.into(),
+    };
+    let (first, second) = state.inner.reserved_spans(&mut reservation);
+    write_spans(out, first, second);
+    *slot = Some(reservation);
+    shm_error_t::SHM_SUCCESS
+}
+
+/// Публикует первые `size` байт активного резерва (`size` <= зарезервированного).
+#[unsafe(no_mangle)]
+pub extern "C" fn shm_server_commit(handle: *mut ServerHandle, size: u32) -> shm_error_t {
+    if handle.is_null() {
+        return shm_error_t::SHM_ERROR_INVALID_PARAM;
+    }
+    let state = unsafe { &*server_state_from(handle) };
+    let mut slot = state.reservation.lock().unwrap();
+    let Some(reservation) = slot.take() else {
+        return shm_error_t::SHM_ERROR_INVALID_PARAM;
+    };
+    match state.inner.commit_to_client(reservation, size as usize) {
+        Ok(_) => shm_error_t::SHM_SUCCESS,
+        Err(err) => err.into(),
+    }
+}
+
+/// Отменяет активный резерв без публикации сообщения.
+#[unsafe(no_mangle)]
+pub extern "C" fn shm_server_cancel(handle: *mut ServerHandle) -> shm_error_t {
+    if handle.is_null() {
+        return shm_error_t::SHM_ERROR_INVALID_PARAM;
+    }
+    let state = unsafe { &*server_state_from(handle) };
+    match state.reservation.lock().unwrap().take() {
+        Some(_) => shm_error_t::SHM_SUCCESS,
+        None => shm_error_t::SHM_ERROR_INVALID_PARAM,
+    }
+}
+
+fn write_read_spans(dst: *mut shm_read_span_t, first: &[u8], second: &[u8]) {
+    unsafe {
+        *dst = shm_read_span_t {
+            first: first.as_ptr() as *const c_void,
+            first_size: first.len() as u32,
+            second: if second.is_empty() {
+                std::ptr::null()
+            } else {
+                second.as_ptr() as *const c_void
+            },
+            second_size: second.len() as u32,
+        };
+    }
+}
+
+/// Zero-copy чтение: выдаёт payload самого старого сообщения клиента прямо
+/// из кольца, не забирая его.
+///
+/// Данные действительны только если последующий `shm_server_consume` вернул
+/// `SHM_SUCCESS`; `SHM_ERROR_OVERWRITTEN` означает, что сообщение вытеснено
+/// во время чтения — результат надо отбросить и повторить peek.
+#[unsafe(no_mangle)]
+pub extern "C" fn shm_server_peek(
+    handle: *mut ServerHandle,
+    out: *mut shm_read_span_t,
+) -> shm_error_t {
+    if handle.is_null() || out.is_null() {
+        return shm_error_t::SHM_ERROR_INVALID_PARAM;
+    }
+    let state = unsafe { &*server_state_from(handle) };
+    let mut cache = state.recv_cache.lock().unwrap();
+    if let Some(len) = cache.pending_len {
+        // недоставленное receive-ом сообщение старше всего, что в кольце
+        write_read_spans(out, &cache.buffer[..len], &[]);
+        return shm_error_t::SHM_SUCCESS;
+    }
+    if cache.peeked.is_none() {
+        match state.inner.peek_from_client() {
+            Ok(message) => cache.peeked = Some(message),
+            Err(err) => return err.into(),
+        }
+    }
+    let (first, second) = state.inner.peeked_spans(cache.peeked.as_ref().unwrap());
+    write_read_spans(out, first, second);
+    shm_error_t::SHM_SUCCESS
+}
+
+/// Забирает сообщение, выданное `shm_server_peek`.
+#[unsafe(no_mangle)]
+pub extern "C" fn shm_server_consume(handle: *mut ServerHandle) -> shm_error_t {
+    if handle.is_null() {
+        return shm_error_t::SHM_ERROR_INVALID_PARAM;
+    }
+    let state = unsafe { &*server_state_from(handle) };
+    let mut cache = state.recv_cache.lock().unwrap();
+    if cache.pending_len.take().is_some() {
+        return shm_error_t::SHM_SUCCESS;
+    }
+    let Some(message) = cache.peeked.take() else {
+        return shm_error_t::SHM_ERROR_INVALID_PARAM;
+    };
+    match state.inner.consume_from_client(message) {
+        Ok(_) => shm_error_t::SHM_SUCCESS,
+        Err(err) => err.into(),
+    }
+}
+
 #[unsafe(no_mangle)]
 pub extern "C" fn shm_client_connect(
     config: *const shm_endpoint_config_t,
@@ -857,6 +1871,7 @@ pub extern "C" fn shm_client_connect(
             Box::into_raw(Box::new(ClientState {
                 inner: client,
                 recv_cache: Mutex::new(RecvCache::new()),
+                reservation: Mutex::new(None),
             })) as *mut ClientHandle
         }
         Err(err) => {
@@ -891,16 +1906,76 @@ pub extern "C" fn shm_client_is_connected(handle: *const ClientHandle) -> bool {
     state.inner.is_connected()
 }
 
+/// Политика `shm_client_send*`/`shm_client_reserve` при нехватке места
+/// (см. `shm_server_set_overflow_policy`).
+#[unsafe(no_mangle)]
+pub extern "C" fn shm_client_set_overflow_policy(
+    handle: *mut ClientHandle,
+    policy: *const shm_overflow_policy_t,
+) -> shm_error_t {
+    if handle.is_null() {
+        return shm_error_t::SHM_ERROR_INVALID_PARAM;
+    }
+    let policy = if policy.is_null() {
+        shm_overflow_policy_t::default()
+    } else {
+        unsafe { *policy }
+    };
+    let Some(policy) = policy.to_policy() else {
+        return shm_error_t::SHM_ERROR_INVALID_PARAM;
+    };
+    let state = unsafe { &*client_state_from(handle) };
+    state.inner.set_overflow_policy(policy);
+    shm_error_t::SHM_SUCCESS
+}
+
+/// См. `shm_server_channel_stats`.
+#[unsafe(no_mangle)]
+pub extern "C" fn shm_client_channel_stats(
+    handle: *const ClientHandle,
+    out: *mut shm_channel_stats_t,
+) -> bool {
+    if handle.is_null() {
+        return false;
+    }
+    let state = unsafe { &*client_state_from_const(handle) };
+    write_channel_stats(out, state.inner.channel_stats())
+}
+
+/// Оценка квантиля `quantile` (0.0..1.0) гистограммы сверху — граница
+/// корзины, не больше `max`. 0 для NULL и пустой гистограммы.
+#[unsafe(no_mangle)]
+pub extern "C" fn shm_histogram_percentile(
+    histogram: *const shm_histogram_t,
+    quantile: f64,
+) -> u64 {
+    if histogram.is_null() {
+        return 0;
+    }
+    let histogram = unsafe { &*histogram };
+    HistogramSnapshot {
+        count: histogram.count,
+        sum: histogram.sum,
+        max: histogram.max,
+        buckets: histogram.buckets,
+    }
+    .percentile(quantile)
+}
+
 #[unsafe(no_mangle)]
 pub extern "C" fn shm_client_send(
     handle: *mut ClientHandle,
     data: *const c_void,
     size: u32,
 ) -> shm_error_t {
-    if handle.is_null() || data.is_null() || size == 0 || size as usize > MAX_MESSAGE_SIZE {
+    if handle.is_null() || data.is_null() || size == 0 {
         return shm_error_t::SHM_ERROR_INVALID_PARAM;
     }
     let state = unsafe { &*client_state_from(handle) };
+    let slot = state.reservation.lock().unwrap();
+    if slot.is_some() {
+        return shm_error_t::SHM_ERROR_EXISTS;
+    }
     let slice = unsafe { std::slice::from_raw_parts(data as *const u8, size as usize) };
     match state.inner.send_to_server(slice) {
         Ok(_) => shm_error_t::SHM_SUCCESS,
@@ -908,6 +1983,30 @@ pub extern "C" fn shm_client_send(
     }
 }
 
+/// Отправка пачки сообщений серверу (см. `shm_server_send_batch`).
+#[unsafe(no_mangle)]
+pub extern "C" fn shm_client_send_batch(
+    handle: *mut ClientHandle,
+    messages: *const shm_iovec_t,
+    count: u32,
+) -> shm_error_t {
+    if handle.is_null() {
+        return shm_error_t::SHM_ERROR_INVALID_PARAM;
+    }
+    let Some(batch) = batch_slices(messages, count) else {
+        return shm_error_t::SHM_ERROR_INVALID_PARAM;
+    };
+    let state = unsafe { &*client_state_from(handle) };
+    let slot = state.reservation.lock().unwrap();
+    if slot.is_some() {
+        return shm_error_t::SHM_ERROR_EXISTS;
+    }
+    match state.inner.send_batch_to_server(&batch) {
+        Ok(_) => shm_error_t::SHM_SUCCESS,
+        Err(err) => err.into(),
+    }
+}
+
 #[unsafe(no_mangle)]
 pub extern "C" fn shm_client_receive(
     handle: *mut ClientHandle,
@@ -918,28 +2017,48 @@ pub extern "C" fn shm_client_receive(
         return shm_error_t::SHM_ERROR_INVALID_PARAM;
     }
     let state = unsafe { &*client_state_from(handle as *mut ClientHandle) };
-    let capacity = unsafe { *size } as usize;
-    if capacity == 0 {
+    let mut cache = state.recv_cache.lock().unwrap();
+    cache.receive(
+        |buffer| state.inner.receive_from_server(buffer),
+        buffer,
+        size,
+    )
+}
+
+/// Пакетный приём на стороне клиента, семантика как у
+/// `shm_server_receive_batch`.
+#[unsafe(no_mangle)]
+pub extern "C" fn shm_client_receive_batch(
+    handle: *mut ClientHandle,
+    buffer: *mut c_void,
+    buffer_size: u32,
+    offsets: *mut u32,
+    max_messages: u32,
+    count: *mut u32,
+) -> shm_error_t {
+    if handle.is_null()
+        || buffer.is_null()
+        || offsets.is_null()
+        || count.is_null()
+        || buffer_size == 0
+        || max_messages == 0
+    {
         return shm_error_t::SHM_ERROR_INVALID_PARAM;
     }
-
+    let state = unsafe { &*client_state_from(handle as *mut ClientHandle) };
     let mut cache = state.recv_cache.lock().unwrap();
-    let len = match cache.pending_len.take() {
-        Some(pending_len) => pending_len,
-        None => match state.inner.receive_from_server(&mut cache.buffer) {
-            Ok(len) => len,
-            Err(err) => return err.into(),
+    cache.receive_batch(
+        |batch, max_messages, max_bytes| {
+            state
+                .inner
+                .receive_batch_from_server(batch, max_messages, max_bytes)
         },
-    };
-    if len > capacity {
-        cache.pending_len = Some(len);
-        return shm_error_t::SHM_ERROR_MEMORY;
-    }
-    unsafe {
-        std::ptr::copy_nonoverlapping(cache.buffer.as_ptr(), buffer as *mut u8, len);
-        *size = len as u32;
-    }
-    shm_error_t::SHM_SUCCESS
+        buffer,
+        buffer_size,
+        offsets,
+        max_messages,
+        count,
+    )
 }
 
 #[unsafe(no_mangle)]
@@ -960,6 +2079,107 @@ pub extern "C" fn shm_client_poll(handle: *mut ClientHandle, timeout_ms: u32) ->
     }
 }
 
+/// Zero-copy чтение сообщения сервера (см. `shm_server_peek`).
+#[unsafe(no_mangle)]
+pub extern "C" fn shm_client_peek(
+    handle: *mut ClientHandle,
+    out: *mut shm_read_span_t,
+) -> shm_error_t {
+    if handle.is_null() || out.is_null() {
+        return shm_error_t::SHM_ERROR_INVALID_PARAM;
+    }
+    let state = unsafe { &*client_state_from(handle) };
+    let mut cache = state.recv_cache.lock().unwrap();
+    if let Some(len) = cache.pending_len {
+        write_read_spans(out, &cache.buffer[..len], &[]);
+        return shm_error_t::SHM_SUCCESS;
+    }
+    if cache.peeked.is_none() {
+        match state.inner.peek_from_server() {
+            Ok(message) => cache.peeked = Some(message),
+            Err(err) => return err.into(),
+        }
+    }
+    let (first, second) = state.inner.peeked_spans(cache.peeked.as_ref().unwrap());
+    write_read_spans(out, first, second);
+    shm_error_t::SHM_SUCCESS
+}
+
+/// Забирает сообщение, выданное `shm_client_peek`.
+#[unsafe(no_mangle)]
+pub extern "C" fn shm_client_consume(handle: *mut ClientHandle) -> shm_error_t {
+    if handle.is_null() {
+        return shm_error_t::SHM_ERROR_INVALID_PARAM;
+    }
+    let state = unsafe { &*client_state_from(handle) };
+    let mut cache = state.recv_cache.lock().unwrap();
+    if cache.pending_len.take().is_some() {
+        return shm_error_t::SHM_SUCCESS;
+    }
+    let Some(message) = cache.peeked.take() else {
+        return shm_error_t::SHM_ERROR_INVALID_PARAM;
+    };
+    match state.inner.consume_from_server(message) {
+        Ok(_) => shm_error_t::SHM_SUCCESS,
+        Err(err) => err.into(),
+    }
+}
+
+/// Zero-copy отправка в кольцо client→server (см. `shm_server_reserve`).
+#[unsafe(no_mangle)]
+pub extern "C" fn shm_client_reserve(
+    handle: *mut ClientHandle,
+    size: u32,
+    out: *mut shm_write_span_t,
+) -> shm_error_t {
+    if handle.is_null() || out.is_null() || size == 0 {
+        return shm_error_t::SHM_ERROR_INVALID_PARAM;
+    }
+    let state = unsafe { &*client_state_from(handle) };
+    let mut slot = state.reservation.lock().unwrap();
+    if slot.is_some() {
+        return shm_error_t::SHM_ERROR_EXISTS;
+    }
+    let mut reservation = match state.inner.reserve_to_server(size as usize) {
+        Ok(reservation) => reservation,
+        Err(err) => return err.into(),
+    };
+    let (first, second) = state.inner.reserved_spans(&mut reservation);
+    write_spans(out, first, second);
+    *slot = Some(reservation);
+    shm_error_t::SHM_SUCCESS
+}
+
+/// Публикует первые `size` байт активного резерва клиента.
+#[unsafe(no_mangle)]
+pub extern "C" fn shm_client_commit(handle: *mut ClientHandle, size: u32) -> shm_error_t {
+    if handle.is_null() {
+        return shm_error_t::SHM_ERROR_INVALID_PARAM;
+    }
+    let state = unsafe { &*client_state_from(handle) };
+    let mut slot = state.reservation.lock().unwrap();
+    let Some(reservation) = slot.take() else {
+        return shm_error_t::SHM_ERROR_INVALID_PARAM;
+    };
+    match state.inner.commit_to_server(reservation, size as usize) {
+        Ok(_) => shm_error_t::SHM_SUCCESS,
+        Err(err) => err.into(),
+    }
+}
+
+/// Отменяет активный резерв клиента без публикации сообщения.
+#[unsafe(no_mangle)]
+pub extern "C" fn shm_client_cancel(handle: *mut ClientHandle) -> shm_error_t {
+    if handle.is_null() {
+        return shm_error_t::SHM_ERROR_INVALID_PARAM;
+    }
+    let state = unsafe { &*client_state_from(handle) };
+    match state.reservation.lock().unwrap().take() {
+        Some(_) => shm_error_t::SHM_SUCCESS,
+        None => shm_error_t::SHM_ERROR_INVALID_PARAM,
+    }
+}
+
 /// Получить event handles для передачи в kernel driver
 ///
 /// Возвращает структуру с raw handles (isize) для event-driven IPC.
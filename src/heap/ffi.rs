@@ -0,0 +1,194 @@
+//! C FFI для общей кучи блоков.
+//!
+//! Следует тем же паттернам, что и `crate::rpc::ffi`; кучу `MultiServer`
+//! отдаёт `shm_multi_server_heap`, остальные стороны открывают её через
+//! `shm_heap_open`.
+
+use std::ffi::CStr;
+use std::os::raw::{c_char, c_void};
+use std::ptr::null_mut;
+
+use crate::ffi::shm_error_t;
+
+use super::{HeapHandle, SharedHeap};
+
+/// Handle блока кучи (см. `HeapHandle`); передаётся через кольцо как есть —
+/// 16 байт little-endian.
+#[repr(C)]
+#[derive(Clone, Copy, Default)]
+pub struct shm_heap_handle_t {
+    /// Смещение данных блока от начала секции
+    pub offset: u64,
+    /// Длина данных
+    pub len: u32,
+    /// Поколение блока на момент выделения
+    pub generation: u32,
+}
+
+impl From<HeapHandle> for shm_heap_handle_t {
+    fn from(value: HeapHandle) -> Self {
+        Self {
+            offset: value.offset,
+            len: value.len,
+            generation: value.generation,
+        }
+    }
+}
+
+impl From<shm_heap_handle_t> for HeapHandle {
+    fn from(value: shm_heap_handle_t) -> Self {
+        Self {
+            offset: value.offset,
+            len: value.len,
+            generation: value.generation,
+        }
+    }
+}
+
+pub type SharedHeapHandle = c_void;
+
+/// # Safety
+/// `heap` обязан быть валидным SharedHeapHandle либо null.
+unsafe fn heap_ref<'a>(heap: *const SharedHeapHandle) -> Option<&'a SharedHeap> {
+    unsafe { (heap as *const SharedHeap).as_ref() }
+}
+
+/// # Safety
+/// `handle` обязан быть валидным указателем либо null.
+unsafe fn handle_ref(handle: *const shm_heap_handle_t) -> Option<HeapHandle> {
+    unsafe { handle.as_ref() }.map(|handle| (*handle).into())
+}
+
+/// Открывает кучу сервера `base_name`; null — кучи нет или секция
+/// непригодна. Закрывается `shm_heap_close`.
+///
+/// # Safety
+/// `base_name` обязан быть валидной C-строкой либо null.
+#[unsafe(no_mangle)]
+pub unsafe extern "C" fn shm_heap_open(base_name: *const c_char) -> *mut SharedHeapHandle {
+    if base_name.is_null() {
+        return null_mut();
+    }
+    let name = unsafe { CStr::from_ptr(base_name) }.to_string_lossy();
+    match SharedHeap::open(&name) {
+        Ok(heap) => Box::into_raw(Box::new(heap)) as *mut SharedHeapHandle,
+        Err(_) => null_mut(),
+    }
+}
+
+/// Выделяет блок под `size` байт: handle — в `*out`, адрес данных — в
+/// `*data`. Ссылку producer-а снимает `shm_heap_release` (свой или
+/// получателя). Свободных блоков нет — `SHM_ERROR_FULL`.
+///
+/// # Safety
+/// `heap` обязан быть валидным SharedHeapHandle, `out` и `data` —
+/// валидными указателями.
+#[unsafe(no_mangle)]
+pub unsafe extern "C" fn shm_heap_allocate(
+    heap: *const SharedHeapHandle,
+    size: u32,
+    out: *mut shm_heap_handle_t,
+    data: *mut *mut c_void,
+) -> shm_error_t {
+    let Some(heap) = (unsafe { heap_ref(heap) }) else {
+        return shm_error_t::SHM_ERROR_INVALID_PARAM;
+    };
+    if out.is_null() || data.is_null() {
+        return shm_error_t::SHM_ERROR_INVALID_PARAM;
+    }
+    match heap.allocate(size as usize) {
+        Ok(mut block) => {
+            unsafe { *data = block.as_mut_slice().as_mut_ptr() as *mut c_void };
+            unsafe { *out = block.into_handle().into() };
+            shm_error_t::SHM_SUCCESS
+        }
+        Err(err) => err.into(),
+    }
+}
+
+/// Адрес данных блока (`handle->len` байт) — в `*data`; валиден, пока
+/// вызывающий держит ссылку. Блок освобождён — `SHM_ERROR_OVERWRITTEN`.
+///
+/// # Safety
+/// `heap` обязан быть валидным SharedHeapHandle, `handle` и `data` —
+/// валидными указателями.
+#[unsafe(no_mangle)]
+pub unsafe extern "C" fn shm_heap_get(
+    heap: *const SharedHeapHandle,
+    handle: *const shm_heap_handle_t,
+    data: *mut *const c_void,
+) -> shm_error_t {
+    let (Some(heap), Some(handle)) = (unsafe { heap_ref(heap) }, unsafe { handle_ref(handle) })
+    else {
+        return shm_error_t::SHM_ERROR_INVALID_PARAM;
+    };
+    if data.is_null() {
+        return shm_error_t::SHM_ERROR_INVALID_PARAM;
+    }
+    match heap.get(&handle) {
+        Ok(bytes) => {
+            unsafe { *data = bytes.as_ptr() as *const c_void };
+            shm_error_t::SHM_SUCCESS
+        }
+        Err(err) => err.into(),
+    }
+}
+
+/// Ещё одна ссылка на блок (перед отправкой handle-а каждому получателю).
+///
+/// # Safety
+/// `heap` обязан быть валидным SharedHeapHandle, `handle` — валидным
+/// указателем.
+#[unsafe(no_mangle)]
+pub unsafe extern "C" fn shm_heap_retain(
+    heap: *const SharedHeapHandle,
+    handle: *const shm_heap_handle_t,
+) -> shm_error_t {
+    let (Some(heap), Some(handle)) = (unsafe { heap_ref(heap) }, unsafe { handle_ref(handle) })
+    else {
+        return shm_error_t::SHM_ERROR_INVALID_PARAM;
+    };
+    match heap.retain(&handle) {
+        Ok(()) => shm_error_t::SHM_SUCCESS,
+        Err(err) => err.into(),
+    }
+}
+
+/// Снимает ссылку; последняя возвращает блок в кучу.
+///
+/// # Safety
+/// Как у `shm_heap_retain`.
+#[unsafe(no_mangle)]
+pub unsafe extern "C" fn shm_heap_release(
+    heap: *const SharedHeapHandle,
+    handle: *const shm_heap_handle_t,
+) -> shm_error_t {
+    let (Some(heap), Some(handle)) = (unsafe { heap_ref(heap) }, unsafe { handle_ref(handle) })
+    else {
+        return shm_error_t::SHM_ERROR_INVALID_PARAM;
+    };
+    match heap.release(&handle) {
+        Ok(()) => shm_error_t::SHM_SUCCESS,
+        Err(err) => err.into(),
+    }
+}
+
+/// Сколько блоков свободно сейчас (0 при null).
+///
+/// # Safety
+/// `heap` обязан быть валидным SharedHeapHandle либо null.
+#[unsafe(no_mangle)]
+pub unsafe extern "C" fn shm_heap_free_blocks(heap: *const SharedHeapHandle) -> u32 {
+    unsafe { heap_ref(heap) }.map_or(0, SharedHeap::free_blocks)
+}
+
+/// # Safety
+/// `heap` обязан быть handle-ом из `shm_heap_open` либо null (не кучей
+/// `shm_multi_server_heap`). Поглощает handle.
+#[unsafe(no_mangle)]
+pub unsafe extern "C" fn shm_heap_close(heap: *mut SharedHeapHandle) {
+    if heap.is_null() {
+        return;
+    }
+    unsafe { drop(Box::from_raw(heap as *mut SharedHeap)) };
+}
@@ -0,0 +1,665 @@
+//! Общая куча блоков для крупных payload-ов вне кольца.
+//!
+//! Многомегабайтный blob (кадр, веса модели) дешевле один раз записать в
+//! отдельную секцию `{base}_HEAP` и передать через кольцо только его
+//! `HeapHandle` (16 байт: смещение, длина, поколение), чем копировать в
+//! кольцо каждого получателя. Куча — slab из `blocks` блоков одного размера
+//! (`HeapOptions::block_size`, кратен странице); свободные блоки связаны в
+//! lock-free стек с tag-счётчиком против ABA, так что выделять и освобождать
+//! может любой процесс, открывший секцию.
+//!
+//! Блок живёт, пока на него есть ссылки: `allocate` отдаёт одну ссылку
+//! producer-у, `retain` добавляет по одной на каждого получателя,
+//! `release` снимает. Последняя возвращает блок в список свободных и
+//! поднимает его поколение — старые handle-ы после этого получают
+//! `Overwritten`. Ссылки процесса, упавшего с ними, не возвращаются: блок
+//! остаётся занятым до пересоздания секции.
+
+pub mod ffi;
+
+use std::ptr::NonNull;
+use std::sync::atomic::Ordering;
+
+use crate::constants::{
+    HEAP_BLOCK_ALIGN, HEAP_MAGIC, HEAP_VERSION, MAX_HEAP_BLOCKS, MAX_RING_CAPACITY,
+};
+use crate::copy::copy_to_shared;
+use crate::error::{Result, ShmError};
+use crate::layout::{heap_data_offset, heap_mapping_size, HeapBlockHeader, HeapHeader};
+use crate::naming::{heap_name, mapping_name};
+use crate::win::{Mapping, SectionOptions};
+
+/// Размер сериализованного `HeapHandle`.
+pub const HEAP_HANDLE_SIZE: usize = 16;
+
+/// Пустая вершина списка свободных блоков.
+const NIL: u32 = u32::MAX;
+
+/// Геометрия кучи.
+#[derive(Debug, Clone, Copy, PartialEq, Eq)]
+pub struct HeapOptions {
+    /// Размер блока (байты, кратен 4 КБ, не больше 1 ГБ) — предел одного
+    /// payload-а.
+    pub block_size: usize,
+    /// Число блоков; 0 — кучи нет.
+    pub blocks: u32,
+}
+
+impl Default for HeapOptions {
+    fn default() -> Self {
+        Self {
+            block_size: 1024 * 1024,
+            blocks: 0,
+        }
+    }
+}
+
+impl HeapOptions {
+    pub fn validate(&self) -> Result<()> {
+        if self.blocks == 0 || self.blocks > MAX_HEAP_BLOCKS {
+            return Err(ShmError::InvalidConfig(
+                "heap blocks must be in 1..=MAX_HEAP_BLOCKS",
+            ));
+        }
+        if self.block_size % HEAP_BLOCK_ALIGN != 0
+            || !(HEAP_BLOCK_ALIGN..=MAX_RING_CAPACITY).contains(&self.block_size)
+        {
+            return Err(ShmError::InvalidConfig(
+                "heap block_size must be a multiple of 4 KB in 4 KB..=1 GB",
+            ));
+        }
+        if self
+            .block_size
+            .checked_mul(self.blocks as usize)
+            .and_then(|data| data.checked_add(heap_data_offset(self.blocks as usize)))
+            .is_none()
+        {
+            return Err(ShmError::InvalidConfig(
+                "heap size does not fit the address space",
+            ));
+        }
+        Ok(())
+    }
+}
+
+/// Ссылка на блок кучи, которую передают через кольцо.
+#[derive(Debug, Clone, Copy, PartialEq, Eq, Hash)]
+pub struct HeapHandle {
+    /// Смещение данных блока от начала секции.
+    pub offset: u64,
+    /// Длина данных.
+    pub len: u32,
+    /// Поколение блока на момент выделения.
+    pub generation: u32,
+}
+
+impl HeapHandle {
+    /// Little-endian: `u64` смещение, `u32` длина, `u32` поколение.
+    pub fn to_bytes(&self) -> [u8; HEAP_HANDLE_SIZE] {
+        let mut bytes = [0u8; HEAP_HANDLE_SIZE];
+        bytes[..8].copy_from_slice(&self.offset.to_le_bytes());
+        bytes[8..12].copy_from_slice(&self.len.to_le_bytes());
+        bytes[12..].copy_from_slice(&self.generation.to_le_bytes());
+        bytes
+    }
+
+    /// Разбор сообщения из `to_bytes`; другой длины — `Corrupted`.
+    pub fn from_bytes(bytes: &[u8]) -> Result<Self> {
+        let bytes: &[u8; HEAP_HANDLE_SIZE] = bytes.try_into().map_err(|_| ShmError::Corrupted)?;
+        Ok(Self {
+            offset: u64::from_le_bytes(bytes[..8].try_into().unwrap()),
+            len: u32::from_le_bytes(bytes[8..12].try_into().unwrap()),
+            generation: u32::from_le_bytes(bytes[12..].try_into().unwrap()),
+        })
+    }
+}
+
+const fn pack(generation: u32, refs: u32) -> u64 {
+    ((generation as u64) << 32) | refs as u64
+}
+
+const fn unpack(state: u64) -> (u32, u32) {
+    ((state >> 32) as u32, state as u32)
+}
+
+/// Аллокатор поверх заголовка, дескрипторов и блоков секции.
+struct HeapArena {
+    base: NonNull<u8>,
+    block_size: usize,
+    block_count: u32,
+    data_offset: usize,
+}
+
+unsafe impl Send for HeapArena {}
+unsafe impl Sync for HeapArena {}
+
+impl HeapArena {
+    /// # Safety
+    /// `base` указывает на `heap_mapping_size(block_size, block_count)` байт,
+    /// выровненных на страницу и живущих не меньше self; пределы проверены
+    /// `HeapOptions::validate`.
+    unsafe fn new(base: *mut u8, block_size: usize, block_count: u32) -> Self {
+        Self {
+            base: NonNull::new(base).expect("heap mapping pointer must be valid"),
+            block_size,
+            block_count,
+            data_offset: heap_data_offset(block_count as usize),
+        }
+    }
+
+    fn header(&self) -> &HeapHeader {
+        // SAFETY: заголовок — начало секции (инвариант new).
+        unsafe { &*(self.base.as_ptr() as *const HeapHeader) }
+    }
+
+    fn block(&self, index: u32) -> &HeapBlockHeader {
+        debug_assert!(index < self.block_count);
+        // SAFETY: дескрипторы идут сразу за заголовком, index < block_count.
+        unsafe {
+            &*(self.base.as_ptr().add(std::mem::size_of::<HeapHeader>()) as *const HeapBlockHeader)
+                .add(index as usize)
+        }
+    }
+
+    fn offset_of(&self, index: u32) -> usize {
+        self.data_offset + index as usize * self.block_size
+    }
+
+    fn data(&self, index: u32) -> *mut u8 {
+        // SAFETY: блок index < block_count целиком внутри секции.
+        unsafe { self.base.as_ptr().add(self.offset_of(index)) }
+    }
+
+    /// Новая секция: все блоки свободны, поколение 1 (нулевой handle никогда
+    /// не валиден); `magic` — последним.
+    fn init(&self) {
+        // SAFETY: единственный владелец на этапе инициализации (magic не
+        // записан — открывающие секцию её отвергают).
+        let header = unsafe { &mut *(self.base.as_ptr() as *mut HeapHeader) };
+        header.version = HEAP_VERSION;
+        header.block_size = self.block_size as u32;
+        header.block_count = self.block_count;
+        header.data_offset = self.data_offset as u64;
+        header.reserved = [0; 10];
+        for index in 0..self.block_count {
+            let block = self.block(index);
+            block.state.store(pack(1, 0), Ordering::Relaxed);
+            block.len.store(0, Ordering::Relaxed);
+            let next = index + 1;
+            block.next.store(
+                if next < self.block_count { next } else { NIL },
+                Ordering::Relaxed,
+            );
+        }
+        let free = &self.header().free;
+        free.head.store(0, Ordering::Relaxed);
+        free.free_blocks.store(self.block_count, Ordering::Relaxed);
+        self.header().magic.store(HEAP_MAGIC, Ordering::Release);
+    }
+
+    fn pop(&self) -> Option<u32> {
+        let free = &self.header().free;
+        let mut head = free.head.load(Ordering::Acquire);
+        loop {
+            let index = head as u32;
+            // Индекс за пределами — испорченная секция: считаем кучу пустой.
+            if index == NIL || index >= self.block_count {
+                return None;
+            }
+            // Блок мог уйти другому процессу между чтениями — тогда next
+            // устарел, но и tag в head уже другой, и CAS не пройдёт.
+            let next = self.block(index).next.load(Ordering::Relaxed);
+            let tag = (head >> 32) + 1;
+            match free.head.compare_exchange_weak(
+                head,
+                (tag << 32) | next as u64,
+                Ordering::AcqRel,
+                Ordering::Acquire,
+            ) {
+                Ok(_) => {
+                    free.free_blocks.fetch_sub(1, Ordering::Relaxed);
+                    return Some(index);
+                }
+                Err(current) => head = current,
+            }
+        }
+    }
+
+    fn push(&self, index: u32) {
+        let free = &self.header().free;
+        let mut head = free.head.load(Ordering::Relaxed);
+        loop {
+            self.block(index).next.store(head as u32, Ordering::Relaxed);
+            let tag = (head >> 32) + 1;
+            match free.head.compare_exchange_weak(
+                head,
+                (tag << 32) | index as u64,
+                Ordering::Release,
+                Ordering::Relaxed,
+            ) {
+                Ok(_) => break,
+                Err(current) => head = current,
+            }
+        }
+        free.free_blocks.fetch_add(1, Ordering::Relaxed);
+    }
+
+    /// Индекс блока handle-а; смещение не на границе блока или длина больше
+    /// блока — `Corrupted`.
+    fn locate(&self, handle: &HeapHandle) -> Result<u32> {
+        let offset = usize::try_from(handle.offset).map_err(|_| ShmError::Corrupted)?;
+        let relative = offset
+            .checked_sub(self.data_offset)
+            .ok_or(ShmError::Corrupted)?;
+        let index = relative / self.block_size;
+        if relative % self.block_size != 0
+            || index >= self.block_count as usize
+            || handle.len as usize > self.block_size
+        {
+            return Err(ShmError::Corrupted);
+        }
+        Ok(index as u32)
+    }
+
+    fn allocate(&self, len: usize) -> Result<HeapBlock<'_>> {
+        if len == 0 {
+            return Err(ShmError::MessageTooSmall);
+        }
+        if len > self.block_size {
+            return Err(ShmError::MessageTooLarge);
+        }
+        let index = self.pop().ok_or(ShmError::QueueFull)?;
+        let block = self.block(index);
+        // Снятый со стека блок принадлежит только нам: ссылок у него нет.
+        let (generation, _) = unpack(block.state.load(Ordering::Acquire));
+        block.len.store(len as u32, Ordering::Relaxed);
+        block.state.store(pack(generation, 1), Ordering::Release);
+        Ok(HeapBlock {
+            arena: self,
+            index,
+            generation,
+            len,
+        })
+    }
+
+    fn get(&self, handle: &HeapHandle) -> Result<&[u8]> {
+        let index = self.locate(handle)?;
+        let block = self.block(index);
+        let (generation, refs) = unpack(block.state.load(Ordering::Acquire));
+        if generation != handle.generation || refs == 0 {
+            return Err(ShmError::Overwritten);
+        }
+        if block.len.load(Ordering::Relaxed) != handle.len {
+            return Err(ShmError::Corrupted);
+        }
+        // SAFETY: len <= block_size (locate), блок внутри секции.
+        Ok(unsafe { std::slice::from_raw_parts(self.data(index), handle.len as usize) })
+    }
+
+    fn retain(&self, handle: &HeapHandle) -> Result<()> {
+        let index = self.locate(handle)?;
+        let state = &self.block(index).state;
+        let mut current = state.load(Ordering::Acquire);
+        loop {
+            let (generation, refs) = unpack(current);
+            if generation != handle.generation || refs == 0 {
+                return Err(ShmError::Overwritten);
+            }
+            if refs == u32::MAX {
+                return Err(ShmError::QueueFull);
+            }
+            match state.compare_exchange_weak(
+                current,
+                pack(generation, refs + 1),
+                Ordering::AcqRel,
+                Ordering::Acquire,
+            ) {
+                Ok(_) => return Ok(()),
+                Err(actual) => current = actual,
+            }
+        }
+    }
+
+    fn release(&self, handle: &HeapHandle) -> Result<()> {
+        self.release_index(self.locate(handle)?, handle.generation)
+    }
+
+    fn release_index(&self, index: u32, expected: u32) -> Result<()> {
+        let state = &self.block(index).state;
+        let mut current = state.load(Ordering::Acquire);
+        loop {
+            let (generation, refs) = unpack(current);
+            if generation != expected || refs == 0 {
+                return Err(ShmError::Overwritten);
+            }
+            // Последняя ссылка поднимает поколение (ноль пропускаем).
+            let next = if refs == 1 {
+                pack(generation.wrapping_add(1).max(1), 0)
+            } else {
+                pack(generation, refs - 1)
+            };
+            match state.compare_exchange_weak(current, next, Ordering::AcqRel, Ordering::Acquire) {
+                Ok(_) => break,
+                Err(actual) => current = actual,
+            }
+        }
+        if unpack(current).1 == 1 {
+            self.push(index);
+        }
+        Ok(())
+    }
+
+    fn free_blocks(&self) -> u32 {
+        self.header().free.free_blocks.load(Ordering::Relaxed)
+    }
+}
+
+/// Выделенный, ещё не переданный блок: держит ссылку producer-а. Drop
+/// снимает её; `into_handle` передаёт её получателю.
+pub struct HeapBlock<'a> {
+    arena: &'a HeapArena,
+    index: u32,
+    generation: u32,
+    len: usize,
+}
+
+impl HeapBlock<'_> {
+    pub fn handle(&self) -> HeapHandle {
+        HeapHandle {
+            offset: self.arena.offset_of(self.index) as u64,
+            len: self.len as u32,
+            generation: self.generation,
+        }
+    }
+
+    /// Данные блока (`len` байт из `allocate`).
+    pub fn as_mut_slice(&mut self) -> &mut [u8] {
+        // SAFETY: пока жив HeapBlock, у блока одна ссылка — наша, и handle
+        // ещё никому не отдан.
+        unsafe { std::slice::from_raw_parts_mut(self.arena.data(self.index), self.len) }
+    }
+
+    /// Отдаёт ссылку producer-а вместе с handle-ом: её снимет получатель
+    /// через `release`.
+    pub fn into_handle(self) -> HeapHandle {
+        let handle = self.handle();
+        std::mem::forget(self);
+        handle
+    }
+}
+
+impl Drop for HeapBlock<'_> {
+    fn drop(&mut self) {
+        let _ = self.arena.release_index(self.index, self.generation);
+    }
+}
+
+/// Секция кучи: создаёт сервер (`create`), открывают остальные (`open`).
+/// Выделять, читать и освобождать блоки может любая сторона.
+pub struct SharedHeap {
+    _mapping: Mapping,
+    arena: HeapArena,
+}
+
+impl SharedHeap {
+    /// Создаёт секцию `{base}_HEAP`.
+    pub fn create(base: &str, options: &HeapOptions, memory: &SectionOptions) -> Result<Self> {
+        options.validate()?;
+        memory.validate()?;
+        let mapping = Mapping::create(
+            &mapping_name(&heap_name(base)),
+            heap_mapping_size(options.block_size, options.blocks as usize),
+            memory,
+        )?;
+        // SAFETY: секция создана под heap_mapping_size, view выровнен на
+        // страницу и живёт, пока жив self (_mapping).
+        let arena = unsafe { HeapArena::new(mapping.as_ptr(), options.block_size, options.blocks) };
+        arena.init();
+        Ok(Self {
+            _mapping: mapping,
+            arena,
+        })
+    }
+
+    /// Открывает кучу сервера `base`. Ошибка — сервер запущен без кучи
+    /// (секции нет) или секция непригодна.
+    pub fn open(base: &str) -> Result<Self> {
+        let mapping = Mapping::open(&mapping_name(&heap_name(base)))?;
+        if mapping.size() < std::mem::size_of::<HeapHeader>() {
+            return Err(ShmError::Corrupted);
+        }
+        // SAFETY: маппинг не меньше заголовка (проверено выше).
+        let header = unsafe { &*(mapping.as_ptr() as *const HeapHeader) };
+        if header.magic.load(Ordering::Acquire) != HEAP_MAGIC {
+            return Err(ShmError::Corrupted);
+        }
+        if header.version != HEAP_VERSION {
+            return Err(ShmError::HandshakeFailed);
+        }
+        let options = HeapOptions {
+            block_size: header.block_size as usize,
+            blocks: header.block_count,
+        };
+        if options.validate().is_err()
+            || header.data_offset != heap_data_offset(options.blocks as usize) as u64
+            || heap_mapping_size(options.block_size, options.blocks as usize) > mapping.size()
+        {
+            return Err(ShmError::Corrupted);
+        }
+        // SAFETY: пределы проверены против заголовка и размера маппинга.
+        let arena = unsafe { HeapArena::new(mapping.as_ptr(), options.block_size, options.blocks) };
+        Ok(Self {
+            _mapping: mapping,
+            arena,
+        })
+    }
+
+    /// Выделяет блок под `len` байт. Свободных нет — `QueueFull`.
+    pub fn allocate(&self, len: usize) -> Result<HeapBlock<'_>> {
+        self.arena.allocate(len)
+    }
+
+    /// Выделяет блок, копирует в него `data` и отдаёт handle со ссылкой
+    /// producer-а.
+    pub fn allocate_copy(&self, data: &[u8]) -> Result<HeapHandle> {
+        let block = self.arena.allocate(data.len())?;
+        // SAFETY: блок на data.len() байт принадлежит только нам.
+        unsafe { copy_to_shared(self.arena.data(block.index), data) };
+        Ok(block.into_handle())
+    }
+
+    /// Данные блока. Остаются валидными, пока вызывающий держит ссылку;
+    /// блок уже освобождён — `Overwritten`, чужой handle — `Corrupted`.
+    pub fn get(&self, handle: &HeapHandle) -> Result<&[u8]> {
+        self.arena.get(handle)
+    }
+
+    /// Ещё одна ссылка на блок (по одной на каждого получателя handle-а).
+    pub fn retain(&self, handle: &HeapHandle) -> Result<()> {
+        self.arena.retain(handle)
+    }
+
+    /// Снимает ссылку; последняя возвращает блок в кучу.
+    pub fn release(&self, handle: &HeapHandle) -> Result<()> {
+        self.arena.release(handle)
+    }
+
+    pub fn block_size(&self) -> usize {
+        self.arena.block_size
+    }
+
+    pub fn block_count(&self) -> u32 {
+        self.arena.block_count
+    }
+
+    /// Сколько блоков свободно сейчас.
+    pub fn free_blocks(&self) -> u32 {
+        self.arena.free_blocks()
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use std::alloc::{alloc_zeroed, dealloc, Layout};
+    use std::sync::Arc;
+    use std::thread;
+
+    const BLOCK: usize = HEAP_BLOCK_ALIGN;
+
+    /// Секция в куче процесса вместо shared memory — логика та же.
+    struct Section {
+        ptr: *mut u8,
+        layout: Layout,
+    }
+
+    unsafe impl Send for Section {}
+    unsafe impl Sync for Section {}
+
+    impl Drop for Section {
+        fn drop(&mut self) {
+            unsafe { dealloc(self.ptr, self.layout) };
+        }
+    }
+
+    fn arena(blocks: u32) -> (Section, HeapArena) {
+        let layout =
+            Layout::from_size_align(heap_mapping_size(BLOCK, blocks as usize), HEAP_BLOCK_ALIGN)
+                .unwrap();
+        let section = Section {
+            ptr: unsafe { alloc_zeroed(layout) },
+            layout,
+        };
+        let arena = unsafe { HeapArena::new(section.ptr, BLOCK, blocks) };
+        arena.init();
+        (section, arena)
+    }
+
+    #[test]
+    fn options_validation() {
+        let options = |block_size, blocks| HeapOptions { block_size, blocks };
+        assert!(options(BLOCK, 1).validate().is_ok());
+        assert!(HeapOptions::default().validate().is_err());
+        assert!(options(BLOCK + 1, 4).validate().is_err());
+        assert!(options(0, 4).validate().is_err());
+        assert!(options(2 * MAX_RING_CAPACITY, 4).validate().is_err());
+        assert!(options(BLOCK, MAX_HEAP_BLOCKS + 1).validate().is_err());
+    }
+
+    #[test]
+    fn handle_bytes_roundtrip() {
+        let handle = HeapHandle {
+            offset: 0x1_0000_2000,
+            len: 77,
+            generation: 9,
+        };
+        assert_eq!(HeapHandle::from_bytes(&handle.to_bytes()), Ok(handle));
+        assert_eq!(HeapHandle::from_bytes(b"short"), Err(ShmError::Corrupted));
+    }
+
+    #[test]
+    fn allocate_until_exhausted_then_reuse() {
+        let (_section, arena) = arena(2);
+        let mut first = arena.allocate(100).unwrap();
+        first.as_mut_slice().fill(0xAB);
+        let first = first.into_handle();
+        let second = arena.allocate(BLOCK).unwrap().into_handle();
+        assert_eq!(arena.allocate(1).err(), Some(ShmError::QueueFull));
+        assert_eq!(arena.free_blocks(), 0);
+
+        assert_eq!(arena.get(&first).unwrap(), &[0xAB; 100][..]);
+        arena.release(&first).unwrap();
+        assert_eq!(arena.free_blocks(), 1);
+        // Освобождённый блок: старый handle устарел, повторный release — тоже.
+        assert_eq!(arena.get(&first), Err(ShmError::Overwritten));
+        assert_eq!(arena.release(&first), Err(ShmError::Overwritten));
+
+        let reused = arena.allocate(8).unwrap().into_handle();
+        assert_eq!(reused.offset, first.offset);
+        assert_ne!(reused.generation, first.generation);
+        assert_eq!(arena.retain(&first), Err(ShmError::Overwritten));
+        arena.release(&reused).unwrap();
+        arena.release(&second).unwrap();
+        assert_eq!(arena.free_blocks(), 2);
+
+        assert_eq!(arena.allocate(0).err(), Some(ShmError::MessageTooSmall));
+        assert_eq!(
+            arena.allocate(BLOCK + 1).err(),
+            Some(ShmError::MessageTooLarge)
+        );
+    }
+
+    #[test]
+    fn block_lives_until_last_reference() {
+        let (_section, arena) = arena(1);
+        let block = arena.allocate(16).unwrap();
+        let handle = block.handle();
+        // два получателя
+        arena.retain(&handle).unwrap();
+        arena.retain(&handle).unwrap();
+        drop(block);
+        arena.release(&handle).unwrap();
+        assert!(arena.get(&handle).is_ok());
+        assert_eq!(arena.free_blocks(), 0);
+        arena.release(&handle).unwrap();
+        assert_eq!(arena.free_blocks(), 1);
+        assert_eq!(arena.get(&handle), Err(ShmError::Overwritten));
+    }
+
+    #[test]
+    fn foreign_handles_are_rejected() {
+        let (_section, arena) = arena(2);
+        let handle = arena.allocate(16).unwrap().into_handle();
+        let shifted = HeapHandle {
+            offset: handle.offset + 8,
+            ..handle
+        };
+        let past_end = HeapHandle {
+            offset: handle.offset + 2 * BLOCK as u64,
+            ..handle
+        };
+        let too_long = HeapHandle {
+            len: BLOCK as u32 + 1,
+            ..handle
+        };
+        for bad in [
+            shifted,
+            past_end,
+            too_long,
+            HeapHandle {
+                offset: 0,
+                ..handle
+            },
+        ] {
+            assert_eq!(arena.get(&bad), Err(ShmError::Corrupted));
+            assert_eq!(arena.release(&bad), Err(ShmError::Corrupted));
+        }
+    }
+
+    #[test]
+    fn concurrent_allocations_never_share_a_block() {
+        let (section, arena) = arena(8);
+        let shared = Arc::new((section, arena));
+        let workers: Vec<_> = (0..4u8)
+            .map(|id| {
+                let shared = shared.clone();
+                thread::spawn(move || {
+                    let arena = &shared.1;
+                    for _ in 0..2000 {
+                        let Ok(mut block) = arena.allocate(64) else {
+                            continue;
+                        };
+                        block.as_mut_slice().fill(id);
+                        let handle = block.into_handle();
+                        assert!(arena.get(&handle).unwrap().iter().all(|&b| b == id));
+                        arena.release(&handle).unwrap();
+                    }
+                })
+            })
+            .collect();
+        for worker in workers {
+            worker.join().unwrap();
+        }
+        assert_eq!(shared.1.free_blocks(), 8);
+    }
+}
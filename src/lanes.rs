@@ -0,0 +1,464 @@
+//! Дорожки канала: несколько независимых SPSC-колец на направление для
+//! многопоточных producer-ов.
+//!
+//! `ChannelGeometry::lanes > 1` добавляет за основными кольцами дорожки
+//! 1..N той же ёмкости (layout — `shared_mapping_size`). Каждую дорожку
+//! пишет ровно один поток: он захватывает её через [`LaneSet::claim`] и
+//! держит [`LaneSender`], пока не отпустит. Общего лока на записи нет —
+//! потоки разных дорожек не делят ни одной кэш-линии кольца.
+//! [`LaneSet::send_keyed`] выбирает дорожку по ключу и держит её только на
+//! время записи: сообщения одного ключа идут через одно кольцо и приходят в
+//! порядке отправки. Порядок между дорожками не определён.
+//!
+//! Consumer (`receive_*`, `poll_*`, spin-ожидание стороны) разбирает все
+//! дорожки по кругу, каждый раз начиная со следующей, чтобы загруженная
+//! дорожка не вытесняла остальные. Дорожка 0 остаётся за `send_*` самой
+//! стороны; peek/consume и zero-copy резерв работают только с ней. Space- и
+//! data-события у дорожек направления общие.
+
+use std::marker::PhantomData;
+use std::sync::atomic::{AtomicBool, AtomicUsize, Ordering};
+use std::time::Duration;
+
+use crate::error::{Result, ShmError};
+use crate::ring::{MessageBatch, OverflowPolicy, RingBuffer, WriteOutcome};
+use crate::wait::{write_batch_with_backpressure, write_with_backpressure, SHARED_SPACE_NAP};
+use crate::win::EventHandle;
+
+/// Предел ожидания space-события producer-ом стороны с `extra` дорожками:
+/// с дорожками событие общее (см. `SHARED_SPACE_NAP`).
+pub(crate) fn space_nap(extra: &[RingBuffer]) -> Option<Duration> {
+    (!extra.is_empty()).then_some(SHARED_SPACE_NAP)
+}
+
+/// Кольца приёма одной стороны: основное и дорожки 1..N.
+pub(crate) struct RxLanes<'a> {
+    pub main: &'a RingBuffer,
+    pub extra: &'a [RingBuffer],
+    /// Дорожка, с которой начнётся следующий разбор.
+    pub cursor: &'a AtomicUsize,
+    /// Space-событие направления (`None` — anonymous-режим).
+    pub space: Option<&'a EventHandle>,
+}
+
+impl<'a> RxLanes<'a> {
+    fn lane(&self, index: usize) -> &'a RingBuffer {
+        if index == 0 {
+            self.main
+        } else {
+            &self.extra[index - 1]
+        }
+    }
+
+    /// Первая дорожка разбора; курсор сдвигается на следующую.
+    fn next_start(&self) -> usize {
+        let count = self.extra.len() + 1;
+        let start = self.cursor.load(Ordering::Relaxed) % count;
+        self.cursor.store(start + 1, Ordering::Relaxed);
+        start
+    }
+
+    /// Взводит space, если producer мог ждать места в `ring`.
+    fn notify_space(&self, ring: &RingBuffer) {
+        if let Some(space) = self.space {
+            if ring.is_empty() {
+                let _ = space.set();
+            }
+        }
+    }
+
+    /// Одно сообщение с первой непустой дорожки.
+    pub fn read_message(&self, out: &mut Vec<u8>) -> Result<usize> {
+        if self.extra.is_empty() {
+            let len = self.main.read_message(out)?;
+            self.notify_space(self.main);
+            return Ok(len);
+        }
+        let count = self.extra.len() + 1;
+        let start = self.next_start();
+        for step in 0..count {
+            let ring = self.lane((start + step) % count);
+            match ring.read_message(out) {
+                Ok(len) => {
+                    self.notify_space(ring);
+                    return Ok(len);
+                }
+                Err(ShmError::QueueEmpty) => {}
+                Err(err) => return Err(err),
+            }
+        }
+        Err(ShmError::QueueEmpty)
+    }
+
+    /// Пачка со всех дорожек по кругу; пределы — на всю пачку (см.
+    /// `RingBuffer::read_batch`). Ошибка дорожки после того, как пачка уже
+    /// что-то забрала, не теряет забранное: пачка отдаётся, ошибка
+    /// повторится при следующем разборе.
+    pub fn read_batch(
+        &self,
+        batch: &mut MessageBatch,
+        max_messages: usize,
+        max_bytes: usize,
+    ) -> Result<usize> {
+        if self.extra.is_empty() {
+            let count = self.main.read_batch(batch, max_messages, max_bytes)?;
+            self.notify_space(self.main);
+            return Ok(count);
+        }
+        batch.clear();
+        let count = self.extra.len() + 1;
+        let start = self.next_start();
+        let mut drained = false;
+        for step in 0..count {
+            let ring = self.lane((start + step) % count);
+            match ring.append_batch(batch, max_messages, max_bytes) {
+                Ok(0) => break,
+                Ok(_) => drained |= self.space.is_some() && ring.is_empty(),
+                Err(ShmError::QueueEmpty) => {}
+                Err(_) if !batch.is_empty() => break,
+                Err(err) => return Err(err),
+            }
+        }
+        if batch.is_empty() {
+            return Err(ShmError::QueueEmpty);
+        }
+        if drained {
+            if let Some(space) = self.space {
+                let _ = space.set();
+            }
+        }
+        Ok(batch.len())
+    }
+
+    /// Есть ли данные хотя бы на одной дорожке.
+    pub fn has_data(&self) -> bool {
+        !self.main.is_empty() || self.extra.iter().any(|ring| !ring.is_empty())
+    }
+
+    pub fn start_spinning(&self) {
+        self.main.start_spinning();
+        for ring in self.extra {
+            ring.start_spinning();
+        }
+    }
+
+    /// Снимает флаг со всех дорожек (даже если на первой уже есть данные)
+    /// и перепроверяет каждую — пара к `RingBuffer::stop_spinning`.
+    pub fn stop_spinning(&self) -> bool {
+        let mut ready = self.main.stop_spinning();
+        for ring in self.extra {
+            ready |= ring.stop_spinning();
+        }
+        ready
+    }
+}
+
+/// Дорожки отправки стороны канала (без основной, дорожки 0): выдаётся
+/// [`crate::SharedServer::lanes`] / [`crate::SharedClient::lanes`] и
+/// делится между потоками по ссылке.
+pub struct LaneSet<'a> {
+    rings: &'a [RingBuffer],
+    claims: &'a [AtomicBool],
+    overflow: OverflowPolicy,
+    space: Option<&'a EventHandle>,
+    data: Option<&'a EventHandle>,
+}
+
+impl<'a> LaneSet<'a> {
+    pub(crate) fn new(
+        rings: &'a [RingBuffer],
+        claims: &'a [AtomicBool],
+        overflow: OverflowPolicy,
+        space: Option<&'a EventHandle>,
+        data: Option<&'a EventHandle>,
+    ) -> Self {
+        debug_assert_eq!(rings.len(), claims.len());
+        Self {
+            rings,
+            claims,
+            overflow,
+            space,
+            data,
+        }
+    }
+
+    /// Число дорожек для producer-ов (`ChannelGeometry::lanes - 1`).
+    pub fn len(&self) -> usize {
+        self.rings.len()
+    }
+
+    pub fn is_empty(&self) -> bool {
+        self.rings.is_empty()
+    }
+
+    /// Захватывает первую свободную дорожку. Все заняты — `NotReady`;
+    /// у канала одна дорожка — `InvalidConfig`.
+    pub fn claim(&self) -> Result<LaneSender<'a>> {
+        if self.is_empty() {
+            return Err(ShmError::InvalidConfig("channel has no producer lanes"));
+        }
+        (0..self.len())
+            .find(|&index| self.try_claim(index))
+            .map(|index| self.sender(index))
+            .ok_or(ShmError::NotReady)
+    }
+
+    /// Захватывает дорожку `lane` (1..=`len()`): поток, привязанный к своей
+    /// дорожке. Занята — `NotReady`.
+    pub fn claim_lane(&self, lane: usize) -> Result<LaneSender<'a>> {
+        if !(1..=self.len()).contains(&lane) {
+            return Err(ShmError::InvalidConfig("lane index out of range"));
+        }
+        if !self.try_claim(lane - 1) {
+            return Err(ShmError::NotReady);
+        }
+        Ok(self.sender(lane - 1))
+    }
+
+    /// Отправка по ключу: дорожка `1 + key % len()` захватывается только на
+    /// время записи (ждёт, пока её отпустит другой поток), поэтому сообщения
+    /// одного ключа не обгоняют друг друга.
+    pub fn send_keyed(&self, key: u64, payload: &[u8]) -> Result<WriteOutcome> {
+        if self.is_empty() {
+            return Err(ShmError::InvalidConfig("channel has no producer lanes"));
+        }
+        let index = (key % self.len() as u64) as usize;
+        let mut spins = 0u32;
+        while !self.try_claim(index) {
+            // дорожку держат на одну запись — сначала короткий spin
+            if spins < 64 {
+                spins += 1;
+                std::hint::spin_loop();
+            } else {
+                std::thread::yield_now();
+            }
+        }
+        self.sender(index).send(payload)
+    }
+
+    fn try_claim(&self, index: usize) -> bool {
+        self.claims[index]
+            .compare_exchange(false, true, Ordering::Acquire, Ordering::Relaxed)
+            .is_ok()
+    }
+
+    fn sender(&self, index: usize) -> LaneSender<'a> {
+        LaneSender {
+            lane: index + 1,
+            ring: &self.rings[index],
+            claim: &self.claims[index],
+            overflow: self.overflow,
+            space: self.space,
+            data: self.data,
+            _not_sync: PhantomData,
+        }
+    }
+}
+
+/// Захваченная дорожка: единственный producer своего кольца. Передаётся в
+/// поток (`Send`), но не делится между потоками; дорожка освобождается при
+/// drop.
+pub struct LaneSender<'a> {
+    lane: usize,
+    ring: &'a RingBuffer,
+    claim: &'a AtomicBool,
+    overflow: OverflowPolicy,
+    space: Option<&'a EventHandle>,
+    data: Option<&'a EventHandle>,
+    _not_sync: PhantomData<std::cell::Cell<()>>,
+}
+
+impl LaneSender<'_> {
+    /// Номер дорожки (1..=`LaneSet::len()`).
+    pub fn lane(&self) -> usize {
+        self.lane
+    }
+
+    /// Отправка по политике переполнения стороны (см.
+    /// `SharedServer::set_overflow_policy`).
+    pub fn send(&self, payload: &[u8]) -> Result<WriteOutcome> {
+        let result =
+            write_with_backpressure(self.overflow, self.space, Some(SHARED_SPACE_NAP), || {
+                self.ring.write_message(payload)
+            })?;
+        if result.wake_consumer {
+            if let Some(data) = self.data {
+                let _ = data.set();
+            }
+        }
+        Ok(result)
+    }
+
+    /// Пачка одной публикацией (см. `SharedServer::send_batch_to_client`).
+    pub fn send_batch(&self, messages: &[&[u8]]) -> Result<WriteOutcome> {
+        write_batch_with_backpressure(
+            self.ring,
+            self.overflow,
+            self.space,
+            Some(SHARED_SPACE_NAP),
+            self.data,
+            messages,
+        )
+    }
+}
+
+impl Drop for LaneSender<'_> {
+    fn drop(&mut self) {
+        self.claim.store(false, Ordering::Release);
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use crate::ring::overflow_race_tests::{make_ring, RingMem};
+
+    fn make_lanes(count: usize) -> (Vec<RingBuffer>, Vec<RingMem>) {
+        (0..count).map(|_| make_ring()).unzip()
+    }
+
+    fn payloads(batch: &MessageBatch) -> Vec<Vec<u8>> {
+        batch.iter().map(<[u8]>::to_vec).collect()
+    }
+
+    #[test]
+    fn batch_drains_lanes_round_robin() {
+        let (rings, _mem) = make_lanes(3);
+        let cursor = AtomicUsize::new(0);
+        let rx = RxLanes {
+            main: &rings[0],
+            extra: &rings[1..],
+            cursor: &cursor,
+            space: None,
+        };
+        for (lane, ring) in rings.iter().enumerate() {
+            for i in 0..=lane {
+                ring.write_message(&[lane as u8, i as u8]).unwrap();
+            }
+        }
+
+        let mut batch = MessageBatch::new();
+        assert_eq!(rx.read_batch(&mut batch, 100, usize::MAX).unwrap(), 6);
+        let expected: Vec<Vec<u8>> = vec![
+            vec![0, 0],
+            vec![1, 0],
+            vec![1, 1],
+            vec![2, 0],
+            vec![2, 1],
+            vec![2, 2],
+        ];
+        assert_eq!(payloads(&batch), expected);
+        assert!(!rx.has_data());
+
+        // следующий разбор начинается со следующей дорожки, а предел —
+        // на всю пачку
+        for (lane, ring) in rings.iter().enumerate() {
+            ring.write_message(&[lane as u8, 9]).unwrap();
+            ring.write_message(&[lane as u8, 10]).unwrap();
+        }
+        assert_eq!(rx.read_batch(&mut batch, 3, usize::MAX).unwrap(), 3);
+        assert_eq!(payloads(&batch), vec![vec![1, 9], vec![1, 10], vec![2, 9]]);
+        assert_eq!(rx.read_batch(&mut batch, 100, usize::MAX).unwrap(), 3);
+        assert_eq!(payloads(&batch), vec![vec![2, 10], vec![0, 9], vec![0, 10]]);
+        assert_eq!(
+            rx.read_batch(&mut batch, 100, usize::MAX),
+            Err(ShmError::QueueEmpty)
+        );
+    }
+
+    #[test]
+    fn single_reads_rotate_start_lane() {
+        let (rings, _mem) = make_lanes(2);
+        let cursor = AtomicUsize::new(0);
+        let rx = RxLanes {
+            main: &rings[0],
+            extra: &rings[1..],
+            cursor: &cursor,
+            space: None,
+        };
+        for ring in &rings {
+            ring.write_message(b"aa").unwrap();
+            ring.write_message(b"bb").unwrap();
+        }
+        let mut out = Vec::new();
+        let mut seen = Vec::new();
+        while rx.read_message(&mut out).is_ok() {
+            seen.push(out.clone());
+        }
+        // чередование дорожек, а не сначала вся дорожка 0
+        assert_eq!(
+            seen,
+            vec![
+                b"aa".to_vec(),
+                b"aa".to_vec(),
+                b"bb".to_vec(),
+                b"bb".to_vec()
+            ]
+        );
+        assert_eq!(rings[0].message_count() + rings[1].message_count(), 0);
+    }
+
+    #[test]
+    fn lanes_are_claimed_exclusively() {
+        let (rings, _mem) = make_lanes(2);
+        let claims: Vec<AtomicBool> = rings.iter().map(|_| AtomicBool::new(false)).collect();
+        let lanes = LaneSet::new(&rings, &claims, OverflowPolicy::Fail, None, None);
+
+        let first = lanes.claim().unwrap();
+        let second = lanes.claim().unwrap();
+        assert_eq!((first.lane(), second.lane()), (1, 2));
+        assert_eq!(lanes.claim().err(), Some(ShmError::NotReady));
+        assert_eq!(lanes.claim_lane(2).err(), Some(ShmError::NotReady));
+        assert!(matches!(
+            lanes.claim_lane(3),
+            Err(ShmError::InvalidConfig(_))
+        ));
+
+        drop(second);
+        let again = lanes.claim_lane(2).unwrap();
+        again.send(b"lane two").unwrap();
+        assert_eq!(rings[1].message_count(), 1);
+
+        let none = LaneSet::new(&[], &[], OverflowPolicy::Fail, None, None);
+        assert!(matches!(none.claim(), Err(ShmError::InvalidConfig(_))));
+    }
+
+    #[test]
+    fn keyed_sends_keep_per_key_order() {
+        const THREADS: u64 = 4;
+        const PER_KEY: u32 = 100;
+
+        let (rings, _mem) = make_lanes(3);
+        let claims: Vec<AtomicBool> = rings.iter().map(|_| AtomicBool::new(false)).collect();
+        let lanes = LaneSet::new(&rings, &claims, OverflowPolicy::Fail, None, None);
+
+        // у каждого потока свой ключ: сообщения одного ключа пишет один
+        // поток, но дорожку делят несколько ключей
+        std::thread::scope(|scope| {
+            for key in 0..THREADS {
+                let lanes = &lanes;
+                scope.spawn(move || {
+                    for seq in 0..PER_KEY {
+                        let mut payload = [0u8; 12];
+                        payload[..8].copy_from_slice(&key.to_le_bytes());
+                        payload[8..].copy_from_slice(&seq.to_le_bytes());
+                        lanes.send_keyed(key, &payload).unwrap();
+                    }
+                });
+            }
+        });
+
+        let mut next = [0u32; THREADS as usize];
+        let mut out = Vec::new();
+        for (index, ring) in rings.iter().enumerate() {
+            while ring.read_message(&mut out).is_ok() {
+                let key = u64::from_le_bytes(out[..8].try_into().unwrap());
+                let seq = u32::from_le_bytes(out[8..].try_into().unwrap());
+                assert_eq!(key % rings.len() as u64, index as u64);
+                assert_eq!(seq, next[key as usize], "key {key} out of order");
+                next[key as usize] += 1;
+            }
+        }
+        assert_eq!(next, [PER_KEY; THREADS as usize]);
+    }
+}
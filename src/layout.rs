@@ -1,26 +1,177 @@
-use core::sync::atomic::{AtomicU32, Ordering};
+use core::sync::atomic::{AtomicU32, AtomicU64, Ordering};
 
 use crate::constants::*;
+use crate::error::{Result, ShmError};
+use crate::win::SectionOptions;
 
+/// Геометрия колец канала: выбирается сервером при создании сегмента и
+/// записывается в `ControlBlock`, откуда её берёт клиент.
+///
+/// Ёмкости задаются отдельно для каждого направления — каналу с объёмной
+/// телеметрией в одну сторону не нужно такое же обратное кольцо.
+#[derive(Debug, Clone, Copy, PartialEq, Eq)]
+pub struct ChannelGeometry {
+    /// Ёмкость кольца server→client (байты, степень двойки).
+    pub s2c_capacity: usize,
+    /// Ёмкость кольца client→server (байты, степень двойки).
+    pub c2s_capacity: usize,
+    /// Предел числа сообщений в одном кольце.
+    pub max_messages: u32,
+    /// Максимальный размер одного сообщения. Больше `MAX_MESSAGE_SIZE` —
+    /// длинные кадры; сообщение с заголовком должно влезать в меньшее кольцо.
+    pub max_message_size: usize,
+    /// Дорожек на направление, включая основное кольцо (1..=`MAX_LANES`).
+    /// Дорожки 1.. — отдельные SPSC-кольца той же ёмкости для
+    /// многопоточных producer-ов (`SharedServer::lanes`), consumer разбирает
+    /// их по кругу. Старый пир видит только дорожку 0, поэтому больше одной
+    /// — когда обе стороны обновлены.
+    pub lanes: u32,
+    /// Размер слота для каналов с одним POD-типом сообщений (0 — кадры
+    /// переменной длины). Каждое сообщение — ровно `slot_size` байт без
+    /// заголовка кадра и метки трассировки, слот никогда не переходит
+    /// границу кольца (хвост, куда он не влезает, пропускается), поэтому
+    /// zero-copy спан у него всегда один. Равен `max_message_size`, не
+    /// больше половины меньшего кольца. Старый пир слотов не понимает —
+    /// только когда обе стороны обновлены.
+    pub slot_size: u32,
+    /// Выделение памяти сегмента (большие страницы, pre-fault, NUMA-узел).
+    /// В `ControlBlock` не пишется: это выбор создателя, у клиента — всегда
+    /// `SectionOptions::DEFAULT`.
+    pub memory: SectionOptions,
+}
+
+impl Default for ChannelGeometry {
+    fn default() -> Self {
+        Self::symmetric(RING_CAPACITY)
+    }
+}
+
+impl ChannelGeometry {
+    /// Одинаковая ёмкость в обе стороны, остальные пределы — по умолчанию.
+    pub const fn symmetric(capacity: usize) -> Self {
+        Self {
+            s2c_capacity: capacity,
+            c2s_capacity: capacity,
+            max_messages: MAX_MESSAGES,
+            max_message_size: MAX_MESSAGE_SIZE,
+            lanes: 1,
+            slot_size: 0,
+            memory: SectionOptions::DEFAULT,
+        }
+    }
+
+    /// Кольца фиксированных слотов по `slot_size` байт (см. `slot_size`).
+    pub const fn fixed_slots(capacity: usize, slot_size: usize) -> Self {
+        let mut geometry = Self::symmetric(capacity);
+        geometry.max_message_size = slot_size;
+        geometry.slot_size = slot_size as u32;
+        geometry
+    }
+
+    pub fn validate(&self) -> Result<()> {
+        for capacity in [self.s2c_capacity, self.c2s_capacity] {
+            if !capacity.is_power_of_two()
+                || !(MIN_RING_CAPACITY..=MAX_RING_CAPACITY).contains(&capacity)
+            {
+                return Err(ShmError::InvalidConfig(
+                    "ring capacity must be a power of two in 4 KB..=1 GB",
+                ));
+            }
+        }
+        if self.max_messages == 0 {
+            return Err(ShmError::InvalidConfig("max_messages must be non-zero"));
+        }
+        if self.max_message_size < MIN_MESSAGE_SIZE {
+            return Err(ShmError::InvalidConfig(
+                "max_message_size must be at least 2",
+            ));
+        }
+        if !(1..=MAX_LANES).contains(&self.lanes) {
+            return Err(ShmError::InvalidConfig("lanes must be in 1..=64"));
+        }
+        if self.slot_size != 0 {
+            let slot = self.slot_size as usize;
+            if slot != self.max_message_size {
+                return Err(ShmError::InvalidConfig(
+                    "slot_size must equal max_message_size",
+                ));
+            }
+            // худший пропуск у границы — почти целый слот
+            if 2 * slot > self.s2c_capacity.min(self.c2s_capacity) {
+                return Err(ShmError::InvalidConfig(
+                    "slot_size must be at most half of the ring",
+                ));
+            }
+        }
+        self.memory.validate()?;
+        let frame = frame_header_size(self.max_message_size) + self.max_message_size;
+        if frame > self.s2c_capacity.min(self.c2s_capacity) {
+            return Err(ShmError::InvalidConfig(
+                "max_message_size does not fit into the ring",
+            ));
+        }
+        Ok(())
+    }
+
+    /// Размер сегмента под эту геометрию.
+    pub const fn mapping_size(&self) -> usize {
+        shared_mapping_size(self.s2c_capacity, self.c2s_capacity, self.lanes as usize)
+    }
+}
+
+/// Индексы, которые пишет producer кольца (своя кэш-линия).
 #[repr(C, align(64))]
-pub struct RingHeader {
+pub struct ProducerIndex {
     pub write_pos: AtomicU32,
-    pub read_pos: AtomicU32,
-    pub message_count: AtomicU32,
+    /// Сколько сообщений опубликовано (wrapping).
+    pub messages_written: AtomicU32,
+    /// Сколько сообщений вытеснено overwrite-ом (wrapping).
     pub drop_count: AtomicU32,
-    pub sequence: AtomicU32,
+    /// Метка времени сэмплированной публикации для замера задержки (см.
+    /// `stats::publish_stamp`); ноль — метки нет. Старые пиры поле не пишут.
+    pub publish_stamp: AtomicU64,
+}
+
+/// Индексы, которые пишет consumer кольца (своя кэш-линия).
+///
+/// `read_pos` producer двигает CAS-ом только при overwrite
+/// (`discard_oldest`); `messages_read` и `spinning` пишет исключительно
+/// consumer.
+#[repr(C, align(64))]
+pub struct ConsumerIndex {
+    pub read_pos: AtomicU32,
+    /// Сколько сообщений забрано consumer-ом (wrapping).
+    pub messages_read: AtomicU32,
+    /// Ненулевой, пока consumer активно ждёт данных (spin/yield, см.
+    /// `WaitStrategy`) — producer тогда не сигналит data-событие. Ноль —
+    /// consumer может спать на событии; старые пиры флаг не трогают.
+    pub spinning: AtomicU32,
+}
+
+/// Заголовок кольца: три кэш-линии.
+///
+/// Линия 0 — состояние соединения (меняется только на handshake), линии 1 и 2
+/// — индексы producer-а и consumer-а. Общего RMW-счётчика сообщений нет:
+/// число сообщений в кольце = `messages_written - drop_count - messages_read`,
+/// так что на каждом сообщении каждая сторона пишет только в свою линию.
+#[repr(C, align(64))]
+pub struct RingHeader {
     pub connection_gen: AtomicU32,
     pub handshake_state: AtomicU32,
-    pub reserved: [u32; 8],
+    pub reserved: [u32; 14],
+    pub producer: ProducerIndex,
+    pub consumer: ConsumerIndex,
 }
 
 impl RingHeader {
     pub fn reset(&self, generation: u32) {
-        self.write_pos.store(0, Ordering::Relaxed);
-        self.read_pos.store(0, Ordering::Relaxed);
-        self.message_count.store(0, Ordering::Relaxed);
-        self.drop_count.store(0, Ordering::Relaxed);
-        self.sequence.store(0, Ordering::Relaxed);
+        self.producer.write_pos.store(0, Ordering::Relaxed);
+        self.producer.messages_written.store(0, Ordering::Relaxed);
+        self.producer.drop_count.store(0, Ordering::Relaxed);
+        self.producer.publish_stamp.store(0, Ordering::Relaxed);
+        self.consumer.read_pos.store(0, Ordering::Relaxed);
+        self.consumer.messages_read.store(0, Ordering::Relaxed);
+        self.consumer.spinning.store(0, Ordering::Relaxed);
         self.connection_gen.store(generation, Ordering::Relaxed);
         self.handshake_state
             .store(HANDSHAKE_IDLE, Ordering::Relaxed);
@@ -34,21 +185,50 @@ pub struct ControlBlock {
     pub generation: AtomicU32,
     pub server_state: AtomicU32,
     pub client_state: AtomicU32,
+    /// Геометрия канала (см. `ChannelGeometry`). Пишется сервером один раз
+    /// при создании сегмента, до того как его может открыть клиент.
+    pub ring_capacity_a: u32,
+    pub ring_capacity_b: u32,
+    pub max_messages: u32,
+    pub max_message_size: u32,
     /// Reserved поля для расширения протокола.
-    /// reserved[0] используется для передачи slot_id в multi-client режиме.
-    pub reserved: [AtomicU32; 11],
+    /// reserved[0] используется для передачи slot_id в multi-client режиме,
+    /// reserved[3] — число дорожек (`RESERVED_LANES_INDEX`), reserved[4] —
+    /// размер слота (`RESERVED_SLOT_SIZE_INDEX`).
+    pub reserved: [AtomicU32; 7],
 }
 
 impl ControlBlock {
-    pub fn reset(&mut self) {
+    pub fn reset(&mut self, geometry: &ChannelGeometry) {
         self.magic = SHARED_MAGIC;
         self.version = SHARED_VERSION;
+        self.ring_capacity_a = geometry.s2c_capacity as u32;
+        self.ring_capacity_b = geometry.c2s_capacity as u32;
+        self.max_messages = geometry.max_messages;
+        self.max_message_size = geometry.max_message_size as u32;
         self.generation.store(1, Ordering::Relaxed);
         self.server_state.store(HANDSHAKE_IDLE, Ordering::Relaxed);
         self.client_state.store(HANDSHAKE_IDLE, Ordering::Relaxed);
         for r in &self.reserved {
             r.store(0, Ordering::Relaxed);
         }
+        self.reserved[RESERVED_LANES_INDEX].store(geometry.lanes, Ordering::Relaxed);
+        self.reserved[RESERVED_SLOT_SIZE_INDEX].store(geometry.slot_size, Ordering::Relaxed);
+    }
+
+    /// Геометрия, записанная сервером (клиент обязан её провалидировать).
+    pub fn geometry(&self) -> ChannelGeometry {
+        ChannelGeometry {
+            s2c_capacity: self.ring_capacity_a as usize,
+            c2s_capacity: self.ring_capacity_b as usize,
+            max_messages: self.max_messages,
+            max_message_size: self.max_message_size as usize,
+            lanes: self.reserved[RESERVED_LANES_INDEX]
+                .load(Ordering::Relaxed)
+                .max(1),
+            slot_size: self.reserved[RESERVED_SLOT_SIZE_INDEX].load(Ordering::Relaxed),
+            memory: SectionOptions::DEFAULT,
+        }
     }
 }
 
@@ -60,6 +240,10 @@ impl Default for ControlBlock {
             generation: AtomicU32::new(1),
             server_state: AtomicU32::new(HANDSHAKE_IDLE),
             client_state: AtomicU32::new(HANDSHAKE_IDLE),
+            ring_capacity_a: RING_CAPACITY as u32,
+            ring_capacity_b: RING_CAPACITY as u32,
+            max_messages: MAX_MESSAGES,
+            max_message_size: MAX_MESSAGE_SIZE as u32,
             reserved: [
                 AtomicU32::new(0),
                 AtomicU32::new(0),
@@ -68,18 +252,238 @@ impl Default for ControlBlock {
                 AtomicU32::new(0),
                 AtomicU32::new(0),
                 AtomicU32::new(0),
-                AtomicU32::new(0),
-                AtomicU32::new(0),
-                AtomicU32::new(0),
-                AtomicU32::new(0),
             ],
         }
     }
 }
 
-/// Общий размер сегмента (контрольный блок + 2 хэдера + 2 кольца).
-pub const fn shared_mapping_size() -> usize {
-    core::mem::size_of::<ControlBlock>()
-        + core::mem::size_of::<RingHeader>() * 2
-        + RING_CAPACITY * 2
+/// Позиции producer-а секции рассылки (своя кэш-линия). Все позиции —
+/// байтовые, монотонные u64: читатель, отставший на любое расстояние,
+/// однозначно видит, что его обогнали.
+#[repr(C, align(64))]
+pub struct BroadcastIndex {
+    /// Конец записи, которую producer пишет сейчас (или записал последней).
+    /// Двигается ДО копирования данных — по нему читатель проверяет, не
+    /// затёрта ли его копия.
+    pub tail_intent: AtomicU64,
+    /// Конец последней опубликованной записи.
+    pub tail: AtomicU64,
+    /// Начало последнего опубликованного сообщения — сюда перескакивает
+    /// обогнанный читатель.
+    pub latest: AtomicU64,
+    /// Сколько сообщений опубликовано (порядковый номер следующего).
+    pub published: AtomicU64,
+}
+
+/// Заголовок секции рассылки: описание (пишется один раз при создании) и
+/// линия producer-а. Курсоры читателей в секции не хранятся — producer
+/// никого не ждёт.
+#[repr(C, align(64))]
+pub struct BroadcastHeader {
+    /// `BROADCAST_MAGIC` — записывается последним, после остальных полей.
+    pub magic: AtomicU32,
+    pub version: u32,
+    pub capacity: u32,
+    pub max_message_size: u32,
+    pub reserved: [u32; 12],
+    pub producer: BroadcastIndex,
+}
+
+/// Размер секции рассылки с кольцом на `capacity` байт.
+pub const fn broadcast_mapping_size(capacity: usize) -> usize {
+    core::mem::size_of::<BroadcastHeader>() + capacity
+}
+
+/// Вершина списка свободных блоков кучи (своя кэш-линия: её двигают все
+/// аллоцирующие и освобождающие процессы).
+#[repr(C, align(64))]
+pub struct HeapFreeList {
+    /// `(tag << 32) | index` вершины; `tag` растёт на каждом изменении, чтобы
+    /// CAS не принял вершину, снятую и возвращённую между двумя чтениями
+    /// (ABA). `index == u32::MAX` — свободных блоков нет.
+    pub head: AtomicU64,
+    /// Сколько блоков свободно сейчас.
+    pub free_blocks: AtomicU32,
+}
+
+/// Заголовок секции кучи: описание (пишется один раз при создании) и
+/// список свободных блоков. За ним идут `block_count` дескрипторов
+/// `HeapBlockHeader`, а с `data_offset` — сами блоки.
+#[repr(C, align(64))]
+pub struct HeapHeader {
+    /// `HEAP_MAGIC` — записывается последним, после остальных полей.
+    pub magic: AtomicU32,
+    pub version: u32,
+    pub block_size: u32,
+    pub block_count: u32,
+    /// Смещение первого блока от начала секции (кратно странице).
+    pub data_offset: u64,
+    pub reserved: [u32; 10],
+    pub free: HeapFreeList,
+}
+
+/// Дескриптор одного блока кучи.
+#[repr(C)]
+pub struct HeapBlockHeader {
+    /// `(generation << 32) | refs`: одно слово, чтобы `retain` по устаревшему
+    /// handle-у не прибавил ссылку блоку, который уже выдан заново.
+    pub state: AtomicU64,
+    /// Длина данных, записанная при выделении.
+    pub len: AtomicU32,
+    /// Следующий свободный блок (пока этот в списке свободных).
+    pub next: AtomicU32,
+}
+
+/// Смещение первого блока кучи из `block_count` блоков.
+pub const fn heap_data_offset(block_count: usize) -> usize {
+    let descriptors =
+        core::mem::size_of::<HeapHeader>() + block_count * core::mem::size_of::<HeapBlockHeader>();
+    (descriptors + HEAP_BLOCK_ALIGN - 1) & !(HEAP_BLOCK_ALIGN - 1)
+}
+
+/// Размер секции кучи из `block_count` блоков по `block_size` байт.
+pub const fn heap_mapping_size(block_size: usize, block_count: usize) -> usize {
+    heap_data_offset(block_count) + block_size * block_count
+}
+
+/// Размер заголовка кадра под payload из `len` байт: короткий (u16-длина),
+/// пока длина влезает в u16, иначе длинный (`MESSAGE_FLAG_LONG` + u32-длина).
+pub const fn frame_header_size(len: usize) -> usize {
+    if len > MAX_MESSAGE_SIZE {
+        LONG_MESSAGE_HEADER_SIZE
+    } else {
+        MESSAGE_HEADER_SIZE
+    }
+}
+
+/// Размер одной дорожки: `[RingHeader_A][A][RingHeader_B][B]`.
+pub const fn lane_size(capacity_a: usize, capacity_b: usize) -> usize {
+    core::mem::size_of::<RingHeader>() * 2 + capacity_a + capacity_b
+}
+
+/// Общий размер сегмента: контрольный блок и `lanes` дорожек подряд.
+/// Дорожка 0 — основные кольца, поэтому при `lanes == 1` layout совпадает
+/// с прежним.
+pub const fn shared_mapping_size(capacity_a: usize, capacity_b: usize, lanes: usize) -> usize {
+    core::mem::size_of::<ControlBlock>() + lane_size(capacity_a, capacity_b) * lanes
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    /// Геометрия заняла часть reserved[]: ControlBlock обязан остаться одной
+    /// кэш-линией, иначе съедут смещения колец у уже собранных C-клиентов.
+    #[test]
+    fn control_block_stays_one_cache_line() {
+        assert_eq!(core::mem::size_of::<ControlBlock>(), 64);
+    }
+
+    /// Индексы producer-а и consumer-а не должны делить кэш-линию ни между
+    /// собой, ни с состоянием соединения.
+    #[test]
+    fn ring_header_separates_producer_and_consumer_lines() {
+        assert_eq!(core::mem::size_of::<RingHeader>(), 192);
+        assert_eq!(core::mem::offset_of!(RingHeader, producer), 64);
+        assert_eq!(core::mem::offset_of!(RingHeader, consumer), 128);
+    }
+
+    #[test]
+    fn broadcast_header_separates_producer_line() {
+        assert_eq!(core::mem::size_of::<BroadcastHeader>(), 128);
+        assert_eq!(core::mem::offset_of!(BroadcastHeader, producer), 64);
+    }
+
+    #[test]
+    fn heap_header_separates_free_list_line() {
+        assert_eq!(core::mem::size_of::<HeapHeader>(), 128);
+        assert_eq!(core::mem::offset_of!(HeapHeader, free), 64);
+        assert_eq!(core::mem::size_of::<HeapBlockHeader>(), 16);
+        assert_eq!(heap_data_offset(0), 4096);
+        assert_eq!(heap_data_offset(248), 4096);
+        assert_eq!(heap_data_offset(249), 8192);
+    }
+
+    #[test]
+    fn geometry_validation() {
+        assert!(ChannelGeometry::default().validate().is_ok());
+        assert!(ChannelGeometry::symmetric(128 * 1024).validate().is_ok());
+        // 64 КБ не вмещают заголовок + сообщение максимального размера
+        assert!(ChannelGeometry::symmetric(64 * 1024).validate().is_err());
+        assert!(ChannelGeometry::symmetric(3000).validate().is_err());
+        assert!(ChannelGeometry::symmetric(1024).validate().is_err());
+
+        let mut geometry = ChannelGeometry::symmetric(MIN_RING_CAPACITY);
+        assert!(
+            geometry.validate().is_err(),
+            "65535-byte message does not fit 4 KB"
+        );
+        geometry.max_message_size = 1024;
+        assert!(geometry.validate().is_ok());
+        geometry.max_messages = 0;
+        assert!(geometry.validate().is_err());
+    }
+
+    #[test]
+    fn lanes_extend_mapping_after_main_rings() {
+        let mut geometry = ChannelGeometry::symmetric(128 * 1024);
+        let single = geometry.mapping_size();
+        assert_eq!(single, 64 + 2 * 192 + 2 * 128 * 1024);
+        geometry.lanes = 4;
+        assert!(geometry.validate().is_ok());
+        assert_eq!(geometry.mapping_size(), 64 + 4 * (single - 64));
+        geometry.lanes = 0;
+        assert!(geometry.validate().is_err());
+        geometry.lanes = MAX_LANES + 1;
+        assert!(geometry.validate().is_err());
+
+        // старый сервер не пишет reserved[3]: одна дорожка
+        let mut control = ControlBlock::default();
+        assert_eq!(control.geometry().lanes, 1);
+        control.reset(&ChannelGeometry {
+            lanes: 8,
+            ..ChannelGeometry::default()
+        });
+        assert_eq!(control.geometry().lanes, 8);
+    }
+
+    #[test]
+    fn fixed_slots_fit_twice_and_match_message_size() {
+        let mut geometry = ChannelGeometry::fixed_slots(4 * 1024, 48);
+        assert!(geometry.validate().is_ok());
+        geometry.max_message_size = 64;
+        assert!(geometry.validate().is_err());
+        geometry = ChannelGeometry::fixed_slots(4 * 1024, 2 * 1024 + 1);
+        assert!(geometry.validate().is_err());
+
+        // старый сервер не пишет reserved[4]: кадры переменной длины
+        let mut control = ControlBlock::default();
+        assert_eq!(control.geometry().slot_size, 0);
+        control.reset(&ChannelGeometry::fixed_slots(64 * 1024, 48));
+        assert_eq!(
+            control.geometry(),
+            ChannelGeometry::fixed_slots(64 * 1024, 48)
+        );
+    }
+
+    #[test]
+    fn numa_node_must_fit_allocation_type() {
+        let mut geometry = ChannelGeometry::default();
+        geometry.memory.numa_node = Some(62);
+        assert!(geometry.validate().is_ok());
+        geometry.memory.numa_node = Some(63);
+        assert!(geometry.validate().is_err());
+    }
+
+    #[test]
+    fn large_messages_need_room_for_long_frame() {
+        let mut geometry = ChannelGeometry::symmetric(4 * 1024 * 1024);
+        geometry.max_message_size = 4 * 1024 * 1024 - LONG_MESSAGE_HEADER_SIZE;
+        assert!(geometry.validate().is_ok());
+        // короткого заголовка длинному кадру мало
+        geometry.max_message_size += MESSAGE_HEADER_SIZE;
+        assert!(geometry.validate().is_err());
+        geometry.max_message_size = 1;
+        assert!(geometry.validate().is_err());
+    }
 }
@@ -1,39 +1,58 @@
 #![forbid(unsafe_op_in_unsafe_fn)]
 
+mod broadcast;
 mod client;
 mod constants;
+mod copy;
 mod error;
 pub mod events;
+mod lanes;
 mod layout;
 mod naming;
 mod ring;
+mod sched;
 mod server;
 mod shared;
+mod stats;
+mod trace;
+mod wait;
 mod win;
 
 pub mod auto;
 pub mod dispatch;
 #[allow(clippy::not_unsafe_ptr_arg_deref)]
 pub mod ffi;
+pub mod heap;
 #[allow(clippy::not_unsafe_ptr_arg_deref)]
 pub mod multi;
+pub mod rpc;
 
 // Внутренний модуль - не экспортируется в C API
 pub(crate) mod ntapi;
 
 pub use auto::{AutoClient, AutoHandler, AutoOptions, AutoServer, AutoStatsSnapshot, ChannelKind};
 pub use client::SharedClient;
+pub use copy::{set_stream_threshold, stream_threshold, DEFAULT_STREAM_THRESHOLD};
 pub use dispatch::{
     ClientRegistration, DispatchClient, DispatchClientHandler, DispatchClientOptions,
     DispatchHandler, DispatchOptions, DispatchServer,
 };
 pub use error::{Result, ShmError};
 pub use events::EventHandles;
+pub use heap::{HeapBlock, HeapHandle, HeapOptions, SharedHeap, HEAP_HANDLE_SIZE};
+pub use lanes::{LaneSender, LaneSet};
+pub use layout::ChannelGeometry;
 pub use multi::{
     MultiClient, MultiClientHandler, MultiClientOptions, MultiHandler, MultiOptions, MultiServer,
 };
-pub use ring::WriteOutcome;
+pub use ring::{MessageBatch, OverflowPolicy, PeekedMessage, WriteOutcome, WriteReservation};
+pub use rpc::{RpcClient, RpcHandler, RpcServer, RPC_ENVELOPE_SIZE, RPC_FAULT_REPLY_TOO_LARGE};
+pub use sched::MAX_CLIENT_WEIGHT;
 pub use server::SharedServer;
+pub use stats::{ChannelStatsSnapshot, HistogramSnapshot, HISTOGRAM_BUCKETS};
+pub use trace::{MessageTrace, ETW_PROVIDER_GUID};
+pub use wait::WaitStrategy;
+pub use win::SectionOptions;
 
 use std::sync::atomic::{AtomicBool, Ordering};
 use std::time::{Duration, Instant};
@@ -66,7 +85,7 @@ mod tests {
         const NAME: &str = "UNITTEST_XSHM";
 
         let server_thread = thread::spawn(|| -> Result<()> {
-            let mut server = SharedServer::start(NAME)?;
+            let server = SharedServer::start(NAME)?;
             // ожидание клиента
             server.wait_for_client(Some(Duration::from_secs(2)))?;
 
@@ -108,6 +127,104 @@ mod tests {
         assert!(server_result.is_ok());
     }
 
+    /// `OverflowPolicy::Block`: отправка в полное кольцо ждёт, пока клиент
+    /// его дочитает, и ничего не вытесняет.
+    #[test]
+    fn blocking_send_waits_for_reader() {
+        const NAME: &str = "UNITTEST_XSHM_BACKPRESSURE";
+
+        let server =
+            SharedServer::start_with(NAME, &ChannelGeometry::symmetric(4 * 1024)).expect("start");
+        server.set_overflow_policy(OverflowPolicy::Block(Duration::from_millis(20)));
+        let client_thread = thread::spawn(|| SharedClient::connect(NAME, Duration::from_secs(2)));
+        server
+            .wait_for_client(Some(Duration::from_secs(2)))
+            .expect("client");
+        let client = client_thread.join().unwrap().expect("connect");
+
+        let payload = [7u8; 1000];
+        let mut sent = 0u32;
+        loop {
+            match server.send_to_client(&payload) {
+                Ok(outcome) => {
+                    assert_eq!(outcome.overwritten, 0);
+                    sent += 1;
+                }
+                Err(ShmError::QueueFull) => break,
+                Err(err) => panic!("send: {err:?}"),
+            }
+        }
+        assert!(sent > 0);
+
+        // клиент дочитывает всё, что было до блокировки, и только потом
+        // видит сообщение, дождавшееся места
+        let reader = thread::spawn(move || {
+            thread::sleep(Duration::from_millis(5));
+            let mut out = Vec::new();
+            for _ in 0..=sent {
+                while !client.poll_server(Some(Duration::from_secs(5))).unwrap() {}
+                client.receive_from_server(&mut out).unwrap();
+            }
+            client
+        });
+        server.set_overflow_policy(OverflowPolicy::Block(Duration::from_secs(5)));
+        server.send_to_client(&payload).expect("space after drain");
+        let client = reader.join().unwrap();
+        assert_eq!(
+            client.receive_from_server(&mut Vec::new()).err(),
+            Some(ShmError::QueueEmpty)
+        );
+    }
+
+    /// Дорожки: потоки клиента пишут каждый в своё кольцо, сервер разбирает
+    /// их вместе с основным одной пачкой.
+    #[test]
+    fn lane_producers_reach_server() {
+        const NAME: &str = "UNITTEST_XSHM_LANES";
+        const PER_LANE: u32 = 50;
+
+        let geometry = ChannelGeometry {
+            max_message_size: 1024,
+            lanes: 4,
+            ..ChannelGeometry::symmetric(64 * 1024)
+        };
+        let server = SharedServer::start_with(NAME, &geometry).expect("start");
+        let client_thread = thread::spawn(|| SharedClient::connect(NAME, Duration::from_secs(2)));
+        server
+            .wait_for_client(Some(Duration::from_secs(2)))
+            .expect("client");
+        let client = client_thread.join().unwrap().expect("connect");
+
+        let lanes = client.lanes().expect("lanes");
+        assert_eq!(lanes.len(), 3);
+        thread::scope(|scope| {
+            for _ in 0..lanes.len() {
+                let sender = lanes.claim().expect("claim");
+                scope.spawn(move || {
+                    for seq in 0..PER_LANE {
+                        let mut payload = [sender.lane() as u8; 5];
+                        payload[1..].copy_from_slice(&seq.to_le_bytes());
+                        sender.send(&payload).expect("lane send");
+                    }
+                });
+            }
+        });
+        client.send_to_server(&[0, 0, 0, 0, 0]).expect("main send");
+
+        let mut next = [0u32; 4];
+        let mut batch = MessageBatch::new();
+        while let Ok(count) = server.receive_batch_from_client(&mut batch, 64, usize::MAX) {
+            assert!(count > 0);
+            for message in batch.iter() {
+                let lane = message[0] as usize;
+                let seq = u32::from_le_bytes(message[1..].try_into().unwrap());
+                assert_eq!(seq, next[lane], "lane {lane} out of order");
+                next[lane] += 1;
+            }
+        }
+        assert_eq!(next, [1, PER_LANE, PER_LANE, PER_LANE]);
+    }
+
     #[derive(Clone)]
     struct CaptureHandler {
         buffer: Arc<(Mutex<Vec<Vec<u8>>>, Condvar)>,
@@ -8,21 +8,41 @@ use std::ptr::null_mut;
 use std::sync::Arc;
 use std::time::Duration;
 
-use crate::constants::MAX_MESSAGE_SIZE;
 use crate::error::ShmError;
-use crate::ffi::shm_error_t;
+use crate::ffi::{
+    shm_channel_geometry_t, shm_channel_stats_t, shm_error_t, shm_wait_strategy_t,
+    write_channel_stats,
+};
+use crate::heap::ffi::SharedHeapHandle;
+use crate::heap::HeapOptions;
 use crate::multi::{MultiHandler, MultiOptions, MultiServer, DEFAULT_MAX_CLIENTS};
 
 /// Опции для мультиклиентного сервера
 #[repr(C)]
 #[derive(Clone, Copy)]
 pub struct shm_multi_options_t {
-    /// Максимальное количество клиентов (по умолчанию 20)
+    /// Максимальное количество клиентов (по умолчанию 20, до MAX_MULTI_CLIENTS).
+    /// Больше SLOTS_PER_WAITER — callbacks разных клиентов приходят из разных
+    /// потоков
     pub max_clients: u32,
     /// Таймаут ожидания событий в мс (по умолчанию 50)
     pub poll_timeout_ms: u32,
     /// Количество сообщений за один цикл (по умолчанию 32)
     pub recv_batch: u32,
+    /// Геометрия колец каждого слота (нулевые поля — значения по умолчанию)
+    pub geometry: shm_channel_geometry_t,
+    /// Ожидание данных worker-ом (нули — сразу событие)
+    pub wait: shm_wait_strategy_t,
+    /// Ёмкость общего кольца рассылки (байты, степень двойки); 0 —
+    /// `shm_multi_server_broadcast` пишет в кольцо каждого слота
+    pub broadcast_capacity: u32,
+    /// Бюджет хода слота, мкс (см. `MultiOptions::recv_budget`); 0 —
+    /// фиксированная пачка
+    pub recv_budget_us: u32,
+    /// Размер блока общей кучи (байты, кратен 4 КБ); 0 — 1 МБ
+    pub heap_block_size: u32,
+    /// Число блоков общей кучи (`shm_multi_server_heap`); 0 — кучи нет
+    pub heap_blocks: u32,
 }
 
 impl Default for shm_multi_options_t {
@@ -31,6 +51,12 @@ impl Default for shm_multi_options_t {
             max_clients: DEFAULT_MAX_CLIENTS,
             poll_timeout_ms: 50,
             recv_batch: 32,
+            geometry: shm_channel_geometry_t::default(),
+            wait: shm_wait_strategy_t::default(),
+            broadcast_capacity: 0,
+            recv_budget_us: 0,
+            heap_block_size: 0,
+            heap_blocks: 0,
         }
     }
 }
@@ -175,6 +201,17 @@ pub extern "C" fn shm_multi_server_start(
             max_clients: o.max_clients,
             poll_timeout: Duration::from_millis(o.poll_timeout_ms as u64),
             recv_batch: o.recv_batch as usize,
+            recv_budget: Duration::from_micros(o.recv_budget_us as u64),
+            geometry: o.geometry.into(),
+            wait: o.wait.into(),
+            broadcast_capacity: o.broadcast_capacity as usize,
+            heap: HeapOptions {
+                block_size: match o.heap_block_size {
+                    0 => HeapOptions::default().block_size,
+                    size => size as usize,
+                },
+                blocks: o.heap_blocks,
+            },
         }
     };
 
@@ -216,7 +253,7 @@ pub extern "C" fn shm_multi_server_send_to(
     data: *const c_void,
     size: u32,
 ) -> shm_error_t {
-    if handle.is_null() || data.is_null() || size == 0 || size as usize > MAX_MESSAGE_SIZE {
+    if handle.is_null() || data.is_null() || size == 0 {
         return shm_error_t::SHM_ERROR_INVALID_PARAM;
     }
 
@@ -246,7 +283,7 @@ pub extern "C" fn shm_multi_server_broadcast(
     size: u32,
     sent_count: *mut u32,
 ) -> shm_error_t {
-    if handle.is_null() || data.is_null() || size == 0 || size as usize > MAX_MESSAGE_SIZE {
+    if handle.is_null() || data.is_null() || size == 0 {
         return shm_error_t::SHM_ERROR_INVALID_PARAM;
     }
 
@@ -289,6 +326,34 @@ pub extern "C" fn shm_multi_server_disconnect_client(
     }
 }
 
+/// Вес клиента в круговом обходе слотов (1..=64, по умолчанию 1; см.
+/// `MultiServer::set_client_weight`)
+///
+/// # Parameters
+/// - `handle`: Handle сервера
+/// - `client_id`: ID подключённого клиента
+/// - `weight`: Вес
+///
+/// # Returns
+/// SHM_SUCCESS, SHM_ERROR_NOT_CONNECTED или SHM_ERROR_INVALID_PARAM
+#[unsafe(no_mangle)]
+pub extern "C" fn shm_multi_server_set_client_weight(
+    handle: *mut MultiServerHandle,
+    client_id: u32,
+    weight: u32,
+) -> shm_error_t {
+    if handle.is_null() {
+        return shm_error_t::SHM_ERROR_INVALID_PARAM;
+    }
+
+    let state = unsafe { &*(handle as *const MultiServerState) };
+
+    match state.server.set_client_weight(client_id, weight) {
+        Ok(()) => shm_error_t::SHM_SUCCESS,
+        Err(err) => err.into(),
+    }
+}
+
 /// Получение количества подключённых клиентов
 ///
 /// # Parameters
@@ -306,6 +371,28 @@ pub extern "C" fn shm_multi_server_client_count(handle: *const MultiServerHandle
     state.server.client_count()
 }
 
+/// Общая куча блоков сервера (`heap_blocks` в опциях)
+///
+/// # Parameters
+/// - `handle`: Handle сервера
+///
+/// # Returns
+/// Куча для функций `shm_heap_*`, валидна до `shm_multi_server_stop`
+/// (не закрывать через `shm_heap_close`), или NULL, если кучи нет
+#[unsafe(no_mangle)]
+pub extern "C" fn shm_multi_server_heap(
+    handle: *const MultiServerHandle,
+) -> *const SharedHeapHandle {
+    if handle.is_null() {
+        return std::ptr::null();
+    }
+
+    let state = unsafe { &*(handle as *const MultiServerState) };
+    state.server.heap().map_or(std::ptr::null(), |heap| {
+        heap as *const _ as *const SharedHeapHandle
+    })
+}
+
 /// Проверка подключения конкретного клиента
 ///
 /// # Parameters
@@ -327,6 +414,32 @@ pub extern "C" fn shm_multi_server_is_client_connected(
     state.server.is_client_connected(client_id)
 }
 
+/// Телеметрия канала подключённого клиента (считается с его подключения)
+///
+/// # Parameters
+/// - `handle`: Handle сервера
+/// - `client_id`: ID клиента
+/// - `out`: Куда записать статистику
+///
+/// # Returns
+/// false если клиент не подключён или `out` == NULL
+#[unsafe(no_mangle)]
+pub extern "C" fn shm_multi_server_client_stats(
+    handle: *const MultiServerHandle,
+    client_id: u32,
+    out: *mut shm_channel_stats_t,
+) -> bool {
+    if handle.is_null() {
+        return false;
+    }
+
+    let state = unsafe { &*(handle as *const MultiServerState) };
+    match state.server.client_stats(client_id) {
+        Some(stats) => write_channel_stats(out, stats),
+        None => false,
+    }
+}
+
 /// Получение списка подключённых клиентов
 ///
 /// # Parameters
@@ -466,6 +579,7 @@ pub struct shm_multi_client_callbacks_t {
     /// Вызывается при получении сообщения от сервера
     pub on_message: Option<extern "C" fn(data: *const c_void, size: u32, user_data: *mut c_void)>,
     /// Вызывается при переполнении внутренней send-очереди (`max_send_queue`)
+    /// или при отставании от общего кольца рассылки
     pub on_overflow: Option<extern "C" fn(dropped: u32, user_data: *mut c_void)>,
     /// Вызывается при ошибке
     pub on_error: Option<extern "C" fn(error: shm_error_t, user_data: *mut c_void)>,
@@ -630,7 +744,7 @@ pub extern "C" fn shm_multi_client_send(
     data: *const c_void,
     size: u32,
 ) -> shm_error_t {
-    if handle.is_null() || data.is_null() || size == 0 || size as usize > MAX_MESSAGE_SIZE {
+    if handle.is_null() || data.is_null() || size == 0 {
         return shm_error_t::SHM_ERROR_INVALID_PARAM;
     }
 
@@ -23,35 +23,57 @@
 //!
 //! N клиентов подключаются ПОЛНОСТЬЮ КОНКУРЕНТНО: CAS на разной памяти,
 //! без общего состояния, без coalescing событий, без коллизий слотов.
+//!
+//! Слоты обслуживаются шардами по `SLOTS_PER_WAITER`: у каждого шарда свой
+//! поток-waiter со своим `NtWaitForMultipleObjects` (предел 64 хендла на
+//! вызов), поэтому один сервер держит до `MAX_MULTI_CLIENTS` клиентов, и
+//! каждый из них будится событием, а не опросом.
+//!
+//! Смерть клиента тоже видна по событию: на handshake сервер открывает
+//! handle процесса-владельца слота и ждёт его вместе с событиями слота.
 
 mod ffi;
 
 pub use ffi::*;
 
-use std::sync::atomic::{AtomicBool, AtomicU32, Ordering};
+use std::ops::Range;
+use std::sync::atomic::{AtomicBool, AtomicU32, AtomicU64, Ordering};
 use std::sync::{Arc, Mutex, RwLock};
 use std::thread::{self, JoinHandle};
 use std::time::{Duration, Instant};
 
+use crate::broadcast::{BroadcastReceiver, BroadcastSender};
 use crate::client::SharedClient;
 use crate::constants::{
     CLAIM_FREE, HANDSHAKE_CLIENT_HELLO, HANDSHAKE_SERVER_READY, MAX_MESSAGE_SIZE,
     RESERVED_CLAIM_INDEX, RESERVED_OWNER_PID_INDEX, SHARED_MAGIC, SHARED_VERSION, SLOT_ID_NO_SLOT,
 };
 use crate::error::{Result, ShmError};
+use crate::heap::{HeapOptions, SharedHeap};
+use crate::layout::ChannelGeometry;
 use crate::naming::mapping_name;
+use crate::ring::MessageBatch;
+use crate::sched::{self, Intake, DEFAULT_CLIENT_WEIGHT};
 use crate::server::SharedServer;
 use crate::shared::SharedView;
+use crate::stats::{ChannelStats, ChannelStatsSnapshot};
+use crate::trace;
+use crate::wait::WaitStrategy;
 use crate::wait_delay;
 use crate::win::{self, Mapping};
 
 /// Максимальное количество клиентов по умолчанию
 pub const DEFAULT_MAX_CLIENTS: u32 = 20;
 
-/// Жёсткий предел: NtWaitForMultipleObjects поддерживает максимум 64 хендла.
-/// worker ждёт до 2 хендлов на подключённый слот => 2*N <= 64 => N <= 32;
-/// берём 31 с запасом.
-pub const MAX_MULTI_CLIENTS: u32 = 31;
+/// Слотов на один поток-waiter: NtWaitForMultipleObjects поддерживает
+/// максимум 64 хендла, worker ждёт до 3 хендлов на подключённый слот
+/// (данные, disconnect, процесс-владелец) => 3*N <= 64 => N <= 21.
+pub const SLOTS_PER_WAITER: u32 = 21;
+
+/// Жёсткий предел слотов одного `MultiServer` (`ceil(N / SLOTS_PER_WAITER)`
+/// потоков-waiter-ов). Клиент при захвате перебирает слоты по порядку, так
+/// что предел защищает и от бесконечного перебора.
+pub const MAX_MULTI_CLIENTS: u32 = 1024;
 
 /// Таймаут, после которого «зависшая» резервация слота освобождается
 /// (клиент получил slot_id, но не подключился к слоту).
@@ -69,9 +91,16 @@ const RESERVE_SAFETY_MARGIN: Duration = Duration::from_secs(2);
 /// Throttle для liveness-проверки процесса-владельца connected-слота
 /// (`NtOpenProcess` + `NtWaitForSingleObject`) — не на каждой итерации
 /// worker loop (которая крутится с интервалом `poll_timeout`, по умолчанию
-/// 50мс), а не чаще этого периода.
+/// 50мс), а не чаще этого периода. Только для слотов без `ClientSlot::owner`
+/// — остальные узнают о смерти клиента из набора ожидания.
 const LIVENESS_CHECK_INTERVAL: Duration = Duration::from_secs(3);
 
+/// Как часто waiter проходит `reclaim_stale_claims`. Пороги внутри — секунды
+/// (`RESERVE_TIMEOUT`, `LIVENESS_CHECK_INTERVAL`), так что делать это на
+/// каждом проходе, под потоком данных, незачем: обход блокирует все слоты
+/// шарда.
+const RECLAIM_INTERVAL: Duration = Duration::from_millis(100);
+
 /// Callback-интерфейс для обработки событий мультиклиентного сервера
 pub trait MultiHandler: Send + Sync + 'static {
     /// Вызывается при подключении нового клиента
@@ -100,8 +129,10 @@ pub trait MultiClientHandler: Send + Sync + 'static {
     /// Вызывается при получении сообщения от сервера
     fn on_message(&self, data: &[u8]);
 
-    /// Вызывается при переполнении внутренней send-очереди (`max_send_queue`):
-    /// `dropped` — сколько старых неотправленных сообщений вытеснено новыми.
+    /// Вызывается при потере сообщений: `dropped` старых неотправленных
+    /// вытеснено новыми из внутренней send-очереди (`max_send_queue`), либо
+    /// клиент отстал от рассылки сервера (`MultiOptions::broadcast_capacity`)
+    /// и `dropped` сообщений рассылки пропущено.
     fn on_overflow(&self, _dropped: u32) {}
 
     /// Вызывается при ошибке
@@ -113,12 +144,39 @@ pub trait MultiClientHandler: Send + Sync + 'static {
 /// Опции для MultiServer
 #[derive(Clone)]
 pub struct MultiOptions {
-    /// Максимальное количество одновременных клиентов
+    /// Максимальное количество одновременных клиентов. Больше
+    /// `SLOTS_PER_WAITER` — несколько потоков-waiter-ов, и callbacks
+    /// `MultiHandler` для клиентов разных шардов приходят из разных потоков
+    /// (для одного клиента — всегда из одного).
     pub max_clients: u32,
     /// Таймаут ожидания событий в worker loop
     pub poll_timeout: Duration,
     /// Количество сообщений для обработки за один цикл
     pub recv_batch: usize,
+    /// Бюджет времени на ход слота (пачка вместе с `on_message`). Ненулевой
+    /// — worker подбирает пачку по стоимости сообщения, не больше
+    /// `recv_batch` × вес клиента (`set_client_weight`). 0 — фиксированная
+    /// пачка.
+    pub recv_budget: Duration,
+    /// Геометрия колец каждого слота (по умолчанию 2 МБ в каждую сторону —
+    /// при десятках слотов имеет смысл уменьшить).
+    pub geometry: ChannelGeometry,
+    /// Как worker ждёт данные. Активная фаза крутится сразу по всем
+    /// подключённым слотам; connect/disconnect обслуживаются после неё.
+    pub wait: WaitStrategy,
+    /// Ёмкость общего кольца рассылки (байты, степень двойки; должно
+    /// вмещать два сообщения `geometry.max_message_size`). Ненулевая —
+    /// `broadcast` пишет сообщение один раз в секцию `{base_name}_BCAST`,
+    /// которую клиенты читают каждый своим курсором, вместо копии в кольцо
+    /// каждого слота; отставшие больше чем на ёмкость теряют старые
+    /// сообщения (`MultiClientHandler::on_overflow`). 0 — прежняя рассылка
+    /// по кольцам слотов.
+    pub broadcast_capacity: usize,
+    /// Общая куча блоков `{base_name}_HEAP` для крупных payload-ов
+    /// (`MultiServer::heap`): payload пишется в блок один раз, а клиентам
+    /// уходит только его `HeapHandle`. Память секции — как у слотов
+    /// (`geometry.memory`). `blocks == 0` — кучи нет.
+    pub heap: HeapOptions,
 }
 
 impl Default for MultiOptions {
@@ -127,6 +185,11 @@ impl Default for MultiOptions {
             max_clients: DEFAULT_MAX_CLIENTS,
             poll_timeout: Duration::from_millis(50),
             recv_batch: 32,
+            recv_budget: Duration::ZERO,
+            geometry: ChannelGeometry::default(),
+            wait: WaitStrategy::default(),
+            broadcast_capacity: 0,
+            heap: HeapOptions::default(),
         }
     }
 }
@@ -171,6 +234,12 @@ struct ClientSlot {
     ///   (throttle, чтобы не дёргать `NtOpenProcess` на каждой итерации
     ///   worker loop — см. `LIVENESS_CHECK_INTERVAL`).
     claim_seen_at: Option<Instant>,
+    /// Handle процесса-владельца, открытый на handshake; стоит в наборе
+    /// ожидания шарда и сигналит о завершении клиента. `None` — открыть не
+    /// удалось (нет прав, PID уже не тот), тогда работает опрос по PID.
+    /// `Arc` — набор ожидания держит свою ссылку, и handle не закроется,
+    /// пока его raw-значение ещё может ждать `NtWaitForMultipleObjects`.
+    owner: Option<Arc<win::ProcessHandle>>,
 }
 
 /// Мультиклиентный сервер.
@@ -188,7 +257,23 @@ pub struct MultiServer {
     slots: RwLock<Vec<Mutex<ClientSlot>>>,
     max_clients: u32,
     running: Arc<AtomicBool>,
+    /// Waiter шарда 0; остальные шарды он джойнит перед выходом, так что
+    /// завершение этого потока означает завершение всех.
     worker_handle: Mutex<Option<JoinHandle<()>>>,
+    /// Растёт при каждом изменении `connected` любого слота; waiter-ы
+    /// сравнивают её со своей копией и только тогда перестраивают набор
+    /// ожидания.
+    wait_epoch: AtomicU64,
+    /// Кольцо рассылки; `None` при `broadcast_capacity == 0`.
+    fanout: Option<Mutex<BroadcastSender>>,
+    /// Куча блоков; `None` при `heap.blocks == 0`.
+    heap: Option<SharedHeap>,
+    /// Статистика каналов по слотам (подключена к кольцам `SharedServer`
+    /// слота): читается без блокировок слотов.
+    slot_stats: Vec<Arc<ChannelStats>>,
+    /// Веса клиентов по слотам (`set_client_weight`); сбрасываются на
+    /// подключении.
+    slot_weights: Vec<AtomicU32>,
     handler: Arc<dyn MultiHandler>,
     options: MultiOptions,
 }
@@ -202,25 +287,51 @@ impl MultiServer {
     ) -> Result<Arc<Self>> {
         if options.max_clients == 0 || options.max_clients > MAX_MULTI_CLIENTS {
             return Err(ShmError::InvalidConfig(
-                "max_clients must be in 1..=31 (NtWaitForMultipleObjects limit)",
+                "max_clients must be in 1..=MAX_MULTI_CLIENTS",
             ));
         }
 
         let running = Arc::new(AtomicBool::new(true));
 
+        // Секцию рассылки создаём до слотов: клиент открывает её перед
+        // handshake и не должен её не застать.
+        let fanout = match options.broadcast_capacity {
+            0 => None,
+            capacity => Some(Mutex::new(BroadcastSender::create(
+                base_name,
+                capacity,
+                options.geometry.max_message_size,
+                &options.geometry.memory,
+            )?)),
+        };
+
+        let heap = match options.heap.blocks {
+            0 => None,
+            _ => Some(SharedHeap::create(
+                base_name,
+                &options.heap,
+                &options.geometry.memory,
+            )?),
+        };
+
         // Создаём N независимых сегментов-слотов. Lobby не нужен — клиенты
         // захватывают слоты сами через атомарный claim (см. doc MultiServer).
         let slots: RwLock<Vec<Mutex<ClientSlot>>> = RwLock::new(Vec::new());
+        let mut slot_stats = Vec::with_capacity(options.max_clients as usize);
         {
             let mut slots_guard = slots.write().unwrap();
             for slot_id in 0..options.max_clients {
                 let channel_name = format!("{}_{}", base_name, slot_id);
-                let server = SharedServer::start(&channel_name)?;
+                let mut server = SharedServer::start_with(&channel_name, &options.geometry)?;
+                let stats = Arc::new(ChannelStats::default());
+                server.set_stats(stats.clone());
+                slot_stats.push(stats);
                 slots_guard.push(Mutex::new(ClientSlot {
                     id: slot_id,
                     server,
                     connected: false,
                     claim_seen_at: None,
+                    owner: None,
                 }));
             }
         }
@@ -231,18 +342,53 @@ impl MultiServer {
             max_clients: options.max_clients,
             running,
             worker_handle: Mutex::new(None),
+            wait_epoch: AtomicU64::new(0),
+            fanout,
+            heap,
+            slot_stats,
+            slot_weights: (0..options.max_clients)
+                .map(|_| AtomicU32::new(DEFAULT_CLIENT_WEIGHT))
+                .collect(),
             handler,
             options,
         });
 
-        // Запускаем worker thread
+        // Waiter-ы шардов 1..; шард 0 обслуживает основной worker и
+        // джойнит остальные при выходе.
+        let mut shards = shard_ranges(server.max_clients);
+        let first_shard = shards.next().unwrap_or(0..0);
+        let mut shard_handles = Vec::new();
+        for (index, shard) in shards.enumerate() {
+            let server_clone = server.clone();
+            match thread::Builder::new()
+                .name(format!("xshm-multi-{}-{}", base_name, index + 1))
+                .spawn(move || server_clone.worker_loop(shard))
+            {
+                Ok(handle) => shard_handles.push(handle),
+                Err(e) => {
+                    server.running.store(false, Ordering::Release);
+                    for handle in shard_handles {
+                        let _ = handle.join();
+                    }
+                    return Err(map_spawn_error(e));
+                }
+            }
+        }
+
         let server_clone = server.clone();
         let handle = thread::Builder::new()
             .name(format!("xshm-multi-{}", base_name))
-            .spawn(move || server_clone.worker_loop())
-            .map_err(|e| ShmError::WindowsError {
-                code: e.raw_os_error().unwrap_or(-1) as u32,
-                context: "spawn multi worker",
+            .spawn(move || {
+                server_clone.worker_loop(first_shard);
+                for handle in shard_handles {
+                    let _ = handle.join();
+                }
+            })
+            .map_err(|e| {
+                // Замыкание с handle-ами уже дропнуто — остальные waiter-ы
+                // сами выйдут по флагу.
+                server.running.store(false, Ordering::Release);
+                map_spawn_error(e)
             })?;
 
         *server.worker_handle.lock().unwrap() = Some(handle);
@@ -266,8 +412,17 @@ impl MultiServer {
         Ok(())
     }
 
-    /// Отправка сообщения всем подключённым клиентам
+    /// Отправка сообщения всем подключённым клиентам.
+    ///
+    /// С кольцом рассылки (`broadcast_capacity`) payload копируется один раз,
+    /// а слотам только сигналится data-событие; возвращается число
+    /// разбуженных клиентов.
     pub fn broadcast(&self, data: &[u8]) -> Result<u32> {
+        if let Some(fanout) = &self.fanout {
+            fanout.lock().unwrap().publish(data)?;
+            return Ok(self.notify_connected());
+        }
+
         let slots = self.slots.read().unwrap();
         let mut sent_count = 0u32;
 
@@ -281,6 +436,18 @@ impl MultiServer {
         Ok(sent_count)
     }
 
+    /// Будит всех подключённых клиентов, не трогая их кольца.
+    fn notify_connected(&self) -> u32 {
+        let slots = self.slots.read().unwrap();
+        slots
+            .iter()
+            .filter(|slot_mutex| {
+                let slot = slot_mutex.lock().unwrap();
+                slot.connected && slot.server.notify_client().is_ok()
+            })
+            .count() as u32
+    }
+
     /// Принудительное отключение клиента
     pub fn disconnect_client(&self, client_id: u32) -> Result<()> {
         let slots = self.slots.read().unwrap();
@@ -292,6 +459,7 @@ impl MultiServer {
         if slot.connected {
             slot.connected = false;
             slot.claim_seen_at = None;
+            slot.owner = None;
             // Сигналим клиенту об отключении, сбрасываем состояние слота, затем
             // освобождаем claim -> слот снова доступен для захвата.
             if let Some(events) = slot.server.events() {
@@ -300,7 +468,9 @@ impl MultiServer {
             slot.server.mark_disconnected();
             Self::release_slot_claim(&slot);
             drop(slot);
+            self.slots_changed();
             self.handler.on_client_disconnect(client_id);
+            trace::disconnected(&self.base_name, client_id);
         }
 
         Ok(())
@@ -331,6 +501,31 @@ impl MultiServer {
             .count() as u32
     }
 
+    /// Статистика канала подключённого клиента: кольцо сервер→клиент,
+    /// задержка доставки от клиента, пробуждения, пачки и время `on_message`.
+    /// Считается с момента подключения клиента к слоту; `None` — клиент не
+    /// подключён.
+    pub fn client_stats(&self, client_id: u32) -> Option<ChannelStatsSnapshot> {
+        if !self.is_client_connected(client_id) {
+            return None;
+        }
+        self.slot_stats
+            .get(client_id as usize)
+            .map(|stats| stats.snapshot())
+    }
+
+    /// Вес клиента в круговом обходе слотов шарда (1..=`MAX_CLIENT_WEIGHT`,
+    /// по умолчанию 1): за ход клиент отдаёт до `weight` пачек. Вес живёт до
+    /// отключения клиента.
+    pub fn set_client_weight(&self, client_id: u32, weight: u32) -> Result<()> {
+        let weight = sched::check_weight(weight)?;
+        if !self.is_client_connected(client_id) {
+            return Err(ShmError::NotConnected);
+        }
+        self.slot_weights[client_id as usize].store(weight, Ordering::Relaxed);
+        Ok(())
+    }
+
     /// Проверка подключения конкретного клиента
     pub fn is_client_connected(&self, client_id: u32) -> bool {
         let slots = self.slots.read().unwrap();
@@ -364,6 +559,12 @@ impl MultiServer {
         &self.base_name
     }
 
+    /// Куча блоков сервера (`MultiOptions::heap`); клиенты открывают её
+    /// через `SharedHeap::open(base_name)`.
+    pub fn heap(&self) -> Option<&SharedHeap> {
+        self.heap.as_ref()
+    }
+
     /// Получение имени канала для конкретного слота
     pub fn channel_name(&self, slot_id: u32) -> Option<String> {
         if slot_id < self.max_clients {
@@ -392,7 +593,8 @@ impl MultiServer {
     ///   такой слот был бы потерян НАВСЕГДА: от мёртвого процесса не придёт
     ///   ни данных, ни disconnect-события, а claim!=FREE означало бы «живой»
     ///   для остальной логики. Проверяется не чаще `LIVENESS_CHECK_INTERVAL`
-    ///   (throttle — `NtOpenProcess` дороже atomic load).
+    ///   (throttle — `NtOpenProcess` дороже atomic load) и только у слотов
+    ///   без `owner`: с ним смерть видна сразу (`handle_owner_exit`).
     ///
     /// В обоих connected-случаях слот никогда не получит данные/disconnect
     /// сам по себе, поэтому форсированно отключаем его.
@@ -410,10 +612,10 @@ impl MultiServer {
     /// `slot_timeout` всегда клампится ниже `RESERVE_TIMEOUT`, иначе сервер
     /// мог бы отнять слот у легитимно подключающегося клиента.
     #[must_use]
-    fn reclaim_stale_claims(&self) -> Vec<(u32, u32)> {
+    fn reclaim_stale_claims(&self, shard: Range<usize>) -> Vec<(u32, u32)> {
         let mut orphaned = Vec::new();
         let slots = self.slots.read().unwrap();
-        for slot_mutex in slots.iter() {
+        for slot_mutex in &slots[shard] {
             let mut slot = slot_mutex.lock().unwrap();
             let claim = slot.server.view().control_block().reserved[RESERVED_CLAIM_INDEX]
                 .load(Ordering::Acquire);
@@ -422,6 +624,9 @@ impl MultiServer {
                     orphaned.push((slot.id, CLAIM_FREE)); // abandoned-handshake
                     continue;
                 }
+                if slot.owner.is_some() {
+                    continue; // процесс-владелец в наборе ожидания
+                }
                 // Живой claim на connected-слоте: троттлим liveness-проверку
                 // процесса-владельца вместо детекции по событиям (их не будет,
                 // если процесс мёртв).
@@ -460,59 +665,58 @@ impl MultiServer {
         orphaned
     }
 
-    /// Worker loop — обслуживает слоты (захват / данные / отключение).
-    fn worker_loop(&self) {
-        let mut buffer = Vec::with_capacity(MAX_MESSAGE_SIZE);
+    /// Worker loop — обслуживает слоты шарда (захват / данные / отключение).
+    fn worker_loop(&self, shard: Range<usize>) {
+        let mut intake = Intake::new(self.options.recv_batch, self.options.recv_budget);
+        let mut wait_set = ShardWaitSet::default();
+        // Слоты, у которых после прошлой пачки остались сообщения: их кольцо
+        // повторно не просигналит (событие ставится только на переходе из
+        // пустого), поэтому пока список не пуст, на событиях не блокируемся.
+        let mut hot: Vec<u32> = Vec::new();
+        let mut last_reclaim: Option<Instant> = None;
 
         while self.running.load(Ordering::Acquire) {
-            // Освобождаем «зависшие» захваты и осиротевшие слоты в начале каждой
-            // итерации. Отключение осиротевших — вне блокировок (handler без lock-а).
-            for (slot_id, expected_claim) in self.reclaim_stale_claims() {
-                self.handle_orphaned_slot_disconnect(slot_id, expected_claim);
+            // Освобождаем «зависшие» захваты и осиротевшие слоты не чаще
+            // RECLAIM_INTERVAL. Отключение осиротевших — вне блокировок
+            // (handler без lock-а).
+            if last_reclaim.map_or(true, |at| at.elapsed() >= RECLAIM_INTERVAL) {
+                last_reclaim = Some(Instant::now());
+                for (slot_id, expected_claim) in self.reclaim_stale_claims(shard.clone()) {
+                    self.handle_orphaned_slot_disconnect(slot_id, expected_claim);
+                }
             }
 
-            // Собираем handles для ожидания
-            let mut wait_handles: Vec<isize> = Vec::new();
-            let mut handle_to_event: Vec<EventSource> = Vec::new();
+            self.refresh_wait_set(&shard, &mut wait_set);
 
-            // Слоты
-            {
-                let slots = self.slots.read().unwrap();
-                for slot_mutex in slots.iter() {
-                    let slot = slot_mutex.lock().unwrap();
-                    // Anonymous режим не поддерживается в multi-mode
-                    let events = slot
-                        .server
-                        .events()
-                        .expect("Anonymous mode not supported in multi-mode");
-
-                    if slot.connected {
-                        // Данные от клиента
-                        wait_handles.push(events.c2s.data.raw_handle());
-                        handle_to_event.push(EventSource::SlotData(slot.id));
-
-                        // Disconnect
-                        wait_handles.push(events.disconnect.raw_handle());
-                        handle_to_event.push(EventSource::SlotDisconnect(slot.id));
-                    } else {
-                        // Ожидаем connect_req на слоте (клиент захватил слот и подключается)
-                        wait_handles.push(events.connect_req.raw_handle());
-                        handle_to_event.push(EventSource::SlotConnect(slot.id));
-                    }
+            // Данные, дождавшиеся в активной фазе, забираем сразу, а события
+            // (connect/disconnect) только опрашиваем без блокировки — иначе
+            // под постоянным потоком данных они бы не обслуживались.
+            let busy = if hot.is_empty() {
+                let spun = self.spin_wait_slots(&shard);
+                if spun {
+                    self.poll_slots(&wait_set.connected, &mut intake, &mut hot);
                 }
-            }
+                spun
+            } else {
+                // По одной пачке с каждого — занятый слот не отнимает весь
+                // проход у остальных.
+                let pending = std::mem::take(&mut hot);
+                self.poll_slots(&pending, &mut intake, &mut hot);
+                true
+            };
+            let timeout = if busy {
+                Duration::ZERO
+            } else {
+                self.options.poll_timeout
+            };
 
             // Ожидаем любое событие
-            match win::wait_any(&wait_handles, Some(self.options.poll_timeout)) {
-                Ok(Some(index)) => {
-                    if index < handle_to_event.len() {
-                        self.handle_event(&handle_to_event[index], &mut buffer);
-                    }
-                }
+            match win::wait_any(&wait_set.handles, Some(timeout)) {
+                Ok(Some(index)) => self.drain_signaled(&wait_set, index, &mut intake, &mut hot),
+                Ok(None) if busy => {}
                 Ok(None) => {
-                    // Timeout — собираем данные со всех слотов (reclaim уже
-                    // выполнен в начале итерации).
-                    self.poll_all_slots(&mut buffer);
+                    // Timeout — собираем данные со всех подключённых слотов.
+                    self.poll_slots(&wait_set.connected, &mut intake, &mut hot);
                 }
                 Err(err) => {
                     self.handler.on_error(None, err);
@@ -521,12 +725,87 @@ impl MultiServer {
         }
     }
 
+    /// Перестраивает набор ожидания шарда, только если с прошлой сборки
+    /// менялось `connected` какого-либо слота.
+    fn refresh_wait_set(&self, shard: &Range<usize>, wait_set: &mut ShardWaitSet) {
+        // Эпоха читается ДО обхода: изменение во время сборки поднимет её
+        // ещё раз, и набор перестроится на следующей итерации.
+        let epoch = self.wait_epoch.load(Ordering::Acquire);
+        if wait_set.epoch == Some(epoch) {
+            return;
+        }
+        wait_set.epoch = Some(epoch);
+        wait_set.handles.clear();
+        wait_set.sources.clear();
+        wait_set.connected.clear();
+        wait_set.owners.clear();
+
+        let slots = self.slots.read().unwrap();
+        for slot_mutex in &slots[shard.clone()] {
+            let slot = slot_mutex.lock().unwrap();
+            // Anonymous режим не поддерживается в multi-mode
+            let events = slot
+                .server
+                .events()
+                .expect("Anonymous mode not supported in multi-mode");
+
+            if slot.connected {
+                // Данные от клиента
+                wait_set.handles.push(events.c2s.data.raw_handle());
+                wait_set.sources.push(EventSource::SlotData(slot.id));
+
+                // Disconnect
+                wait_set.handles.push(events.disconnect.raw_handle());
+                wait_set.sources.push(EventSource::SlotDisconnect(slot.id));
+
+                // Завершение процесса-владельца
+                if let Some(owner) = &slot.owner {
+                    wait_set.handles.push(owner.raw_handle());
+                    wait_set.sources.push(EventSource::SlotOwnerExit(slot.id));
+                    wait_set.owners.push(owner.clone());
+                }
+                wait_set.connected.push(slot.id);
+            } else {
+                // Ожидаем connect_req на слоте (клиент захватил слот и подключается)
+                wait_set.handles.push(events.connect_req.raw_handle());
+                wait_set.sources.push(EventSource::SlotConnect(slot.id));
+            }
+        }
+    }
+
+    /// Обрабатывает `first` и все остальные сработавшие события набора.
+    /// `NtWaitForMultipleObjects` возвращает наименьший сигнальный индекс,
+    /// поэтому хвост после него доопрашивается с нулевым таймаутом — иначе
+    /// занятый слот с малым индексом заслонял бы все последующие.
+    fn drain_signaled(
+        &self,
+        wait_set: &ShardWaitSet,
+        first: usize,
+        intake: &mut Intake,
+        hot: &mut Vec<u32>,
+    ) {
+        let mut index = first;
+        while let Some(source) = wait_set.sources.get(index) {
+            self.handle_event(source, intake, hot);
+            let next = index + 1;
+            match win::wait_any(&wait_set.handles[next..], Some(Duration::ZERO)) {
+                Ok(Some(offset)) => index = next + offset,
+                _ => break,
+            }
+        }
+    }
+
     /// Обработка события
-    fn handle_event(&self, source: &EventSource, buffer: &mut Vec<u8>) {
-        match source {
-            EventSource::SlotConnect(slot_id) => self.handle_slot_connect(*slot_id),
-            EventSource::SlotData(slot_id) => self.receive_from_slot(*slot_id, buffer),
-            EventSource::SlotDisconnect(slot_id) => self.handle_slot_disconnect(*slot_id),
+    fn handle_event(&self, source: &EventSource, intake: &mut Intake, hot: &mut Vec<u32>) {
+        match *source {
+            EventSource::SlotConnect(slot_id) => self.handle_slot_connect(slot_id),
+            EventSource::SlotData(slot_id) => {
+                if self.receive_from_slot(slot_id, intake, true) && !hot.contains(&slot_id) {
+                    hot.push(slot_id);
+                }
+            }
+            EventSource::SlotDisconnect(slot_id) => self.handle_slot_disconnect(slot_id),
+            EventSource::SlotOwnerExit(slot_id) => self.handle_owner_exit(slot_id),
         }
     }
 
@@ -543,12 +822,21 @@ impl MultiServer {
             // Выполняем handshake
             match Self::do_slot_handshake(&mut slot.server) {
                 Ok(()) => {
+                    self.slot_stats[slot_id as usize].reset();
+                    self.slot_weights[slot_id as usize]
+                        .store(DEFAULT_CLIENT_WEIGHT, Ordering::Relaxed);
                     slot.connected = true;
                     slot.claim_seen_at = None;
+                    let owner_pid = slot.server.view().control_block().reserved
+                        [RESERVED_OWNER_PID_INDEX]
+                        .load(Ordering::Acquire);
+                    slot.owner = win::ProcessHandle::open(owner_pid).ok().map(Arc::new);
                     let id = slot.id;
                     drop(slot);
                     drop(slots);
+                    self.slots_changed();
                     self.handler.on_client_connect(id);
+                    trace::connected(&self.base_name, id);
                 }
                 Err(_) => {
                     // Handshake не удался — освобождаем claim, чтобы слот снова
@@ -582,6 +870,7 @@ impl MultiServer {
             (&*view.ring_header_a()).reset(new_generation);
             (&*view.ring_header_b()).reset(new_generation);
         }
+        view.reset_extra_lanes(new_generation);
 
         control.generation.store(new_generation, Ordering::Release);
 
@@ -625,6 +914,7 @@ impl MultiServer {
                 let was = slot.connected;
                 slot.connected = false;
                 slot.claim_seen_at = None;
+                slot.owner = None;
                 slot.server.mark_disconnected();
                 // Освобождаем claim -> слот снова доступен для захвата.
                 Self::release_slot_claim(&slot);
@@ -635,7 +925,9 @@ impl MultiServer {
         };
 
         if was_connected {
+            self.slots_changed();
             self.handler.on_client_disconnect(slot_id);
+            trace::disconnected(&self.base_name, slot_id);
         }
     }
 
@@ -679,74 +971,153 @@ impl MultiServer {
             // им) -- освобождать его повторно не нужно.
             slot.connected = false;
             slot.claim_seen_at = None;
+            slot.owner = None;
             slot.server.mark_disconnected();
             true
         };
 
         if was_connected {
+            self.slots_changed();
             self.handler.on_client_disconnect(slot_id);
+            trace::disconnected(&self.base_name, slot_id);
         }
     }
 
-    /// Получение сообщений от слота (batch)
-    fn receive_from_slot(&self, slot_id: u32, buffer: &mut Vec<u8>) {
-        // Собираем все сообщения под lock-ом
-        let mut messages: Vec<Vec<u8>> = Vec::new();
+    /// Завершился процесс-владелец connected-слота (его handle сработал в
+    /// наборе ожидания). Клиент упал, не освободив claim, — отключаем слот
+    /// сразу, как осиротевший, с его текущим claim в качестве ожидаемого.
+    ///
+    /// Событие из набора ожидания могло устареть (слот уже отключён или
+    /// разобран другим путём), поэтому завершение перепроверяется по
+    /// текущему `owner`. Сработавший handle снимается со слота: он остаётся
+    /// сигнальным навсегда и иначе будил бы waiter до перестройки набора.
+    fn handle_owner_exit(&self, slot_id: u32) {
+        let expected_claim = {
+            let slots = self.slots.read().unwrap();
+            let Some(slot_mutex) = slots.get(slot_id as usize) else {
+                return;
+            };
+            let mut slot = slot_mutex.lock().unwrap();
+            let exited = match &slot.owner {
+                Some(owner) => owner.has_exited(),
+                None => false,
+            };
+            if !slot.connected || !exited {
+                return;
+            }
+            slot.owner = None;
+            slot.server.view().control_block().reserved[RESERVED_CLAIM_INDEX]
+                .load(Ordering::Acquire)
+        };
+        self.slots_changed();
+        self.handle_orphaned_slot_disconnect(slot_id, expected_claim);
+    }
+
+    /// Получение сообщений от слота (batch). `true` — пачка заполнена до
+    /// хода слота (`recv_batch` × вес, с `recv_budget` — по бюджету), в
+    /// кольце могут остаться сообщения. `woken` — чтение по data-событию
+    /// слота (для счёта ложных пробуждений).
+    fn receive_from_slot(&self, slot_id: u32, intake: &mut Intake, woken: bool) -> bool {
+        let Intake { batch, sizer } = intake;
+        let weight = self.slot_weights.get(slot_id as usize);
+        let quantum =
+            sizer.quantum(weight.map_or(DEFAULT_CLIENT_WEIGHT, |w| w.load(Ordering::Relaxed)));
+        let started = sizer.begin();
+        // Забираем пачку под lock-ом: одна арена и один сдвиг read_pos, без
+        // аллокации на сообщение
+        batch.clear();
         let mut error: Option<ShmError> = None;
+        let mut more_pending = false;
 
         {
             let slots = self.slots.read().unwrap();
             if let Some(slot_mutex) = slots.get(slot_id as usize) {
                 let slot = slot_mutex.lock().unwrap();
                 if !slot.connected {
-                    return;
+                    return false;
                 }
 
-                for _ in 0..self.options.recv_batch {
-                    match slot.server.receive_from_client(buffer) {
-                        Ok(len) => {
-                            messages.push(buffer[..len].to_vec());
-                        }
-                        Err(ShmError::QueueEmpty) => break,
-                        Err(err) => {
-                            error = Some(err);
-                            break;
-                        }
-                    }
+                match slot
+                    .server
+                    .receive_batch_from_client(batch, quantum, usize::MAX)
+                {
+                    Ok(count) => more_pending = count >= quantum,
+                    Err(ShmError::QueueEmpty) => {}
+                    Err(err) => error = Some(err),
                 }
             }
         }
 
         // Отдаём handler-у без lock-а
-        for data in &messages {
-            self.handler.on_message(slot_id, data);
+        if let Some(stats) = self.slot_stats.get(slot_id as usize) {
+            if woken {
+                stats.record_wakeup(batch.is_empty());
+            }
+            if !batch.is_empty() {
+                stats.record_batch(batch.len());
+                stats.time_handler(|| {
+                    for data in batch.iter() {
+                        self.handler.on_message(slot_id, data);
+                    }
+                });
+            }
         }
+        sizer.finish(started, batch.len());
 
         if let Some(err) = error {
             self.handler.on_error(Some(slot_id), err);
         }
+        more_pending
     }
 
-    /// Проверка всех слотов на данные
-    fn poll_all_slots(&self, buffer: &mut Vec<u8>) {
-        let slot_ids: Vec<u32> = {
-            let slots = self.slots.read().unwrap();
-            slots
-                .iter()
-                .filter_map(|slot_mutex| {
-                    let slot = slot_mutex.lock().unwrap();
-                    if slot.connected {
-                        Some(slot.id)
-                    } else {
-                        None
-                    }
-                })
-                .collect()
-        };
+    /// Пачка с каждого слота из `slot_ids`; недочитанные попадают в `hot`.
+    fn poll_slots(&self, slot_ids: &[u32], intake: &mut Intake, hot: &mut Vec<u32>) {
+        for &slot_id in slot_ids {
+            if self.receive_from_slot(slot_id, intake, false) && !hot.contains(&slot_id) {
+                hot.push(slot_id);
+            }
+        }
+    }
+
+    /// Подключённость какого-то слота изменилась — waiter-ы перестроят
+    /// наборы ожидания.
+    fn slots_changed(&self) {
+        self.wait_epoch.fetch_add(1, Ordering::Release);
+    }
 
-        for slot_id in slot_ids {
-            self.receive_from_slot(slot_id, buffer);
+    /// Активная фаза ожидания (`MultiOptions::wait`) по всем подключённым
+    /// слотам шарда. `true` — у какого-то слота есть данные (флаги `spinning`
+    /// остаются стоять на время обработки); `false` — бюджет исчерпан, флаги
+    /// сняты, и можно блокироваться на событиях.
+    fn spin_wait_slots(&self, shard: &Range<usize>) -> bool {
+        let wait = &self.options.wait;
+        if wait.is_blocking() {
+            return false;
+        }
+        self.any_connected_slot(shard, |server| {
+            server.start_client_spin();
+            false
+        });
+        wait.spin_until(|| self.any_connected_slot(shard, SharedServer::has_client_data))
+            || self.any_connected_slot(shard, SharedServer::stop_client_spin)
+    }
+
+    /// `f` для каждого подключённого слота шарда; `true`, если хоть один вызов
+    /// вернул `true`. Обход не прерывается: снятие флагов должно дойти до всех.
+    fn any_connected_slot(
+        &self,
+        shard: &Range<usize>,
+        mut f: impl FnMut(&SharedServer) -> bool,
+    ) -> bool {
+        let slots = self.slots.read().unwrap();
+        let mut any = false;
+        for slot_mutex in &slots[shard.clone()] {
+            let slot = slot_mutex.lock().unwrap();
+            if slot.connected {
+                any |= f(&slot.server);
+            }
         }
+        any
     }
 }
 
@@ -759,6 +1130,36 @@ impl Drop for MultiServer {
     }
 }
 
+/// Диапазоны слотов по `SLOTS_PER_WAITER` — по одному на поток-waiter.
+fn shard_ranges(max_clients: u32) -> impl Iterator<Item = Range<usize>> {
+    let total = max_clients as usize;
+    let step = SLOTS_PER_WAITER as usize;
+    (0..total)
+        .step_by(step)
+        .map(move |start| start..(start + step).min(total))
+}
+
+fn map_spawn_error(err: std::io::Error) -> ShmError {
+    ShmError::WindowsError {
+        code: err.raw_os_error().unwrap_or(-1) as u32,
+        context: "spawn multi worker",
+    }
+}
+
+/// Кэшированный набор ожидания одного шарда (см. `refresh_wait_set`).
+#[derive(Default)]
+struct ShardWaitSet {
+    /// `wait_epoch`, при которой набор собран; `None` — ещё не собирался.
+    epoch: Option<u64>,
+    handles: Vec<isize>,
+    sources: Vec<EventSource>,
+    /// Подключённые слоты шарда — для опроса по таймауту.
+    connected: Vec<u32>,
+    /// Handle-ы процессов-владельцев из `handles`: держат их открытыми, пока
+    /// набор в ходу, даже если слот уже отключён.
+    owners: Vec<Arc<win::ProcessHandle>>,
+}
+
 /// Источник события для worker loop
 #[derive(Clone, Copy)]
 #[allow(clippy::enum_variant_names)]
@@ -766,6 +1167,7 @@ enum EventSource {
     SlotConnect(u32),
     SlotData(u32),
     SlotDisconnect(u32),
+    SlotOwnerExit(u32),
 }
 
 // ============================================================================
@@ -894,7 +1296,7 @@ fn client_worker(
     running: Arc<AtomicBool>,
     slot_id_out: Arc<AtomicU32>,
 ) {
-    let mut buffer = Vec::with_capacity(MAX_MESSAGE_SIZE);
+    let mut batch = MessageBatch::with_capacity(MAX_MESSAGE_SIZE, options.recv_batch);
 
     let effective_slot_timeout = clamp_slot_timeout(options.slot_timeout);
 
@@ -911,6 +1313,11 @@ fn client_worker(
             }
         };
 
+        // Рассылку открываем ДО handshake: всё, что сервер разошлёт после
+        // того, как посчитает нас подключёнными, уже попадёт к нам. Секции
+        // нет — сервер без рассылки, читаем только кольцо слота.
+        let mut fanout = BroadcastReceiver::open(base_name).ok();
+
         // Шаг 2: подключаемся к захваченному слоту обычным handshake.
         let client = match SharedClient::connect(&slot_name, effective_slot_timeout) {
             Ok(c) => c,
@@ -928,6 +1335,7 @@ fn client_worker(
 
         slot_id_out.store(slot_id, Ordering::Release);
         handler.on_connect(slot_id);
+        trace::connected(base_name, slot_id);
 
         // Шаг 3: Работаем с данными
         // SharedClient всегда использует named events (не anonymous)
@@ -950,6 +1358,7 @@ fn client_worker(
                     ClientCommand::Send(data) => {
                         if push_with_cap(&mut send_queue, data, options.max_send_queue) {
                             handler.on_overflow(1);
+                            trace::overflowed(base_name, slot_id, 1);
                         }
                     }
                     ClientCommand::Shutdown => {
@@ -974,8 +1383,12 @@ fn client_worker(
 
             // Получаем данные
             loop {
-                match client.receive_from_server(&mut buffer) {
-                    Ok(len) => handler.on_message(&buffer[..len]),
+                match client.receive_batch_from_server(&mut batch, options.recv_batch, usize::MAX) {
+                    Ok(_) => {
+                        for data in batch.iter() {
+                            handler.on_message(data);
+                        }
+                    }
                     Err(ShmError::QueueEmpty) => break,
                     Err(err) => {
                         handler.on_error(err);
@@ -983,6 +1396,19 @@ fn client_worker(
                     }
                 }
             }
+            if let Some(receiver) = fanout.as_mut() {
+                if let Err(err) = receive_broadcast(
+                    base_name,
+                    slot_id,
+                    receiver,
+                    &mut batch,
+                    options.recv_batch,
+                    &*handler,
+                ) {
+                    handler.on_error(err);
+                    fanout = None;
+                }
+            }
 
             // Ожидаем события
             match win::wait_any(&handles, Some(options.poll_timeout)) {
@@ -990,6 +1416,7 @@ fn client_worker(
                     // Disconnect
                     slot_id_out.store(SLOT_ID_NO_SLOT, Ordering::Release);
                     handler.on_disconnect();
+                    trace::disconnected(base_name, slot_id);
                     break;
                 }
                 Ok(Some(1)) => {
@@ -1000,6 +1427,7 @@ fn client_worker(
                     handler.on_error(err);
                     slot_id_out.store(SLOT_ID_NO_SLOT, Ordering::Release);
                     handler.on_disconnect();
+                    trace::disconnected(base_name, slot_id);
                     break;
                 }
             }
@@ -1017,6 +1445,34 @@ fn client_worker(
     }
 }
 
+/// Дренирует кольцо рассылки сервера. Ошибка — секция непригодна, дальше
+/// клиент её не читает.
+fn receive_broadcast(
+    base_name: &str,
+    slot_id: u32,
+    receiver: &mut BroadcastReceiver,
+    batch: &mut MessageBatch,
+    recv_batch: usize,
+    handler: &dyn MultiClientHandler,
+) -> Result<()> {
+    loop {
+        match receiver.receive_batch(batch, recv_batch, usize::MAX) {
+            Ok((_, dropped)) => {
+                if dropped > 0 {
+                    let dropped = dropped.min(u32::MAX as u64) as u32;
+                    handler.on_overflow(dropped);
+                    trace::overflowed(base_name, slot_id, dropped);
+                }
+                for data in batch.iter() {
+                    handler.on_message(data);
+                }
+            }
+            Err(ShmError::QueueEmpty) => return Ok(()),
+            Err(err) => return Err(err),
+        }
+    }
+}
+
 /// Процесс-локальный счётчик попыток захвата (гарантирует, что в пределах
 /// одного процесса токены не повторяются, пока живёт процесс).
 static CLAIM_TOKEN_COUNTER: AtomicU32 = AtomicU32::new(1);
@@ -1033,7 +1489,7 @@ static CLAIM_TOKEN_COUNTER: AtomicU32 = AtomicU32::new(1);
 /// сидируется свежей ОС-энтропией — смешивая её с pid и процесс-локальным
 /// счётчиком, получаем токен, практически уникальный и внутри процесса,
 /// и между процессами (в отличие от детерминированной XOR-схемы).
-fn next_claim_token() -> u32 {
+pub(crate) fn next_claim_token() -> u32 {
     use std::collections::hash_map::RandomState;
     use std::hash::{BuildHasher, Hasher};
 
@@ -1053,7 +1509,7 @@ fn next_claim_token() -> u32 {
 /// Пытается атомарно захватить конкретный слот через `compare_exchange`.
 /// `Ok(true)` — захвачено нами; `Ok(false)` — слот занят/невалиден;
 /// `Err(_)` — слота с таким именем не существует (сегмент не открылся).
-fn try_claim_slot(slot_name: &str, token: u32) -> Result<bool> {
+pub(crate) fn try_claim_slot(slot_name: &str, token: u32) -> Result<bool> {
     // Сервер создаёт секцию под именем mapping_name(slot_name) — открываем так же.
     let mapping = Mapping::open(&mapping_name(slot_name))?; // Err => слота нет
     let view = unsafe { SharedView::new(mapping.as_ptr()) };
@@ -1217,6 +1673,85 @@ mod tests {
         assert_eq!(server.client_count(), 0);
     }
 
+    #[test]
+    fn client_weight_requires_connected_slot_and_valid_weight() {
+        let handler = Arc::new(TestHandler::new());
+        let options = MultiOptions {
+            max_clients: 2,
+            ..Default::default()
+        };
+        let server = MultiServer::start("TEST_MULTI_WEIGHT", handler, options).unwrap();
+        assert!(matches!(
+            server.set_client_weight(0, 4),
+            Err(ShmError::NotConnected)
+        ));
+        assert!(matches!(
+            server.set_client_weight(0, 0),
+            Err(ShmError::InvalidConfig(_))
+        ));
+        assert!(matches!(
+            server.set_client_weight(7, 1),
+            Err(ShmError::NotConnected)
+        ));
+        server.stop();
+    }
+
+    #[test]
+    fn shards_cover_slots_within_wait_limit() {
+        let shards: Vec<_> = shard_ranges(70).collect();
+        assert_eq!(shards, vec![0..21, 21..42, 42..63, 63..70]);
+        assert!(shards.iter().all(|shard| 3 * shard.len() <= 64));
+
+        assert_eq!(shard_ranges(1).collect::<Vec<_>>(), vec![0..1]);
+        let last = shard_ranges(MAX_MULTI_CLIENTS).last().unwrap();
+        assert_eq!(last.end, MAX_MULTI_CLIENTS as usize);
+    }
+
+    /// Набор ожидания собирается заново только после `slots_changed`:
+    /// пока подключённость слотов не менялась, повторная сборка — no-op.
+    #[test]
+    fn wait_set_is_rebuilt_only_on_connection_change() {
+        let name = format!("TEST_MULTI_WAIT_SET_{}", std::process::id());
+        let handler = Arc::new(TestHandler::new());
+        let server = MultiServer::start(
+            &name,
+            handler,
+            MultiOptions {
+                max_clients: 2,
+                ..Default::default()
+            },
+        )
+        .expect("start");
+        server.stop();
+
+        let shard = 0..2;
+        let mut wait_set = ShardWaitSet::default();
+        server.refresh_wait_set(&shard, &mut wait_set);
+        assert_eq!(wait_set.handles.len(), 2); // connect_req обоих слотов
+        assert!(wait_set.connected.is_empty());
+
+        server.slots.read().unwrap()[1].lock().unwrap().connected = true;
+        server.refresh_wait_set(&shard, &mut wait_set);
+        assert_eq!(
+            wait_set.handles.len(),
+            2,
+            "без slots_changed набор не трогается"
+        );
+
+        server.slots_changed();
+        server.refresh_wait_set(&shard, &mut wait_set);
+        assert_eq!(wait_set.handles.len(), 3); // connect_req + data + disconnect
+        assert_eq!(wait_set.connected, vec![1]);
+        assert!(matches!(
+            wait_set.sources[..],
+            [
+                EventSource::SlotConnect(0),
+                EventSource::SlotData(1),
+                EventSource::SlotDisconnect(1)
+            ]
+        ));
+    }
+
     /// `stop()` обязан синхронно дождаться выхода worker-потока: после
     /// возврата `worker_handle` должен быть `None` (взят и заджойнен), иначе
     /// C-вызывающий код может освободить `user_data` до того как worker
@@ -1285,7 +1820,7 @@ mod tests {
         // win::tests::exited_process_is_detected_as_dead) -- ретраим.
         let mut orphaned = Vec::new();
         for _ in 0..50 {
-            orphaned = server.reclaim_stale_claims();
+            orphaned = server.reclaim_stale_claims(0..1);
             if !orphaned.is_empty() {
                 break;
             }
@@ -1332,13 +1867,55 @@ mod tests {
                 .store(std::process::id(), Ordering::Release);
         }
 
-        let orphaned = server.reclaim_stale_claims();
+        let orphaned = server.reclaim_stale_claims(0..1);
         assert!(
             orphaned.is_empty(),
             "connected-слот с живым процессом-владельцем не должен считаться осиротевшим"
         );
     }
 
+    /// Сработавшее в наборе ожидания событие `SlotOwnerExit` перепроверяется
+    /// по текущему `owner`: процесс жив — слот остаётся подключённым и
+    /// сохраняет handle (устаревшее событие не отключает клиента).
+    #[test]
+    fn owner_exit_event_keeps_slot_with_alive_owner() {
+        let name = format!("TEST_MULTI_OWNER_EXIT_{}", std::process::id());
+        let handler = Arc::new(TestHandler::new());
+        let server = MultiServer::start(
+            &name,
+            handler,
+            MultiOptions {
+                max_clients: 1,
+                ..Default::default()
+            },
+        )
+        .expect("start");
+
+        server.stop();
+        if let Some(h) = server.worker_handle.lock().unwrap().take() {
+            let _ = h.join();
+        }
+
+        {
+            let slots = server.slots.read().unwrap();
+            let mut slot0 = slots[0].lock().unwrap();
+            slot0.connected = true;
+            slot0.owner = Some(Arc::new(
+                win::ProcessHandle::open(std::process::id()).expect("open own process"),
+            ));
+            slot0.server.view().control_block().reserved[RESERVED_CLAIM_INDEX]
+                .store(0xABCD_0002, Ordering::Release);
+        }
+
+        server.handle_owner_exit(0);
+        assert!(server.reclaim_stale_claims(0..1).is_empty());
+
+        let slots = server.slots.read().unwrap();
+        let slot0 = slots[0].lock().unwrap();
+        assert!(slot0.connected, "живой владелец не должен отключаться");
+        assert!(slot0.owner.is_some());
+    }
+
     /// Детерминированная проверка обнаружения «осиротевшего» слота
     /// (abandoned-handshake): connected=true, но claim снят клиентом.
     /// `reclaim_stale_claims` обязан вернуть такой слот для отключения.
@@ -1373,7 +1950,7 @@ mod tests {
                 .store(CLAIM_FREE, Ordering::Release);
         }
 
-        let orphaned = server.reclaim_stale_claims();
+        let orphaned = server.reclaim_stale_claims(0..2);
         assert_eq!(
             orphaned,
             vec![(0, CLAIM_FREE)],
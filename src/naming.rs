@@ -1,3 +1,5 @@
+use crate::constants::{BROADCAST_SECTION_SUFFIX, HEAP_SECTION_SUFFIX};
+
 #[derive(Clone, Copy)]
 pub enum Direction {
     ServerToClient,
@@ -27,3 +29,13 @@ pub fn mapping_name(base: &str) -> String {
 pub fn event_name(base: &str, direction: Direction, suffix: &str) -> String {
     format!("{}{}_{}", event_prefix(base), direction.as_str(), suffix)
 }
+
+/// Базовое имя секции fan-out рассылки сервера `base` (multi / dispatch).
+pub fn broadcast_name(base: &str) -> String {
+    format!("{base}_{BROADCAST_SECTION_SUFFIX}")
+}
+
+/// Базовое имя секции общей кучи блоков сервера `base`.
+pub fn heap_name(base: &str) -> String {
+    format!("{base}_{HEAP_SECTION_SUFFIX}")
+}
@@ -89,6 +89,69 @@ extern "system" {
         Timeout: *const i64,
     ) -> NTSTATUS;
 
+    // ========================================================================
+    // IoCompletion operations
+    // ========================================================================
+
+    /// Создание порта завершения (IoCompletion). Count — сколько потоков
+    /// порт будит одновременно (0 — по числу процессоров).
+    pub fn NtCreateIoCompletion(
+        IoCompletionHandle: *mut HANDLE,
+        DesiredAccess: ACCESS_MASK,
+        ObjectAttributes: *mut OBJECT_ATTRIBUTES,
+        Count: ULONG,
+    ) -> NTSTATUS;
+
+    /// Постановка пакета в порт вручную (аналог PostQueuedCompletionStatus)
+    pub fn NtSetIoCompletion(
+        IoCompletionHandle: HANDLE,
+        KeyContext: PVOID,
+        ApcContext: PVOID,
+        IoStatus: NTSTATUS,
+        IoStatusInformation: ULONG_PTR,
+    ) -> NTSTATUS;
+
+    /// Извлечение до Count пакетов одним вызовом
+    ///
+    /// Timeout: NULL = бесконечно, отрицательное = относительное (100ns units)
+    pub fn NtRemoveIoCompletionEx(
+        IoCompletionHandle: HANDLE,
+        IoCompletionInformation: *mut FILE_IO_COMPLETION_INFORMATION,
+        Count: ULONG,
+        NumEntriesRemoved: *mut ULONG,
+        Timeout: *const i64,
+        Alertable: BOOLEAN,
+    ) -> NTSTATUS;
+
+    /// Создание wait completion packet (Windows 8+) — основа TpSetWait
+    pub fn NtCreateWaitCompletionPacket(
+        WaitCompletionPacketHandle: *mut HANDLE,
+        DesiredAccess: ACCESS_MASK,
+        ObjectAttributes: *mut OBJECT_ATTRIBUTES,
+    ) -> NTSTATUS;
+
+    /// Однократное ожидание объекта силами ядра: когда TargetObjectHandle
+    /// станет сигнальным (ожидание его «потребляет», как WaitForSingleObject),
+    /// пакет с KeyContext/ApcContext встаёт в порт. Уже сигнальный объект
+    /// ставит пакет сразу.
+    pub fn NtAssociateWaitCompletionPacket(
+        WaitCompletionPacketHandle: HANDLE,
+        IoCompletionHandle: HANDLE,
+        TargetObjectHandle: HANDLE,
+        KeyContext: PVOID,
+        ApcContext: PVOID,
+        IoStatus: NTSTATUS,
+        IoStatusInformation: ULONG_PTR,
+        AlreadySignaled: *mut BOOLEAN,
+    ) -> NTSTATUS;
+
+    /// Отмена ожидания; RemoveSignaledPacket — заодно убрать из порта уже
+    /// поставленный, но не извлечённый пакет.
+    pub fn NtCancelWaitCompletionPacket(
+        WaitCompletionPacketHandle: HANDLE,
+        RemoveSignaledPacket: BOOLEAN,
+    ) -> NTSTATUS;
+
     // ========================================================================
     // Section operations (Shared Memory)
     // ========================================================================
@@ -131,6 +194,15 @@ extern "system" {
     /// Размаппинг секции
     pub fn NtUnmapViewOfSection(ProcessHandle: HANDLE, BaseAddress: PVOID) -> NTSTATUS;
 
+    /// Сведения о секции (атрибуты создания, размер)
+    pub fn NtQuerySection(
+        SectionHandle: HANDLE,
+        SectionInformationClass: ULONG,
+        SectionInformation: PVOID,
+        SectionInformationLength: usize,
+        ReturnLength: *mut usize,
+    ) -> NTSTATUS;
+
     // ========================================================================
     // Security Descriptor helpers (Rtl* functions)
     // ========================================================================
@@ -148,6 +220,63 @@ extern "system" {
         Dacl: PVOID,
         DaclDefaulted: BOOLEAN,
     ) -> NTSTATUS;
+
+    /// Включение привилегии в токене процесса (`CurrentThread = 0`) или
+    /// потока; `Enabled` получает прежнее состояние.
+    pub fn RtlAdjustPrivilege(
+        Privilege: ULONG,
+        Enable: BOOLEAN,
+        CurrentThread: BOOLEAN,
+        Enabled: *mut BOOLEAN,
+    ) -> NTSTATUS;
+
+    // ========================================================================
+    // Performance counter
+    // ========================================================================
+
+    /// Текущее значение счётчика производительности (QPC). На системах с
+    /// инвариантным TSC читается без перехода в ядро.
+    pub fn RtlQueryPerformanceCounter(PerformanceCounter: *mut LARGE_INTEGER) -> BOOLEAN;
+
+    /// Частота счётчика производительности, тиков в секунду (постоянна до
+    /// перезагрузки).
+    pub fn RtlQueryPerformanceFrequency(PerformanceFrequency: *mut LARGE_INTEGER) -> BOOLEAN;
+
+    // ========================================================================
+    // ETW (то же, что EventRegister/EventWrite из advapi32, без advapi32)
+    // ========================================================================
+
+    /// Регистрация провайдера; возвращает Win32-код ошибки (0 — успех).
+    /// `EnableCallback` не используем — передаётся NULL.
+    pub fn EtwEventRegister(
+        ProviderId: *const GUID,
+        EnableCallback: PVOID,
+        CallbackContext: PVOID,
+        RegHandle: *mut REGHANDLE,
+    ) -> ULONG;
+
+    /// Есть ли сессия, слушающая событие; дешёвое чтение без перехода в ядро.
+    pub fn EtwEventEnabled(
+        RegHandle: REGHANDLE,
+        EventDescriptor: *const EVENT_DESCRIPTOR,
+    ) -> BOOLEAN;
+
+    /// Настройка провайдера; нужна для traits TraceLogging
+    /// (`EVENT_PROVIDER_SET_TRAITS`, Windows 10+).
+    pub fn EtwEventSetInformation(
+        RegHandle: REGHANDLE,
+        InformationClass: ULONG,
+        EventInformation: PVOID,
+        InformationLength: ULONG,
+    ) -> ULONG;
+
+    /// Запись события с `UserDataCount` полями payload.
+    pub fn EtwEventWrite(
+        RegHandle: REGHANDLE,
+        EventDescriptor: *const EVENT_DESCRIPTOR,
+        UserDataCount: ULONG,
+        UserData: *const EVENT_DATA_DESCRIPTOR,
+    ) -> ULONG;
 }
 
 // ============================================================================
@@ -221,6 +221,31 @@ pub const SEC_COMMIT: ULONG = 0x08000000;
 /// ViewUnmap - секция будет размаппена при закрытии handle
 pub const VIEW_UNMAP: ULONG = 2;
 
+/// Секция на больших страницах (только вместе с SEC_COMMIT, нужна
+/// SeLockMemoryPrivilege, размер кратен `LARGE_PAGE_MINIMUM`).
+pub const SEC_LARGE_PAGES: ULONG = 0x80000000;
+/// AllocationType NtMapViewOfSection: view секции SEC_LARGE_PAGES на больших
+/// страницах (с Windows 10 1703 без него view маппится обычными).
+pub const MEM_LARGE_PAGES: ULONG = 0x20000000;
+/// Младшие биты AllocationType NtMapViewOfSection — предпочтительный NUMA-узел
+/// плюс один (так его передаёт MapViewOfFileExNuma), 0 — без предпочтения.
+pub const NUMA_NODE_MASK: ULONG = 0x3F;
+/// Минимальный размер большой страницы x86 (PAE) и x86_64.
+pub const LARGE_PAGE_MINIMUM: usize = 2 * 1024 * 1024;
+
+/// SECTION_INFORMATION_CLASS::SectionBasicInformation
+pub const SECTION_BASIC_INFORMATION_CLASS: ULONG = 0;
+
+#[repr(C)]
+pub struct SECTION_BASIC_INFORMATION {
+    pub BaseAddress: PVOID,
+    pub AllocationAttributes: ULONG,
+    pub MaximumSize: LARGE_INTEGER,
+}
+
+/// SeLockMemoryPrivilege (для RtlAdjustPrivilege).
+pub const SE_LOCK_MEMORY_PRIVILEGE: ULONG = 4;
+
 // ============================================================================
 // Константы для Event
 // ============================================================================
@@ -240,3 +265,77 @@ pub const NOTIFICATION_EVENT: ULONG = 0;
 pub const WAIT_ANY: ULONG = 1;
 /// WaitAll - вернуться когда все объекты сигнализированы
 pub const WAIT_ALL: ULONG = 0;
+
+// ============================================================================
+// IoCompletion и wait completion packets
+// ============================================================================
+
+pub const IO_COMPLETION_ALL_ACCESS: ACCESS_MASK = 0x001F0003;
+/// Права на wait completion packet (так же его создаёт thread pool ntdll).
+pub const GENERIC_ALL: ACCESS_MASK = 0x1000_0000;
+
+/// IO_STATUS_BLOCK: объединение Status/Pointer занимает размер указателя.
+#[repr(C)]
+#[derive(Clone, Copy)]
+pub struct IO_STATUS_BLOCK {
+    pub Status: ULONG_PTR,
+    pub Information: ULONG_PTR,
+}
+
+/// Элемент результата NtRemoveIoCompletionEx.
+#[repr(C)]
+#[derive(Clone, Copy)]
+pub struct FILE_IO_COMPLETION_INFORMATION {
+    pub KeyContext: PVOID,
+    pub ApcContext: PVOID,
+    pub IoStatusBlock: IO_STATUS_BLOCK,
+}
+
+// ============================================================================
+// ETW
+// ============================================================================
+
+/// Handle регистрации ETW-провайдера (0 — не зарегистрирован).
+pub type REGHANDLE = u64;
+
+#[repr(C)]
+#[derive(Clone, Copy)]
+pub struct GUID {
+    pub Data1: u32,
+    pub Data2: u16,
+    pub Data3: u16,
+    pub Data4: [u8; 8],
+}
+
+#[repr(C)]
+#[derive(Clone, Copy)]
+pub struct EVENT_DESCRIPTOR {
+    pub Id: u16,
+    pub Version: u8,
+    pub Channel: u8,
+    pub Level: u8,
+    pub Opcode: u8,
+    pub Task: u16,
+    pub Keyword: u64,
+}
+
+/// Поле payload события: адрес всегда 64-битный, и на x86 тоже.
+/// Младший байт `Reserved` — тип поля (`EVENT_DATA_DESCRIPTOR_TYPE_*`).
+#[repr(C)]
+#[derive(Clone, Copy)]
+pub struct EVENT_DATA_DESCRIPTOR {
+    pub Ptr: u64,
+    pub Size: ULONG,
+    pub Reserved: ULONG,
+}
+
+/// Поле — метаданные события TraceLogging (имя, имена и типы полей).
+pub const EVENT_DATA_DESCRIPTOR_TYPE_EVENT_METADATA: ULONG = 1;
+/// Поле — метаданные провайдера TraceLogging (traits).
+pub const EVENT_DATA_DESCRIPTOR_TYPE_PROVIDER_METADATA: ULONG = 2;
+
+/// EVENT_INFO_CLASS::EventProviderSetTraits
+pub const EVENT_PROVIDER_SET_TRAITS: ULONG = 2;
+
+/// Канал событий TraceLogging: для декодера признак самоописывающего события.
+pub const WINEVENT_CHANNEL_TRACELOGGING: u8 = 11;
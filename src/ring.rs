@@ -5,36 +5,372 @@
 //! синхронизацию. НЕ портировать на ARM/RISC-V без доработки!
 
 use std::ptr::NonNull;
-use std::sync::atomic::{compiler_fence, Ordering};
+use std::sync::atomic::{compiler_fence, fence, AtomicBool, AtomicU32, AtomicU64, Ordering};
+use std::sync::Arc;
+use std::time::Duration;
 
 use crate::constants::*;
+use crate::copy::{copy_to_shared, extend_from_shared};
 use crate::error::{Result, ShmError};
-use crate::layout::RingHeader;
+use crate::layout::{frame_header_size, RingHeader};
+use crate::stats::{self, ChannelStats, LATENCY_SAMPLE_INTERVAL};
+use crate::trace::MessageTrace;
+use crate::win;
 
-#[derive(Debug, Clone, Copy)]
+#[derive(Debug, Clone, Copy, Default)]
 pub struct WriteOutcome {
     pub overwritten: u32,
     pub was_empty: bool,
+    /// Consumer мог уснуть на data-событии и его нужно просигналить: кольцо
+    /// было пустым, а consumer не в активном ожидании (`spinning` снят).
+    pub wake_consumer: bool,
+}
+
+/// Что делает producer, когда сообщению не хватает места в кольце.
+///
+/// Политика локальна для пишущей стороны и в shared memory не попадает:
+/// у каждого направления канала она своя.
+#[derive(Debug, Clone, Copy, PartialEq, Eq, Default)]
+pub enum OverflowPolicy {
+    /// Вытеснить самые старые сообщения (`discard_oldest`) — прежнее поведение.
+    #[default]
+    Overwrite,
+    /// Ничего не трогать и вернуть `QueueFull`.
+    Fail,
+    /// Ждать `space`-событие (consumer дочитал кольцо) не дольше таймаута,
+    /// затем `QueueFull`.
+    Block(Duration),
+}
+
+/// `OverflowPolicy`, которую можно сменить через `&self`, пока другие потоки
+/// пишут (FFI-дескрипторы делятся между потоками). `Block` хранится в
+/// наносекундах; таймаут, не представимый в них, — `Duration::MAX`.
+pub(crate) struct AtomicOverflowPolicy(AtomicU64);
+
+impl AtomicOverflowPolicy {
+    const OVERWRITE: u64 = 0;
+    const FAIL: u64 = 1;
+    /// `Block(timeout)` — `BLOCK + наносекунды`.
+    const BLOCK: u64 = 2;
+    const BLOCK_FOREVER: u64 = u64::MAX;
+
+    pub(crate) fn new(policy: OverflowPolicy) -> Self {
+        Self(AtomicU64::new(Self::encode(policy)))
+    }
+
+    pub(crate) fn load(&self) -> OverflowPolicy {
+        match self.0.load(Ordering::Relaxed) {
+            Self::OVERWRITE => OverflowPolicy::Overwrite,
+            Self::FAIL => OverflowPolicy::Fail,
+            Self::BLOCK_FOREVER => OverflowPolicy::Block(Duration::MAX),
+            value => OverflowPolicy::Block(Duration::from_nanos(value - Self::BLOCK)),
+        }
+    }
+
+    pub(crate) fn store(&self, policy: OverflowPolicy) {
+        self.0.store(Self::encode(policy), Ordering::Relaxed);
+    }
+
+    fn encode(policy: OverflowPolicy) -> u64 {
+        match policy {
+            OverflowPolicy::Overwrite => Self::OVERWRITE,
+            OverflowPolicy::Fail => Self::FAIL,
+            OverflowPolicy::Block(timeout) => u64::try_from(timeout.as_nanos())
+                .ok()
+                .and_then(|nanos| nanos.checked_add(Self::BLOCK))
+                .unwrap_or(Self::BLOCK_FOREVER),
+        }
+    }
+}
+
+/// Место, зарезервированное в кольце под одно сообщение (zero-copy запись).
+///
+/// Получается из [`RingBuffer::reserve`], заполняется через
+/// [`RingBuffer::reservation_spans`] и публикуется [`RingBuffer::commit`].
+/// Отмена — просто drop: до commit ничего не опубликовано. Кольцо SPSC,
+/// поэтому пока резерв жив, тот же producer не должен писать в кольцо
+/// (`write_message`/`reserve`) — иначе вторая запись ляжет поверх резерва.
+#[derive(Debug)]
+pub struct WriteReservation {
+    write: u32,
+    len: u32,
+    /// Размер заголовка кадра (выбран по `len` при резерве).
+    header_len: u32,
+    generation: u32,
+    overwritten: u32,
+    /// Метка постановки в очередь трассируемого кадра.
+    stamp: Option<u64>,
+}
+
+impl WriteReservation {
+    /// Зарезервированная длина payload (байты).
+    pub fn reserved_len(&self) -> usize {
+        self.len as usize
+    }
+
+    /// Сколько старых сообщений вытеснено ради этого резерва.
+    pub fn overwritten(&self) -> u32 {
+        self.overwritten
+    }
+}
+
+/// Подсмотренное через [`RingBuffer::peek`] сообщение (zero-copy чтение).
+///
+/// Payload доступен через [`RingBuffer::peeked_spans`]; сообщение забирается
+/// [`RingBuffer::consume`]. Drop без consume оставляет сообщение в кольце.
+#[derive(Debug)]
+pub struct PeekedMessage {
+    read: u32,
+    len: u32,
+    header_len: u32,
+    generation: u32,
+    trace: Option<MessageTrace>,
+}
+
+impl PeekedMessage {
+    /// Длина payload (байты).
+    pub fn message_len(&self) -> usize {
+        self.len as usize
+    }
+
+    /// Метка трассируемого сообщения. Как и payload, достоверна только
+    /// после успешного [`RingBuffer::consume`].
+    pub fn trace(&self) -> Option<MessageTrace> {
+        self.trace
+    }
+}
+
+/// Разобранный заголовок кадра.
+#[derive(Clone, Copy)]
+struct Frame {
+    /// Длина payload (не проверена — её валидирует вызывающий код).
+    len: usize,
+    /// Размер заголовка вместе с расширением трассировки.
+    header_len: usize,
+    traced: bool,
+}
+
+/// Локальный (вне shared memory) снимок индекса другой стороны кольца:
+/// `connection_gen << 32 | значение`.
+///
+/// Пока снимка хватает для решения, чужую кэш-линию не читаем. Снимок
+/// консервативен: чужой индекс только растёт, поэтому устаревшее значение
+/// может лишь занизить свободное место (producer) или число готовых
+/// сообщений (consumer). Снимок другого поколения (после reset заголовка)
+/// считается промахом.
+struct IndexCache(AtomicU64);
+
+impl IndexCache {
+    fn new() -> Self {
+        // поколение u32::MAX не совпадёт с реальным до первого `set`
+        IndexCache(AtomicU64::new((u32::MAX as u64) << 32))
+    }
+
+    fn get(&self, generation: u32) -> Option<u32> {
+        let packed = self.0.load(Ordering::Relaxed);
+        ((packed >> 32) as u32 == generation).then_some(packed as u32)
+    }
+
+    fn set(&self, generation: u32, value: u32) {
+        self.0.store(
+            ((generation as u64) << 32) | value as u64,
+            Ordering::Relaxed,
+        );
+    }
+}
+
+/// Пачка сообщений, забранных [`RingBuffer::read_batch`]: payload-ы лежат
+/// подряд в одной арене, границы — в `ends` (конец i-го сообщения).
+///
+/// Переиспользуется между вызовами: после прогрева чтение пачки не аллоцирует.
+#[derive(Debug, Default)]
+pub struct MessageBatch {
+    arena: Vec<u8>,
+    ends: Vec<usize>,
+    /// Метки трассировки по индексу сообщения; заполняется, только когда в
+    /// пачке есть трассируемые кадры, и может быть короче `ends`.
+    traces: Vec<Option<MessageTrace>>,
+}
+
+impl MessageBatch {
+    pub fn new() -> Self {
+        Self::default()
+    }
+
+    /// Пачка с заранее выделенной ареной на `bytes` байт и `messages` сообщений.
+    pub fn with_capacity(bytes: usize, messages: usize) -> Self {
+        Self {
+            arena: Vec::with_capacity(bytes),
+            ends: Vec::with_capacity(messages),
+            traces: Vec::new(),
+        }
+    }
+
+    /// Число сообщений в пачке.
+    pub fn len(&self) -> usize {
+        self.ends.len()
+    }
+
+    pub fn is_empty(&self) -> bool {
+        self.ends.is_empty()
+    }
+
+    pub fn clear(&mut self) {
+        self.arena.clear();
+        self.ends.clear();
+        self.traces.clear();
+    }
+
+    /// Payload `index`-го сообщения.
+    pub fn get(&self, index: usize) -> Option<&[u8]> {
+        let end = *self.ends.get(index)?;
+        let start = if index == 0 { 0 } else { self.ends[index - 1] };
+        Some(&self.arena[start..end])
+    }
+
+    /// Метка трассировки `index`-го сообщения (`None` — кадр без метки).
+    pub fn trace(&self, index: usize) -> Option<MessageTrace> {
+        self.traces.get(index).copied().flatten()
+    }
+
+    pub fn iter(&self) -> impl Iterator<Item = &[u8]> + '_ {
+        (0..self.len()).filter_map(|index| self.get(index))
+    }
+
+    /// Вся арена: payload-ы подряд, без заголовков.
+    pub fn as_bytes(&self) -> &[u8] {
+        &self.arena
+    }
+
+    /// Концы сообщений в арене (`ends()[i]` — конец i-го сообщения).
+    pub fn ends(&self) -> &[usize] {
+        &self.ends
+    }
+
+    /// Дописывает сообщение в конец пачки (чтение не из `RingBuffer`).
+    pub(crate) fn push(&mut self, payload: &[u8]) {
+        extend_from_shared(&mut self.arena, payload);
+        self.ends.push(self.arena.len());
+    }
+
+    /// Оставляет первые `messages` сообщений, занимающие `bytes` байт арены.
+    fn truncate(&mut self, messages: usize, bytes: usize) {
+        self.arena.truncate(bytes);
+        self.ends.truncate(messages);
+        self.traces.truncate(messages);
+    }
+
+    /// Убирает последнее сообщение (копия оказалась недействительной).
+    pub(crate) fn pop(&mut self) {
+        if self.ends.pop().is_some() {
+            let end = self.ends.last().copied().unwrap_or(0);
+            self.arena.truncate(end);
+            self.traces.truncate(self.ends.len());
+        }
+    }
+
+    /// Метка только что добавленного сообщения.
+    fn trace_last(&mut self, trace: MessageTrace) {
+        self.traces.resize(self.ends.len() - 1, None);
+        self.traces.push(Some(trace));
+    }
 }
 
 pub struct RingBuffer {
     header: NonNull<RingHeader>,
     storage: NonNull<u8>,
     capacity: u32,
+    mask: u32,
+    max_messages: u32,
+    max_message_size: usize,
+    /// Размер слота кольца фиксированных слотов (`ChannelGeometry::slot_size`);
+    /// 0 — кадры переменной длины.
+    slot_size: usize,
+    /// Снимки producer-а: `read_pos` и `messages_read` consumer-а.
+    cached_read: IndexCache,
+    cached_consumed: IndexCache,
+    /// Снимок consumer-а: `write_pos` producer-а.
+    cached_write: IndexCache,
+    /// `false` — при нехватке места `QueueFull` вместо вытеснения. Меняется
+    /// через `&self`: политику FFI-дескриптора задают, пока другой поток
+    /// пишет.
+    overwrite: AtomicBool,
+    /// Статистика стороны канала, которой принадлежит кольцо (общая для её
+    /// tx- и rx-колец).
+    stats: Arc<ChannelStats>,
+    /// Снимок consumer-а: `publish_stamp`, ещё не дочитанный до своей позиции.
+    pending_stamp: AtomicU64,
+    /// Producer пишет кадры с расширением трассировки.
+    trace: bool,
+    /// Номер следующего трассируемого кадра producer-а.
+    sequence: AtomicU32,
 }
 
 unsafe impl Send for RingBuffer {}
 unsafe impl Sync for RingBuffer {}
 
 impl RingBuffer {
-    pub unsafe fn new(header: *mut RingHeader, data: *mut u8) -> Self {
+    /// # Safety
+    /// `header` и `data` указывают на заголовок и `capacity` байт storage,
+    /// живущие не меньше self; пределы уже проверены
+    /// (`ChannelGeometry::validate`: степень двойки, сообщение влезает).
+    pub unsafe fn new(
+        header: *mut RingHeader,
+        data: *mut u8,
+        capacity: usize,
+        max_messages: u32,
+        max_message_size: usize,
+    ) -> Self {
+        debug_assert!(capacity.is_power_of_two() && capacity <= MAX_RING_CAPACITY);
+        debug_assert!(frame_header_size(max_message_size) + max_message_size <= capacity);
         RingBuffer {
             header: NonNull::new(header).expect("header pointer must be valid"),
             storage: NonNull::new(data).expect("ring buffer pointer must be valid"),
-            capacity: RING_CAPACITY as u32,
+            capacity: capacity as u32,
+            mask: capacity as u32 - 1,
+            max_messages,
+            max_message_size,
+            slot_size: 0,
+            cached_read: IndexCache::new(),
+            cached_consumed: IndexCache::new(),
+            cached_write: IndexCache::new(),
+            overwrite: AtomicBool::new(true),
+            stats: Arc::default(),
+            pending_stamp: AtomicU64::new(0),
+            trace: false,
+            sequence: AtomicU32::new(0),
         }
     }
 
+    /// Разрешено ли producer-у вытеснять старые сообщения (по умолчанию да).
+    pub(crate) fn set_overwrite(&self, overwrite: bool) {
+        self.overwrite.store(overwrite, Ordering::Relaxed);
+    }
+
+    /// Кольцо фиксированных слотов: каждое сообщение — ровно `slot_size`
+    /// байт без заголовка кадра (0 — кадры переменной длины). Задаётся
+    /// геометрией сегмента, одинаково на обеих сторонах.
+    pub(crate) fn set_slot_size(&mut self, slot_size: usize) {
+        debug_assert!(
+            slot_size == 0
+                || (slot_size == self.max_message_size && 2 * slot_size <= self.capacity as usize)
+        );
+        self.slot_size = slot_size;
+    }
+
+    pub(crate) fn set_stats(&mut self, stats: Arc<ChannelStats>) {
+        self.stats = stats;
+    }
+
+    /// Писать ли кадры с расширением трассировки (по умолчанию нет).
+    pub(crate) fn set_trace(&mut self, trace: bool) {
+        self.trace = trace;
+    }
+
+    pub(crate) fn stats(&self) -> &Arc<ChannelStats> {
+        &self.stats
+    }
+
     fn header(&self) -> &RingHeader {
         unsafe { self.header.as_ref() }
     }
@@ -59,7 +395,19 @@ impl RingBuffer {
     }
 
     fn mask_index(&self, pos: u32) -> usize {
-        (pos & RING_MASK) as usize
+        (pos & self.mask) as usize
+    }
+
+    /// Пропуск перед слотом по индексу `index`: слот не переходит границу
+    /// кольца, поэтому хвост, в который он не влезает, пропускается целиком.
+    /// Producer и consumer считают его одинаково — в кольцо он не пишется.
+    fn slot_pad(&self, index: usize) -> usize {
+        let tail = self.capacity as usize - index;
+        if tail < self.slot_size {
+            tail
+        } else {
+            0
+        }
     }
 
     /// # Safety
@@ -71,10 +419,7 @@ impl RingBuffer {
         // SAFETY: storage валиден на всё время жизни self (гарантия
         // конструктора RingBuffer::new); index+data.len() <= capacity --
         // инвариант вызывающей стороны (см. doc выше).
-        unsafe {
-            let ptr = self.data_ptr().add(index);
-            ptr.copy_from_nonoverlapping(data.as_ptr(), data.len());
-        }
+        unsafe { copy_to_shared(self.data_ptr().add(index), data) };
     }
 
     /// # Safety
@@ -88,16 +433,75 @@ impl RingBuffer {
         }
     }
 
+    /// Разбирает заголовок кадра. Длина не проверяется — её валидирует
+    /// вызывающий код.
+    ///
     /// # Safety
-    /// `index < capacity` (читает 2 байта начиная с `index`, с wrap-around
-    /// через `copy_from_wrapped`, поэтому сам `index` не обязан оставлять
-    /// место под оба байта без переноса).
-    unsafe fn read_u16(&self, index: usize) -> u16 {
-        let mut buf = [0u8; 2];
+    /// `index < capacity` (заголовок читается с wrap-around через
+    /// `copy_from_wrapped`, поэтому сам `index` не обязан оставлять место под
+    /// весь заголовок без переноса).
+    unsafe fn read_frame(&self, index: usize) -> Frame {
+        if self.slot_size != 0 {
+            // у слотов нет заголовка: длина известна, перед payload — пропуск
+            return Frame {
+                len: self.slot_size,
+                header_len: self.slot_pad(index),
+                traced: false,
+            };
+        }
+        let mut buf = [0u8; LONG_MESSAGE_HEADER_SIZE];
         // SAFETY: copy_from_wrapped сам обеспечивает wrap-around в пределах
         // capacity -- единственное требование к index описано в doc выше.
-        unsafe { self.copy_from_wrapped(index, &mut buf) };
-        u16::from_le_bytes(buf)
+        unsafe { self.copy_from_wrapped(index, &mut buf[..MESSAGE_HEADER_SIZE]) };
+        let flags = u16::from_le_bytes([buf[2], buf[3]]);
+        let traced = flags & MESSAGE_FLAG_TRACED != 0;
+        let extension = if traced { TRACE_EXTENSION_SIZE } else { 0 };
+        if flags & MESSAGE_FLAG_LONG == 0 {
+            return Frame {
+                len: u16::from_le_bytes([buf[0], buf[1]]) as usize,
+                header_len: MESSAGE_HEADER_SIZE + extension,
+                traced,
+            };
+        }
+        // SAFETY: см. выше; длинная часть заголовка тоже переносится через
+        // границу кольца самим copy_from_wrapped.
+        unsafe {
+            self.copy_from_wrapped(index + MESSAGE_HEADER_SIZE, &mut buf[MESSAGE_HEADER_SIZE..])
+        };
+        let len = u32::from_le_bytes([buf[4], buf[5], buf[6], buf[7]]);
+        Frame {
+            len: len as usize,
+            header_len: LONG_MESSAGE_HEADER_SIZE + extension,
+            traced,
+        }
+    }
+
+    /// Расширение трассировки кадра `frame` по позиции `pos`, прочитанное в
+    /// момент `now` (тики).
+    fn read_trace(&self, pos: u32, frame: &Frame, now: u64) -> MessageTrace {
+        let mut buf = [0u8; 12];
+        let at = self.mask_index(pos) + frame.header_len - TRACE_EXTENSION_SIZE;
+        // SAFETY: copy_from_wrapped сам переносит чтение через границу кольца.
+        unsafe { self.copy_from_wrapped(at, &mut buf) };
+        let mut stamp = [0u8; 8];
+        stamp.copy_from_slice(&buf[..8]);
+        let sequence = u32::from_le_bytes([buf[8], buf[9], buf[10], buf[11]]);
+        MessageTrace::new(u64::from_le_bytes(stamp), sequence, now)
+    }
+
+    /// Заголовок кадра под payload `len` по позиции `pos`: с расширением
+    /// трассировки, если она включена и кадр с ним влезает в кольцо (иначе —
+    /// без метки). У слотов вместо заголовка — пропуск до границы кольца.
+    fn frame_layout(&self, pos: u32, len: usize) -> (usize, bool) {
+        if self.slot_size != 0 {
+            return (self.slot_pad(self.mask_index(pos)), false);
+        }
+        let header_len = frame_header_size(len);
+        if self.trace && header_len + TRACE_EXTENSION_SIZE + len <= self.capacity as usize {
+            (header_len + TRACE_EXTENSION_SIZE, true)
+        } else {
+            (header_len, false)
+        }
     }
 
     /// # Safety
@@ -141,186 +545,726 @@ impl RingBuffer {
         let header = self.header();
 
         loop {
-            let read = header.read_pos.load(Ordering::Acquire);
-            let write = header.write_pos.load(Ordering::Acquire);
+            let read = header.consumer.read_pos.load(Ordering::Acquire);
+            let write = header.producer.write_pos.load(Ordering::Acquire);
             if read == write {
                 return Err(ShmError::QueueEmpty);
             }
 
             let idx = self.mask_index(read);
-            // SAFETY: idx = read & RING_MASK всегда < capacity (mask_index).
-            let msg_len = unsafe { self.read_u16(idx) } as usize;
-            if !(MIN_MESSAGE_SIZE..=MAX_MESSAGE_SIZE).contains(&msg_len) {
-                // Повреждённая длина в слоте. Не трогаем общий message_count
-                // деструктивно (его двигает и reader). Сигналим Corrupted —
+            // SAFETY: idx = read & mask всегда < capacity (mask_index).
+            let frame = unsafe { self.read_frame(idx) };
+            if !(MIN_MESSAGE_SIZE..=self.max_message_size).contains(&frame.len) {
+                // Повреждённая длина в слоте. Не трогаем read_pos деструктивно
+                // (его двигает и reader). Сигналим Corrupted —
                 // вызывающий код решает (auto-mode трактует как fatal -> reconnect,
                 // что сбросит буферы через handshake/generation).
                 return Err(ShmError::Corrupted);
             }
-            let total = MESSAGE_HEADER_SIZE + msg_len;
+            let total = frame.header_len + frame.len;
             let new_read = read.wrapping_add(total as u32);
 
             // CAS to avoid racing with read_message on the reader side
             if header
+                .consumer
                 .read_pos
                 .compare_exchange(read, new_read, Ordering::AcqRel, Ordering::Acquire)
                 .is_ok()
             {
-                header.message_count.fetch_sub(1, Ordering::AcqRel);
-                header.drop_count.fetch_add(1, Ordering::Relaxed);
+                // drop_count пишет только producer: вытесненное сообщение
+                // уходит из счёта, не трогая messages_read consumer-а
+                header.producer.drop_count.fetch_add(1, Ordering::Release);
+                self.stats.record_drop();
                 return Ok(());
             }
             // CAS failed — reader moved read_pos, retry with fresh values
         }
     }
 
-    pub fn write_message(&self, payload: &[u8]) -> Result<WriteOutcome> {
-        if payload.len() < MIN_MESSAGE_SIZE {
+    /// Резервирует в кольце место под сообщение из `len` байт (zero-copy запись).
+    ///
+    /// Освобождение места идёт по той же политике, что и в `write_message`:
+    /// при нехватке байт/слотов старые сообщения вытесняются через
+    /// `discard_oldest`, а без вытеснения — `QueueFull`. Сам резерв reader-у не виден, пока не вызван
+    /// [`RingBuffer::commit`] — `write_pos` до этого не двигается.
+    pub fn reserve(&self, len: usize) -> Result<WriteReservation> {
+        self.reserve_at(len, None)
+    }
+
+    /// `reserve` с меткой постановки в очередь `enqueued` (тики
+    /// `win::perf_counter`) для трассируемого кадра: auto-режим передаёт
+    /// время `send()`, а не записи в кольцо. `None` — метка берётся сейчас;
+    /// без трассировки метка не пишется вовсе.
+    pub(crate) fn reserve_at(&self, len: usize, enqueued: Option<u64>) -> Result<WriteReservation> {
+        // слот — ровно slot_size байт (длиннее не пропустит max_message_size)
+        if len < MIN_MESSAGE_SIZE || len < self.slot_size {
             return Err(ShmError::MessageTooSmall);
         }
-        if payload.len() > MAX_MESSAGE_SIZE {
+        if len > self.max_message_size {
             return Err(ShmError::MessageTooLarge);
         }
 
-        let total_required = (MESSAGE_HEADER_SIZE + payload.len()) as u32;
+        let generation = self.header().connection_gen.load(Ordering::Acquire);
+        // write_pos двигает только сам producer (и reset на reconnect)
+        let pos = self.header().producer.write_pos.load(Ordering::Acquire);
+        let (header_len, traced) = self.frame_layout(pos, len);
+        let total_required = (header_len + len) as u32;
         if total_required > self.capacity {
             return Err(ShmError::MessageTooLarge);
         }
 
+        let (write, overwritten) = self.make_room(generation, total_required, 1)?;
+        if write != pos {
+            // reset посреди резерва: пропуск слота посчитан не от той позиции
+            return Err(ShmError::NotConnected);
+        }
+        Ok(WriteReservation {
+            write,
+            len: len as u32,
+            header_len: header_len as u32,
+            generation,
+            overwritten,
+            stamp: traced.then(|| enqueued.unwrap_or_else(win::perf_counter)),
+        })
+    }
+
+    /// Освобождает за текущим `write_pos` место под `bytes` байт и `messages`
+    /// сообщений (`messages <= max_messages`), при нехватке вытесняя старые
+    /// через `discard_oldest` (без вытеснения — `QueueFull`). Возвращает
+    /// `(write_pos, число вытесненных)`.
+    fn make_room(&self, generation: u32, bytes: u32, messages: u32) -> Result<(u32, u32)> {
         let header = self.header();
         let mut overwritten = 0u32;
 
         loop {
-            let write = header.write_pos.load(Ordering::Acquire);
-            let read = header.read_pos.load(Ordering::Acquire);
-            let available = self.available_bytes(write, read);
-            let count = header.message_count.load(Ordering::Acquire);
-
-            if available < total_required as i64 || count >= MAX_MESSAGES {
-                if count == 0 {
-                    // нет сообщений, но не хватает места — значит сообщение больше буфера
-                    return Err(ShmError::MessageTooLarge);
+            let write = header.producer.write_pos.load(Ordering::Acquire);
+            let published = header
+                .producer
+                .messages_written
+                .load(Ordering::Relaxed)
+                .wrapping_sub(header.producer.drop_count.load(Ordering::Relaxed));
+            let has_room = |read: u32, consumed: u32| {
+                self.available_bytes(write, read) >= bytes as i64
+                    && published.wrapping_sub(consumed) <= self.max_messages - messages
+            };
+
+            // Быстрый путь: снимка индексов consumer-а хватает, его линию не трогаем.
+            if let (Some(read), Some(consumed)) = (
+                self.cached_read.get(generation),
+                self.cached_consumed.get(generation),
+            ) {
+                if has_room(read, consumed) {
+                    return Ok((write, overwritten));
                 }
-                self.discard_oldest()?;
-                overwritten += 1;
-                continue;
             }
 
-            let idx = self.mask_index(write);
-            let len_le = (payload.len() as u16).to_le_bytes();
-            let flags = 0u16.to_le_bytes();
-            // SAFETY: каждый вызов copy_into_wrapped пишет <= capacity байт
-            // (len_le/flags -- по 2 байта, payload -- не более MAX_MESSAGE_SIZE,
-            // и total_required = MESSAGE_HEADER_SIZE+payload.len() уже
-            // проверен против self.capacity веткой availability-проверки выше).
-            unsafe {
-                self.copy_into_wrapped(idx, &len_le);
-                self.copy_into_wrapped((idx + 2) & (RING_MASK as usize), &flags);
-                self.copy_into_wrapped((idx + MESSAGE_HEADER_SIZE) & (RING_MASK as usize), payload);
+            let read = header.consumer.read_pos.load(Ordering::Acquire);
+            let consumed = header.consumer.messages_read.load(Ordering::Acquire);
+            self.cached_read.set(generation, read);
+            self.cached_consumed.set(generation, consumed);
+            if has_room(read, consumed) {
+                return Ok((write, overwritten));
             }
+            if read == write {
+                // нет сообщений, но не хватает места — значит сообщение больше буфера
+                return Err(ShmError::MessageTooLarge);
+            }
+            if !self.overwrite.load(Ordering::Relaxed) {
+                return Err(ShmError::QueueFull);
+            }
+            // consumer мог сдвинуть read_pos, но ещё не messages_read: тогда
+            // счёт завышен на одно сообщение и вытеснение у самого предела
+            // max_messages случится на одно раньше — безопасная сторона.
+            self.discard_oldest()?;
+            overwritten += 1;
+        }
+    }
+
+    /// Участки кольца под payload резерва: второй непуст только при переносе
+    /// через границу кольца. Заполнять нужно подряд — сначала первый, затем
+    /// второй; при `commit(_, used)` опубликуются первые `used` байт этой пары.
+    pub fn reservation_spans<'a>(
+        &'a self,
+        reservation: &'a mut WriteReservation,
+    ) -> (&'a mut [u8], &'a mut [u8]) {
+        let capacity = self.capacity as usize;
+        let start = (self.mask_index(reservation.write) + reservation.header_len as usize)
+            & (self.mask as usize);
+        let len = reservation.len as usize;
+        let first = len.min(capacity - start);
+        // SAFETY: [start, start+first) и [0, len-first) лежат в пределах
+        // storage (start < capacity, first <= capacity-start, len <= capacity
+        // проверено в reserve). Участки за write_pos reader не публикует, а
+        // producer у кольца один, поэтому &mut на время жизни резерва не
+        // пересекается с другой записью.
+        unsafe {
+            (
+                std::slice::from_raw_parts_mut(self.data_ptr().add(start), first),
+                std::slice::from_raw_parts_mut(self.data_ptr(), len - first),
+            )
+        }
+    }
+
+    /// Публикует резерв: пишет заголовок сообщения длиной `used` и сдвигает
+    /// `write_pos`. `used` может быть меньше зарезервированного — хвост резерва
+    /// просто возвращается кольцу (вид заголовка остаётся тем, что выбран при
+    /// резерве: payload уже лежит за ним). Если за время резерва произошёл reconnect
+    /// (сменился `connection_gen`), данные отбрасываются с `NotConnected`.
+    pub fn commit(&self, reservation: WriteReservation, used: usize) -> Result<WriteOutcome> {
+        if used < MIN_MESSAGE_SIZE || used < self.slot_size {
+            return Err(ShmError::MessageTooSmall);
+        }
+        if used > reservation.len as usize {
+            return Err(ShmError::MessageTooLarge);
+        }
+
+        let header = self.header();
+        if header.connection_gen.load(Ordering::Acquire) != reservation.generation {
+            return Err(ShmError::NotConnected);
+        }
 
-            // ВАЖНО: сначала увеличиваем message_count, потом обновляем write_pos
-            // Это гарантирует, что reader увидит count > 0 когда видит новый write_pos
-            // На x86/x64 TSO это безопасно, но порядок операций всё равно важен
-            let prev_count = header.message_count.fetch_add(1, Ordering::AcqRel);
+        let header_len = reservation.header_len as usize;
+        self.write_frame_header(reservation.write, header_len, used, reservation.stamp);
+        let end = reservation.write.wrapping_add((header_len + used) as u32);
 
-            let new_write = write.wrapping_add(total_required);
-            header.write_pos.store(new_write, Ordering::Release);
+        let was_empty = self.publish(reservation.generation, reservation.write, end, 1);
+        Ok(WriteOutcome {
+            overwritten: reservation.overwritten,
+            was_empty,
+            wake_consumer: was_empty && self.consumer_may_block(),
+        })
+    }
 
-            if prev_count == 0 {
-                header.sequence.fetch_add(1, Ordering::Relaxed);
+    /// Пишет заголовок кадра (короткий или длинный — по `header_len`) для
+    /// payload длиной `len` по позиции `pos`; со `stamp` — вместе с
+    /// расширением трассировки (`header_len` его уже включает).
+    fn write_frame_header(&self, pos: u32, header_len: usize, len: usize, stamp: Option<u64>) {
+        if self.slot_size != 0 {
+            return; // у слотов заголовка нет
+        }
+        let mut frame = [0u8; LONG_MESSAGE_HEADER_SIZE + TRACE_EXTENSION_SIZE];
+        let mut flags = 0u16;
+        let mut base = header_len;
+        if let Some(stamp) = stamp {
+            base -= TRACE_EXTENSION_SIZE;
+            flags |= MESSAGE_FLAG_TRACED;
+            // номер пишет только producer — хватает load/store без RMW
+            let sequence = self.sequence.load(Ordering::Relaxed);
+            self.sequence
+                .store(sequence.wrapping_add(1), Ordering::Relaxed);
+            frame[base..base + 8].copy_from_slice(&stamp.to_le_bytes());
+            frame[base + 8..base + 12].copy_from_slice(&sequence.to_le_bytes());
+        }
+        if base == LONG_MESSAGE_HEADER_SIZE {
+            flags |= MESSAGE_FLAG_LONG;
+            frame[4..8].copy_from_slice(&(len as u32).to_le_bytes());
+        } else {
+            frame[0..2].copy_from_slice(&(len as u16).to_le_bytes());
+        }
+        frame[2..4].copy_from_slice(&flags.to_le_bytes());
+        // SAFETY: заголовок -- не больше 24 байт, copy_into_wrapped сам
+        // переносит запись через границу кольца.
+        unsafe { self.copy_into_wrapped(self.mask_index(pos), &frame[..header_len]) };
+    }
+
+    /// Публикует `count` сообщений, записанных в `[start, end)`: один store
+    /// счётчика и один store `write_pos`. Возвращает `was_empty`.
+    fn publish(&self, generation: u32, start: u32, end: u32, count: u32) -> bool {
+        // Сначала счётчик, потом write_pos: увидев новый write_pos, consumer
+        // уже видит и опубликованные сообщения в messages_written, поэтому
+        // `message_count` не уходит в минус. Обе записи — в линию producer-а.
+        let producer = &self.header().producer;
+        let written = producer.messages_written.load(Ordering::Relaxed);
+        let total = written.wrapping_add(count);
+        // Метка для замера задержки — когда счёт переходит очередную границу
+        // LATENCY_SAMPLE_INTERVAL; до write_pos, чтобы consumer, увидевший
+        // публикацию, увидел и метку.
+        if (written ^ total) >= LATENCY_SAMPLE_INTERVAL {
+            producer
+                .publish_stamp
+                .store(stats::publish_stamp(end), Ordering::Relaxed);
+        }
+        producer.messages_written.store(total, Ordering::Release);
+        producer.write_pos.store(end, Ordering::Release);
+        let was_empty = self.was_drained(generation, start);
+        self.track_occupancy(generation, end, was_empty, count, total);
+        was_empty
+    }
+
+    /// High-water mark после публикации. `was_drained` только что освежил
+    /// снимок `read_pos` (или убедился, что он равен началу публикации),
+    /// так что байты считаются без лишних чтений; `messages_read` лежит в
+    /// той же, уже прочитанной линии consumer-а.
+    fn track_occupancy(&self, generation: u32, end: u32, was_empty: bool, count: u32, total: u32) {
+        let Some(read) = self.cached_read.get(generation) else {
+            return;
+        };
+        let messages = if was_empty {
+            count
+        } else {
+            let header = self.header();
+            total
+                .wrapping_sub(header.producer.drop_count.load(Ordering::Relaxed))
+                .wrapping_sub(header.consumer.messages_read.load(Ordering::Relaxed))
+        };
+        self.stats
+            .record_occupancy(end.wrapping_sub(read), messages);
+    }
+
+    #[allow(dead_code)]
+    pub fn write_message(&self, payload: &[u8]) -> Result<WriteOutcome> {
+        self.write_message_at(payload, None)
+    }
+
+    /// `write_message` с меткой постановки в очередь (см. `reserve_at`).
+    pub(crate) fn write_message_at(
+        &self,
+        payload: &[u8],
+        enqueued: Option<u64>,
+    ) -> Result<WriteOutcome> {
+        let mut reservation = self.reserve_at(payload.len(), enqueued)?;
+        let (first, second) = self.reservation_spans(&mut reservation);
+        let split = first.len();
+        // SAFETY: спаны резерва — свободная часть кольца ровно под payload.
+        unsafe {
+            copy_to_shared(first.as_mut_ptr(), &payload[..split]);
+            copy_to_shared(second.as_mut_ptr(), &payload[split..]);
+        }
+        self.commit(reservation, payload.len())
+    }
+
+    /// Пишет пачку сообщений с одной публикацией `write_pos` — consumer видит
+    /// их разом, а `was_empty` (и значит пробуждение) не больше одного.
+    ///
+    /// Размеры проверяются до записи: при ошибке валидации не пишется ничего.
+    /// Пачка, не влезающая в кольцо целиком (по байтам или `max_messages`),
+    /// публикуется несколькими частями по одному store на часть; `was_empty`
+    /// в итоге — true, если его дала любая часть. `NotConnected` (reconnect
+    /// посреди пачки) и `QueueFull` (кольцо без вытеснения) оставляют уже
+    /// опубликованные части в кольце.
+    #[allow(dead_code)]
+    pub fn write_batch(&self, messages: &[&[u8]]) -> Result<WriteOutcome> {
+        let mut outcome = WriteOutcome::default();
+        let written = self.write_batch_prefix(messages, &mut outcome)?;
+        if written < messages.len() {
+            return Err(ShmError::QueueFull);
+        }
+        Ok(outcome)
+    }
+
+    /// Ядро `write_batch`: публикует части пачки, пока хватает места, и
+    /// возвращает число опубликованных сообщений, накапливая итог в
+    /// `outcome`. `QueueFull` — только если не влезла даже первая часть;
+    /// на остатке пачки можно просто позвать ещё раз.
+    pub(crate) fn write_batch_prefix(
+        &self,
+        messages: &[&[u8]],
+        outcome: &mut WriteOutcome,
+    ) -> Result<usize> {
+        for message in messages {
+            if message.len() < MIN_MESSAGE_SIZE || message.len() < self.slot_size {
+                return Err(ShmError::MessageTooSmall);
             }
+            if message.len() > self.max_message_size {
+                return Err(ShmError::MessageTooLarge);
+            }
+        }
 
-            return Ok(WriteOutcome {
-                overwritten,
-                was_empty: prev_count == 0,
-            });
+        let generation = self.header().connection_gen.load(Ordering::Acquire);
+        let mut rest = messages;
+        while !rest.is_empty() {
+            // Самый длинный префикс, который влезает в пустое кольцо; хотя бы
+            // одно сообщение влезает всегда (ChannelGeometry::validate).
+            // Пропуски слотов зависят от позиции — считаем от write_pos,
+            // который вернёт make_room.
+            let write = self.header().producer.write_pos.load(Ordering::Acquire);
+            let mut bytes = 0usize;
+            let mut count = 0usize;
+            for message in rest {
+                let pos = write.wrapping_add(bytes as u32);
+                let frame = self.frame_layout(pos, message.len()).0 + message.len();
+                if count as u32 == self.max_messages || bytes + frame > self.capacity as usize {
+                    break;
+                }
+                bytes += frame;
+                count += 1;
+            }
+            let (chunk, tail) = rest.split_at(count);
+
+            let (start, overwritten) = match self.make_room(generation, bytes as u32, count as u32)
+            {
+                Ok(room) => room,
+                Err(ShmError::QueueFull) if rest.len() < messages.len() => break,
+                Err(err) => return Err(err),
+            };
+            if start != write {
+                return Err(ShmError::NotConnected); // reset посреди пачки
+            }
+            // одна метка на часть: её сообщения публикуются разом
+            let stamp = self.trace.then(win::perf_counter);
+            let mut pos = start;
+            for message in chunk {
+                let (header_len, traced) = self.frame_layout(pos, message.len());
+                let stamp = stamp.filter(|_| traced);
+                self.write_frame_header(pos, header_len, message.len(), stamp);
+                // SAFETY: message.len() <= max_message_size < capacity;
+                // copy_into_wrapped сам переносит запись через границу кольца.
+                unsafe { self.copy_into_wrapped(self.mask_index(pos) + header_len, message) };
+                pos = pos.wrapping_add((header_len + message.len()) as u32);
+            }
+
+            if self.header().connection_gen.load(Ordering::Acquire) != generation {
+                return Err(ShmError::NotConnected);
+            }
+            outcome.was_empty |= self.publish(generation, start, pos, count as u32);
+            outcome.overwritten += overwritten;
+            rest = tail;
         }
+        // флаг проверяется после последней публикации — она видна consumer-у
+        // позже всех, поэтому одной проверки хватает на всю пачку
+        outcome.wake_consumer = outcome.was_empty && self.consumer_may_block();
+        Ok(messages.len() - rest.len())
     }
 
-    pub fn read_message(&self, out: &mut Vec<u8>) -> Result<usize> {
+    /// Заглядывает в самое старое сообщение, не забирая его (zero-copy чтение).
+    ///
+    /// Возвращённые [`RingBuffer::peeked_spans`] указывают прямо в storage.
+    /// Overwrite-политика сохраняется: producer может вытеснить и перезаписать
+    /// это сообщение, пока его читают, поэтому содержимое считается валидным
+    /// только после успешного [`RingBuffer::consume`] (seqlock-проверка).
+    pub fn peek(&self) -> Result<PeekedMessage> {
         let header = self.header();
 
         loop {
-            let count = header.message_count.load(Ordering::Acquire);
-            if count == 0 {
+            let generation = header.connection_gen.load(Ordering::Acquire);
+            let read = header.consumer.read_pos.load(Ordering::Acquire);
+            if !self.has_pending(generation, read) {
                 return Err(ShmError::QueueEmpty);
             }
 
-            let read = header.read_pos.load(Ordering::Acquire);
             let idx = self.mask_index(read);
-            // SAFETY: idx = read & RING_MASK всегда < capacity (mask_index).
-            let msg_len = unsafe { self.read_u16(idx) } as usize;
-            if !(MIN_MESSAGE_SIZE..=MAX_MESSAGE_SIZE).contains(&msg_len) {
+            // SAFETY: idx = read & mask всегда < capacity (mask_index).
+            let frame = unsafe { self.read_frame(idx) };
+            if !(MIN_MESSAGE_SIZE..=self.max_message_size).contains(&frame.len) {
                 // Длина могла быть «порвана» перезаписью producer-а. Если read_pos
                 // уже сдвинулся — это гонка перезаписи, повторяем. Иначе буфер
                 // действительно повреждён.
-                if header.read_pos.load(Ordering::Acquire) != read {
+                if header.consumer.read_pos.load(Ordering::Acquire) != read {
                     continue;
                 }
                 return Err(ShmError::Corrupted);
             }
 
-            let total = MESSAGE_HEADER_SIZE + msg_len;
-            let new_read = read.wrapping_add(total as u32);
+            return Ok(PeekedMessage {
+                read,
+                len: frame.len as u32,
+                header_len: frame.header_len as u32,
+                generation,
+                trace: frame
+                    .traced
+                    .then(|| self.read_trace(read, &frame, win::perf_counter())),
+            });
+        }
+    }
+
+    /// Участки кольца с payload подсмотренного сообщения: второй непуст только
+    /// при переносе через границу кольца.
+    pub fn peeked_spans<'a>(&'a self, message: &'a PeekedMessage) -> (&'a [u8], &'a [u8]) {
+        self.payload_spans(
+            message.read,
+            message.header_len as usize,
+            message.len as usize,
+        )
+    }
+
+    /// Участки storage с payload кадра по позиции `pos`.
+    fn payload_spans(&self, pos: u32, header_len: usize, len: usize) -> (&[u8], &[u8]) {
+        let capacity = self.capacity as usize;
+        let start = (self.mask_index(pos) + header_len) & (self.mask as usize);
+        let first = len.min(capacity - start);
+        // SAFETY: оба участка лежат в пределах storage (start < capacity,
+        // first <= capacity-start, len <= max_message_size < capacity).
+        // Конкурентная перезапись producer-ом возможна и ловится в commit_read.
+        unsafe {
+            (
+                std::slice::from_raw_parts(self.data_ptr().add(start), first),
+                std::slice::from_raw_parts(self.data_ptr(), len - first),
+            )
+        }
+    }
+
+    /// Забирает подсмотренное сообщение, сдвигая `read_pos`.
+    ///
+    /// `Err(Overwritten)` — producer вытеснил сообщение (или случился
+    /// reconnect) после `peek`: всё, что было прочитано через spans, надо
+    /// отбросить и повторить `peek`.
+    pub fn consume(&self, message: PeekedMessage) -> Result<usize> {
+        let new_read = message.read.wrapping_add(message.header_len + message.len);
+        self.commit_read(message.generation, message.read, new_read, 1)?;
+        if let Some(trace) = message.trace {
+            self.stats.record_queue_delay(trace.queued_ns);
+        }
+        Ok(message.len as usize)
+    }
+
+    /// Забирает `count` сообщений из `[read, new_read)` одним CAS по
+    /// `read_pos`. `Err(Overwritten)` — producer вытеснил часть из них (или
+    /// случился reconnect), прочитанное из этого диапазона невалидно.
+    fn commit_read(&self, generation: u32, read: u32, new_read: u32, count: u32) -> Result<()> {
+        let header = self.header();
+
+        // Барьер компилятора: чтение spans не должно «переехать» НИЖЕ CAS,
+        // иначе валидация теряет смысл. На x86 успешный lock cmpxchg также
+        // даёт аппаратный барьер.
+        compiler_fence(Ordering::Release);
+
+        if header.connection_gen.load(Ordering::Acquire) != generation {
+            return Err(ShmError::Overwritten);
+        }
+
+        // Фиксация: атомарно забираем слоты. Провал => producer сдвинул read_pos
+        // (перезапись/конкурентный discard) => прочитанные байты невалидны.
+        let consumer = &header.consumer;
+        if consumer
+            .read_pos
+            .compare_exchange(read, new_read, Ordering::AcqRel, Ordering::Acquire)
+            .is_err()
+        {
+            return Err(ShmError::Overwritten);
+        }
+
+        // messages_read пишет только consumer — обычный store вместо RMW
+        let consumed = consumer.messages_read.load(Ordering::Relaxed);
+        consumer
+            .messages_read
+            .store(consumed.wrapping_add(count), Ordering::Release);
+        self.sample_latency(read, new_read);
+        Ok(())
+    }
+
+    /// Забрано `[read, new_read)`: если в диапазоне кончается публикация с
+    /// меткой времени, записать её задержку.
+    fn sample_latency(&self, read: u32, new_read: u32) {
+        let stamp = self.pending_stamp.load(Ordering::Relaxed);
+        if stamp == 0 {
+            return;
+        }
+        let end = stamp as u32;
+        if (new_read.wrapping_sub(end) as i32) < 0 {
+            return; // до помеченной публикации ещё не дочитали
+        }
+        self.pending_stamp.store(0, Ordering::Relaxed);
+        // метка не старше прочитанного (не вытесненная и не из прошлого
+        // соединения)
+        if end.wrapping_sub(read) as i32 > 0 {
+            self.stats.record_latency_ticks(stats::stamp_age(stamp));
+        }
+    }
+
+    /// Забирает до `max_messages` сообщений в `batch` одним CAS по `read_pos`.
+    ///
+    /// Payload-ы копируются подряд в арену пачки (та же seqlock-схема, что в
+    /// `read_message`: копия до фиксации, при вытеснении — повтор). Пачка
+    /// обрывается перед сообщением, с которым арена превысила бы `max_bytes`;
+    /// первое сообщение берётся всегда, даже если оно само больше `max_bytes`
+    /// — вызывающий с фиксированным буфером проверяет это сам.
+    pub fn read_batch(
+        &self,
+        batch: &mut MessageBatch,
+        max_messages: usize,
+        max_bytes: usize,
+    ) -> Result<usize> {
+        batch.clear();
+        self.append_batch(batch, max_messages, max_bytes)
+    }
+
+    /// `read_batch` без очистки: дописывает сообщения к уже лежащим в
+    /// `batch` (разбор нескольких дорожек в одну пачку). Пределы считаются
+    /// по всей пачке; `Ok(0)` — в кольце есть данные, но пачка уже полна.
+    pub fn append_batch(
+        &self,
+        batch: &mut MessageBatch,
+        max_messages: usize,
+        max_bytes: usize,
+    ) -> Result<usize> {
+        let header = self.header();
+        let (start, start_bytes) = (batch.len(), batch.arena.len());
+
+        'retry: loop {
+            batch.truncate(start, start_bytes);
+            let generation = header.connection_gen.load(Ordering::Acquire);
+            let read = header.consumer.read_pos.load(Ordering::Acquire);
+            if !self.has_pending(generation, read) {
+                return Err(ShmError::QueueEmpty);
+            }
+            // has_pending оставил годный снимок write_pos этого поколения
+            let Some(write) = self.cached_write.get(generation) else {
+                continue;
+            };
+            let published = write.wrapping_sub(read) as usize;
+
+            // часы читаются один раз на пачку и только ради трассируемых кадров
+            let mut now = None;
+            let mut offset = 0usize;
+            while offset < published && batch.len() < max_messages.max(1) {
+                let pos = read.wrapping_add(offset as u32);
+                // SAFETY: mask_index(pos) < capacity.
+                let frame = unsafe { self.read_frame(self.mask_index(pos)) };
+                let (len, header_len) = (frame.len, frame.header_len);
+                if !(MIN_MESSAGE_SIZE..=self.max_message_size).contains(&len)
+                    || offset + header_len + len > published
+                {
+                    // Порванный заголовок: гонка перезаписи — повторяем, иначе
+                    // буфер действительно повреждён (как в peek).
+                    if header.consumer.read_pos.load(Ordering::Acquire) != read {
+                        continue 'retry;
+                    }
+                    return Err(ShmError::Corrupted);
+                }
+                if !batch.is_empty() && batch.arena.len() + len > max_bytes {
+                    break;
+                }
+                let (first, second) = self.payload_spans(pos, header_len, len);
+                extend_from_shared(&mut batch.arena, first);
+                extend_from_shared(&mut batch.arena, second);
+                batch.ends.push(batch.arena.len());
+                if frame.traced {
+                    let now = *now.get_or_insert_with(win::perf_counter);
+                    batch.trace_last(self.read_trace(pos, &frame, now));
+                }
+                offset += header_len + len;
+            }
+
+            let count = batch.len() - start;
+            if count == 0 {
+                return Ok(0);
+            }
+            let new_read = read.wrapping_add(offset as u32);
+            match self.commit_read(generation, read, new_read, count as u32) {
+                Ok(()) => {
+                    for trace in batch.traces.iter().skip(start).flatten() {
+                        self.stats.record_queue_delay(trace.queued_ns);
+                    }
+                    return Ok(count);
+                }
+                Err(ShmError::Overwritten) => continue,
+                Err(err) => return Err(err),
+            }
+        }
+    }
+
+    pub fn read_message(&self, out: &mut Vec<u8>) -> Result<usize> {
+        loop {
+            let message = self.peek()?;
 
             // ОПТИМИСТИЧНОЕ копирование ДО фиксации read_pos (seqlock-паттерн).
-            // Если producer перезапишет слот во время копирования, CAS ниже
+            // Если producer перезапишет слот во время копирования, consume
             // провалится, и мы отбросим эту (потенциально битую) копию.
-            // SAFETY: clear + reserve гарантируют capacity >= msg_len; copy_from_wrapped
-            // читает строго в пределах кольца (wrap по модулю capacity).
+            let (first, second) = self.peeked_spans(&message);
             out.clear();
-            out.reserve(msg_len);
-            debug_assert!(out.capacity() >= msg_len);
-            unsafe {
-                out.set_len(msg_len);
-                self.copy_from_wrapped(
-                    (idx + MESSAGE_HEADER_SIZE) & (RING_MASK as usize),
-                    out.as_mut_slice(),
-                );
+            extend_from_shared(out, first);
+            extend_from_shared(out, second);
+
+            match self.consume(message) {
+                Ok(len) => return Ok(len),
+                Err(ShmError::Overwritten) => continue,
+                Err(err) => return Err(err),
             }
+        }
+    }
 
-            // Барьер компилятора: копирование не должно «переехать» НИЖЕ CAS,
-            // иначе валидация теряет смысл. На x86 успешный lock cmpxchg также
-            // даёт аппаратный барьер.
-            compiler_fence(Ordering::Release);
+    /// Producer, только что сдвинувший `write_pos` с `prev_write`: было ли
+    /// кольцо пустым, т.е. мог ли consumer уже уснуть в ожидании данных.
+    fn was_drained(&self, generation: u32, prev_write: u32) -> bool {
+        // read_pos не обгоняет write_pos: снимок, равный prev_write, точен
+        if self.cached_read.get(generation) == Some(prev_write) {
+            return true;
+        }
+        // StoreLoad-барьер между публикацией write_pos и чтением read_pos
+        // (Dekker): либо мы видим, что consumer всё дочитал, либо consumer
+        // после своего CAS по read_pos увидит наш write_pos и не уснёт.
+        fence(Ordering::SeqCst);
+        let read = self.header().consumer.read_pos.load(Ordering::Acquire);
+        self.cached_read.set(generation, read);
+        read == prev_write
+    }
 
-            // Фиксация: атомарно забираем слот. Провал => producer сдвинул read_pos
-            // (перезапись/конкурентный discard) => скопированные байты невалидны,
-            // повторяем с актуальными значениями.
-            if header
-                .read_pos
-                .compare_exchange(read, new_read, Ordering::AcqRel, Ordering::Acquire)
-                .is_err()
-            {
-                continue;
-            }
+    /// Producer после публикации в пустое кольцо: может ли consumer спать на
+    /// data-событии. Пара к [`RingBuffer::stop_spinning`] (Dekker): либо мы
+    /// видим снятый флаг и сигналим, либо consumer после снятия флага увидит
+    /// наш `write_pos` и блокироваться не станет.
+    fn consumer_may_block(&self) -> bool {
+        fence(Ordering::SeqCst);
+        self.header().consumer.spinning.load(Ordering::Relaxed) == 0
+    }
 
-            let prev_count = header.message_count.fetch_sub(1, Ordering::AcqRel);
-            if prev_count <= 1 {
-                header.sequence.fetch_add(1, Ordering::Relaxed);
-            }
+    /// Consumer переходит к активному ожиданию: пока флаг стоит, producer не
+    /// сигналит data-событие. Флаг можно держать и во время обработки данных —
+    /// снять его обязательно перед блокировкой на событии.
+    pub fn start_spinning(&self) {
+        self.header().consumer.spinning.store(1, Ordering::Relaxed);
+    }
 
-            return Ok(msg_len);
+    /// Consumer собирается блокироваться: снимает флаг и перепроверяет кольцо.
+    /// `true` — данные пришли, пока флаг стоял (их producer не просигналил),
+    /// блокироваться нельзя.
+    pub fn stop_spinning(&self) -> bool {
+        self.header().consumer.spinning.store(0, Ordering::Relaxed);
+        // StoreLoad: снятие флага должно стать видимым до чтения write_pos
+        fence(Ordering::SeqCst);
+        !self.is_empty()
+    }
+
+    /// Consumer на позиции `read`: есть ли опубликованное сообщение. Свежий
+    /// `write_pos` читается, только если снимок уже исчерпан.
+    fn has_pending(&self, generation: u32, read: u32) -> bool {
+        if let Some(write) = self.cached_write.get(generation) {
+            // знаковая дистанция: read_pos мог уйти за старый снимок через
+            // discard_oldest (ёмкость <= 1 ГБ, переполнения i32 нет)
+            if write.wrapping_sub(read) as i32 > 0 {
+                return true;
+            }
         }
+        let producer = &self.header().producer;
+        let write = producer.write_pos.load(Ordering::Acquire);
+        self.cached_write.set(generation, write);
+        // метка лежит в той же линии producer-а, что и write_pos
+        let stamp = producer.publish_stamp.load(Ordering::Relaxed);
+        if stamp != 0 {
+            self.pending_stamp.store(stamp, Ordering::Relaxed);
+        }
+        write != read
     }
 
+    /// Число сообщений в кольце. Счётчики читаются с обеих линий, поэтому
+    /// вне горячего пути: для диагностики и тестов.
+    #[allow(dead_code)]
     pub fn message_count(&self) -> u32 {
-        self.header().message_count.load(Ordering::Acquire)
+        let header = self.header();
+        // Порядок важен: сообщение попадает в messages_read/drop_count только
+        // после messages_written, поэтому разность не уходит в минус.
+        let consumed = header.consumer.messages_read.load(Ordering::Acquire);
+        let dropped = header.producer.drop_count.load(Ordering::Acquire);
+        let written = header.producer.messages_written.load(Ordering::Acquire);
+        written.wrapping_sub(dropped).wrapping_sub(consumed)
     }
 
     #[allow(dead_code)]
     pub fn drop_count(&self) -> u32 {
-        self.header().drop_count.load(Ordering::Acquire)
+        self.header().producer.drop_count.load(Ordering::Acquire)
     }
 
+    /// Пусто ли кольцо с точки зрения consumer-а.
     pub fn is_empty(&self) -> bool {
-        self.message_count() == 0
+        let header = self.header();
+        let generation = header.connection_gen.load(Ordering::Acquire);
+        let read = header.consumer.read_pos.load(Ordering::Acquire);
+        !self.has_pending(generation, read)
     }
 }
 
 #[cfg(test)]
-mod overflow_race_tests {
+pub(crate) mod overflow_race_tests {
     use super::*;
     use crate::layout::RingHeader;
     use std::alloc::{alloc_zeroed, dealloc, Layout};
@@ -328,8 +1272,8 @@ mod overflow_race_tests {
     use std::sync::Arc;
     use std::thread;
 
-    /// Владелец сырой выровненной памяти под один RingHeader + RING_CAPACITY.
-    struct RingMem {
+    /// Владелец сырой выровненной памяти под один RingHeader + storage кольца.
+    pub(crate) struct RingMem {
         ptr: *mut u8,
         layout: Layout,
     }
@@ -342,9 +1286,17 @@ mod overflow_race_tests {
         }
     }
 
-    fn make_ring() -> (RingBuffer, RingMem) {
+    pub(crate) fn make_ring() -> (RingBuffer, RingMem) {
+        make_ring_with(RING_CAPACITY, MAX_MESSAGES, MAX_MESSAGE_SIZE)
+    }
+
+    pub(crate) fn make_ring_with(
+        capacity: usize,
+        max_messages: u32,
+        max_message_size: usize,
+    ) -> (RingBuffer, RingMem) {
         let header_size = std::mem::size_of::<RingHeader>();
-        let total = header_size + RING_CAPACITY;
+        let total = header_size + capacity;
         let layout = Layout::from_size_align(total, 64).unwrap();
         // SAFETY: ненулевой размер; зануление валидно для AtomicU32 полей.
         let ptr = unsafe { alloc_zeroed(layout) };
@@ -355,7 +1307,8 @@ mod overflow_race_tests {
         // SAFETY: data сразу за заголовком, в пределах выделения.
         let data = unsafe { ptr.add(header_size) };
         // SAFETY: header и data валидны, не пересекаются, живут пока жив RingMem.
-        let ring = unsafe { RingBuffer::new(header, data) };
+        let ring =
+            unsafe { RingBuffer::new(header, data, capacity, max_messages, max_message_size) };
         (ring, RingMem { ptr, layout })
     }
 
@@ -463,3 +1416,788 @@ mod overflow_race_tests {
         );
     }
 }
+
+#[cfg(test)]
+mod reservation_tests {
+    use super::overflow_race_tests::make_ring;
+    use super::*;
+
+    /// Ставит пустое кольцо так, чтобы следующая запись начиналась за
+    /// `tail` байт до физического конца storage.
+    fn park_near_end(ring: &RingBuffer, tail: u32) {
+        let pos = RING_CAPACITY as u32 - tail;
+        ring.header()
+            .producer
+            .write_pos
+            .store(pos, Ordering::Release);
+        ring.header()
+            .consumer
+            .read_pos
+            .store(pos, Ordering::Release);
+    }
+
+    #[test]
+    fn reserve_commit_roundtrip_across_wrap() {
+        let (ring, _mem) = make_ring();
+        park_near_end(&ring, 10);
+
+        let payload: Vec<u8> = (0..100u8).collect();
+        let mut reservation = ring.reserve(payload.len()).unwrap();
+        let (first, second) = ring.reservation_spans(&mut reservation);
+        // заголовок занял 4 из 10 хвостовых байт -> 6 байт до конца, остальное с начала
+        assert_eq!(first.len(), 6);
+        assert_eq!(second.len(), 94);
+        first.copy_from_slice(&payload[..6]);
+        second.copy_from_slice(&payload[6..]);
+        let outcome = ring.commit(reservation, payload.len()).unwrap();
+        assert!(outcome.was_empty);
+
+        let mut out = Vec::new();
+        assert_eq!(ring.read_message(&mut out).unwrap(), payload.len());
+        assert_eq!(out, payload);
+    }
+
+    #[test]
+    fn commit_shorter_than_reserved_publishes_prefix() {
+        let (ring, _mem) = make_ring();
+        let mut reservation = ring.reserve(64).unwrap();
+        let (first, _) = ring.reservation_spans(&mut reservation);
+        first[..5].copy_from_slice(b"hello");
+        ring.commit(reservation, 5).unwrap();
+        ring.write_message(b"next").unwrap();
+
+        let mut out = Vec::new();
+        ring.read_message(&mut out).unwrap();
+        assert_eq!(out, b"hello");
+        ring.read_message(&mut out).unwrap();
+        assert_eq!(out, b"next");
+    }
+
+    #[test]
+    fn dropped_reservation_publishes_nothing() {
+        let (ring, _mem) = make_ring();
+        let reservation = ring.reserve(32).unwrap();
+        drop(reservation);
+        assert!(ring.is_empty());
+        ring.write_message(b"ok").unwrap();
+        let mut out = Vec::new();
+        ring.read_message(&mut out).unwrap();
+        assert_eq!(out, b"ok");
+    }
+
+    /// Reconnect (reset заголовка с новым generation) между reserve и commit
+    /// не должен публиковать сообщение по устаревшей позиции.
+    #[test]
+    fn commit_after_generation_change_is_rejected() {
+        let (ring, _mem) = make_ring();
+        let reservation = ring.reserve(16).unwrap();
+        ring.reset(2);
+        assert!(matches!(
+            ring.commit(reservation, 16),
+            Err(ShmError::NotConnected)
+        ));
+        assert!(ring.is_empty());
+    }
+}
+
+#[cfg(test)]
+mod peek_tests {
+    use super::overflow_race_tests::make_ring;
+    use super::*;
+
+    #[test]
+    fn peek_then_consume_returns_message_in_place() {
+        let (ring, _mem) = make_ring();
+        let pos = RING_CAPACITY as u32 - 8;
+        ring.header()
+            .producer
+            .write_pos
+            .store(pos, Ordering::Release);
+        ring.header()
+            .consumer
+            .read_pos
+            .store(pos, Ordering::Release);
+        let payload: Vec<u8> = (0..40u8).collect();
+        ring.write_message(&payload).unwrap();
+
+        let message = ring.peek().unwrap();
+        let (first, second) = ring.peeked_spans(&message);
+        assert_eq!(first.len(), 4);
+        assert_eq!([first, second].concat(), payload);
+        // peek не забирает сообщение
+        assert_eq!(ring.message_count(), 1);
+        assert_eq!(ring.consume(message).unwrap(), payload.len());
+        assert!(ring.is_empty());
+    }
+
+    /// Вытеснение подсмотренного сообщения producer-ом должно ловиться
+    /// в consume, а не молча отдавать перезаписанные байты.
+    #[test]
+    fn consume_after_overwrite_reports_overwritten() {
+        let (ring, _mem) = make_ring();
+        ring.write_message(b"first").unwrap();
+        let message = ring.peek().unwrap();
+        for _ in 0..MAX_MESSAGES {
+            ring.write_message(b"flood").unwrap();
+        }
+        assert!(matches!(ring.consume(message), Err(ShmError::Overwritten)));
+
+        let mut out = Vec::new();
+        ring.read_message(&mut out).unwrap();
+        assert_eq!(out, b"flood");
+    }
+}
+
+#[cfg(test)]
+mod geometry_tests {
+    use super::overflow_race_tests::make_ring_with;
+    use super::*;
+
+    /// При поднятом пределе числа сообщений кольцо заполняется по байтам,
+    /// а не вытесняет данные по счётчику при почти пустом буфере.
+    #[test]
+    fn raised_message_limit_avoids_count_based_overwrite() {
+        let (ring, _mem) = make_ring_with(64 * 1024, 10_000, 1024);
+        for i in 0..2_000u32 {
+            let outcome = ring.write_message(&i.to_le_bytes()).unwrap();
+            assert_eq!(outcome.overwritten, 0, "overwrite at message {i}");
+        }
+        assert_eq!(ring.message_count(), 2_000);
+    }
+
+    #[test]
+    fn small_ring_enforces_configured_limits() {
+        let (ring, _mem) = make_ring_with(4 * 1024, 4, 256);
+        assert!(matches!(
+            ring.write_message(&[0u8; 257]),
+            Err(ShmError::MessageTooLarge)
+        ));
+        for _ in 0..5 {
+            ring.write_message(&[1u8; 16]).unwrap();
+        }
+        assert_eq!(ring.message_count(), 4);
+        assert_eq!(ring.drop_count(), 1);
+
+        // позиции переходят через границу маленького кольца без порчи данных
+        let mut out = Vec::new();
+        for i in 0..1_000u32 {
+            let payload = [i as u8; 200];
+            ring.write_message(&payload).unwrap();
+            while ring.message_count() > 1 {
+                ring.read_message(&mut out).unwrap();
+            }
+        }
+        ring.read_message(&mut out).unwrap();
+        assert_eq!(out, [(999u32) as u8; 200]);
+    }
+}
+
+#[cfg(test)]
+mod overflow_policy_tests {
+    use super::overflow_race_tests::make_ring_with;
+    use super::*;
+
+    /// Без вытеснения полное кольцо отвечает `QueueFull` и ничего не теряет.
+    #[test]
+    fn full_ring_without_overwrite_rejects_instead_of_dropping() {
+        let (ring, _mem) = make_ring_with(4 * 1024, 4, 256);
+        ring.set_overwrite(false);
+        for i in 0..4u8 {
+            ring.write_message(&[i; 16]).unwrap();
+        }
+        assert!(matches!(
+            ring.write_message(&[9u8; 16]),
+            Err(ShmError::QueueFull)
+        ));
+        assert!(matches!(ring.reserve(16), Err(ShmError::QueueFull)));
+        assert_eq!(ring.drop_count(), 0);
+
+        let mut out = Vec::new();
+        ring.read_message(&mut out).unwrap();
+        assert_eq!(out, [0u8; 16]);
+        ring.write_message(&[4u8; 16]).unwrap();
+        for i in 1..5u8 {
+            ring.read_message(&mut out).unwrap();
+            assert_eq!(out, [i; 16]);
+        }
+    }
+
+    /// Пачка без вытеснения публикуется частями: сколько влезло — столько и
+    /// принято, остаток дописывается следующим вызовом.
+    #[test]
+    fn batch_prefix_publishes_what_fits() {
+        let (ring, _mem) = make_ring_with(4 * 1024, 2, 256);
+        ring.set_overwrite(false);
+        let messages: Vec<&[u8]> = vec![b"one", b"two", b"three"];
+
+        let mut outcome = WriteOutcome::default();
+        assert_eq!(ring.write_batch_prefix(&messages, &mut outcome).unwrap(), 2);
+        assert!(outcome.was_empty);
+        let mut outcome = WriteOutcome::default();
+        assert!(matches!(
+            ring.write_batch_prefix(&messages[2..], &mut outcome),
+            Err(ShmError::QueueFull)
+        ));
+
+        let mut out = Vec::new();
+        ring.read_message(&mut out).unwrap();
+        ring.read_message(&mut out).unwrap();
+        assert_eq!(out, b"two");
+        assert_eq!(
+            ring.write_batch_prefix(&messages[2..], &mut outcome)
+                .unwrap(),
+            1
+        );
+        ring.read_message(&mut out).unwrap();
+        assert_eq!(out, b"three");
+        assert_eq!(ring.drop_count(), 0);
+    }
+
+    /// Политика переживает запись в атомик без потерь, кроме таймаутов, не
+    /// представимых в наносекундах.
+    #[test]
+    fn atomic_policy_round_trips() {
+        let cell = AtomicOverflowPolicy::new(OverflowPolicy::Overwrite);
+        for policy in [
+            OverflowPolicy::Fail,
+            OverflowPolicy::Block(Duration::ZERO),
+            OverflowPolicy::Block(Duration::from_millis(250)),
+            OverflowPolicy::Block(Duration::MAX),
+            OverflowPolicy::Overwrite,
+        ] {
+            cell.store(policy);
+            assert_eq!(cell.load(), policy);
+        }
+        cell.store(OverflowPolicy::Block(Duration::from_secs(u64::MAX / 2)));
+        assert_eq!(cell.load(), OverflowPolicy::Block(Duration::MAX));
+    }
+}
+
+#[cfg(test)]
+mod long_frame_tests {
+    use super::overflow_race_tests::make_ring_with;
+    use super::*;
+
+    fn pattern(len: usize, seed: u8) -> Vec<u8> {
+        (0..len).map(|i| (i as u8).wrapping_add(seed)).collect()
+    }
+
+    #[test]
+    fn large_messages_roundtrip_across_wrap() {
+        let (ring, _mem) = make_ring_with(1024 * 1024, MAX_MESSAGES, 400 * 1024);
+        let mut out = Vec::new();
+        // 300 КБ + 8 не кратно ёмкости: кадры (и их заголовки) ложатся
+        // поперёк границы кольца
+        for seed in 0..16u8 {
+            let payload = pattern(300 * 1024 + seed as usize, seed);
+            ring.write_message(&payload).unwrap();
+            assert_eq!(ring.read_message(&mut out).unwrap(), payload.len());
+            assert_eq!(out, payload);
+        }
+        // короткие кадры по-прежнему используют 4-байтовый заголовок
+        ring.write_message(&[7u8; MAX_MESSAGE_SIZE]).unwrap();
+        ring.read_message(&mut out).unwrap();
+        assert_eq!(out.len(), MAX_MESSAGE_SIZE);
+        assert!(ring.is_empty());
+    }
+
+    #[test]
+    fn overflow_discards_long_frames_by_their_length() {
+        let (ring, _mem) = make_ring_with(1024 * 1024, MAX_MESSAGES, 400 * 1024);
+        for seed in 0..3u8 {
+            ring.write_message(&pattern(300 * 1024, seed)).unwrap();
+        }
+        let outcome = ring.write_message(&pattern(300 * 1024, 3)).unwrap();
+        assert_eq!(outcome.overwritten, 1);
+
+        let mut out = Vec::new();
+        for seed in 1..4u8 {
+            ring.read_message(&mut out).unwrap();
+            assert_eq!(out, pattern(300 * 1024, seed));
+        }
+    }
+
+    #[test]
+    fn shrunk_long_reservation_keeps_long_frame() {
+        let (ring, _mem) = make_ring_with(1024 * 1024, MAX_MESSAGES, 400 * 1024);
+        let mut reservation = ring.reserve(200 * 1024).unwrap();
+        let (first, _) = ring.reservation_spans(&mut reservation);
+        first[..100].copy_from_slice(&[9u8; 100]);
+        ring.commit(reservation, 100).unwrap();
+
+        let message = ring.peek().unwrap();
+        assert_eq!(message.message_len(), 100);
+        let (first, second) = ring.peeked_spans(&message);
+        assert_eq!(first, &[9u8; 100][..]);
+        assert!(second.is_empty());
+        ring.consume(message).unwrap();
+        assert!(ring.is_empty());
+    }
+}
+
+#[cfg(test)]
+mod fixed_slot_tests {
+    use super::overflow_race_tests::{make_ring_with, RingMem};
+    use super::*;
+
+    const SLOT: usize = 48;
+    const CAPACITY: usize = 4 * 1024;
+
+    fn slot_ring(max_messages: u32) -> (RingBuffer, RingMem) {
+        let (mut ring, mem) = make_ring_with(CAPACITY, max_messages, SLOT);
+        ring.set_slot_size(SLOT);
+        (ring, mem)
+    }
+
+    fn slot(seq: u32) -> [u8; SLOT] {
+        let mut payload = [seq as u8; SLOT];
+        payload[..4].copy_from_slice(&seq.to_le_bytes());
+        payload
+    }
+
+    /// Слот, не влезающий в хвост storage, целиком уходит в начало кольца:
+    /// и резерв, и peek выдают один спан.
+    #[test]
+    fn slot_never_straddles_the_wrap() {
+        let (ring, _mem) = slot_ring(MAX_MESSAGES);
+        let pos = CAPACITY as u32 - 20;
+        ring.header()
+            .producer
+            .write_pos
+            .store(pos, Ordering::Release);
+        ring.header()
+            .consumer
+            .read_pos
+            .store(pos, Ordering::Release);
+
+        let mut reservation = ring.reserve(SLOT).unwrap();
+        let (first, second) = ring.reservation_spans(&mut reservation);
+        assert_eq!(
+            (first.as_ptr(), first.len()),
+            (ring.data_ptr() as *const u8, SLOT)
+        );
+        assert!(second.is_empty());
+        first.copy_from_slice(&slot(1));
+        ring.commit(reservation, SLOT).unwrap();
+
+        let message = ring.peek().unwrap();
+        let (first, second) = ring.peeked_spans(&message);
+        assert_eq!(first, slot(1));
+        assert!(second.is_empty());
+        assert_eq!(ring.consume(message).unwrap(), SLOT);
+        assert_eq!(
+            ring.header().consumer.read_pos.load(Ordering::Acquire),
+            pos.wrapping_add((20 + SLOT) as u32)
+        );
+    }
+
+    #[test]
+    fn message_must_fill_the_slot() {
+        let (ring, _mem) = slot_ring(MAX_MESSAGES);
+        assert_eq!(
+            ring.write_message(&[1u8; SLOT - 1]).err(),
+            Some(ShmError::MessageTooSmall)
+        );
+        assert_eq!(
+            ring.write_message(&[1u8; SLOT + 1]).err(),
+            Some(ShmError::MessageTooLarge)
+        );
+        let reservation = ring.reserve(SLOT).unwrap();
+        assert_eq!(
+            ring.commit(reservation, SLOT - 8).err(),
+            Some(ShmError::MessageTooSmall)
+        );
+        assert!(ring.is_empty());
+    }
+
+    /// Вытеснение и пачки идут по тем же пропускам у границы, что и запись:
+    /// после многих оборотов сообщения читаются подряд и целыми.
+    #[test]
+    fn overwrite_and_batches_follow_slot_pads() {
+        let (ring, _mem) = slot_ring(MAX_MESSAGES);
+        for seq in 0..1000 {
+            ring.write_message(&slot(seq)).unwrap();
+        }
+        let slots: Vec<[u8; SLOT]> = (1000..1100).map(slot).collect();
+        let messages: Vec<&[u8]> = slots.iter().map(|s| s.as_slice()).collect();
+        ring.write_batch(&messages).unwrap();
+
+        let mut batch = MessageBatch::new();
+        let mut expected = None;
+        while let Ok(count) = ring.read_batch(&mut batch, 16, usize::MAX) {
+            assert!(count > 0);
+            for message in batch.iter() {
+                let seq = u32::from_le_bytes(message[..4].try_into().unwrap());
+                assert_eq!(message, slot(seq));
+                assert_eq!(seq, *expected.get_or_insert(seq));
+                expected = Some(seq + 1);
+            }
+        }
+        assert_eq!(expected, Some(1100));
+        assert!(ring.drop_count() > 0);
+    }
+}
+
+#[cfg(test)]
+mod index_cache_tests {
+    use super::overflow_race_tests::make_ring_with;
+    use super::*;
+
+    /// `was_empty` должен оставаться точным и тогда, когда producer решает по
+    /// снимку `read_pos`, а не по общему счётчику.
+    #[test]
+    fn was_empty_tracks_consumer_progress() {
+        let (ring, _mem) = make_ring_with(64 * 1024, MAX_MESSAGES, 1024);
+        let mut out = Vec::new();
+        assert!(ring.write_message(b"first").unwrap().was_empty);
+        assert!(!ring.write_message(b"second").unwrap().was_empty);
+        ring.read_message(&mut out).unwrap();
+        assert!(!ring.write_message(b"third").unwrap().was_empty);
+        while ring.read_message(&mut out).is_ok() {}
+        assert!(ring.write_message(b"fourth").unwrap().was_empty);
+        assert_eq!(ring.message_count(), 1);
+    }
+
+    /// После reset заголовка (новое поколение) снимки прошлого соединения
+    /// не должны ни выдавать ложное свободное место, ни ложные сообщения.
+    #[test]
+    fn snapshots_from_previous_generation_are_ignored() {
+        let (ring, _mem) = make_ring_with(4 * 1024, MAX_MESSAGES, 1024);
+        let mut out = Vec::new();
+        for _ in 0..3 {
+            ring.write_message(&[1u8; 1000]).unwrap();
+            ring.read_message(&mut out).unwrap();
+        }
+
+        ring.reset(2);
+        assert!(ring.is_empty());
+        assert!(matches!(
+            ring.read_message(&mut out),
+            Err(ShmError::QueueEmpty)
+        ));
+        // позиции прошлого поколения снова проходятся теми же записями: без
+        // сверки поколения снимок read_pos совпал бы с новым write_pos, и
+        // producer счёл бы кольцо пустым и перезаписал непрочитанное
+        for _ in 0..3 {
+            assert_eq!(ring.write_message(&[2u8; 1000]).unwrap().overwritten, 0);
+        }
+        let outcome = ring.write_message(&[3u8; 1000]).unwrap();
+        assert_eq!(outcome.overwritten, 0);
+        assert_eq!(ring.message_count(), 4);
+        ring.read_message(&mut out).unwrap();
+        assert_eq!(out, [2u8; 1000]);
+    }
+}
+
+#[cfg(test)]
+mod batch_tests {
+    use super::overflow_race_tests::{make_ring, make_ring_with};
+    use super::*;
+
+    #[test]
+    fn batch_is_published_at_once_in_order() {
+        let (ring, _mem) = make_ring();
+        let payloads: Vec<Vec<u8>> = (0..200u32).map(|i| i.to_le_bytes().repeat(4)).collect();
+        let batch: Vec<&[u8]> = payloads.iter().map(Vec::as_slice).collect();
+
+        let outcome = ring.write_batch(&batch).unwrap();
+        assert!(outcome.was_empty);
+        assert_eq!(outcome.overwritten, 0);
+        assert_eq!(ring.message_count(), 200);
+        // следующая пачка в непустое кольцо будить consumer-а не должна
+        assert!(!ring.write_batch(&batch[..2]).unwrap().was_empty);
+
+        let mut out = Vec::new();
+        for payload in payloads.iter().chain(&payloads[..2]) {
+            ring.read_message(&mut out).unwrap();
+            assert_eq!(&out, payload);
+        }
+        assert!(ring.is_empty());
+    }
+
+    #[test]
+    fn invalid_message_rejects_whole_batch() {
+        let (ring, _mem) = make_ring_with(64 * 1024, MAX_MESSAGES, 1024);
+        let big = [0u8; 1025];
+        assert!(matches!(
+            ring.write_batch(&[b"ok", &big]),
+            Err(ShmError::MessageTooLarge)
+        ));
+        assert!(matches!(
+            ring.write_batch(&[b"ok", b"x"]),
+            Err(ShmError::MessageTooSmall)
+        ));
+        assert!(ring.is_empty());
+    }
+
+    /// Пачка больше кольца уходит частями; overwrite-политика та же, что и у
+    /// поштучной записи: в кольце остаются самые свежие сообщения.
+    #[test]
+    fn oversized_batch_is_split_into_publishes() {
+        let (ring, _mem) = make_ring_with(4 * 1024, 4, 1024);
+        let payloads: Vec<Vec<u8>> = (0..10u8).map(|i| vec![i; 100]).collect();
+        let batch: Vec<&[u8]> = payloads.iter().map(Vec::as_slice).collect();
+
+        let outcome = ring.write_batch(&batch).unwrap();
+        assert!(outcome.was_empty);
+        assert_eq!(outcome.overwritten, 6);
+        assert_eq!(ring.message_count(), 4);
+
+        let mut out = Vec::new();
+        for payload in &payloads[6..] {
+            ring.read_message(&mut out).unwrap();
+            assert_eq!(&out, payload);
+        }
+    }
+
+    #[test]
+    fn batch_mixes_short_and_long_frames_across_wrap() {
+        let (ring, _mem) = make_ring_with(1024 * 1024, MAX_MESSAGES, 400 * 1024);
+        let mut out = Vec::new();
+        for round in 0..8u8 {
+            let long = vec![round; 300 * 1024 + 3];
+            let short = vec![round ^ 0xFF; 77];
+            ring.write_batch(&[&short, &long, &short]).unwrap();
+            for expected in [&short, &long, &short] {
+                ring.read_message(&mut out).unwrap();
+                assert_eq!(&out, expected);
+            }
+        }
+        assert!(ring.is_empty());
+    }
+}
+
+#[cfg(test)]
+mod read_batch_tests {
+    use super::overflow_race_tests::{make_ring, make_ring_with};
+    use super::*;
+
+    #[test]
+    fn drains_up_to_limit_and_leaves_the_rest() {
+        let (ring, _mem) = make_ring();
+        let payloads: Vec<Vec<u8>> = (0..10u8).map(|i| vec![i; 10 + i as usize]).collect();
+        for payload in &payloads {
+            ring.write_message(payload).unwrap();
+        }
+
+        let mut batch = MessageBatch::new();
+        assert_eq!(ring.read_batch(&mut batch, 6, usize::MAX).unwrap(), 6);
+        assert_eq!(ring.message_count(), 4);
+        let got: Vec<&[u8]> = batch.iter().collect();
+        let expected: Vec<&[u8]> = payloads[..6].iter().map(Vec::as_slice).collect();
+        assert_eq!(got, expected);
+        assert_eq!(batch.as_bytes().len(), *batch.ends().last().unwrap());
+
+        // арена очищается при каждом вызове
+        assert_eq!(ring.read_batch(&mut batch, 100, usize::MAX).unwrap(), 4);
+        assert_eq!(batch.get(0), Some(payloads[6].as_slice()));
+        assert_eq!(batch.get(3), Some(payloads[9].as_slice()));
+        assert!(ring.is_empty());
+        assert!(matches!(
+            ring.read_batch(&mut batch, 100, usize::MAX),
+            Err(ShmError::QueueEmpty)
+        ));
+        assert!(batch.is_empty());
+    }
+
+    #[test]
+    fn byte_limit_stops_before_overflow_but_takes_first() {
+        let (ring, _mem) = make_ring();
+        for i in 0..3u8 {
+            ring.write_message(&[i; 100]).unwrap();
+        }
+        let mut batch = MessageBatch::new();
+        // первое сообщение больше лимита — всё равно выдаётся одно
+        assert_eq!(ring.read_batch(&mut batch, 10, 50).unwrap(), 1);
+        assert_eq!(batch.get(0), Some(&[0u8; 100][..]));
+        // 250 байт вмещают два сообщения по 100, третье ждёт
+        ring.write_message(&[3; 100]).unwrap();
+        assert_eq!(ring.read_batch(&mut batch, 10, 250).unwrap(), 2);
+        assert_eq!(batch.ends(), &[100, 200]);
+        assert_eq!(ring.message_count(), 1);
+    }
+
+    #[test]
+    fn batch_reads_long_frames_across_wrap() {
+        let (ring, _mem) = make_ring_with(1024 * 1024, MAX_MESSAGES, 400 * 1024);
+        let mut batch = MessageBatch::new();
+        for round in 0..8u8 {
+            let long = vec![round; 300 * 1024 + 3];
+            let short = vec![round ^ 0xFF; 77];
+            ring.write_batch(&[&short, &long, &short]).unwrap();
+            assert_eq!(ring.read_batch(&mut batch, 16, usize::MAX).unwrap(), 3);
+            let got: Vec<&[u8]> = batch.iter().collect();
+            assert_eq!(got, [&short[..], &long[..], &short[..]]);
+        }
+        assert!(ring.is_empty());
+    }
+}
+
+#[cfg(test)]
+mod spin_wait_tests {
+    use super::overflow_race_tests::make_ring;
+
+    #[test]
+    fn spinning_consumer_is_not_woken() {
+        let (ring, _mem) = make_ring();
+        // по умолчанию consumer может спать: первая запись будит
+        let outcome = ring.write_message(b"first").unwrap();
+        assert!(outcome.was_empty && outcome.wake_consumer);
+        let mut out = Vec::new();
+        ring.read_message(&mut out).unwrap();
+
+        ring.start_spinning();
+        let outcome = ring.write_message(b"second").unwrap();
+        assert!(outcome.was_empty);
+        assert!(!outcome.wake_consumer);
+        let batch = ring.write_batch(&[b"third", b"fourth"]).unwrap();
+        assert!(!batch.wake_consumer);
+
+        // данные пришли без сигнала — снятие флага обязано их заметить
+        assert!(ring.stop_spinning());
+        while ring.read_message(&mut out).is_ok() {}
+        assert!(!ring.stop_spinning());
+        assert!(ring.write_message(b"fifth").unwrap().wake_consumer);
+    }
+
+    #[test]
+    fn reset_clears_spinning_flag() {
+        let (ring, _mem) = make_ring();
+        ring.start_spinning();
+        ring.reset(2);
+        assert!(ring.write_message(b"after reset").unwrap().wake_consumer);
+    }
+}
+
+#[cfg(test)]
+mod stats_tests {
+    use super::overflow_race_tests::make_ring_with;
+    use super::*;
+
+    /// High-water mark — пик заполненности, а не текущее значение;
+    /// вытеснения учитываются в статистике стороны-producer-а.
+    #[test]
+    fn high_water_tracks_peak_and_drops() {
+        let (ring, _mem) = make_ring_with(4 * 1024, 8, 256);
+        let frame = (MESSAGE_HEADER_SIZE + 16) as u32;
+        for i in 0..5u8 {
+            ring.write_message(&[i; 16]).unwrap();
+        }
+        let mut batch = MessageBatch::new();
+        assert_eq!(ring.read_batch(&mut batch, 16, usize::MAX).unwrap(), 5);
+        ring.write_message(&[5u8; 16]).unwrap();
+
+        let snapshot = ring.stats().snapshot();
+        assert_eq!(snapshot.high_water_messages, 5);
+        assert_eq!(snapshot.high_water_bytes, 5 * frame);
+        assert_eq!(snapshot.dropped_messages, 0);
+
+        for i in 0..10u8 {
+            ring.write_message(&[i; 16]).unwrap();
+        }
+        let snapshot = ring.stats().snapshot();
+        assert_eq!(snapshot.high_water_messages, 8);
+        assert_eq!(snapshot.dropped_messages, 3);
+    }
+
+    /// Метка ставится раз в LATENCY_SAMPLE_INTERVAL сообщений и дочитывается
+    /// ровно один раз, даже если чтение идёт мелкими пачками.
+    #[test]
+    fn latency_is_sampled_once_per_interval() {
+        let (ring, _mem) = make_ring_with(64 * 1024, 1024, 256);
+        let mut batch = MessageBatch::new();
+        let total = 3 * LATENCY_SAMPLE_INTERVAL;
+        for i in 0..total {
+            ring.write_message(&i.to_le_bytes()).unwrap();
+            if i % 7 == 0 {
+                while ring.read_batch(&mut batch, 3, usize::MAX).is_ok() {}
+            }
+        }
+        while ring.read_batch(&mut batch, 3, usize::MAX).is_ok() {}
+        assert_eq!(
+            ring.stats().snapshot().latency_ns.count,
+            total as u64 / LATENCY_SAMPLE_INTERVAL as u64
+        );
+    }
+}
+
+#[cfg(test)]
+mod trace_tests {
+    use super::overflow_race_tests::{make_ring, make_ring_with};
+    use super::*;
+
+    #[test]
+    fn traced_frames_carry_sequence_and_stamp() {
+        let (mut ring, _mem) = make_ring();
+        ring.write_message(b"plain").unwrap();
+        ring.set_trace(true);
+        ring.write_message(b"first").unwrap();
+        ring.write_message_at(b"second", Some(5)).unwrap();
+        ring.write_batch(&[b"third"]).unwrap();
+
+        let mut batch = MessageBatch::new();
+        assert_eq!(ring.read_batch(&mut batch, 16, usize::MAX).unwrap(), 4);
+        assert_eq!(batch.get(0).unwrap(), b"plain");
+        assert_eq!(batch.trace(0), None);
+        assert_eq!(batch.get(1).unwrap(), b"first");
+        assert_eq!(batch.trace(1).unwrap().sequence, 0);
+        assert_eq!(batch.get(2).unwrap(), b"second");
+        assert_eq!(batch.trace(2).unwrap().sequence, 1);
+        assert_eq!(batch.trace(2).unwrap().enqueued, 5);
+        assert_eq!(batch.trace(3).unwrap().sequence, 2);
+        assert_eq!(ring.stats().snapshot().queue_delay_ns.count, 3);
+
+        // хвост пачки без меток: trace короче ends
+        ring.write_message(b"last traced").unwrap();
+        ring.set_trace(false);
+        ring.write_message(b"untraced").unwrap();
+        assert_eq!(ring.read_batch(&mut batch, 16, usize::MAX).unwrap(), 2);
+        assert_eq!(batch.trace(0).unwrap().sequence, 3);
+        assert_eq!(batch.trace(1), None);
+        assert_eq!(batch.get(1).unwrap(), b"untraced");
+    }
+
+    #[test]
+    fn peeked_trace_survives_wrap() {
+        let (mut ring, _mem) = make_ring();
+        ring.set_trace(true);
+        // заголовок в хвосте storage, расширение переносится через границу
+        let pos = RING_CAPACITY as u32 - 10;
+        ring.header()
+            .producer
+            .write_pos
+            .store(pos, Ordering::Release);
+        ring.header()
+            .consumer
+            .read_pos
+            .store(pos, Ordering::Release);
+        let payload: Vec<u8> = (0..40u8).collect();
+        ring.write_message_at(&payload, Some(42)).unwrap();
+
+        let message = ring.peek().unwrap();
+        let trace = message.trace().unwrap();
+        assert_eq!((trace.sequence, trace.enqueued), (0, 42));
+        let (first, second) = ring.peeked_spans(&message);
+        assert_eq!([first, second].concat(), payload);
+        assert_eq!(ring.consume(message).unwrap(), payload.len());
+        assert_eq!(ring.stats().snapshot().queue_delay_ns.count, 1);
+    }
+
+    /// Кадр, которому расширение не даёт влезть в кольцо, уходит без метки,
+    /// а не с `MessageTooLarge`.
+    #[test]
+    fn frame_without_room_for_extension_is_sent_untraced() {
+        let (mut ring, _mem) = make_ring_with(4 * 1024, 8, 4 * 1024 - MESSAGE_HEADER_SIZE);
+        ring.set_trace(true);
+        let payload = vec![3u8; 4 * 1024 - MESSAGE_HEADER_SIZE];
+        ring.write_message(&payload).unwrap();
+
+        let mut out = Vec::new();
+        let message = ring.peek().unwrap();
+        assert_eq!(message.trace(), None);
+        drop(message);
+        ring.read_message(&mut out).unwrap();
+        assert_eq!(out, payload);
+        assert_eq!(ring.stats().snapshot().queue_delay_ns.count, 0);
+    }
+}
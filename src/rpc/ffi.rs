@@ -0,0 +1,364 @@
+//! C FFI для RPC-сервера и клиента.
+//!
+//! Следует тем же паттернам, что и `crate::ffi` и `crate::dispatch::ffi`;
+//! параметры канала — общий `shm_auto_options_t`.
+
+use std::collections::HashMap;
+use std::ffi::CStr;
+use std::os::raw::{c_char, c_void};
+use std::ptr::null_mut;
+use std::sync::{Arc, Mutex};
+use std::time::Duration;
+
+use crate::constants::MAX_MESSAGE_SIZE;
+use crate::error::{Result, ShmError};
+use crate::ffi::{ffi_auto_options, shm_auto_options_t, shm_error_t};
+
+use super::{RpcClient, RpcHandler, RpcServer, RPC_ENVELOPE_SIZE};
+
+/// Обработчик вызова на стороне сервера: ответ пишется в `reply` (не больше
+/// `reply_capacity` байт), его длина — в `*reply_size`. Возвращает 0 либо
+/// прикладной код отказа, который клиент получит как `SHM_ERROR_REMOTE`.
+#[allow(non_camel_case_types)]
+pub type shm_rpc_handler_fn = Option<
+    extern "C" fn(
+        request: *const c_void,
+        size: u32,
+        reply: *mut c_void,
+        reply_capacity: u32,
+        reply_size: *mut u32,
+        user_data: *mut c_void,
+    ) -> u32,
+>;
+
+pub type RpcServerHandle = c_void;
+pub type RpcClientHandle = c_void;
+
+struct FfiRpcHandler {
+    handler: extern "C" fn(*const c_void, u32, *mut c_void, u32, *mut u32, *mut c_void) -> u32,
+    user_data: *mut c_void,
+    capacity: usize,
+}
+
+unsafe impl Send for FfiRpcHandler {}
+unsafe impl Sync for FfiRpcHandler {}
+
+impl RpcHandler for FfiRpcHandler {
+    fn on_call(&self, request: &[u8], reply: &mut Vec<u8>) -> std::result::Result<(), u32> {
+        reply.reserve(self.capacity);
+        let mut size = 0u32;
+        let code = (self.handler)(
+            request.as_ptr() as *const c_void,
+            request.len() as u32,
+            reply.as_mut_ptr() as *mut c_void,
+            self.capacity as u32,
+            &mut size,
+            self.user_data,
+        );
+        if code != 0 {
+            return Err(code);
+        }
+        // SAFETY: reserve выше дал `capacity` байт; первые `size` из них
+        // handler заполнил по контракту `shm_rpc_handler_fn`.
+        unsafe { reply.set_len((size as usize).min(self.capacity)) };
+        Ok(())
+    }
+}
+
+struct RpcClientState {
+    inner: RpcClient,
+    /// Ответы, не влезшие в буфер `shm_rpc_client_wait`/`poll`: ждут
+    /// повторного вызова с тем же id.
+    stash: Mutex<HashMap<u32, Vec<u8>>>,
+}
+
+/// # Safety
+/// `ptr` обязан быть валидной null-terminated C-строкой либо null.
+unsafe fn to_rust_str(ptr: *const c_char) -> Option<String> {
+    if ptr.is_null() {
+        return None;
+    }
+    let cstr = unsafe { CStr::from_ptr(ptr) };
+    Some(cstr.to_string_lossy().into_owned())
+}
+
+fn ffi_timeout(timeout_ms: u32) -> Option<Duration> {
+    if timeout_ms == u32::MAX {
+        None
+    } else {
+        Some(Duration::from_millis(timeout_ms as u64))
+    }
+}
+
+/// Копирует ответ в буфер C. Не влезший — `SHM_ERROR_MEMORY` с нужной
+/// длиной в `*reply_size`; тогда `reply` возвращается вызывающему.
+///
+/// # Safety
+/// `buffer` указывает на `*reply_size` байт, `reply_size` валиден.
+unsafe fn copy_reply(reply: Vec<u8>, buffer: *mut c_void, reply_size: *mut u32) -> Option<Vec<u8>> {
+    let capacity = unsafe { *reply_size } as usize;
+    unsafe { *reply_size = reply.len() as u32 };
+    if reply.len() > capacity {
+        return Some(reply);
+    }
+    unsafe { std::ptr::copy_nonoverlapping(reply.as_ptr(), buffer as *mut u8, reply.len()) };
+    None
+}
+
+/// Ошибка вызова для C: отказ handler-а — его код в `*remote_code`.
+///
+/// # Safety
+/// `remote_code` валиден либо null.
+unsafe fn call_error(err: ShmError, remote_code: *mut u32) -> shm_error_t {
+    if let ShmError::RemoteFailed(code) = err {
+        if !remote_code.is_null() {
+            unsafe { *remote_code = code };
+        }
+    }
+    err.into()
+}
+
+// ─── FFI сервера ─────────────────────────────────────────────────────────────
+
+/// Запускает RPC-сервер канала `name`; `handler` вызывается на сервисном
+/// потоке сервера. `options` может быть null.
+///
+/// # Safety
+/// `name` обязан быть валидной C-строкой, `options` — валидным указателем
+/// либо null. `user_data` передаётся в `handler` как есть.
+#[unsafe(no_mangle)]
+pub unsafe extern "C" fn shm_rpc_server_start(
+    name: *const c_char,
+    handler: shm_rpc_handler_fn,
+    user_data: *mut c_void,
+    options: *const shm_auto_options_t,
+) -> *mut RpcServerHandle {
+    let (Some(name), Some(handler)) = (unsafe { to_rust_str(name) }, handler) else {
+        return null_mut();
+    };
+    let opts = ffi_auto_options(options);
+    let capacity = opts
+        .geometry
+        .max_message_size
+        .min(MAX_MESSAGE_SIZE)
+        .saturating_sub(RPC_ENVELOPE_SIZE);
+    let handler = Arc::new(FfiRpcHandler {
+        handler,
+        user_data,
+        capacity,
+    });
+    match RpcServer::start(&name, handler, opts) {
+        Ok(inner) => Box::into_raw(Box::new(inner)) as *mut RpcServerHandle,
+        Err(_) => null_mut(),
+    }
+}
+
+/// # Safety
+/// `handle` обязан быть валидным RpcServerHandle либо null. Поглощает handle.
+#[unsafe(no_mangle)]
+pub unsafe extern "C" fn shm_rpc_server_stop(handle: *mut RpcServerHandle) {
+    if handle.is_null() {
+        return;
+    }
+    unsafe { drop(Box::from_raw(handle as *mut RpcServer)) };
+}
+
+// ─── FFI клиента ─────────────────────────────────────────────────────────────
+
+/// Подключается к RPC-серверу `name` (переподключение — автоматически).
+///
+/// # Safety
+/// `name` обязан быть валидной C-строкой, `options` — валидным указателем
+/// либо null.
+#[unsafe(no_mangle)]
+pub unsafe extern "C" fn shm_rpc_client_connect(
+    name: *const c_char,
+    options: *const shm_auto_options_t,
+) -> *mut RpcClientHandle {
+    let Some(name) = (unsafe { to_rust_str(name) }) else {
+        return null_mut();
+    };
+    match RpcClient::connect(&name, ffi_auto_options(options)) {
+        Ok(inner) => Box::into_raw(Box::new(RpcClientState {
+            inner,
+            stash: Mutex::new(HashMap::new()),
+        })) as *mut RpcClientHandle,
+        Err(_) => null_mut(),
+    }
+}
+
+/// Синхронный вызов. `*reply_size` — на входе ёмкость `reply`, на выходе
+/// длина ответа; не влезший ответ — `SHM_ERROR_MEMORY`, и он теряется
+/// (ответ не длиннее `max_message_size` сервера минус 8 байт).
+/// `SHM_ERROR_REMOTE` — handler отказал, код в `*remote_code` (может быть
+/// null). `timeout_ms == UINT32_MAX` — без предела.
+///
+/// # Safety
+/// `handle` обязан быть валидным RpcClientHandle, `request` — указывать на
+/// `size` байт (null при `size == 0`), `reply` — на `*reply_size` байт.
+#[unsafe(no_mangle)]
+pub unsafe extern "C" fn shm_rpc_client_call(
+    handle: *mut RpcClientHandle,
+    request: *const c_void,
+    size: u32,
+    reply: *mut c_void,
+    reply_size: *mut u32,
+    timeout_ms: u32,
+    remote_code: *mut u32,
+) -> shm_error_t {
+    let mut call_id = 0u32;
+    let status = unsafe { shm_rpc_client_submit(handle, request, size, &mut call_id) };
+    if status != shm_error_t::SHM_SUCCESS {
+        return status;
+    }
+    let status =
+        unsafe { shm_rpc_client_wait(handle, call_id, reply, reply_size, timeout_ms, remote_code) };
+    if status == shm_error_t::SHM_ERROR_MEMORY {
+        let state = unsafe { &*(handle as *const RpcClientState) };
+        state.stash.lock().unwrap().remove(&call_id);
+    }
+    status
+}
+
+/// Отправляет вызов без ожидания; id для `shm_rpc_client_wait`/`poll` — в
+/// `*call_id`.
+///
+/// # Safety
+/// `handle` обязан быть валидным RpcClientHandle, `request` — указывать на
+/// `size` байт (null при `size == 0`), `call_id` — валиден.
+#[unsafe(no_mangle)]
+pub unsafe extern "C" fn shm_rpc_client_submit(
+    handle: *mut RpcClientHandle,
+    request: *const c_void,
+    size: u32,
+    call_id: *mut u32,
+) -> shm_error_t {
+    if handle.is_null() || call_id.is_null() || (request.is_null() && size != 0) {
+        return shm_error_t::SHM_ERROR_INVALID_PARAM;
+    }
+    let state = unsafe { &*(handle as *const RpcClientState) };
+    let request: &[u8] = if size == 0 {
+        &[]
+    } else {
+        unsafe { std::slice::from_raw_parts(request as *const u8, size as usize) }
+    };
+    match state.inner.submit(request) {
+        Ok(id) => {
+            unsafe { *call_id = id };
+            shm_error_t::SHM_SUCCESS
+        }
+        Err(err) => err.into(),
+    }
+}
+
+/// Ждёт ответ на `call_id`, семантика буфера и ошибок — как у
+/// `shm_rpc_client_call`, но не влезший ответ сохраняется для повторного
+/// вызова с тем же id.
+///
+/// # Safety
+/// Как у `shm_rpc_client_call`.
+#[unsafe(no_mangle)]
+pub unsafe extern "C" fn shm_rpc_client_wait(
+    handle: *mut RpcClientHandle,
+    call_id: u32,
+    reply: *mut c_void,
+    reply_size: *mut u32,
+    timeout_ms: u32,
+    remote_code: *mut u32,
+) -> shm_error_t {
+    unsafe {
+        take_reply(
+            handle,
+            call_id,
+            reply,
+            reply_size,
+            remote_code,
+            |client, id, out| client.wait(id, out, ffi_timeout(timeout_ms)),
+        )
+    }
+}
+
+/// Неблокирующая проверка ответа на `call_id`: `SHM_ERROR_EMPTY` — ещё не
+/// пришёл; остальное — как у `shm_rpc_client_wait`.
+///
+/// # Safety
+/// Как у `shm_rpc_client_call`.
+#[unsafe(no_mangle)]
+pub unsafe extern "C" fn shm_rpc_client_poll(
+    handle: *mut RpcClientHandle,
+    call_id: u32,
+    reply: *mut c_void,
+    reply_size: *mut u32,
+    remote_code: *mut u32,
+) -> shm_error_t {
+    unsafe {
+        take_reply(
+            handle,
+            call_id,
+            reply,
+            reply_size,
+            remote_code,
+            |client, id, out| client.poll(id, out),
+        )
+    }
+}
+
+/// Снимает вызов: опоздавший ответ отбрасывается. `false` — id неизвестен.
+///
+/// # Safety
+/// `handle` обязан быть валидным RpcClientHandle либо null.
+#[unsafe(no_mangle)]
+pub unsafe extern "C" fn shm_rpc_client_cancel(handle: *mut RpcClientHandle, call_id: u32) -> bool {
+    if handle.is_null() {
+        return false;
+    }
+    let state = unsafe { &*(handle as *const RpcClientState) };
+    let stashed = state.stash.lock().unwrap().remove(&call_id).is_some();
+    state.inner.cancel(call_id) || stashed
+}
+
+/// # Safety
+/// `handle` обязан быть валидным RpcClientHandle либо null. Поглощает handle.
+#[unsafe(no_mangle)]
+pub unsafe extern "C" fn shm_rpc_client_stop(handle: *mut RpcClientHandle) {
+    if handle.is_null() {
+        return;
+    }
+    unsafe { drop(Box::from_raw(handle as *mut RpcClientState)) };
+}
+
+/// Общая часть `wait`/`poll`: сначала ответ из `stash`, иначе `fetch`.
+///
+/// # Safety
+/// Как у `shm_rpc_client_call`.
+unsafe fn take_reply(
+    handle: *mut RpcClientHandle,
+    call_id: u32,
+    reply: *mut c_void,
+    reply_size: *mut u32,
+    remote_code: *mut u32,
+    fetch: impl FnOnce(&RpcClient, u32, &mut Vec<u8>) -> Result<usize>,
+) -> shm_error_t {
+    if handle.is_null() || reply.is_null() || reply_size.is_null() {
+        return shm_error_t::SHM_ERROR_INVALID_PARAM;
+    }
+    let state = unsafe { &*(handle as *const RpcClientState) };
+    let stashed = state.stash.lock().unwrap().remove(&call_id);
+    let payload = match stashed {
+        Some(payload) => payload,
+        None => {
+            let mut payload = Vec::new();
+            if let Err(err) = fetch(&state.inner, call_id, &mut payload) {
+                return unsafe { call_error(err, remote_code) };
+            }
+            payload
+        }
+    };
+    match unsafe { copy_reply(payload, reply, reply_size) } {
+        None => shm_error_t::SHM_SUCCESS,
+        Some(payload) => {
+            state.stash.lock().unwrap().insert(call_id, payload);
+            shm_error_t::SHM_ERROR_MEMORY
+        }
+    }
+}
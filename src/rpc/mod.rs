@@ -0,0 +1,735 @@
+//! Запрос/ответ поверх пары колец `auto`-канала.
+//!
+//! Каждый кадр начинается с 8-байтного конверта: `u32` correlation id и
+//! `u32` вид кадра (вызов, ответ, отказ handler-а), little-endian. Флаги
+//! кадра остаются за кольцом: zero-copy чтение (`peek`/`MessageBatch`) их
+//! не отдаёт, а id в 16 бит не помещается.
+//!
+//! Обе стороны работают в pull-режиме `auto`: worker держит соединение, а
+//! кольца пишет и читает поток вызова напрямую, без очереди отправки и
+//! пробуждения worker-а. При `AutoOptions::wait` со spin-фазой
+//! синхронный `RpcClient::call` крутится на кольце ответов, и round trip
+//! остаётся в пределах единиц микросекунд — ни одного `NtSetEvent` и
+//! переключения контекста.
+//!
+//! Конвейер вызовов — `submit` + `wait`/`poll`: кольцо ответов читает тот
+//! из ждущих потоков, кто первым взялся (`pumping`), и раскладывает чужие
+//! ответы по слотам, остальные спят на `Condvar`.
+
+pub mod ffi;
+
+use std::collections::HashMap;
+use std::sync::atomic::{AtomicBool, AtomicU32, Ordering};
+use std::sync::{Arc, Condvar, Mutex};
+use std::thread::{self, JoinHandle};
+use std::time::{Duration, Instant};
+
+use crate::auto::{
+    join_unless_self, AutoClient, AutoHandler, AutoOptions, AutoServer, AutoStatsSnapshot,
+};
+use crate::constants::MAX_MESSAGE_SIZE;
+use crate::error::{Result, ShmError};
+use crate::ring::{MessageBatch, OverflowPolicy};
+use crate::wait::WaitStrategy;
+use crate::win::{self, EventHandle};
+
+/// Размер конверта кадра: correlation id и вид кадра.
+pub const RPC_ENVELOPE_SIZE: usize = 8;
+
+const FRAME_CALL: u32 = 1;
+const FRAME_REPLY: u32 = 2;
+/// Handler отказал; тело — прикладной код `u32`.
+const FRAME_FAULT: u32 = 3;
+
+/// Код отказа, который клиент получает (`ShmError::RemoteFailed`), если
+/// ответ handler-а не влез в кольцо ответов (`max_message_size` сервера
+/// минус конверт). Прикладным кодам его не брать.
+pub const RPC_FAULT_REPLY_TOO_LARGE: u32 = u32::MAX;
+
+fn encode(frame: &mut Vec<u8>, id: u32, kind: u32, body: &[u8]) {
+    frame.clear();
+    frame.reserve(RPC_ENVELOPE_SIZE + body.len());
+    frame.extend_from_slice(&id.to_le_bytes());
+    frame.extend_from_slice(&kind.to_le_bytes());
+    frame.extend_from_slice(body);
+}
+
+/// Кадр результата вызова `id`. Ответ длиннее `max_reply` заменяется
+/// отказом `RPC_FAULT_REPLY_TOO_LARGE` (`false`): отправить его всё равно не
+/// вышло бы, и клиент ждал бы до таймаута.
+fn encode_result(
+    frame: &mut Vec<u8>,
+    id: u32,
+    result: std::result::Result<(), u32>,
+    reply: &[u8],
+    max_reply: usize,
+) -> bool {
+    const TOO_LARGE: [u8; 4] = RPC_FAULT_REPLY_TOO_LARGE.to_le_bytes();
+    let fits = reply.len() <= max_reply;
+    match result {
+        Ok(()) if fits => encode(frame, id, FRAME_REPLY, reply),
+        Ok(()) => encode(frame, id, FRAME_FAULT, &TOO_LARGE),
+        Err(code) => encode(frame, id, FRAME_FAULT, &code.to_le_bytes()),
+    }
+    fits || result.is_err()
+}
+
+fn decode(frame: &[u8]) -> Option<(u32, u32, &[u8])> {
+    if frame.len() < RPC_ENVELOPE_SIZE {
+        return None;
+    }
+    let id = u32::from_le_bytes(frame[0..4].try_into().unwrap());
+    let kind = u32::from_le_bytes(frame[4..8].try_into().unwrap());
+    Some((id, kind, &frame[RPC_ENVELOPE_SIZE..]))
+}
+
+/// Параметры канала под RPC: pull-режим и кольца без вытеснения —
+/// вытесненный ответ оставил бы вызов висеть до таймаута.
+fn rpc_channel_options(mut options: AutoOptions) -> AutoOptions {
+    options.pull = true;
+    if options.overflow == OverflowPolicy::Overwrite {
+        options.overflow = OverflowPolicy::Fail;
+    }
+    options
+}
+
+/// Ожидание места под ответ: `OverflowPolicy::Block` — как задано, иначе
+/// не дольше `poll_timeout` (у `Fail` ответ иначе терялся бы на первом же
+/// полном кольце).
+fn reply_policy(overflow: OverflowPolicy, poll_timeout: Duration) -> OverflowPolicy {
+    match overflow {
+        OverflowPolicy::Block(timeout) => OverflowPolicy::Block(timeout),
+        _ => OverflowPolicy::Block(poll_timeout),
+    }
+}
+
+/// Обработчик вызовов `RpcServer`.
+///
+/// `on_call` выполняется на сервисном потоке сервера, вызовы одного клиента
+/// — строго по очереди. Ответ дописывается в `reply` (приходит пустым);
+/// `Err(code)` вернёт клиенту `ShmError::RemoteFailed(code)`. Ответ длиннее
+/// `max_message_size` сервера минус `RPC_ENVELOPE_SIZE` не отправляется:
+/// клиент получит `RemoteFailed(RPC_FAULT_REPLY_TOO_LARGE)`.
+pub trait RpcHandler: Send + Sync + 'static {
+    fn on_call(&self, request: &[u8], reply: &mut Vec<u8>) -> std::result::Result<(), u32>;
+    fn on_connect(&self) {}
+    fn on_disconnect(&self) {}
+    fn on_error(&self, _err: ShmError) {}
+}
+
+/// События соединения от worker-а `AutoServer` — прямо в `RpcHandler`.
+struct ServerEvents(Arc<dyn RpcHandler>);
+
+impl AutoHandler for ServerEvents {
+    fn on_connect(&self) {
+        self.0.on_connect();
+    }
+
+    fn on_disconnect(&self) {
+        self.0.on_disconnect();
+    }
+
+    fn on_error(&self, err: ShmError) {
+        self.0.on_error(err);
+    }
+}
+
+/// RPC-сервер: канал `AutoServer` и сервисный поток, который читает вызовы
+/// и пишет ответы в кольцо клиента.
+pub struct RpcServer {
+    channel: Arc<AutoServer>,
+    running: Arc<AtomicBool>,
+    stop: Arc<EventHandle>,
+    join: Mutex<Option<JoinHandle<()>>>,
+}
+
+impl RpcServer {
+    /// `options.wait` — как сервисный поток ждёт вызовы: spin-фаза держит
+    /// задержку ответа в микросекундах ценой ядра. `pull` включается
+    /// всегда, `OverflowPolicy::Overwrite` заменяется на `Fail`. Места под
+    /// ответ сервис ждёт `Block(timeout)` либо, при других политиках,
+    /// `poll_timeout`; потерянный ответ — `on_error(QueueFull)`.
+    pub fn start(name: &str, handler: Arc<dyn RpcHandler>, options: AutoOptions) -> Result<Self> {
+        let options = rpc_channel_options(options);
+        let wait = options.wait;
+        let poll_timeout = options.poll_timeout;
+        let recv_batch = options.recv_batch.max(1);
+        let reply_policy = reply_policy(options.overflow, poll_timeout);
+        let max_reply = options
+            .geometry
+            .max_message_size
+            .saturating_sub(RPC_ENVELOPE_SIZE);
+        let events = Arc::new(ServerEvents(handler.clone()));
+        let channel = Arc::new(AutoServer::start(name, events, options)?);
+        let running = Arc::new(AtomicBool::new(true));
+        let stop = Arc::new(EventHandle::create_local()?);
+
+        let service = RpcService {
+            channel: channel.clone(),
+            handler,
+            wait,
+            poll_timeout,
+            recv_batch,
+            max_reply,
+            reply_policy,
+        };
+        let join_running = running.clone();
+        let join_stop = stop.clone();
+        #[cfg_attr(not(debug_assertions), allow(unused_mut))]
+        let mut builder = thread::Builder::new();
+        #[cfg(debug_assertions)]
+        {
+            builder = builder.name(format!("xsr-{}", name));
+        }
+        let join = builder
+            .spawn(move || service.run(&join_running, &join_stop))
+            .map_err(|err| ShmError::WindowsError {
+                code: err.raw_os_error().map(|c| c as u32).unwrap_or(0xFFFFFFFF),
+                context: "spawn rpc service",
+            })?;
+        Ok(Self {
+            channel,
+            running,
+            stop,
+            join: Mutex::new(Some(join)),
+        })
+    }
+
+    pub fn stats(&self) -> AutoStatsSnapshot {
+        self.channel.stats()
+    }
+
+    pub fn stop(&self) {
+        self.running.store(false, Ordering::Release);
+        let _ = self.stop.set();
+        self.channel.stop();
+    }
+}
+
+impl Drop for RpcServer {
+    fn drop(&mut self) {
+        self.stop();
+        // handler может уронить сервер прямо из `on_call`
+        if let Some(handle) = self.join.lock().unwrap().take() {
+            join_unless_self(handle);
+        }
+    }
+}
+
+struct RpcService {
+    channel: Arc<AutoServer>,
+    handler: Arc<dyn RpcHandler>,
+    wait: WaitStrategy,
+    poll_timeout: Duration,
+    recv_batch: usize,
+    /// Наибольший ответ, который влезает в кольцо клиента.
+    max_reply: usize,
+    /// Как ждать места в кольце ответов (см. `reply_policy`).
+    reply_policy: OverflowPolicy,
+}
+
+impl RpcService {
+    fn run(&self, running: &AtomicBool, stop: &EventHandle) {
+        let mut batch = MessageBatch::with_capacity(MAX_MESSAGE_SIZE, self.recv_batch);
+        let mut reply = Vec::new();
+        let mut frame = Vec::new();
+        let handles = [
+            self.channel
+                .wait_handle()
+                .expect("rpc channel is always pull"),
+            stop.raw_handle(),
+        ];
+        while running.load(Ordering::Acquire) {
+            match self
+                .channel
+                .receive_batch(&mut batch, self.recv_batch, usize::MAX)
+            {
+                Ok(_) => {
+                    for call in batch.iter() {
+                        self.serve(call, &mut reply, &mut frame, running);
+                    }
+                    continue;
+                }
+                // соединения нет — `wait_handle` взведётся при подключении
+                Err(ShmError::QueueEmpty) | Err(ShmError::NotConnected) => {}
+                // повреждённое кольцо worker сбросит сам
+                Err(err) => self.handler.on_error(err),
+            }
+            if self.channel.spin_wait(&self.wait) {
+                continue;
+            }
+            let _ = win::wait_any(&handles, Some(self.poll_timeout));
+        }
+    }
+
+    fn serve(&self, call: &[u8], reply: &mut Vec<u8>, frame: &mut Vec<u8>, running: &AtomicBool) {
+        let Some((id, FRAME_CALL, request)) = decode(call) else {
+            self.handler.on_error(ShmError::Corrupted);
+            return;
+        };
+        reply.clear();
+        let result = self.handler.on_call(request, reply);
+        if !encode_result(frame, id, result, reply, self.max_reply) {
+            self.handler.on_error(ShmError::MessageTooLarge);
+        }
+        // Кольцо ответов полно, только пока клиент не дочитал прежние:
+        // ждём места на `s2c.space`; не дождались — ответ потерян (клиент
+        // получит `Timeout`), о чём узнаёт и handler.
+        match self.channel.send_direct_with(frame, self.reply_policy) {
+            Ok(()) | Err(ShmError::NotConnected) => {}
+            // сервер останавливается
+            Err(ShmError::NotReady) if !running.load(Ordering::Acquire) => {}
+            Err(err) => self.handler.on_error(err),
+        }
+    }
+}
+
+enum CallSlot {
+    Waiting,
+    Ready(Vec<u8>),
+    Failed(ShmError),
+}
+
+#[derive(Default)]
+struct CallTable {
+    slots: HashMap<u32, CallSlot>,
+    /// Кто-то из ждущих сейчас читает кольцо ответов.
+    pumping: bool,
+}
+
+impl CallTable {
+    /// Забирает готовый результат `id`; `None` — ещё ждём.
+    fn take(&mut self, id: u32, reply: &mut Vec<u8>) -> Option<Result<usize>> {
+        match self.slots.remove(&id) {
+            None => Some(Err(ShmError::UnknownCall)),
+            Some(CallSlot::Waiting) => {
+                self.slots.insert(id, CallSlot::Waiting);
+                None
+            }
+            Some(CallSlot::Ready(payload)) => {
+                reply.clear();
+                reply.extend_from_slice(&payload);
+                Some(Ok(payload.len()))
+            }
+            Some(CallSlot::Failed(err)) => Some(Err(err)),
+        }
+    }
+
+    fn resolve(&mut self, id: u32, result: CallSlot) -> bool {
+        match self.slots.get_mut(&id) {
+            Some(slot @ CallSlot::Waiting) => {
+                *slot = result;
+                true
+            }
+            // отменён или истёк — опоздавший ответ отбрасывается
+            _ => false,
+        }
+    }
+}
+
+#[derive(Default)]
+struct Calls {
+    table: Mutex<CallTable>,
+    changed: Condvar,
+}
+
+/// Разрыв соединения: ответы на отправленные вызовы уже не придут.
+struct ClientEvents(Arc<Calls>);
+
+impl AutoHandler for ClientEvents {
+    fn on_disconnect(&self) {
+        let mut table = self.0.table.lock().unwrap();
+        for slot in table.slots.values_mut() {
+            if matches!(slot, CallSlot::Waiting) {
+                *slot = CallSlot::Failed(ShmError::NotConnected);
+            }
+        }
+        drop(table);
+        self.0.changed.notify_all();
+    }
+}
+
+/// RPC-клиент поверх `AutoClient`: переподключается сам, вызовы во время
+/// разрыва завершаются `NotConnected`.
+pub struct RpcClient {
+    channel: AutoClient,
+    calls: Arc<Calls>,
+    next_id: AtomicU32,
+    /// Арена чтения кольца ответов — у того, кто сейчас `pumping`.
+    batch: Mutex<MessageBatch>,
+    wait: WaitStrategy,
+    poll_timeout: Duration,
+    recv_batch: usize,
+}
+
+impl RpcClient {
+    /// `options.wait` — как ждущий поток крутится на кольце ответов до
+    /// блокировки; `pull` включается всегда, `OverflowPolicy::Overwrite`
+    /// заменяется на `Fail`.
+    pub fn connect(name: &str, options: AutoOptions) -> Result<Self> {
+        let options = rpc_channel_options(options);
+        let calls = Arc::new(Calls::default());
+        let wait = options.wait;
+        let poll_timeout = options.poll_timeout;
+        let recv_batch = options.recv_batch.max(1);
+        let channel = AutoClient::connect(name, Arc::new(ClientEvents(calls.clone())), options)?;
+        Ok(Self {
+            channel,
+            calls,
+            next_id: AtomicU32::new(1),
+            batch: Mutex::new(MessageBatch::with_capacity(MAX_MESSAGE_SIZE, recv_batch)),
+            wait,
+            poll_timeout,
+            recv_batch,
+        })
+    }
+
+    /// Синхронный вызов: ответ в `reply`, возвращает его длину. `timeout`
+    /// `None` — без предела; по таймауту опоздавший ответ отбрасывается.
+    pub fn call(
+        &self,
+        request: &[u8],
+        reply: &mut Vec<u8>,
+        timeout: Option<Duration>,
+    ) -> Result<usize> {
+        let id = self.submit(request)?;
+        self.wait(id, reply, timeout)
+    }
+
+    /// Отправляет вызов, не дожидаясь ответа; забрать его — `wait`/`poll`
+    /// с возвращённым id (не ноль).
+    pub fn submit(&self, request: &[u8]) -> Result<u32> {
+        let mut id = self.next_id.fetch_add(1, Ordering::Relaxed);
+        if id == 0 {
+            id = self.next_id.fetch_add(1, Ordering::Relaxed);
+        }
+        let mut frame = Vec::new();
+        encode(&mut frame, id, FRAME_CALL, request);
+        // слот — до отправки: ответ может прийти раньше, чем вернётся send
+        self.calls
+            .table
+            .lock()
+            .unwrap()
+            .slots
+            .insert(id, CallSlot::Waiting);
+        if let Err(err) = self.channel.send_direct(&frame) {
+            self.calls.table.lock().unwrap().slots.remove(&id);
+            return Err(err);
+        }
+        Ok(id)
+    }
+
+    /// Ждёт ответ на `id`. После результата (любого, кроме `QueueEmpty` у
+    /// `poll`) id больше не действителен; таймаут тоже снимает вызов.
+    pub fn wait(&self, id: u32, reply: &mut Vec<u8>, timeout: Option<Duration>) -> Result<usize> {
+        let deadline = timeout.and_then(|timeout| Instant::now().checked_add(timeout));
+        loop {
+            let mut table = self.calls.table.lock().unwrap();
+            if let Some(result) = table.take(id, reply) {
+                return result;
+            }
+            let remaining = match deadline {
+                Some(deadline) => {
+                    let remaining = deadline.saturating_duration_since(Instant::now());
+                    if remaining.is_zero() {
+                        table.slots.remove(&id);
+                        return Err(ShmError::Timeout);
+                    }
+                    remaining.min(self.poll_timeout)
+                }
+                None => self.poll_timeout,
+            };
+            if table.pumping {
+                // кольцо читает другой поток — он разбудит, разложив ответы
+                let _ = self.calls.changed.wait_timeout(table, remaining).unwrap();
+                continue;
+            }
+            table.pumping = true;
+            drop(table);
+            let pumped = self.pump(id, remaining);
+            self.calls.table.lock().unwrap().pumping = false;
+            // следующий ждущий подхватит чтение
+            self.calls.changed.notify_all();
+            if let Err(err) = pumped {
+                self.calls.table.lock().unwrap().slots.remove(&id);
+                return Err(err);
+            }
+        }
+    }
+
+    /// Неблокирующая проверка ответа на `id`: `QueueEmpty` — ещё не пришёл.
+    pub fn poll(&self, id: u32, reply: &mut Vec<u8>) -> Result<usize> {
+        let mut table = self.calls.table.lock().unwrap();
+        if let Some(result) = table.take(id, reply) {
+            return result;
+        }
+        if table.pumping {
+            return Err(ShmError::QueueEmpty);
+        }
+        table.pumping = true;
+        drop(table);
+        let drained = self.drain(id);
+        let mut table = self.calls.table.lock().unwrap();
+        table.pumping = false;
+        let result = match drained {
+            Ok(_) => table.take(id, reply).unwrap_or(Err(ShmError::QueueEmpty)),
+            Err(err) => {
+                table.slots.remove(&id);
+                Err(err)
+            }
+        };
+        drop(table);
+        self.calls.changed.notify_all();
+        result
+    }
+
+    /// Снимает вызов: его ответ будет отброшен. `false` — id неизвестен.
+    pub fn cancel(&self, id: u32) -> bool {
+        self.calls.table.lock().unwrap().slots.remove(&id).is_some()
+    }
+
+    /// Вызовов, чей результат ещё не забран.
+    pub fn pending(&self) -> usize {
+        self.calls.table.lock().unwrap().slots.len()
+    }
+
+    pub fn stats(&self) -> AutoStatsSnapshot {
+        self.channel.stats()
+    }
+
+    /// Один шаг чтения для ждущего `id`: дочитать кольцо, затем spin по
+    /// `wait`, затем событие не дольше `slice`.
+    fn pump(&self, id: u32, slice: Duration) -> Result<()> {
+        if self.drain(id)? || self.channel.spin_wait(&self.wait) {
+            return Ok(());
+        }
+        if let Some(handle) = self.channel.wait_handle() {
+            win::wait_any(&[handle], Some(slice))?;
+        }
+        Ok(())
+    }
+
+    /// Дочитывает кольцо ответов, раскладывая их по слотам; `true` — среди
+    /// них ответ на `id`.
+    fn drain(&self, id: u32) -> Result<bool> {
+        let mut batch = self.batch.lock().unwrap();
+        let mut resolved = false;
+        loop {
+            match self
+                .channel
+                .receive_batch(&mut batch, self.recv_batch, usize::MAX)
+            {
+                Ok(_) => {}
+                Err(ShmError::QueueEmpty) => return Ok(resolved),
+                Err(err) => return Err(err),
+            }
+            let mut table = self.calls.table.lock().unwrap();
+            let mut others = false;
+            for frame in batch.iter() {
+                let result = match decode(frame) {
+                    Some((call, FRAME_REPLY, body)) => (call, CallSlot::Ready(body.to_vec())),
+                    Some((call, FRAME_FAULT, body)) if body.len() >= 4 => {
+                        let code = u32::from_le_bytes(body[..4].try_into().unwrap());
+                        (call, CallSlot::Failed(ShmError::RemoteFailed(code)))
+                    }
+                    // чужой кадр в кольце ответов — не наш протокол
+                    _ => continue,
+                };
+                if table.resolve(result.0, result.1) {
+                    if result.0 == id {
+                        resolved = true;
+                    } else {
+                        others = true;
+                    }
+                }
+            }
+            drop(table);
+            if others {
+                self.calls.changed.notify_all();
+            }
+        }
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use crate::layout::ChannelGeometry;
+
+    #[test]
+    fn envelope_round_trips_and_rejects_short_frames() {
+        let mut frame = Vec::new();
+        encode(&mut frame, 0xDEAD_BEEF, FRAME_CALL, b"ping");
+        assert_eq!(frame.len(), RPC_ENVELOPE_SIZE + 4);
+        assert_eq!(
+            decode(&frame),
+            Some((0xDEAD_BEEF, FRAME_CALL, &b"ping"[..]))
+        );
+
+        encode(&mut frame, 7, FRAME_REPLY, b"");
+        assert_eq!(decode(&frame), Some((7, FRAME_REPLY, &b""[..])));
+        assert_eq!(decode(&frame[..RPC_ENVELOPE_SIZE - 1]), None);
+    }
+
+    #[test]
+    fn late_replies_to_cancelled_calls_are_dropped() {
+        let mut table = CallTable::default();
+        table.slots.insert(1, CallSlot::Waiting);
+        table.slots.insert(2, CallSlot::Waiting);
+        table.slots.remove(&2);
+
+        assert!(table.resolve(1, CallSlot::Ready(b"one".to_vec())));
+        assert!(!table.resolve(2, CallSlot::Ready(b"two".to_vec())));
+        // повторный ответ на уже решённый вызов не перезаписывает первый
+        assert!(!table.resolve(1, CallSlot::Failed(ShmError::RemoteFailed(5))));
+
+        let mut reply = Vec::new();
+        assert_eq!(table.take(1, &mut reply), Some(Ok(3)));
+        assert_eq!(reply, b"one");
+        assert_eq!(table.take(1, &mut reply), Some(Err(ShmError::UnknownCall)));
+    }
+
+    #[test]
+    fn oversized_reply_becomes_a_fault() {
+        let mut frame = Vec::new();
+        assert!(encode_result(&mut frame, 3, Ok(()), b"four", 4));
+        assert_eq!(decode(&frame), Some((3, FRAME_REPLY, &b"four"[..])));
+
+        assert!(!encode_result(&mut frame, 4, Ok(()), b"five!", 4));
+        let fault = RPC_FAULT_REPLY_TOO_LARGE.to_le_bytes();
+        assert_eq!(decode(&frame), Some((4, FRAME_FAULT, &fault[..])));
+
+        // отказ handler-а проходит как есть, сколько бы он ни написал в reply
+        assert!(encode_result(&mut frame, 5, Err(9), b"ignored", 4));
+        assert_eq!(
+            decode(&frame),
+            Some((5, FRAME_FAULT, &9u32.to_le_bytes()[..]))
+        );
+    }
+
+    #[test]
+    fn replies_wait_for_space_by_overflow_policy() {
+        let poll = Duration::from_millis(100);
+        let block = OverflowPolicy::Block(Duration::from_secs(2));
+        assert_eq!(reply_policy(block, poll), block);
+        assert_eq!(
+            reply_policy(OverflowPolicy::Fail, poll),
+            OverflowPolicy::Block(poll)
+        );
+    }
+
+    /// Отвечает на любой вызов `REPLY_SIZE` байтами и считает потерянные
+    /// ответы.
+    #[derive(Default)]
+    struct Bulky {
+        lost: AtomicU32,
+    }
+
+    const REPLY_SIZE: usize = 1000;
+
+    impl RpcHandler for Bulky {
+        fn on_call(&self, _request: &[u8], reply: &mut Vec<u8>) -> std::result::Result<(), u32> {
+            reply.resize(REPLY_SIZE, 0);
+            Ok(())
+        }
+
+        fn on_error(&self, err: ShmError) {
+            if err == ShmError::QueueFull {
+                self.lost.fetch_add(1, Ordering::Relaxed);
+            }
+        }
+    }
+
+    #[test]
+    fn unread_replies_are_reported_lost() {
+        let name = format!("XSHM_RPC_LOST_TEST_{}", std::process::id());
+        let mut geometry = ChannelGeometry::symmetric(4096);
+        geometry.max_message_size = 1024;
+        let options = AutoOptions {
+            geometry,
+            poll_timeout: Duration::from_millis(20),
+            ..AutoOptions::default()
+        };
+        let handler = Arc::new(Bulky::default());
+        let _server = RpcServer::start(&name, handler.clone(), options.clone()).unwrap();
+        let client = RpcClient::connect(&name, options).unwrap();
+
+        let deadline = Instant::now() + Duration::from_secs(5);
+        let mut submitted = 0;
+        while submitted < 8 {
+            match client.submit(b"x") {
+                Ok(_) => submitted += 1,
+                Err(ShmError::NotConnected) if Instant::now() < deadline => {
+                    thread::sleep(Duration::from_millis(10));
+                }
+                Err(err) => panic!("submit failed: {err:?}"),
+            }
+        }
+        // клиент ответов не читает: все восемь в кольцо 4 КБ не влезут, и
+        // потерянные доходят до handler-а
+        while handler.lost.load(Ordering::Relaxed) == 0 && Instant::now() < deadline {
+            thread::sleep(Duration::from_millis(10));
+        }
+        assert!(handler.lost.load(Ordering::Relaxed) > 0);
+    }
+
+    struct Echo;
+
+    impl RpcHandler for Echo {
+        fn on_call(&self, request: &[u8], reply: &mut Vec<u8>) -> std::result::Result<(), u32> {
+            if request == b"fail" {
+                return Err(42);
+            }
+            if request == b"huge" {
+                reply.resize(MAX_MESSAGE_SIZE, 0);
+                return Ok(());
+            }
+            reply.extend_from_slice(request);
+            reply.extend_from_slice(b"!");
+            Ok(())
+        }
+    }
+
+    #[test]
+    fn calls_round_trip_and_pipeline() {
+        let name = format!("XSHM_RPC_TEST_{}", std::process::id());
+        let options = AutoOptions {
+            wait: WaitStrategy::spin_then_block(Duration::from_micros(50), Duration::ZERO),
+            ..AutoOptions::default()
+        };
+        let _server = RpcServer::start(&name, Arc::new(Echo), options.clone()).unwrap();
+        let client = RpcClient::connect(&name, options).unwrap();
+
+        let mut reply = Vec::new();
+        let deadline = Instant::now() + Duration::from_secs(5);
+        let len = loop {
+            match client.call(b"ping", &mut reply, Some(Duration::from_secs(1))) {
+                Err(ShmError::NotConnected) if Instant::now() < deadline => {
+                    thread::sleep(Duration::from_millis(10));
+                }
+                other => break other.unwrap(),
+            }
+        };
+        assert_eq!(&reply[..len], b"ping!");
+        assert_eq!(
+            client.call(b"fail", &mut reply, Some(Duration::from_secs(1))),
+            Err(ShmError::RemoteFailed(42))
+        );
+        assert_eq!(
+            client.call(b"huge", &mut reply, Some(Duration::from_secs(1))),
+            Err(ShmError::RemoteFailed(RPC_FAULT_REPLY_TOO_LARGE))
+        );
+
+        let ids: Vec<u32> = (0..16)
+            .map(|i| client.submit(format!("m{i}").as_bytes()).unwrap())
+            .collect();
+        // ответы забираются не по порядку отправки
+        for (i, &id) in ids.iter().enumerate().rev() {
+            client
+                .wait(id, &mut reply, Some(Duration::from_secs(1)))
+                .unwrap();
+            assert_eq!(reply, format!("m{i}!").into_bytes());
+        }
+        assert_eq!(client.pending(), 0);
+    }
+}
@@ -0,0 +1,155 @@
+//! Адаптивный размер пачки приёма и веса клиентов.
+//!
+//! Фиксированный `recv_batch` под всплеском либо надолго занимает worker
+//! одним каналом (большая пачка: отправки и другие клиенты ждут), либо
+//! гоняет лишние проходы через `wait_any` (маленькая). С ненулевым
+//! `recv_budget` worker меряет, сколько стоит одно сообщение вместе с
+//! handler-ом (скользящее среднее), и берёт столько, сколько укладывается
+//! в бюджет, но не больше `recv_batch`. Глубину очереди учитывают сами
+//! циклы: канал, заполнивший пачку, остаётся «горячим» и получает
+//! следующий ход без ожидания событий.
+//!
+//! Вес клиента (`MultiServer::set_client_weight`,
+//! `DispatchServer::set_client_weight`) умножает его ход в круговом обходе
+//! горячих каналов: клиент с весом 4 забирает за ход вчетверо больше
+//! сообщений, чем клиент с весом 1, и болтливый клиент с весом 1 больше не
+//! может занять worker целиком.
+
+use std::time::{Duration, Instant};
+
+use crate::constants::MAX_MESSAGE_SIZE;
+use crate::error::{Result, ShmError};
+use crate::ring::MessageBatch;
+
+/// Предел веса клиента.
+pub const MAX_CLIENT_WEIGHT: u32 = 64;
+
+/// Вес клиента по умолчанию (и после переподключения).
+pub(crate) const DEFAULT_CLIENT_WEIGHT: u32 = 1;
+
+/// Размер пачки приёма одного worker-а.
+#[derive(Debug, Clone)]
+pub(crate) struct AdaptiveBatch {
+    cap: usize,
+    budget: Duration,
+    limit: usize,
+    /// Сглаженная стоимость сообщения, нс; 0 — ещё не мерили.
+    cost_ns: u64,
+}
+
+impl AdaptiveBatch {
+    /// `cap` — `recv_batch`; нулевой `budget` — фиксированная пачка `cap`.
+    pub(crate) fn new(cap: usize, budget: Duration) -> Self {
+        let cap = cap.max(1);
+        Self {
+            cap,
+            budget,
+            limit: cap,
+            cost_ns: 0,
+        }
+    }
+
+    /// Сколько сообщений брать за ход.
+    pub(crate) fn limit(&self) -> usize {
+        self.limit
+    }
+
+    /// Ход клиента с весом `weight`.
+    pub(crate) fn quantum(&self, weight: u32) -> usize {
+        self.limit.saturating_mul(weight.max(1) as usize)
+    }
+
+    /// Начало хода; `None` — бюджета нет, часы не читаются.
+    pub(crate) fn begin(&self) -> Option<Instant> {
+        (!self.budget.is_zero()).then(Instant::now)
+    }
+
+    /// Ход, начатый `begin`, принял `received` сообщений.
+    pub(crate) fn finish(&mut self, started: Option<Instant>, received: usize) {
+        if let Some(started) = started {
+            self.record(started.elapsed(), received);
+        }
+    }
+
+    fn record(&mut self, elapsed: Duration, received: usize) {
+        if received == 0 {
+            return;
+        }
+        let cost = (elapsed.as_nanos() / received as u128).max(1) as u64;
+        self.cost_ns = if self.cost_ns == 0 {
+            cost
+        } else {
+            (self.cost_ns * 3 + cost) / 4
+        };
+        let fits = self.budget.as_nanos() / self.cost_ns.max(1) as u128;
+        self.limit = (fits.min(self.cap as u128) as usize).max(1);
+    }
+}
+
+/// Буфер пачки worker-а вместе с её размером.
+pub(crate) struct Intake {
+    pub(crate) batch: MessageBatch,
+    pub(crate) sizer: AdaptiveBatch,
+}
+
+impl Intake {
+    pub(crate) fn new(recv_batch: usize, budget: Duration) -> Self {
+        Self {
+            batch: MessageBatch::with_capacity(MAX_MESSAGE_SIZE, recv_batch),
+            sizer: AdaptiveBatch::new(recv_batch, budget),
+        }
+    }
+}
+
+/// Проверка веса из публичного API.
+pub(crate) fn check_weight(weight: u32) -> Result<u32> {
+    if weight == 0 || weight > MAX_CLIENT_WEIGHT {
+        return Err(ShmError::InvalidConfig(
+            "weight must be in 1..=MAX_CLIENT_WEIGHT",
+        ));
+    }
+    Ok(weight)
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    #[test]
+    fn zero_budget_keeps_fixed_batch() {
+        let mut batch = AdaptiveBatch::new(32, Duration::ZERO);
+        assert!(batch.begin().is_none());
+        batch.finish(None, 32);
+        assert_eq!(batch.limit(), 32);
+        assert_eq!(batch.quantum(3), 96);
+        assert_eq!(AdaptiveBatch::new(0, Duration::ZERO).quantum(0), 1);
+    }
+
+    #[test]
+    fn limit_follows_message_cost() {
+        let mut batch = AdaptiveBatch::new(32, Duration::from_micros(100));
+        // 10 мкс на сообщение — в бюджет влезает 10.
+        batch.record(Duration::from_micros(320), 32);
+        assert_eq!(batch.limit(), 10);
+        // Дешёвые сообщения — обратно к потолку recv_batch.
+        for _ in 0..16 {
+            batch.record(Duration::from_nanos(100), 10);
+        }
+        assert_eq!(batch.limit(), 32);
+        // Медленный handler не опускает пачку ниже одного сообщения.
+        for _ in 0..16 {
+            batch.record(Duration::from_millis(5), 1);
+        }
+        assert_eq!(batch.limit(), 1);
+        // Пустой ход ничего не меняет.
+        batch.record(Duration::from_secs(1), 0);
+        assert_eq!(batch.quantum(2), 2);
+    }
+
+    #[test]
+    fn weight_is_validated() {
+        assert!(check_weight(0).is_err());
+        assert!(check_weight(MAX_CLIENT_WEIGHT + 1).is_err());
+        assert_eq!(check_weight(4).unwrap(), 4);
+    }
+}
@@ -1,13 +1,21 @@
-use std::sync::atomic::Ordering;
+use std::sync::atomic::{AtomicBool, AtomicUsize, Ordering};
+use std::sync::Arc;
 use std::time::Duration;
 
 use crate::constants::{HANDSHAKE_CLIENT_HELLO, HANDSHAKE_IDLE, HANDSHAKE_SERVER_READY};
 use crate::error::{Result, ShmError};
 use crate::events::SharedEvents;
+use crate::lanes::{space_nap, LaneSet, RxLanes};
+use crate::layout::ChannelGeometry;
 use crate::naming::mapping_name;
-use crate::ring::{RingBuffer, WriteOutcome};
+use crate::ring::{
+    AtomicOverflowPolicy, MessageBatch, OverflowPolicy, PeekedMessage, RingBuffer, WriteOutcome,
+    WriteReservation,
+};
 use crate::shared::SharedView;
-use crate::win::Mapping;
+use crate::stats::{ChannelStats, ChannelStatsSnapshot};
+use crate::wait::{write_batch_with_backpressure, write_with_backpressure, WaitStrategy};
+use crate::win::{EventHandle, Mapping};
 
 pub struct SharedServer {
     _name: String,
@@ -16,43 +24,35 @@ pub struct SharedServer {
     events: Option<SharedEvents>, // None для anonymous режима
     ring_tx: RingBuffer,
     ring_rx: RingBuffer,
-    connected: bool,
+    /// Дорожки 1.. каждого направления (`ChannelGeometry::lanes`).
+    tx_lanes: Vec<RingBuffer>,
+    rx_lanes: Vec<RingBuffer>,
+    /// Занятость дорожек `tx_lanes` producer-ами (`LaneSet::claim`).
+    lane_claims: Box<[AtomicBool]>,
+    /// Дорожка приёма, с которой начнётся следующий разбор.
+    rx_cursor: AtomicUsize,
+    /// Атомик: FFI ждёт клиента через `&self`, пока другие потоки шлют.
+    connected: AtomicBool,
+    /// Политика записи в кольцо server→client при нехватке места.
+    overflow: AtomicOverflowPolicy,
 }
 
 unsafe impl Send for SharedServer {}
 
 impl SharedServer {
     pub fn start(name: &str) -> Result<Self> {
-        let map_name = mapping_name(name);
-        let mapping = Mapping::create(&map_name)?;
-        let view = unsafe { SharedView::new(mapping.as_ptr()) };
-
-        // SAFETY: единственный владелец на этапе инициализации, алиасинга нет
-        let control = unsafe { &mut *view.control_block_ptr() };
-        control.reset();
-        let generation = control.generation.load(Ordering::Relaxed);
-
-        unsafe {
-            let header_a = &*view.ring_header_a();
-            header_a.reset(generation);
-            let header_b = &*view.ring_header_b();
-            header_b.reset(generation);
-        }
+        Self::start_with(name, &ChannelGeometry::default())
+    }
 
+    /// Создание сервера с заданной геометрией колец (ёмкость по направлениям,
+    /// пределы сообщений). Геометрия записывается в `ControlBlock`, клиент
+    /// берёт её оттуда при подключении.
+    pub fn start_with(name: &str, geometry: &ChannelGeometry) -> Result<Self> {
+        geometry.validate()?;
+        let map_name = mapping_name(name);
+        let mapping = Mapping::create(&map_name, geometry.mapping_size(), &geometry.memory)?;
         let events = SharedEvents::create(name)?;
-
-        let ring_tx = unsafe { RingBuffer::new(view.ring_header_a(), view.ring_buffer_a()) };
-        let ring_rx = unsafe { RingBuffer::new(view.ring_header_b(), view.ring_buffer_b()) };
-
-        Ok(Self {
-            _name: name.to_owned(),
-            _mapping: mapping,
-            view,
-            events: Some(events),
-            ring_tx,
-            ring_rx,
-            connected: false,
-        })
+        Ok(Self::init(name.to_owned(), mapping, Some(events), geometry))
     }
 
     /// Создание anonymous сервера без имени (только через handle)
@@ -68,12 +68,28 @@ impl SharedServer {
     /// создаст `UNICODE_STRING` с путем `"\\BaseNamedObjects\\"`, что является
     /// именованной секцией, а не anonymous. Поэтому нужна отдельная функция.
     pub fn start_anonymous() -> Result<Self> {
-        let mapping = Mapping::create_anonymous()?;
+        Self::start_anonymous_with(&ChannelGeometry::default())
+    }
+
+    /// Anonymous сервер с заданной геометрией колец (см. `start_with`).
+    pub fn start_anonymous_with(geometry: &ChannelGeometry) -> Result<Self> {
+        geometry.validate()?;
+        let mapping = Mapping::create_anonymous(geometry.mapping_size(), &geometry.memory)?;
+        // Events не создаются для anonymous режима - используется polling
+        Ok(Self::init(String::new(), mapping, None, geometry))
+    }
+
+    fn init(
+        name: String,
+        mapping: Mapping,
+        events: Option<SharedEvents>,
+        geometry: &ChannelGeometry,
+    ) -> Self {
         let view = unsafe { SharedView::new(mapping.as_ptr()) };
 
         // SAFETY: единственный владелец на этапе инициализации, алиасинга нет
         let control = unsafe { &mut *view.control_block_ptr() };
-        control.reset();
+        control.reset(geometry);
         let generation = control.generation.load(Ordering::Relaxed);
 
         unsafe {
@@ -82,21 +98,39 @@ impl SharedServer {
             let header_b = &*view.ring_header_b();
             header_b.reset(generation);
         }
-
-        // Events не создаются для anonymous режима - используется polling
-
-        let ring_tx = unsafe { RingBuffer::new(view.ring_header_a(), view.ring_buffer_a()) };
-        let ring_rx = unsafe { RingBuffer::new(view.ring_header_b(), view.ring_buffer_b()) };
-
-        Ok(Self {
-            _name: String::new(), // Anonymous - нет имени
+        view.reset_extra_lanes(generation);
+
+        // SAFETY: геометрия записана в ControlBlock выше и провалидирована
+        // вызывающим кодом, маппинг создан ровно под неё.
+        let ring_tx = unsafe { view.ring_a() };
+        let ring_rx = unsafe { view.ring_b() };
+        let (tx_lanes, rx_lanes): (Vec<_>, Vec<_>) = (1..geometry.lanes)
+            .map(|lane| unsafe { view.lane_rings(lane) })
+            .unzip();
+        let lane_claims = tx_lanes.iter().map(|_| AtomicBool::new(false)).collect();
+
+        let mut server = Self {
+            _name: name,
             _mapping: mapping,
             view,
-            events: None, // No events for anonymous mode
+            events,
             ring_tx,
             ring_rx,
-            connected: false,
-        })
+            tx_lanes,
+            rx_lanes,
+            lane_claims,
+            rx_cursor: AtomicUsize::new(0),
+            connected: AtomicBool::new(false),
+            overflow: AtomicOverflowPolicy::new(OverflowPolicy::Overwrite),
+        };
+        server.set_stats(Arc::default());
+        server
+    }
+
+    /// Сегмент получил большие страницы (`SectionOptions::large_pages` без
+    /// SeLockMemoryPrivilege откатывается на обычные).
+    pub fn uses_large_pages(&self) -> bool {
+        self._mapping.large_pages()
     }
 
     /// Получить handles событий для передачи в kernel driver
@@ -107,8 +141,8 @@ impl SharedServer {
         self.events.as_ref().map(|e| e.get_event_handles())
     }
 
-    pub fn wait_for_client(&mut self, timeout: Option<Duration>) -> Result<()> {
-        if self.connected {
+    pub fn wait_for_client(&self, timeout: Option<Duration>) -> Result<()> {
+        if self.connected.load(Ordering::Acquire) {
             return Err(ShmError::AlreadyConnected);
         }
 
@@ -120,6 +154,15 @@ impl SharedServer {
         if !self.events.as_ref().unwrap().connect_req.wait(timeout)? {
             return Err(ShmError::Timeout);
         }
+        self.accept_client()
+    }
+
+    /// Handshake после того, как `connect_req` уже забран вызывающим (пул
+    /// dispatch-а ждёт его вместе с событиями других каналов).
+    pub(crate) fn accept_client(&self) -> Result<()> {
+        if self.connected.load(Ordering::Acquire) {
+            return Err(ShmError::AlreadyConnected);
+        }
 
         let control = self.view.control_block();
         let client_state = control.client_state.load(Ordering::Acquire);
@@ -136,6 +179,7 @@ impl SharedServer {
             (&*self.view.ring_header_a()).reset(new_generation);
             (&*self.view.ring_header_b()).reset(new_generation);
         }
+        self.view.reset_extra_lanes(new_generation);
 
         // Теперь атомарно публикуем новый generation
         control.generation.store(new_generation, Ordering::Release);
@@ -161,14 +205,14 @@ impl SharedServer {
         if let Some(events) = &self.events {
             events.connect_ack.set()?;
         }
-        self.connected = true;
+        self.connected.store(true, Ordering::Release);
         Ok(())
     }
 
     /// Ожидание клиента без событий (polling по shared memory).
     /// Использовать когда нет доступа к именованным событиям.
-    pub fn wait_for_client_noevent(&mut self, timeout: Option<Duration>) -> Result<()> {
-        if self.connected {
+    pub fn wait_for_client_noevent(&self, timeout: Option<Duration>) -> Result<()> {
+        if self.connected.load(Ordering::Acquire) {
             return Err(ShmError::AlreadyConnected);
         }
 
@@ -198,6 +242,7 @@ impl SharedServer {
             (&*self.view.ring_header_a()).reset(new_generation);
             (&*self.view.ring_header_b()).reset(new_generation);
         }
+        self.view.reset_extra_lanes(new_generation);
 
         // Теперь атомарно публикуем новый generation
         control.generation.store(new_generation, Ordering::Release);
@@ -219,12 +264,12 @@ impl SharedServer {
             .client_state
             .store(HANDSHAKE_SERVER_READY, Ordering::Release);
 
-        self.connected = true;
+        self.connected.store(true, Ordering::Release);
         Ok(())
     }
 
     pub fn is_connected(&self) -> bool {
-        self.connected
+        self.connected.load(Ordering::Acquire)
     }
 
     /// Доступ к событиям сервера (для внутреннего использования)
@@ -253,11 +298,11 @@ impl SharedServer {
 
     /// Установка состояния подключения (для внутреннего использования)
     pub(crate) fn set_connected(&mut self, connected: bool) {
-        self.connected = connected;
+        self.connected.store(connected, Ordering::Release);
     }
 
     pub(crate) fn mark_disconnected(&mut self) {
-        self.connected = false;
+        self.connected.store(false, Ordering::Release);
 
         // Сбрасываем состояние в shared memory для возможности reconnect
         let control = self.view.control_block();
@@ -278,8 +323,81 @@ impl SharedServer {
         }
     }
 
+    /// Что делать отправке клиенту, когда кольцу не хватает места (по
+    /// умолчанию — вытеснять старые сообщения). Действует на `send_to_client`,
+    /// `send_batch_to_client` и `reserve_to_client`. `Block` ждёт, пока
+    /// клиент дочитает кольцо; в anonymous-режиме событий нет, и ожидание
+    /// идёт через `yield_now`.
+    pub fn set_overflow_policy(&self, policy: OverflowPolicy) {
+        self.overflow.store(policy);
+        for ring in std::iter::once(&self.ring_tx).chain(&self.tx_lanes) {
+            ring.set_overwrite(policy == OverflowPolicy::Overwrite);
+        }
+    }
+
+    pub fn overflow_policy(&self) -> OverflowPolicy {
+        self.overflow.load()
+    }
+
+    /// Писать ли в кольцо server→client кадры с меткой трассировки
+    /// (`MessageTrace`): время постановки в очередь и порядковый номер. Клиент
+    /// должен знать флаг `MESSAGE_FLAG_TRACED` — включать, только когда обе
+    /// стороны обновлены. Кадр, которому расширение не даёт влезть в
+    /// кольцо, уходит без метки.
+    pub fn set_tracing(&mut self, trace: bool) {
+        for ring in std::iter::once(&mut self.ring_tx).chain(&mut self.tx_lanes) {
+            ring.set_trace(trace);
+        }
+    }
+
+    /// Статистика канала на стороне сервера: заполненность и вытеснения
+    /// кольца server→client, задержка доставки от клиента (сэмплы). Без
+    /// worker-а (`AutoServer`, `MultiServer`) пробуждения, пачки и время
+    /// handler-а остаются нулевыми.
+    pub fn channel_stats(&self) -> ChannelStatsSnapshot {
+        self.ring_tx.stats().snapshot()
+    }
+
+    /// Подменяет приёмник статистики обоих колец — чтобы счёт переживал
+    /// переподключение или был виден владельцу worker-а.
+    pub(crate) fn set_stats(&mut self, stats: Arc<ChannelStats>) {
+        for ring in self.rx_lanes.iter_mut().chain(&mut self.tx_lanes) {
+            ring.set_stats(stats.clone());
+        }
+        self.ring_rx.set_stats(stats.clone());
+        self.ring_tx.set_stats(stats);
+    }
+
+    fn space_event(&self) -> Option<&EventHandle> {
+        self.events.as_ref().map(|events| &events.s2c.space)
+    }
+
+    /// Кольца client→server всех дорожек.
+    fn rx(&self) -> RxLanes<'_> {
+        RxLanes {
+            main: &self.ring_rx,
+            extra: &self.rx_lanes,
+            cursor: &self.rx_cursor,
+            space: self.events.as_ref().map(|events| &events.c2s.space),
+        }
+    }
+
+    /// Дорожки server→client для многопоточной отправки (см.
+    /// `crate::lanes`); пусто, если канал создан с одной дорожкой. Пока
+    /// набор жив, сервер нельзя переподключить или закрыть.
+    pub fn lanes(&self) -> Result<LaneSet<'_>> {
+        self.ensure_connected()?;
+        Ok(LaneSet::new(
+            &self.tx_lanes,
+            &self.lane_claims,
+            self.overflow.load(),
+            self.space_event(),
+            self.events.as_ref().map(|events| &events.s2c.data),
+        ))
+    }
+
     fn ensure_connected(&self) -> Result<()> {
-        if !self.connected {
+        if !self.connected.load(Ordering::Acquire) {
             Err(ShmError::NotConnected)
         } else {
             Ok(())
@@ -287,23 +405,138 @@ impl SharedServer {
     }
 
     pub fn send_to_client(&self, payload: &[u8]) -> Result<WriteOutcome> {
+        self.send_to_client_at(payload, None)
+    }
+
+    /// `send_to_client` с меткой постановки в очередь `enqueued` (тики QPC)
+    /// для трассируемого кадра.
+    pub(crate) fn send_to_client_at(
+        &self,
+        payload: &[u8],
+        enqueued: Option<u64>,
+    ) -> Result<WriteOutcome> {
         self.ensure_connected()?;
-        let result = self.ring_tx.write_message(payload)?;
+        let nap = space_nap(&self.tx_lanes);
+        let policy = self.overflow.load();
+        let result = write_with_backpressure(policy, self.space_event(), nap, || {
+            self.ring_tx.write_message_at(payload, enqueued)
+        })?;
         // Сигнализируем только если events доступны
         if let Some(ref events) = self.events {
-            if result.was_empty {
+            if result.wake_consumer {
+                let _ = events.s2c.data.set();
+            }
+        }
+        Ok(result)
+    }
+
+    /// Будит клиента на data-событии server→client без записи в кольцо:
+    /// данные пришли мимо него, через секцию рассылки (`broadcast`).
+    pub(crate) fn notify_client(&self) -> Result<()> {
+        self.ensure_connected()?;
+        if let Some(ref events) = self.events {
+            events.s2c.data.set()?;
+        }
+        Ok(())
+    }
+
+    /// Отправка пачки сообщений: все кадры копируются в кольцо и публикуются
+    /// одним сдвигом `write_pos`, data-событие сигналится не больше одного
+    /// раза. Размеры проверяются заранее — при ошибке валидации не
+    /// отправляется ничего. Без вытеснения (`OverflowPolicy::Fail`/`Block`)
+    /// пачка принимается частями по мере освобождения места, и `QueueFull`
+    /// оставляет уже принятые части у клиента.
+    pub fn send_batch_to_client(&self, messages: &[&[u8]]) -> Result<WriteOutcome> {
+        self.ensure_connected()?;
+        write_batch_with_backpressure(
+            &self.ring_tx,
+            self.overflow.load(),
+            self.space_event(),
+            space_nap(&self.tx_lanes),
+            self.events.as_ref().map(|events| &events.s2c.data),
+            messages,
+        )
+    }
+
+    /// Zero-copy отправка: резерв `len` байт прямо в кольце server→client.
+    /// Заполнить через [`SharedServer::reserved_spans`], опубликовать через
+    /// [`SharedServer::commit_to_client`]; пока резерв жив, `send_to_client`
+    /// вызывать нельзя (кольцо SPSC).
+    pub fn reserve_to_client(&self, len: usize) -> Result<WriteReservation> {
+        self.ensure_connected()?;
+        let nap = space_nap(&self.tx_lanes);
+        let policy = self.overflow.load();
+        write_with_backpressure(policy, self.space_event(), nap, || {
+            self.ring_tx.reserve(len)
+        })
+    }
+
+    /// Участки кольца server→client под payload резерва (второй — при переносе).
+    pub fn reserved_spans<'a>(
+        &'a self,
+        reservation: &'a mut WriteReservation,
+    ) -> (&'a mut [u8], &'a mut [u8]) {
+        self.ring_tx.reservation_spans(reservation)
+    }
+
+    /// Публикует первые `used` байт резерва как одно сообщение клиенту.
+    pub fn commit_to_client(
+        &self,
+        reservation: WriteReservation,
+        used: usize,
+    ) -> Result<WriteOutcome> {
+        self.ensure_connected()?;
+        let result = self.ring_tx.commit(reservation, used)?;
+        if let Some(ref events) = self.events {
+            if result.wake_consumer {
                 let _ = events.s2c.data.set();
             }
         }
         Ok(result)
     }
 
+    /// Следующее сообщение клиента; с несколькими дорожками — с первой
+    /// непустой по кругу.
     pub fn receive_from_client(&self, buffer: &mut Vec<u8>) -> Result<usize> {
         self.ensure_connected()?;
-        let len = self.ring_rx.read_message(buffer)?;
-        // Сигнализируем только если events доступны
+        self.rx().read_message(buffer)
+    }
+
+    /// Забирает до `max_messages` сообщений клиента в `batch` одним сдвигом
+    /// `read_pos`. Пачка обрывается перед сообщением, с которым арена
+    /// превысила бы `max_bytes` (первое сообщение берётся всегда). С
+    /// несколькими дорожками пачка собирается с них по кругу — по сдвигу на
+    /// каждую непустую.
+    pub fn receive_batch_from_client(
+        &self,
+        batch: &mut MessageBatch,
+        max_messages: usize,
+        max_bytes: usize,
+    ) -> Result<usize> {
+        self.ensure_connected()?;
+        self.rx().read_batch(batch, max_messages, max_bytes)
+    }
+
+    /// Zero-copy чтение: самое старое сообщение клиента без копирования
+    /// (только дорожка 0).
+    /// Payload — через [`SharedServer::peeked_spans`], забрать —
+    /// [`SharedServer::consume_from_client`].
+    pub fn peek_from_client(&self) -> Result<PeekedMessage> {
+        self.ensure_connected()?;
+        self.ring_rx.peek()
+    }
+
+    /// Участки кольца client→server с payload подсмотренного сообщения.
+    pub fn peeked_spans<'a>(&'a self, message: &'a PeekedMessage) -> (&'a [u8], &'a [u8]) {
+        self.ring_rx.peeked_spans(message)
+    }
+
+    /// Забирает подсмотренное сообщение; `Err(Overwritten)` — его вытеснили.
+    pub fn consume_from_client(&self, message: PeekedMessage) -> Result<usize> {
+        self.ensure_connected()?;
+        let len = self.ring_rx.consume(message)?;
         if let Some(ref events) = self.events {
-            if self.ring_rx.message_count() == 0 {
+            if self.ring_rx.is_empty() {
                 let _ = events.c2s.space.set();
             }
         }
@@ -312,7 +545,7 @@ impl SharedServer {
 
     pub fn poll_client(&self, timeout: Option<Duration>) -> Result<bool> {
         self.ensure_connected()?;
-        if !self.ring_rx.is_empty() {
+        if self.rx().has_data() {
             return Ok(true);
         }
         // Для anonymous режима просто проверяем буфер (polling)
@@ -321,6 +554,33 @@ impl SharedServer {
         }
         self.events.as_ref().unwrap().c2s.data.wait(timeout)
     }
+
+    /// Активное ожидание данных клиента по `strategy` (spin, затем yield). Пока
+    /// оно идёт — и дальше, пока данные обрабатываются, — клиент не сигналит
+    /// data-событие. `true` — данные есть; `false` — бюджет исчерпан, кольцо
+    /// пусто, флаг снят, и можно блокироваться на `c2s.data`.
+    pub fn spin_wait_client(&self, strategy: &WaitStrategy) -> bool {
+        let rx = self.rx();
+        if strategy.is_blocking() {
+            return rx.has_data();
+        }
+        rx.start_spinning();
+        strategy.spin_until(|| rx.has_data()) || rx.stop_spinning()
+    }
+
+    /// Составные части `spin_wait_client` для worker-а, который крутится сразу
+    /// по нескольким слотам (`MultiServer`).
+    pub(crate) fn start_client_spin(&self) {
+        self.rx().start_spinning();
+    }
+
+    pub(crate) fn stop_client_spin(&self) -> bool {
+        self.rx().stop_spinning()
+    }
+
+    pub(crate) fn has_client_data(&self) -> bool {
+        self.rx().has_data()
+    }
 }
 
 impl Drop for SharedServer {
@@ -340,7 +600,7 @@ impl Drop for SharedServer {
                 .handshake_state
                 .store(HANDSHAKE_IDLE, Ordering::Release);
         }
-        if self.connected {
+        if self.connected.load(Ordering::Acquire) {
             if let Some(ref events) = self.events {
                 let _ = events.disconnect.set();
             }
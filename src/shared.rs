@@ -1,6 +1,7 @@
 use std::ptr::NonNull;
 
-use crate::layout::{ControlBlock, RingHeader};
+use crate::layout::{lane_size, ChannelGeometry, ControlBlock, RingHeader};
+use crate::ring::RingBuffer;
 
 pub struct SharedView {
     base: NonNull<u8>,
@@ -11,12 +12,15 @@ unsafe impl Sync for SharedView {}
 
 impl SharedView {
     /// # Safety
-    /// `base` обязан указывать на начало валидного маппинга размером не
-    /// менее `shared_mapping_size()` байт (layout: `ControlBlock`
-    /// `+RingHeader_A+RingBuffer_A+RingHeader_B+RingBuffer_B`), выровненного
-    /// минимум на 64 байта, и оставаться валидным (не unmapped) на всё время
-    /// жизни возвращаемого `SharedView` -- это гарантирует вызывающий код,
-    /// держащий соответствующий `Mapping` живым.
+    /// `base` обязан указывать на начало валидного маппинга (layout:
+    /// `ControlBlock+RingHeader_A+RingBuffer_A+RingHeader_B+RingBuffer_B`,
+    /// за ним — `lanes - 1` дорожек такого же вида),
+    /// выровненного минимум на 64 байта, и оставаться валидным (не unmapped)
+    /// на всё время жизни возвращаемого `SharedView` -- это гарантирует
+    /// вызывающий код, держащий соответствующий `Mapping` живым. Смещения
+    /// колец берутся из геометрии в `ControlBlock`: до обращения к ним она
+    /// должна быть записана (сервер) или проверена против размера маппинга
+    /// (клиент), см. `ChannelGeometry::mapping_size`.
     pub unsafe fn new(base: *mut u8) -> Self {
         SharedView {
             base: NonNull::new(base).expect("shared mapping pointer must be valid"),
@@ -34,6 +38,10 @@ impl SharedView {
         self.base.as_ptr() as *mut ControlBlock
     }
 
+    pub fn geometry(&self) -> ChannelGeometry {
+        self.control_block().geometry()
+    }
+
     pub fn ring_header_a(&self) -> *mut RingHeader {
         // SAFETY: смещение на size_of::<ControlBlock>() остаётся внутри
         // маппинга -- следующее поле layout'а сразу после ControlBlock.
@@ -41,9 +49,11 @@ impl SharedView {
     }
 
     pub fn ring_header_b(&self) -> *mut RingHeader {
-        // SAFETY: ring_buffer_a() + RING_CAPACITY -- следующее поле layout'а
-        // (RingHeader_B) сразу после RingBuffer_A, остаётся внутри маппинга.
-        unsafe { self.ring_buffer_a().add(crate::constants::RING_CAPACITY) as *mut RingHeader }
+        // SAFETY: ring_buffer_a() + ёмкость кольца A -- следующее поле layout'а
+        // (RingHeader_B) сразу после RingBuffer_A, остаётся внутри маппинга
+        // (геометрия проверена против его размера, см. SharedView::new).
+        let capacity_a = self.control_block().ring_capacity_a as usize;
+        unsafe { self.ring_buffer_a().add(capacity_a) as *mut RingHeader }
     }
 
     pub fn ring_buffer_a(&self) -> *mut u8 {
@@ -55,7 +65,121 @@ impl SharedView {
     pub fn ring_buffer_b(&self) -> *mut u8 {
         // SAFETY: смещение на size_of::<RingHeader>() от ring_header_b() --
         // последнее поле layout'а (RingBuffer_B), остаётся внутри маппинга
-        // (гарантировано размером, выделенным shared_mapping_size()).
+        // (гарантировано размером, выделенным по ChannelGeometry::mapping_size()).
         unsafe { (self.ring_header_b() as *mut u8).add(std::mem::size_of::<RingHeader>()) }
     }
+
+    /// Начало дорожки `lane` (0 — основные кольца, `ring_header_a()`).
+    fn lane_base(&self, lane: u32) -> *mut u8 {
+        let control = self.control_block();
+        let stride = lane_size(
+            control.ring_capacity_a as usize,
+            control.ring_capacity_b as usize,
+        );
+        // SAFETY: lane < lanes из геометрии, проверенной против размера
+        // маппинга (ChannelGeometry::mapping_size): дорожки идут подряд.
+        unsafe { (self.ring_header_a() as *mut u8).add(stride * lane as usize) }
+    }
+
+    /// Заголовки колец A и B дорожки `lane` (0 — основные кольца).
+    pub fn lane_headers(&self, lane: u32) -> (*mut RingHeader, *mut RingHeader) {
+        let base = self.lane_base(lane);
+        let capacity_a = self.control_block().ring_capacity_a as usize;
+        let offset_b = std::mem::size_of::<RingHeader>() + capacity_a;
+        // SAFETY: RingHeader_B дорожки лежит сразу за её кольцом A.
+        (base as *mut RingHeader, unsafe { base.add(offset_b) }
+            as *mut RingHeader)
+    }
+
+    /// Кольца A (server→client) и B (client→server) дорожки `lane`.
+    ///
+    /// # Safety
+    /// См. `ring_a`; `lane` меньше `geometry().lanes`.
+    pub unsafe fn lane_rings(&self, lane: u32) -> (RingBuffer, RingBuffer) {
+        let geometry = self.geometry();
+        let (header_a, header_b) = self.lane_headers(lane);
+        let data = |header: *mut RingHeader| {
+            // SAFETY: storage кольца — сразу за его заголовком.
+            unsafe { (header as *mut u8).add(std::mem::size_of::<RingHeader>()) }
+        };
+        // SAFETY: header/data -- поля layout'а внутри маппинга (см. выше).
+        unsafe {
+            (
+                ring(header_a, data(header_a), geometry.s2c_capacity, &geometry),
+                ring(header_b, data(header_b), geometry.c2s_capacity, &geometry),
+            )
+        }
+    }
+
+    /// Сбрасывает кольца дополнительных дорожек (1..lanes) в поколение
+    /// `generation`. Handshake идёт только по основным кольцам:
+    /// `handshake_state` дорожек не используется.
+    pub fn reset_extra_lanes(&self, generation: u32) {
+        for lane in 1..self.geometry().lanes {
+            let (header_a, header_b) = self.lane_headers(lane);
+            // SAFETY: заголовки внутри маппинга (см. lane_headers).
+            unsafe {
+                (&*header_a).reset(generation);
+                (&*header_b).reset(generation);
+            }
+        }
+    }
+
+    /// Кольцо A (server→client) с пределами из геометрии сегмента.
+    ///
+    /// # Safety
+    /// Те же требования, что и у `SharedView::new`; геометрия уже валидна.
+    pub unsafe fn ring_a(&self) -> RingBuffer {
+        let geometry = self.geometry();
+        // SAFETY: header/data -- поля layout'а внутри маппинга (см. выше).
+        unsafe {
+            ring(
+                self.ring_header_a(),
+                self.ring_buffer_a(),
+                geometry.s2c_capacity,
+                &geometry,
+            )
+        }
+    }
+
+    /// Кольцо B (client→server) с пределами из геометрии сегмента.
+    ///
+    /// # Safety
+    /// См. `ring_a`.
+    pub unsafe fn ring_b(&self) -> RingBuffer {
+        let geometry = self.geometry();
+        // SAFETY: header/data -- поля layout'а внутри маппинга (см. выше).
+        unsafe {
+            ring(
+                self.ring_header_b(),
+                self.ring_buffer_b(),
+                geometry.c2s_capacity,
+                &geometry,
+            )
+        }
+    }
+}
+
+/// Кольцо с пределами и форматом кадров из геометрии сегмента.
+///
+/// # Safety
+/// См. `RingBuffer::new`.
+unsafe fn ring(
+    header: *mut RingHeader,
+    data: *mut u8,
+    capacity: usize,
+    geometry: &ChannelGeometry,
+) -> RingBuffer {
+    // SAFETY: требования переданы вызывающему (см. выше).
+    let mut ring = unsafe {
+        RingBuffer::new(
+            header,
+            data,
+            capacity,
+            geometry.max_messages,
+            geometry.max_message_size,
+        )
+    };
+    ring.set_slot_size(geometry.slot_size as usize);
+    ring
 }
@@ -0,0 +1,313 @@
+//! Телеметрия горячего пути канала: заполненность кольца, задержка
+//! доставки, пробуждения, размеры пачек и время в callback-ах.
+//!
+//! Все счётчики — локальные атомики процесса (`Relaxed`): каждую сторону
+//! канала читает свой процесс. Исключение — метка времени публикации
+//! (`ProducerIndex::publish_stamp`), по которой consumer меряет задержку:
+//! producer ставит её не на каждую публикацию, а раз в
+//! `LATENCY_SAMPLE_INTERVAL` сообщений, так что часы на горячем пути почти
+//! не читаются. Трассируемые кадры (`crate::trace`) несут метку каждый, и
+//! их ожидание в очереди считается отдельно, без сэмплирования.
+
+use std::sync::atomic::{AtomicU32, AtomicU64, Ordering};
+
+use crate::win;
+
+/// Корзин в гистограмме: корзина `i > 0` — значения из `[2^(i-1), 2^i)`,
+/// корзина 0 — ноль, последняя — всё, что не влезло в предыдущие.
+pub const HISTOGRAM_BUCKETS: usize = 32;
+
+/// Сэмпл задержки — одна метка на столько опубликованных сообщений (степень
+/// двойки).
+pub(crate) const LATENCY_SAMPLE_INTERVAL: u32 = 64;
+
+/// log2-гистограмма с атомарными корзинами.
+#[derive(Default)]
+pub(crate) struct Histogram {
+    buckets: [AtomicU64; HISTOGRAM_BUCKETS],
+    count: AtomicU64,
+    sum: AtomicU64,
+    max: AtomicU64,
+}
+
+impl Histogram {
+    pub(crate) fn record(&self, value: u64) {
+        self.buckets[bucket_index(value)].fetch_add(1, Ordering::Relaxed);
+        self.count.fetch_add(1, Ordering::Relaxed);
+        self.sum.fetch_add(value, Ordering::Relaxed);
+        // обычно пишет один поток — RMW только при новом максимуме
+        if value > self.max.load(Ordering::Relaxed) {
+            self.max.fetch_max(value, Ordering::Relaxed);
+        }
+    }
+
+    fn snapshot(&self) -> HistogramSnapshot {
+        let mut buckets = [0u64; HISTOGRAM_BUCKETS];
+        for (dst, src) in buckets.iter_mut().zip(&self.buckets) {
+            *dst = src.load(Ordering::Relaxed);
+        }
+        HistogramSnapshot {
+            count: self.count.load(Ordering::Relaxed),
+            sum: self.sum.load(Ordering::Relaxed),
+            max: self.max.load(Ordering::Relaxed),
+            buckets,
+        }
+    }
+
+    fn reset(&self) {
+        for bucket in &self.buckets {
+            bucket.store(0, Ordering::Relaxed);
+        }
+        self.count.store(0, Ordering::Relaxed);
+        self.sum.store(0, Ordering::Relaxed);
+        self.max.store(0, Ordering::Relaxed);
+    }
+}
+
+fn bucket_index(value: u64) -> usize {
+    ((u64::BITS - value.leading_zeros()) as usize).min(HISTOGRAM_BUCKETS - 1)
+}
+
+/// Снимок гистограммы. Счётчики читаются без общей блокировки, поэтому под
+/// нагрузкой `count` может на пару значений разойтись с суммой корзин.
+#[derive(Clone, Copy, Debug, Default, PartialEq, Eq)]
+pub struct HistogramSnapshot {
+    pub count: u64,
+    pub sum: u64,
+    pub max: u64,
+    pub buckets: [u64; HISTOGRAM_BUCKETS],
+}
+
+impl HistogramSnapshot {
+    pub fn mean(&self) -> u64 {
+        self.sum.checked_div(self.count).unwrap_or(0)
+    }
+
+    /// Оценка квантиля `quantile` (0.0..=1.0) сверху: верхняя граница
+    /// корзины, в которую он попал, но не больше `max`.
+    pub fn percentile(&self, quantile: f64) -> u64 {
+        let total: u64 = self.buckets.iter().sum();
+        if total == 0 {
+            return 0;
+        }
+        let rank = ((total as f64 * quantile.clamp(0.0, 1.0)).ceil() as u64).max(1);
+        let mut seen = 0u64;
+        for (index, &count) in self.buckets.iter().enumerate() {
+            seen += count;
+            if seen >= rank {
+                if index + 1 == HISTOGRAM_BUCKETS {
+                    break;
+                }
+                return ((1u64 << index) - 1).min(self.max);
+            }
+        }
+        self.max
+    }
+}
+
+/// Статистика одной стороны канала.
+///
+/// Кольцо пишет сюда заполненность и вытеснения (как producer) и задержку
+/// (как consumer); worker-ы `auto`/`multi`/`dispatch` — пробуждения, пачки и
+/// время handler-а. Сырые `SharedServer`/`SharedClient` без worker-а
+/// заполняют только кольцевую часть.
+#[derive(Default)]
+pub(crate) struct ChannelStats {
+    high_water_bytes: AtomicU32,
+    high_water_messages: AtomicU32,
+    dropped: AtomicU64,
+    wakeups: AtomicU64,
+    spurious_wakeups: AtomicU64,
+    batch_sizes: Histogram,
+    latency_ns: Histogram,
+    handler_ns: Histogram,
+    queue_delay_ns: Histogram,
+}
+
+impl ChannelStats {
+    /// Заполненность исходящего кольца сразу после публикации.
+    pub(crate) fn record_occupancy(&self, bytes: u32, messages: u32) {
+        // producer у кольца один — хватает load/store без RMW
+        if bytes > self.high_water_bytes.load(Ordering::Relaxed) {
+            self.high_water_bytes.store(bytes, Ordering::Relaxed);
+        }
+        if messages > self.high_water_messages.load(Ordering::Relaxed) {
+            self.high_water_messages.store(messages, Ordering::Relaxed);
+        }
+    }
+
+    pub(crate) fn record_drop(&self) {
+        self.dropped.fetch_add(1, Ordering::Relaxed);
+    }
+
+    /// Задержка от публикации до чтения, в тиках `win::perf_counter`.
+    pub(crate) fn record_latency_ticks(&self, ticks: u64) {
+        self.latency_ns.record(ticks_to_nanos(ticks));
+    }
+
+    /// Сколько трассируемое сообщение ждало от постановки в очередь до
+    /// чтения.
+    pub(crate) fn record_queue_delay(&self, nanos: u64) {
+        self.queue_delay_ns.record(nanos);
+    }
+
+    /// Worker проснулся по data-событию; `spurious` — первое же чтение после
+    /// этого ничего не принесло.
+    pub(crate) fn record_wakeup(&self, spurious: bool) {
+        self.wakeups.fetch_add(1, Ordering::Relaxed);
+        if spurious {
+            self.spurious_wakeups.fetch_add(1, Ordering::Relaxed);
+        }
+    }
+
+    /// Непустое чтение worker-а из `count` сообщений.
+    pub(crate) fn record_batch(&self, count: usize) {
+        self.batch_sizes.record(count as u64);
+    }
+
+    /// Выполняет `deliver` (раздачу пачки handler-у), записывая его время.
+    pub(crate) fn time_handler<R>(&self, deliver: impl FnOnce() -> R) -> R {
+        let started = win::perf_counter();
+        let result = deliver();
+        self.handler_ns
+            .record(ticks_to_nanos(win::perf_counter().wrapping_sub(started)));
+        result
+    }
+
+    /// Обнуление — `MultiServer` начинает статистику слота заново с каждым
+    /// новым клиентом.
+    pub(crate) fn reset(&self) {
+        self.high_water_bytes.store(0, Ordering::Relaxed);
+        self.high_water_messages.store(0, Ordering::Relaxed);
+        self.dropped.store(0, Ordering::Relaxed);
+        self.wakeups.store(0, Ordering::Relaxed);
+        self.spurious_wakeups.store(0, Ordering::Relaxed);
+        self.batch_sizes.reset();
+        self.latency_ns.reset();
+        self.handler_ns.reset();
+        self.queue_delay_ns.reset();
+    }
+
+    pub(crate) fn snapshot(&self) -> ChannelStatsSnapshot {
+        ChannelStatsSnapshot {
+            high_water_bytes: self.high_water_bytes.load(Ordering::Relaxed),
+            high_water_messages: self.high_water_messages.load(Ordering::Relaxed),
+            dropped_messages: self.dropped.load(Ordering::Relaxed),
+            wakeups: self.wakeups.load(Ordering::Relaxed),
+            spurious_wakeups: self.spurious_wakeups.load(Ordering::Relaxed),
+            batch_sizes: self.batch_sizes.snapshot(),
+            latency_ns: self.latency_ns.snapshot(),
+            handler_ns: self.handler_ns.snapshot(),
+            queue_delay_ns: self.queue_delay_ns.snapshot(),
+        }
+    }
+}
+
+/// Снимок статистики одной стороны канала.
+#[derive(Clone, Copy, Debug, Default, PartialEq, Eq)]
+pub struct ChannelStatsSnapshot {
+    /// Максимум занятых байт исходящего кольца (с заголовками кадров).
+    pub high_water_bytes: u32,
+    /// Максимум сообщений в исходящем кольце.
+    pub high_water_messages: u32,
+    /// Сообщений, вытесненных из исходящего кольца overwrite-ом.
+    pub dropped_messages: u64,
+    /// Пробуждений worker-а по data-событию.
+    pub wakeups: u64,
+    /// Из них — без данных в кольце.
+    pub spurious_wakeups: u64,
+    /// Сообщений за одно чтение worker-а.
+    pub batch_sizes: HistogramSnapshot,
+    /// Задержка от публикации во входящее кольцо до чтения, нс (сэмплы,
+    /// точность — период счётчика производительности, обычно 100 нс).
+    pub latency_ns: HistogramSnapshot,
+    /// Время раздачи одной пачки callback-ам, нс.
+    pub handler_ns: HistogramSnapshot,
+    /// Ожидание трассируемых сообщений от постановки в очередь (`send()`
+    /// auto-режима или запись в кольцо) до чтения, нс — по каждому кадру с
+    /// меткой, без сэмплирования.
+    pub queue_delay_ns: HistogramSnapshot,
+}
+
+/// Частота QPC; 0 — ещё не запрошена.
+static PERF_FREQUENCY: AtomicU64 = AtomicU64::new(0);
+
+pub(crate) fn ticks_to_nanos(ticks: u64) -> u64 {
+    let mut frequency = PERF_FREQUENCY.load(Ordering::Relaxed);
+    if frequency == 0 {
+        frequency = win::perf_frequency();
+        if frequency == 0 {
+            return 0;
+        }
+        PERF_FREQUENCY.store(frequency, Ordering::Relaxed);
+    }
+    (ticks as u128 * 1_000_000_000 / frequency as u128).min(u64::MAX as u128) as u64
+}
+
+/// Метка публикации: младшие 32 бита тиков и позиция конца опубликованного.
+/// Ноль зарезервирован за «метки нет».
+pub(crate) fn publish_stamp(end: u32) -> u64 {
+    ((win::perf_counter() as u32 as u64) << 32) | end as u64
+}
+
+/// Тики от метки `stamp` до текущего момента (счёт по модулю 2^32 — при
+/// частоте 10 МГц это ~7 минут, с запасом для любой задержки доставки).
+pub(crate) fn stamp_age(stamp: u64) -> u64 {
+    (win::perf_counter() as u32).wrapping_sub((stamp >> 32) as u32) as u64
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    #[test]
+    fn buckets_are_log2() {
+        assert_eq!(bucket_index(0), 0);
+        assert_eq!(bucket_index(1), 1);
+        assert_eq!(bucket_index(2), 2);
+        assert_eq!(bucket_index(3), 2);
+        assert_eq!(bucket_index(1024), 11);
+        assert_eq!(bucket_index(u64::MAX), HISTOGRAM_BUCKETS - 1);
+    }
+
+    #[test]
+    fn percentile_is_bucket_upper_bound_capped_by_max() {
+        let histogram = Histogram::default();
+        assert_eq!(histogram.snapshot().percentile(0.5), 0);
+        for value in [1u64, 2, 3, 100, 100, 100, 100, 100, 100, 300] {
+            histogram.record(value);
+        }
+        let snapshot = histogram.snapshot();
+        assert_eq!(snapshot.count, 10);
+        assert_eq!(snapshot.max, 300);
+        assert_eq!(snapshot.mean(), 90);
+        // 1 в корзине 1, 2..3 — в корзине 2
+        assert_eq!(snapshot.percentile(0.1), 1);
+        assert_eq!(snapshot.percentile(0.3), 3);
+        // 100 — корзина [64, 128)
+        assert_eq!(snapshot.percentile(0.5), 127);
+        // 300 — корзина [256, 512), но не выше максимума
+        assert_eq!(snapshot.percentile(1.0), 300);
+    }
+
+    #[test]
+    fn counts_wakeups_batches_and_high_water() {
+        let stats = ChannelStats::default();
+        stats.record_wakeup(false);
+        stats.record_batch(4);
+        stats.record_wakeup(true);
+        stats.record_batch(2);
+        stats.record_occupancy(512, 8);
+        stats.record_occupancy(256, 9);
+        let snapshot = stats.snapshot();
+        assert_eq!(snapshot.wakeups, 2);
+        assert_eq!(snapshot.spurious_wakeups, 1);
+        assert_eq!(snapshot.batch_sizes.count, 2);
+        assert_eq!(snapshot.batch_sizes.sum, 6);
+        assert_eq!(snapshot.high_water_bytes, 512);
+        assert_eq!(snapshot.high_water_messages, 9);
+
+        stats.reset();
+        assert_eq!(stats.snapshot(), ChannelStatsSnapshot::default());
+    }
+}
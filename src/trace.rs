@@ -0,0 +1,222 @@
+//! Трассировка: метки постановки в очередь на кадрах и ETW-события
+//! жизненного цикла каналов.
+//!
+//! Producer с включённой трассировкой (`SharedServer::set_tracing`,
+//! `AutoOptions::trace`) пишет за заголовком кадра расширение
+//! (`MESSAGE_FLAG_TRACED`): метку QPC постановки в очередь и порядковый
+//! номер в кольце. Consumer считает по метке, сколько сообщение ждало, и
+//! пишет это в `ChannelStatsSnapshot::queue_delay_ns`; сама метка доступна
+//! через `MessageBatch::trace`, `PeekedMessage::trace` и
+//! `AutoHandler::on_traced_message`. Флаг читают только версии, которые о нём
+//! знают, поэтому включать трассировку можно, когда обе стороны обновлены.
+//!
+//! ETW-провайдер `xshm` (`ETW_PROVIDER_GUID`) регистрируется при первом
+//! событии. Манифеста нет: события самоописывающие (TraceLogging), каждое
+//! несёт traits провайдера и своё имя с именами и типами полей, поэтому
+//! WPA, PerfView и `tracerpt` декодируют их без регистрации схемы. ID,
+//! имена событий и раскладка payload — у `EventKind` и его констант.
+//! Dispatch-каналы на auto-транспорте сообщают о себе как auto-каналы (имя
+//! выделенного канала, ID клиента `u32::MAX`); каналы пула I/O-потоков и
+//! отключения по инициативе сервера — с ID клиента.
+
+use std::sync::atomic::{AtomicU64, Ordering};
+use std::sync::Once;
+
+use crate::stats::ticks_to_nanos;
+use crate::win;
+
+/// GUID ETW-провайдера xshm: `{5853484D-0054-5243-8E5F-3A2C71D04B19}`.
+pub const ETW_PROVIDER_GUID: u128 = 0x5853484D_0054_5243_8E5F_3A2C71D04B19;
+
+/// ID клиента в событии канала, у которого его нет (auto-режим).
+pub(crate) const NO_CLIENT: u32 = u32::MAX;
+
+const LEVEL_WARNING: u8 = 3;
+const LEVEL_INFORMATION: u8 = 4;
+
+/// Имена и типы полей payload в порядке записи: `ClientId` и `Dropped` —
+/// `TlgInUINT32` (8), `Channel` — `TlgInANSISTRING` с флагом `TlgInChain`
+/// (0x82), за которым out-тип `TlgOutUTF8` (35).
+const FIELDS: &[u8] = b"ClientId\0\x08Dropped\0\x08Channel\0\x82\x23";
+
+/// Блок метаданных TraceLogging: `u16` LE полного размера, затем `parts`
+/// подряд. `N` обязан совпасть с итоговым размером — иначе ошибка сборки.
+const fn tlg_block<const N: usize>(parts: &[&[u8]]) -> [u8; N] {
+    let mut out = [0u8; N];
+    out[0] = N as u8;
+    out[1] = (N >> 8) as u8;
+    let mut at = 2;
+    let mut i = 0;
+    while i < parts.len() {
+        let mut j = 0;
+        while j < parts[i].len() {
+            out[at] = parts[i][j];
+            at += 1;
+            j += 1;
+        }
+        i += 1;
+    }
+    assert!(at == N, "TraceLogging block size mismatch");
+    out
+}
+
+/// Traits провайдера: только имя.
+const PROVIDER_TRAITS: &[u8] = &tlg_block::<7>(&[b"xshm\0"]);
+
+/// Событие провайдера. Payload у всех один (`FIELDS`):
+/// - `ClientId` — `u32` LE, ID клиента; `u32::MAX` — у канала его нет;
+/// - `Dropped` — `u32` LE, число потерянных сообщений (0 у подключения и
+///   отключения);
+/// - `Channel` — имя канала, UTF-8 с завершающим нулём.
+struct EventKind {
+    id: u16,
+    level: u8,
+    /// Байт тегов (0 — нет), имя события, `FIELDS`.
+    metadata: &'static [u8],
+}
+
+/// 1 — `ChannelConnected`, уровень Information.
+const CONNECT: EventKind = EventKind {
+    id: 1,
+    level: LEVEL_INFORMATION,
+    metadata: &tlg_block::<49>(&[b"\0ChannelConnected\0", FIELDS]),
+};
+
+/// 2 — `ChannelDisconnected`, уровень Information.
+const DISCONNECT: EventKind = EventKind {
+    id: 2,
+    level: LEVEL_INFORMATION,
+    metadata: &tlg_block::<52>(&[b"\0ChannelDisconnected\0", FIELDS]),
+};
+
+/// 3 — `MessagesLost`, уровень Warning.
+const OVERFLOW: EventKind = EventKind {
+    id: 3,
+    level: LEVEL_WARNING,
+    metadata: &tlg_block::<45>(&[b"\0MessagesLost\0", FIELDS]),
+};
+
+/// Метка трассируемого сообщения.
+#[derive(Clone, Copy, Debug, Default, PartialEq, Eq)]
+pub struct MessageTrace {
+    /// Порядковый номер кадра в кольце producer-а (с wrap-around); пропуск
+    /// — сообщения вытеснены или отброшены reconnect-ом.
+    pub sequence: u32,
+    /// Метка постановки в очередь, тики `QueryPerformanceCounter`.
+    pub enqueued: u64,
+    /// Сколько сообщение ждало до чтения, нс.
+    pub queued_ns: u64,
+}
+
+impl MessageTrace {
+    /// Метка, прочитанная в момент `now` (тики).
+    pub(crate) fn new(enqueued: u64, sequence: u32, now: u64) -> Self {
+        Self {
+            sequence,
+            enqueued,
+            queued_ns: ticks_to_nanos(now.saturating_sub(enqueued)),
+        }
+    }
+}
+
+static REGISTER: Once = Once::new();
+/// Handle регистрации; 0 — ETW недоступен.
+static PROVIDER: AtomicU64 = AtomicU64::new(0);
+
+fn provider() -> Option<u64> {
+    REGISTER.call_once(|| {
+        if let Some(handle) = win::etw_register(ETW_PROVIDER_GUID, PROVIDER_TRAITS) {
+            PROVIDER.store(handle, Ordering::Release);
+        }
+    });
+    match PROVIDER.load(Ordering::Acquire) {
+        0 => None,
+        handle => Some(handle),
+    }
+}
+
+fn emit(event: &EventKind, channel: &str, client_id: u32, count: u32) {
+    let Some(handle) = provider() else {
+        return;
+    };
+    // без слушающей сессии payload не собирается
+    if !win::etw_enabled(handle, event.id, event.level) {
+        return;
+    }
+    let mut name = Vec::with_capacity(channel.len() + 1);
+    name.extend_from_slice(channel.as_bytes());
+    name.push(0);
+    win::etw_write(
+        handle,
+        event.id,
+        event.level,
+        PROVIDER_TRAITS,
+        event.metadata,
+        &[&client_id.to_le_bytes(), &count.to_le_bytes(), &name],
+    );
+}
+
+/// Клиент `client_id` подключился к каналу `channel`.
+pub(crate) fn connected(channel: &str, client_id: u32) {
+    emit(&CONNECT, channel, client_id, 0);
+}
+
+/// Клиент `client_id` отключился от канала `channel`.
+pub(crate) fn disconnected(channel: &str, client_id: u32) {
+    emit(&DISCONNECT, channel, client_id, 0);
+}
+
+/// Канал `channel` потерял `count` сообщений.
+pub(crate) fn overflowed(channel: &str, client_id: u32, count: u32) {
+    emit(&OVERFLOW, channel, client_id, count);
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    /// Строка до нуля; `rest` сдвигается за него.
+    fn take_name(rest: &mut &[u8]) -> String {
+        let end = rest.iter().position(|&b| b == 0).unwrap();
+        let name = std::str::from_utf8(&rest[..end]).unwrap().to_owned();
+        *rest = &rest[end + 1..];
+        name
+    }
+
+    /// Разбор метаданных так, как их читает декодер TraceLogging: размер в
+    /// префиксе, байт тегов, имя события, затем поля «имя — in-тип
+    /// [— out-тип]».
+    #[test]
+    fn metadata_blocks_describe_the_payload() {
+        assert_eq!(PROVIDER_TRAITS, b"\x07\x00xshm\0");
+        let events = [
+            (&CONNECT, "ChannelConnected"),
+            (&DISCONNECT, "ChannelDisconnected"),
+            (&OVERFLOW, "MessagesLost"),
+        ];
+        for (event, name) in events {
+            let meta = event.metadata;
+            let size = u16::from_le_bytes([meta[0], meta[1]]);
+            assert_eq!(usize::from(size), meta.len());
+            assert_eq!(meta[2], 0);
+            let mut rest = &meta[3..];
+            assert_eq!(take_name(&mut rest), name);
+            let mut fields = Vec::new();
+            while !rest.is_empty() {
+                let field = take_name(&mut rest);
+                let in_type = rest[0];
+                let out_type = (in_type & 0x80 != 0).then(|| rest[1]);
+                rest = &rest[1 + usize::from(out_type.is_some())..];
+                fields.push((field, in_type & 0x7F, out_type));
+            }
+            assert_eq!(
+                fields,
+                [
+                    ("ClientId".to_owned(), 8, None),
+                    ("Dropped".to_owned(), 8, None),
+                    ("Channel".to_owned(), 2, Some(35)),
+                ]
+            );
+        }
+    }
+}
@@ -0,0 +1,250 @@
+//! Стратегия ожидания данных consumer-ом: spin → yield → событие, и
+//! ожидание места producer-ом по `OverflowPolicy::Block`.
+
+use std::time::{Duration, Instant};
+
+use crate::error::{Result, ShmError};
+use crate::ring::{OverflowPolicy, RingBuffer, WriteOutcome};
+use crate::win::EventHandle;
+
+/// Как worker ждёт новые сообщения, когда кольцо опустело.
+///
+/// Сначала `spin` крутится на `write_pos` с `pause` (`spin_loop`), затем
+/// `yield_time` отдаёт квант через `yield_now`, и только потом блокируется на
+/// data-событии. Пока worker в активной фазе, в заголовке кольца стоит флаг
+/// `spinning`, и producer не делает `NtSetEvent` вовсе.
+///
+/// По умолчанию обе фазы нулевые — сразу событие (прежнее поведение). Spin
+/// имеет смысл только для consumer-а на выделенном ядре: фаза целиком
+/// съедает CPU.
+#[derive(Debug, Clone, Copy, PartialEq, Eq, Default)]
+pub struct WaitStrategy {
+    /// Длительность busy-spin перед yield.
+    pub spin: Duration,
+    /// Длительность фазы `yield_now` перед блокировкой на событии.
+    pub yield_time: Duration,
+}
+
+impl WaitStrategy {
+    /// Только блокировка на событии.
+    pub const fn blocking() -> Self {
+        Self {
+            spin: Duration::ZERO,
+            yield_time: Duration::ZERO,
+        }
+    }
+
+    /// `spin` busy-spin, затем `yield_time` yield, затем событие.
+    pub const fn spin_then_block(spin: Duration, yield_time: Duration) -> Self {
+        Self { spin, yield_time }
+    }
+
+    /// Активной фазы нет — флаг `spinning` не ставится вовсе.
+    pub fn is_blocking(&self) -> bool {
+        self.spin.is_zero() && self.yield_time.is_zero()
+    }
+
+    /// Крутится, пока `ready` не вернёт `true` или не выйдет бюджет обеих
+    /// фаз. Часы читаются раз в `CLOCK_STRIDE` итераций spin-а: `Instant::now`
+    /// дороже самой проверки кольца.
+    pub(crate) fn spin_until(&self, mut ready: impl FnMut() -> bool) -> bool {
+        const CLOCK_STRIDE: u32 = 64;
+
+        let start = Instant::now();
+        let spin_deadline = start + self.spin;
+        let deadline = spin_deadline + self.yield_time;
+        while !self.spin.is_zero() {
+            for _ in 0..CLOCK_STRIDE {
+                if ready() {
+                    return true;
+                }
+                std::hint::spin_loop();
+            }
+            if Instant::now() >= spin_deadline {
+                break;
+            }
+        }
+        while Instant::now() < deadline {
+            if ready() {
+                return true;
+            }
+            std::thread::yield_now();
+        }
+        ready()
+    }
+}
+
+/// Предел одного ожидания `space`-события, которое делят несколько
+/// producer-ов (дорожки канала, см. `crate::lanes`): auto-reset событие
+/// будит лишь одного из них, остальные перепроверяют своё кольцо сами.
+pub(crate) const SHARED_SPACE_NAP: Duration = Duration::from_millis(1);
+
+/// Повторяет `write`, пока кольцо отвечает `QueueFull`: для
+/// `OverflowPolicy::Block` — с ожиданием `space`-события до общего
+/// дедлайна (anonymous-режим без событий отдаёт квант через `yield_now`),
+/// для остальных политик — ровно одна попытка.
+///
+/// `space` взводит consumer, дочитав кольцо, поэтому заблокированный
+/// producer просыпается не на каждом освобождённом байте, а пачкой.
+/// Событие auto-reset: устаревший сигнал даёт лишь одну лишнюю попытку.
+/// `nap` ограничивает одно ожидание события, если его делят несколько
+/// producer-ов (`SHARED_SPACE_NAP`).
+pub(crate) fn write_with_backpressure<T>(
+    policy: OverflowPolicy,
+    space: Option<&EventHandle>,
+    nap: Option<Duration>,
+    mut write: impl FnMut() -> Result<T>,
+) -> Result<T> {
+    let OverflowPolicy::Block(timeout) = policy else {
+        return write();
+    };
+    // None — таймаут не представим в Instant, ждём без ограничения
+    let deadline = Instant::now().checked_add(timeout);
+    loop {
+        match write() {
+            Err(ShmError::QueueFull) => {}
+            result => return result,
+        }
+        let remaining = match deadline {
+            Some(deadline) => {
+                let remaining = deadline.saturating_duration_since(Instant::now());
+                if remaining.is_zero() {
+                    return Err(ShmError::QueueFull);
+                }
+                Some(remaining)
+            }
+            None => None,
+        };
+        let remaining = match (remaining, nap) {
+            (Some(remaining), Some(nap)) => Some(remaining.min(nap)),
+            (remaining, nap) => remaining.or(nap),
+        };
+        match space {
+            Some(event) => {
+                event.wait(remaining)?;
+            }
+            None => std::thread::yield_now(),
+        }
+    }
+}
+
+/// Пачка по политике `policy`: без вытеснения кольцо принимает её частями
+/// по мере освобождения места. После каждой опубликованной части сразу
+/// сигналится `data` — иначе уснувший consumer не освободил бы места для
+/// остатка. `QueueFull` (истёк `Block` или `Fail`) оставляет уже принятые
+/// части в кольце.
+pub(crate) fn write_batch_with_backpressure(
+    ring: &RingBuffer,
+    policy: OverflowPolicy,
+    space: Option<&EventHandle>,
+    nap: Option<Duration>,
+    data: Option<&EventHandle>,
+    messages: &[&[u8]],
+) -> Result<WriteOutcome> {
+    let mut total = WriteOutcome::default();
+    let mut rest = messages;
+    write_with_backpressure(policy, space, nap, || {
+        let mut part = WriteOutcome::default();
+        let written = ring.write_batch_prefix(rest, &mut part)?;
+        rest = &rest[written..];
+        if part.wake_consumer {
+            if let Some(data) = data {
+                let _ = data.set();
+            }
+        }
+        total.overwritten += part.overwritten;
+        total.was_empty |= part.was_empty;
+        total.wake_consumer |= part.wake_consumer;
+        if rest.is_empty() {
+            Ok(())
+        } else {
+            Err(ShmError::QueueFull)
+        }
+    })?;
+    Ok(total)
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    #[test]
+    fn blocking_strategy_checks_once_without_spinning() {
+        let mut calls = 0;
+        assert!(!WaitStrategy::blocking().spin_until(|| {
+            calls += 1;
+            false
+        }));
+        assert_eq!(calls, 1);
+    }
+
+    #[test]
+    fn spin_returns_as_soon_as_ready() {
+        let strategy = WaitStrategy::spin_then_block(Duration::from_secs(5), Duration::ZERO);
+        let mut calls = 0;
+        let start = Instant::now();
+        assert!(strategy.spin_until(|| {
+            calls += 1;
+            calls == 1000
+        }));
+        assert!(start.elapsed() < Duration::from_secs(1));
+    }
+
+    #[test]
+    fn budget_is_bounded() {
+        let strategy =
+            WaitStrategy::spin_then_block(Duration::from_millis(2), Duration::from_millis(2));
+        let start = Instant::now();
+        assert!(!strategy.spin_until(|| false));
+        let elapsed = start.elapsed();
+        assert!(elapsed >= Duration::from_millis(4));
+        assert!(elapsed < Duration::from_secs(1));
+    }
+
+    #[test]
+    fn non_blocking_policies_try_once() {
+        for policy in [OverflowPolicy::Overwrite, OverflowPolicy::Fail] {
+            let mut calls = 0;
+            let result: Result<()> = write_with_backpressure(policy, None, None, || {
+                calls += 1;
+                Err(ShmError::QueueFull)
+            });
+            assert!(matches!(result, Err(ShmError::QueueFull)));
+            assert_eq!(calls, 1);
+        }
+    }
+
+    #[test]
+    fn blocking_policy_retries_until_space_or_deadline() {
+        let policy = OverflowPolicy::Block(Duration::from_secs(5));
+        let mut calls = 0;
+        let result = write_with_backpressure(policy, None, None, || {
+            calls += 1;
+            if calls < 3 {
+                Err(ShmError::QueueFull)
+            } else {
+                Ok(calls)
+            }
+        });
+        assert_eq!(result.unwrap(), 3);
+
+        let start = Instant::now();
+        let result: Result<()> = write_with_backpressure(
+            OverflowPolicy::Block(Duration::from_millis(5)),
+            None,
+            None,
+            || Err(ShmError::QueueFull),
+        );
+        assert!(matches!(result, Err(ShmError::QueueFull)));
+        assert!(start.elapsed() >= Duration::from_millis(5));
+
+        // прочие ошибки не ретраятся
+        let mut calls = 0;
+        let result: Result<()> = write_with_backpressure(policy, None, None, || {
+            calls += 1;
+            Err(ShmError::NotConnected)
+        });
+        assert!(matches!(result, Err(ShmError::NotConnected)));
+        assert_eq!(calls, 1);
+    }
+}
@@ -13,39 +13,70 @@ use std::ptr::{null, null_mut};
 use std::time::Duration;
 
 use crate::error::{Result, ShmError};
-use crate::layout::shared_mapping_size;
 use crate::ntapi::{
     duration_to_nt_timeout,
     // Functions
+    EtwEventEnabled,
+    EtwEventRegister,
+    EtwEventSetInformation,
+    EtwEventWrite,
+    NtAssociateWaitCompletionPacket,
+    NtCancelWaitCompletionPacket,
     NtClose,
     NtCreateEvent,
+    NtCreateIoCompletion,
     NtCreateSection,
+    NtCreateWaitCompletionPacket,
     NtMapViewOfSection,
     // Helpers
     NtName,
     NtOpenEvent,
     NtOpenProcess,
     NtOpenSection,
+    NtQuerySection,
+    NtRemoveIoCompletionEx,
     NtSetEvent,
+    NtSetIoCompletion,
     NtUnmapViewOfSection,
     NtWaitForMultipleObjects,
     NtWaitForSingleObject,
     NullDaclSecurityDescriptor,
+    RtlAdjustPrivilege,
+    RtlQueryPerformanceCounter,
+    RtlQueryPerformanceFrequency,
     EVENT_ALL_ACCESS,
     // Types
     CLIENT_ID,
+    EVENT_DATA_DESCRIPTOR,
+    EVENT_DATA_DESCRIPTOR_TYPE_EVENT_METADATA,
+    EVENT_DATA_DESCRIPTOR_TYPE_PROVIDER_METADATA,
+    EVENT_DESCRIPTOR,
+    EVENT_PROVIDER_SET_TRAITS,
+    FILE_IO_COMPLETION_INFORMATION,
+    GENERIC_ALL,
+    GUID,
     HANDLE,
+    IO_COMPLETION_ALL_ACCESS,
+    IO_STATUS_BLOCK,
     LARGE_INTEGER,
+    LARGE_PAGE_MINIMUM,
+    MEM_LARGE_PAGES,
     NTSTATUS,
     NT_CURRENT_PROCESS,
+    NUMA_NODE_MASK,
     OBJECT_ATTRIBUTES,
     OBJ_CASE_INSENSITIVE,
     PAGE_READWRITE,
     PROCESS_QUERY_LIMITED_INFORMATION,
     PROCESS_SYNCHRONIZE,
     PVOID,
+    REGHANDLE,
     SECTION_ALL_ACCESS,
+    SECTION_BASIC_INFORMATION,
+    SECTION_BASIC_INFORMATION_CLASS,
     SEC_COMMIT,
+    SEC_LARGE_PAGES,
+    SE_LOCK_MEMORY_PRIVILEGE,
     // Constants
     STATUS_SUCCESS,
     STATUS_TIMEOUT,
@@ -54,6 +85,7 @@ use crate::ntapi::{
     UNICODE_STRING,
     VIEW_UNMAP,
     WAIT_ANY,
+    WINEVENT_CHANNEL_TRACELOGGING,
 };
 
 // ============================================================================
@@ -142,6 +174,33 @@ impl EventHandle {
         })
     }
 
+    /// Безымянное auto-reset событие для пробуждения потоков внутри процесса:
+    /// ни имени, ни NULL DACL — другим процессам его не открыть.
+    pub fn create_local() -> Result<Self> {
+        let mut obj_attr = OBJECT_ATTRIBUTES::new(null_mut(), 0, null_mut());
+
+        let mut handle: HANDLE = null_mut();
+
+        let status = unsafe {
+            NtCreateEvent(
+                &mut handle,
+                EVENT_ALL_ACCESS,
+                &mut obj_attr,
+                SYNCHRONIZATION_EVENT,
+                0, // InitialState = FALSE
+            )
+        };
+
+        if status != STATUS_SUCCESS {
+            return Err(status_to_error(status, "NtCreateEvent"));
+        }
+
+        Ok(EventHandle {
+            handle: Handle(handle),
+            _name: String::new(),
+        })
+    }
+
     /// Открытие события через NtOpenEvent
     pub fn open(name: &str) -> Result<Self> {
         let mut nt_name = NtName::new(name)?;
@@ -210,11 +269,51 @@ impl EventHandle {
 // Mapping - NT Section через ntdll.dll
 // ============================================================================
 
+/// Как создатель сегмента выделяет память секции. Открывающая сторона
+/// получает уже созданную секцию и параметры не выбирает (большие страницы
+/// она распознаёт по атрибутам секции сама).
+#[derive(Debug, Clone, Copy, PartialEq, Eq, Default)]
+pub struct SectionOptions {
+    /// Секция на больших страницах (SEC_LARGE_PAGES): размер округляется до
+    /// `LARGE_PAGE_MINIMUM`, память не выгружается. Нужна SeLockMemoryPrivilege
+    /// у пользователя; без неё (или если ядро не набрало больших страниц)
+    /// секция молча создаётся на обычных — см. `Mapping::large_pages`.
+    pub large_pages: bool,
+    /// Сразу коснуться каждой страницы view: физическая память выделяется при
+    /// создании, а не page fault-ами на горячем пути первых сообщений.
+    pub prefault: bool,
+    /// Предпочтительный NUMA-узел памяти секции. Страницы берутся с узла при
+    /// первом касании через view создателя — вместе с `prefault` так вся
+    /// секция оказывается на нём.
+    pub numa_node: Option<u32>,
+}
+
+impl SectionOptions {
+    /// Обычные страницы, без предпочтения узла и без pre-fault.
+    pub const DEFAULT: Self = Self {
+        large_pages: false,
+        prefault: false,
+        numa_node: None,
+    };
+
+    pub fn validate(&self) -> Result<()> {
+        // узел + 1 должен влезть в младшие биты AllocationType
+        if self.numa_node.map_or(false, |node| node >= NUMA_NODE_MASK) {
+            return Err(ShmError::InvalidConfig("numa_node must be below 63"));
+        }
+        Ok(())
+    }
+}
+
 #[derive(Debug)]
 pub struct Mapping {
     _handle: Handle,
     view: *mut u8,
-    _size: usize,
+    /// Размер отображённого view (для открытой секции — фактический, из
+    /// NtMapViewOfSection, по нему клиент проверяет геометрию сегмента).
+    size: usize,
+    /// Секция создана с SEC_LARGE_PAGES.
+    large_pages: bool,
     _name: String,
 }
 
@@ -228,87 +327,78 @@ impl Mapping {
     }
 
     /// Внутренний метод создания секции (общая логика для named и anonymous)
-    fn create_internal(object_name: *mut UNICODE_STRING, name_for_storage: String) -> Result<Self> {
-        let size = shared_mapping_size();
-        let mut sd = NullDaclSecurityDescriptor::new();
-        let mut obj_attr = OBJECT_ATTRIBUTES::new(object_name, OBJ_CASE_INSENSITIVE, sd.as_ptr());
-
-        let mut section_handle: HANDLE = null_mut();
-        let mut max_size = LARGE_INTEGER {
-            QuadPart: size as i64,
-        };
-
-        let status = unsafe {
-            NtCreateSection(
-                &mut section_handle,
-                SECTION_ALL_ACCESS,
-                &mut obj_attr,
-                &mut max_size,
-                PAGE_READWRITE,
-                SEC_COMMIT,
-                null_mut(), // FileHandle = NULL
-            )
+    fn create_internal(
+        object_name: *mut UNICODE_STRING,
+        name_for_storage: String,
+        size: usize,
+        options: &SectionOptions,
+    ) -> Result<Self> {
+        let context = if object_name.is_null() {
+            "NtCreateSection (anonymous)"
+        } else {
+            "NtCreateSection"
         };
 
-        if status != STATUS_SUCCESS {
-            let context = if object_name.is_null() {
-                "NtCreateSection (anonymous)"
+        // Большие страницы — с откатом на обычные: без привилегии или при
+        // фрагментированной памяти NtCreateSection вернёт ошибку.
+        let mut large_pages = options.large_pages && enable_lock_memory_privilege();
+        let handle = loop {
+            let (attributes, section_size) = if large_pages {
+                (
+                    SEC_COMMIT | SEC_LARGE_PAGES,
+                    (size + LARGE_PAGE_MINIMUM - 1) & !(LARGE_PAGE_MINIMUM - 1),
+                )
             } else {
-                "NtCreateSection"
+                (SEC_COMMIT, size)
             };
-            return Err(status_to_error(status, context));
-        }
-
-        // Проверка: Handle не должен быть NULL
-        if section_handle.is_null() {
-            return Err(status_to_error(
-                0xC0000008u32 as i32,
-                "NtCreateSection returned NULL handle",
-            ));
-        }
-
-        let handle = Handle(section_handle);
-
-        // Map view
-        let mut base_address: PVOID = null_mut();
-        let mut view_size: usize = 0;
-
-        let status = unsafe {
-            NtMapViewOfSection(
-                handle.raw(),
-                NT_CURRENT_PROCESS,
-                &mut base_address,
-                0,
-                0,
-                null_mut(), // SectionOffset
-                &mut view_size,
-                VIEW_UNMAP,
-                0,
-                PAGE_READWRITE,
-            )
+            match create_section(object_name, section_size, attributes, context) {
+                Err(_) if large_pages => large_pages = false,
+                result => break result?,
+            }
         };
 
-        if status != STATUS_SUCCESS {
+        let mut allocation_type = numa_allocation_type(options.numa_node);
+        if large_pages {
+            allocation_type |= MEM_LARGE_PAGES;
+        }
+        let (view, view_size) = map_view(&handle, allocation_type).map_err(|status| {
             let context = if object_name.is_null() {
                 "NtMapViewOfSection (anonymous)"
             } else {
                 "NtMapViewOfSection"
             };
-            return Err(status_to_error(status, context));
+            status_to_error(status, context)
+        })?;
+
+        if options.prefault {
+            let step = if large_pages {
+                LARGE_PAGE_MINIMUM
+            } else {
+                PAGE_SIZE
+            };
+            // SAFETY: view размером view_size только что отображён на запись,
+            // свежая секция заполнена нулями — запись нуля ничего не меняет.
+            unsafe {
+                for offset in (0..view_size).step_by(step) {
+                    std::ptr::write_volatile(view.add(offset), 0);
+                }
+            }
         }
 
         Ok(Mapping {
             _handle: handle,
-            view: base_address as *mut u8,
-            _size: size,
+            view,
+            size: view_size,
+            large_pages,
             _name: name_for_storage,
         })
     }
 
-    /// Создание секции через NtCreateSection с NULL DACL
-    pub fn create(name: &str) -> Result<Self> {
+    /// Создание секции размером `size` через NtCreateSection с NULL DACL;
+    /// память выделяется по `options`.
+    pub fn create(name: &str, size: usize, options: &SectionOptions) -> Result<Self> {
         let mut nt_name = NtName::new(name)?;
-        Self::create_internal(nt_name.as_ptr(), name.to_owned())
+        Self::create_internal(nt_name.as_ptr(), name.to_owned(), size, options)
     }
 
     /// Создание anonymous секции без имени (только через handle)
@@ -328,13 +418,12 @@ impl Mapping {
     /// как anonymous (unnamed) объект. Пустой `UNICODE_STRING` (даже с `Length = 0`)
     /// все равно является указателем на структуру, а не NULL, поэтому создаст
     /// именованную секцию (которая, вероятно, завершится ошибкой из-за невалидного имени).
-    pub fn create_anonymous() -> Result<Self> {
-        Self::create_internal(null_mut(), String::new())
+    pub fn create_anonymous(size: usize, options: &SectionOptions) -> Result<Self> {
+        Self::create_internal(null_mut(), String::new(), size, options)
     }
 
     /// Открытие секции через NtOpenSection
     pub fn open(name: &str) -> Result<Self> {
-        let size = shared_mapping_size();
         let mut nt_name = NtName::new(name)?;
         let mut obj_attr =
             OBJECT_ATTRIBUTES::new(nt_name.as_ptr(), OBJ_CASE_INSENSITIVE, null_mut());
@@ -350,33 +439,21 @@ impl Mapping {
 
         let handle = Handle(section_handle);
 
-        // Map view
-        let mut base_address: PVOID = null_mut();
-        let mut view_size: usize = 0;
-
-        let status = unsafe {
-            NtMapViewOfSection(
-                handle.raw(),
-                NT_CURRENT_PROCESS,
-                &mut base_address,
-                0,
-                0,
-                null_mut(),
-                &mut view_size,
-                VIEW_UNMAP,
-                0,
-                PAGE_READWRITE,
-            )
-        };
-
-        if status != STATUS_SUCCESS {
-            return Err(status_to_error(status, "NtMapViewOfSection"));
+        // View секции на больших страницах маппим на больших же; если
+        // система так не даёт — обычным view, как до Windows 10 1703.
+        let large_pages = section_is_large_page(&handle);
+        let mut mapped = map_view(&handle, if large_pages { MEM_LARGE_PAGES } else { 0 });
+        if mapped.is_err() && large_pages {
+            mapped = map_view(&handle, 0);
         }
+        let (view, view_size) =
+            mapped.map_err(|status| status_to_error(status, "NtMapViewOfSection"))?;
 
         Ok(Mapping {
             _handle: handle,
-            view: base_address as *mut u8,
-            _size: size,
+            view,
+            size: view_size,
+            large_pages,
             _name: name.to_owned(),
         })
     }
@@ -384,6 +461,120 @@ impl Mapping {
     pub fn as_ptr(&self) -> *mut u8 {
         self.view
     }
+
+    pub fn size(&self) -> usize {
+        self.size
+    }
+
+    /// Секция действительно на больших страницах (`SectionOptions::large_pages`
+    /// мог откатиться на обычные).
+    pub fn large_pages(&self) -> bool {
+        self.large_pages
+    }
+}
+
+/// Обычная страница x86/x86_64.
+const PAGE_SIZE: usize = 4096;
+
+fn create_section(
+    object_name: *mut UNICODE_STRING,
+    size: usize,
+    attributes: u32,
+    context: &'static str,
+) -> Result<Handle> {
+    let mut sd = NullDaclSecurityDescriptor::new();
+    let mut obj_attr = OBJECT_ATTRIBUTES::new(object_name, OBJ_CASE_INSENSITIVE, sd.as_ptr());
+
+    let mut section_handle: HANDLE = null_mut();
+    let mut max_size = LARGE_INTEGER {
+        QuadPart: size as i64,
+    };
+
+    let status = unsafe {
+        NtCreateSection(
+            &mut section_handle,
+            SECTION_ALL_ACCESS,
+            &mut obj_attr,
+            &mut max_size,
+            PAGE_READWRITE,
+            attributes,
+            null_mut(), // FileHandle = NULL
+        )
+    };
+
+    if status != STATUS_SUCCESS {
+        return Err(status_to_error(status, context));
+    }
+
+    // Проверка: Handle не должен быть NULL
+    if section_handle.is_null() {
+        return Err(status_to_error(
+            0xC0000008u32 as i32,
+            "NtCreateSection returned NULL handle",
+        ));
+    }
+
+    Ok(Handle(section_handle))
+}
+
+/// View всей секции в текущем процессе: (адрес, размер) или NTSTATUS.
+fn map_view(
+    section: &Handle,
+    allocation_type: u32,
+) -> std::result::Result<(*mut u8, usize), NTSTATUS> {
+    let mut base_address: PVOID = null_mut();
+    let mut view_size: usize = 0;
+
+    let status = unsafe {
+        NtMapViewOfSection(
+            section.raw(),
+            NT_CURRENT_PROCESS,
+            &mut base_address,
+            0,
+            0,
+            null_mut(), // SectionOffset
+            &mut view_size,
+            VIEW_UNMAP,
+            allocation_type,
+            PAGE_READWRITE,
+        )
+    };
+
+    if status != STATUS_SUCCESS {
+        return Err(status);
+    }
+    Ok((base_address as *mut u8, view_size))
+}
+
+/// AllocationType с предпочтительным NUMA-узлом (узел + 1 в младших битах).
+fn numa_allocation_type(node: Option<u32>) -> u32 {
+    node.map_or(0, |node| (node + 1) & NUMA_NODE_MASK)
+}
+
+/// Включает SeLockMemoryPrivilege в токене процесса; `false` — её у
+/// пользователя нет.
+fn enable_lock_memory_privilege() -> bool {
+    let mut was_enabled = 0u8;
+    let status = unsafe { RtlAdjustPrivilege(SE_LOCK_MEMORY_PRIVILEGE, 1, 0, &mut was_enabled) };
+    status == STATUS_SUCCESS
+}
+
+fn section_is_large_page(section: &Handle) -> bool {
+    let mut info = SECTION_BASIC_INFORMATION {
+        BaseAddress: null_mut(),
+        AllocationAttributes: 0,
+        MaximumSize: LARGE_INTEGER { QuadPart: 0 },
+    };
+    let status = unsafe {
+        NtQuerySection(
+            section.raw(),
+            SECTION_BASIC_INFORMATION_CLASS,
+            &mut info as *mut _ as PVOID,
+            std::mem::size_of::<SECTION_BASIC_INFORMATION>(),
+            null_mut(),
+        )
+    };
+    status == STATUS_SUCCESS && info.AllocationAttributes & SEC_LARGE_PAGES != 0
 }
 
 impl Drop for Mapping {
@@ -430,7 +621,7 @@ pub fn wait_any(handles: &[isize], timeout: Option<Duration>) -> Result<Option<u
     // STATUS_TIMEOUT (0x102) проверяем ДО диапазона валидных индексов: это
     // значение >= 0 и по чистой случайности совпало бы с индексом 258,
     // если бы handles.len() когда-нибудь превысил этот порог. Сейчас это
-    // не достижимо (максимум 62 хендла из-за MAX_MULTI_CLIENTS = 31), но
+    // не достижимо (максимум 63 хендла из-за SLOTS_PER_WAITER = 21), но
     // порядок веток не должен полагаться на этот внешний инвариант.
     match status {
         STATUS_TIMEOUT => Ok(None),
@@ -440,15 +631,241 @@ pub fn wait_any(handles: &[isize], timeout: Option<Duration>) -> Result<Option<u
 }
 
 // ============================================================================
-// is_process_alive - liveness-проверка процесса по PID (NtOpenProcess)
+// CompletionPort - NT IoCompletion + wait completion packets
 // ============================================================================
 
+/// Пакетов за один `NtRemoveIoCompletionEx`.
+const COMPLETION_BATCH: usize = 64;
+
+/// Пакет, извлечённый из порта: `key`/`context` — те, что переданы в
+/// `WaitPacket::associate` или `CompletionPort::post`.
+#[derive(Debug, Clone, Copy, PartialEq, Eq)]
+pub struct Completion {
+    pub key: usize,
+    pub context: usize,
+}
+
+/// Порт завершения (IoCompletion): одна очередь пакетов от любого числа
+/// wait-пакетов — без предела в 64 хендла `NtWaitForMultipleObjects`.
+pub struct CompletionPort {
+    handle: Handle,
+}
+
+unsafe impl Send for CompletionPort {}
+unsafe impl Sync for CompletionPort {}
+
+impl CompletionPort {
+    /// Безымянный порт процесса; ждать его может один поток.
+    pub fn create() -> Result<Self> {
+        let mut handle: HANDLE = null_mut();
+        let status =
+            unsafe { NtCreateIoCompletion(&mut handle, IO_COMPLETION_ALL_ACCESS, null_mut(), 1) };
+        if status != STATUS_SUCCESS {
+            return Err(status_to_error(status, "NtCreateIoCompletion"));
+        }
+        Ok(Self {
+            handle: Handle(handle),
+        })
+    }
+
+    /// Ставит в порт пакет без ожидания (пробуждение потока порта).
+    pub fn post(&self, key: usize, context: usize) -> Result<()> {
+        let status = unsafe {
+            NtSetIoCompletion(
+                self.handle.raw(),
+                key as PVOID,
+                context as PVOID,
+                STATUS_SUCCESS,
+                0,
+            )
+        };
+        if status != STATUS_SUCCESS {
+            return Err(status_to_error(status, "NtSetIoCompletion"));
+        }
+        Ok(())
+    }
+
+    /// Забирает накопившиеся пакеты (до `COMPLETION_BATCH`) в `out`, ожидая
+    /// первый не дольше `timeout`. Пустой `out` — таймаут.
+    pub fn remove(&self, out: &mut Vec<Completion>, timeout: Option<Duration>) -> Result<()> {
+        out.clear();
+        let timeout_value: i64 = match timeout {
+            Some(d) => duration_to_nt_timeout(d),
+            None => 0,
+        };
+        let timeout_ptr = if timeout.is_some() {
+            &timeout_value as *const i64
+        } else {
+            null()
+        };
+
+        let empty = FILE_IO_COMPLETION_INFORMATION {
+            KeyContext: null_mut(),
+            ApcContext: null_mut(),
+            IoStatusBlock: IO_STATUS_BLOCK {
+                Status: 0,
+                Information: 0,
+            },
+        };
+        let mut entries = [empty; COMPLETION_BATCH];
+        let mut removed: u32 = 0;
+        let status = unsafe {
+            NtRemoveIoCompletionEx(
+                self.handle.raw(),
+                entries.as_mut_ptr(),
+                COMPLETION_BATCH as u32,
+                &mut removed,
+                timeout_ptr,
+                0, // Alertable = FALSE
+            )
+        };
+        match status {
+            STATUS_TIMEOUT => Ok(()),
+            STATUS_SUCCESS => {
+                out.extend(entries[..removed as usize].iter().map(|entry| Completion {
+                    key: entry.KeyContext as usize,
+                    context: entry.ApcContext as usize,
+                }));
+                Ok(())
+            }
+            _ => Err(status_to_error(status, "NtRemoveIoCompletionEx")),
+        }
+    }
+}
+
+/// Wait completion packet: однократное ожидание объекта ядром с доставкой в
+/// `CompletionPort` (то, на чём построен `TpSetWait`). После срабатывания
+/// пакет можно связать снова; при удалении ожидание отменяется вместе с уже
+/// поставленным, но не извлечённым пакетом.
+pub struct WaitPacket {
+    handle: Handle,
+}
+
+unsafe impl Send for WaitPacket {}
+unsafe impl Sync for WaitPacket {}
+
+impl WaitPacket {
+    pub fn create() -> Result<Self> {
+        let mut handle: HANDLE = null_mut();
+        let status = unsafe { NtCreateWaitCompletionPacket(&mut handle, GENERIC_ALL, null_mut()) };
+        if status != STATUS_SUCCESS {
+            return Err(status_to_error(status, "NtCreateWaitCompletionPacket"));
+        }
+        Ok(Self {
+            handle: Handle(handle),
+        })
+    }
+
+    /// Ждать `object` (сырой HANDLE); когда он станет сигнальным, в `port`
+    /// встанет пакет `key`/`context`. Auto-reset событие при этом
+    /// сбрасывается, как при обычном ожидании. Пакет не должен быть связан.
+    pub fn associate(
+        &self,
+        port: &CompletionPort,
+        object: isize,
+        key: usize,
+        context: usize,
+    ) -> Result<()> {
+        let status = unsafe {
+            NtAssociateWaitCompletionPacket(
+                self.handle.raw(),
+                port.handle.raw(),
+                object as HANDLE,
+                key as PVOID,
+                context as PVOID,
+                STATUS_SUCCESS,
+                0,
+                null_mut(),
+            )
+        };
+        if status != STATUS_SUCCESS {
+            return Err(status_to_error(status, "NtAssociateWaitCompletionPacket"));
+        }
+        Ok(())
+    }
+
+    /// Снять ожидание (и убрать из порта уже поставленный пакет).
+    pub fn cancel(&self) {
+        unsafe {
+            let _ = NtCancelWaitCompletionPacket(self.handle.raw(), 1);
+        }
+    }
+}
+
+impl Drop for WaitPacket {
+    fn drop(&mut self) {
+        self.cancel();
+    }
+}
+
+// ============================================================================
+// ProcessHandle / is_process_alive - liveness процесса по PID (NtOpenProcess)
+// ============================================================================
+
+/// Handle процесса с правом ожидания: сигнален, когда процесс завершился.
+///
+/// Multi-client сервер открывает его на handshake для процесса-владельца
+/// слота (PID из `RESERVED_OWNER_PID_INDEX`) и ждёт вместе с событиями слота
+/// — смерть клиента видна сразу, без периодического опроса.
+pub struct ProcessHandle {
+    handle: Handle,
+}
+
+unsafe impl Send for ProcessHandle {}
+unsafe impl Sync for ProcessHandle {}
+
+impl ProcessHandle {
+    /// Открывает процесс `pid` (`PROCESS_QUERY_LIMITED_INFORMATION |
+    /// SYNCHRONIZE` — повышенных привилегий не нужно). Ошибка — PID уже
+    /// переиспользован или свободен, отказано в доступе (процесс другого
+    /// пользователя/защищённый) и т.п.
+    pub fn open(pid: u32) -> Result<Self> {
+        let mut client_id = CLIENT_ID {
+            UniqueProcess: pid as usize as HANDLE,
+            UniqueThread: null_mut(),
+        };
+        // ObjectName = NULL: процессы не именованные объекты BaseNamedObjects,
+        // идентифицируются исключительно через ClientId.
+        let mut obj_attr = OBJECT_ATTRIBUTES::new(null_mut(), 0, null_mut());
+        let mut raw_handle: HANDLE = null_mut();
+
+        let status = unsafe {
+            NtOpenProcess(
+                &mut raw_handle,
+                PROCESS_QUERY_LIMITED_INFORMATION | PROCESS_SYNCHRONIZE,
+                &mut obj_attr,
+                &mut client_id,
+            )
+        };
+        if status != STATUS_SUCCESS {
+            return Err(status_to_error(status, "NtOpenProcess"));
+        }
+        Ok(Self {
+            handle: Handle(raw_handle),
+        })
+    }
+
+    pub fn raw_handle(&self) -> isize {
+        self.handle.as_isize()
+    }
+
+    /// Процесс завершился (handle сигнален). Любой иной исход ожидания —
+    /// двусмысленность, трактуется как «жив».
+    pub fn has_exited(&self) -> bool {
+        let zero_timeout: i64 = 0; // мгновенный опрос, не блокируем worker
+        let wait_status = unsafe { NtWaitForSingleObject(self.handle.raw(), 0, &zero_timeout) };
+        // STATUS_TIMEOUT (объект не сигнален) => процесс всё ещё выполняется
+        wait_status == STATUS_WAIT_0
+    }
+}
+
 /// Проверяет, жив ли процесс с данным PID.
 ///
 /// Используется multi-client сервером для liveness-детекции connected-слотов,
-/// чей клиент мог упасть ПОСЛЕ завершения handshake, не освободив claim (в
-/// этом случае никаких событий от мёртвого процесса не придёт, и слот иначе
-/// был бы потерян навсегда — см. `RESERVED_OWNER_PID_INDEX`).
+/// для процесса-владельца которых не удалось открыть `ProcessHandle` на
+/// handshake: клиент мог упасть ПОСЛЕ завершения handshake, не освободив
+/// claim (в этом случае никаких событий от мёртвого процесса не придёт, и
+/// слот иначе был бы потерян навсегда — см. `RESERVED_OWNER_PID_INDEX`).
 ///
 /// Консервативна по конструкции: при любой двусмысленности (PID уже
 /// переиспользован под другой процесс, недостаточно прав, иная ошибка NT)
@@ -461,46 +878,114 @@ pub fn is_process_alive(pid: u32) -> bool {
     if pid == 0 {
         return true; // 0 не бывает PID пользовательского процесса
     }
+    // Не удалось открыть — не подтверждение смерти процесса-владельца claim,
+    // поэтому НЕ считаем его мёртвым.
+    ProcessHandle::open(pid).map_or(true, |process| !process.has_exited())
+}
+
+/// Текущее значение счётчика производительности (QPC), тики. Счётчик общий
+/// для всех процессов машины — метки из разных процессов сравнимы.
+pub fn perf_counter() -> u64 {
+    let mut value = LARGE_INTEGER { QuadPart: 0 };
+    // SAFETY: ntdll только пишет LARGE_INTEGER по валидному указателю.
+    unsafe {
+        RtlQueryPerformanceCounter(&mut value);
+        value.QuadPart as u64
+    }
+}
+
+/// Частота `perf_counter`, тиков в секунду (0 — счётчик недоступен).
+pub fn perf_frequency() -> u64 {
+    let mut value = LARGE_INTEGER { QuadPart: 0 };
+    // SAFETY: как в perf_counter.
+    unsafe {
+        RtlQueryPerformanceFrequency(&mut value);
+        value.QuadPart as u64
+    }
+}
+
+// ============================================================================
+// ETW
+// ============================================================================
 
-    let mut client_id = CLIENT_ID {
-        UniqueProcess: pid as usize as HANDLE,
-        UniqueThread: null_mut(),
+/// Регистрирует ETW-провайдер `provider` (GUID как число: `Data1` — старшие
+/// 32 бита) и сообщает ETW его TraceLogging-traits `traits`. `None` — ETW
+/// недоступен. Регистрация не снимается: провайдер живёт до конца процесса.
+pub fn etw_register(provider: u128, traits: &'static [u8]) -> Option<REGHANDLE> {
+    let guid = GUID {
+        Data1: (provider >> 96) as u32,
+        Data2: (provider >> 80) as u16,
+        Data3: (provider >> 64) as u16,
+        Data4: (provider as u64).to_be_bytes(),
     };
-    // ObjectName = NULL: процессы не именованные объекты BaseNamedObjects,
-    // идентифицируются исключительно через ClientId.
-    let mut obj_attr = OBJECT_ATTRIBUTES::new(null_mut(), 0, null_mut());
-    let mut raw_handle: HANDLE = null_mut();
-
-    let open_status = unsafe {
-        NtOpenProcess(
-            &mut raw_handle,
-            PROCESS_QUERY_LIMITED_INFORMATION | PROCESS_SYNCHRONIZE,
-            &mut obj_attr,
-            &mut client_id,
+    let mut handle: REGHANDLE = 0;
+    // SAFETY: guid и handle валидны на время вызова; callback не передаём.
+    let status = unsafe { EtwEventRegister(&guid, null_mut(), null_mut(), &mut handle) };
+    if status != 0 || handle == 0 {
+        return None;
+    }
+    // До Windows 10 класса нет: traits всё равно едут в каждом событии.
+    // SAFETY: traits — 'static, ETW только читает их.
+    unsafe {
+        EtwEventSetInformation(
+            handle,
+            EVENT_PROVIDER_SET_TRAITS,
+            traits.as_ptr() as PVOID,
+            traits.len() as u32,
         )
     };
+    Some(handle)
+}
 
-    if open_status != STATUS_SUCCESS {
-        // Не удалось открыть — PID переиспользован, отказано в доступе или
-        // иная ошибка. Ни один из этих случаев не является подтверждением
-        // смерти процесса-владельца claim, поэтому НЕ считаем его мёртвым.
-        return true;
+/// Поле события типа `kind` (0 — данные payload).
+fn etw_field(block: &[u8], kind: u32) -> EVENT_DATA_DESCRIPTOR {
+    EVENT_DATA_DESCRIPTOR {
+        Ptr: block.as_ptr() as usize as u64,
+        Size: block.len() as u32,
+        Reserved: kind,
     }
+}
 
-    // RAII: handle закроется через NtClose при выходе из функции.
-    let handle = Handle(raw_handle);
+fn etw_descriptor(id: u16, level: u8) -> EVENT_DESCRIPTOR {
+    EVENT_DESCRIPTOR {
+        Id: id,
+        Version: 0,
+        Channel: WINEVENT_CHANNEL_TRACELOGGING,
+        Level: level,
+        Opcode: 0,
+        Task: 0,
+        Keyword: 0,
+    }
+}
 
-    let zero_timeout: i64 = 0; // мгновенный опрос, не блокируем worker
-    let wait_status = unsafe { NtWaitForSingleObject(handle.raw(), 0, &zero_timeout) };
+/// Слушает ли событие `id` уровня `level` хоть одна сессия.
+pub fn etw_enabled(handle: REGHANDLE, id: u16, level: u8) -> bool {
+    // SAFETY: дескриптор валиден на время вызова.
+    unsafe { EtwEventEnabled(handle, &etw_descriptor(id, level)) != 0 }
+}
 
-    match wait_status {
-        // Объект-процесс сигнален => процесс завершился.
-        STATUS_WAIT_0 => false,
-        // Таймаут (объект не сигнален) => процесс всё ещё выполняется.
-        STATUS_TIMEOUT => true,
-        // Любой иной статус — двусмысленность, консервативно трактуем как "жив".
-        _ => true,
+/// Пишет самоописывающее (TraceLogging) событие: `traits` провайдера и
+/// `metadata` события (имя, имена и типы полей) идут перед полями
+/// `fields` (не больше четырёх). Ошибки ETW (нет сессии, переполнен буфер)
+/// молча игнорируются.
+pub fn etw_write(
+    handle: REGHANDLE,
+    id: u16,
+    level: u8,
+    traits: &[u8],
+    metadata: &[u8],
+    fields: &[&[u8]],
+) {
+    let mut data = [etw_field(&[], 0); 6];
+    data[0] = etw_field(traits, EVENT_DATA_DESCRIPTOR_TYPE_PROVIDER_METADATA);
+    data[1] = etw_field(metadata, EVENT_DATA_DESCRIPTOR_TYPE_EVENT_METADATA);
+    let count = 2 + fields.len().min(data.len() - 2);
+    for (dst, field) in data[2..count].iter_mut().zip(fields) {
+        *dst = etw_field(field, 0);
     }
+    let descriptor = etw_descriptor(id, level);
+    // SAFETY: поля живут до возврата, ETW копирует их в свой буфер.
+    unsafe { EtwEventWrite(handle, &descriptor, count as u32, data.as_ptr()) };
 }
 
 #[cfg(test)]
@@ -519,6 +1004,36 @@ mod tests {
         assert!(is_process_alive(0));
     }
 
+    #[test]
+    fn completion_port_delivers_posts_and_wait_packets() {
+        let port = CompletionPort::create().unwrap();
+        let mut out = Vec::new();
+        port.remove(&mut out, Some(Duration::ZERO)).unwrap();
+        assert!(out.is_empty());
+
+        port.post(7, 42).unwrap();
+        let event = EventHandle::create_local().unwrap();
+        let packet = WaitPacket::create().unwrap();
+        packet.associate(&port, event.raw_handle(), 3, 9).unwrap();
+        event.set().unwrap();
+
+        let mut seen = Vec::new();
+        while seen.len() < 2 {
+            port.remove(&mut out, Some(Duration::from_secs(1))).unwrap();
+            assert!(!out.is_empty(), "completion did not arrive");
+            seen.extend(out.iter().map(|c| (c.key, c.context)));
+        }
+        seen.sort_unstable();
+        assert_eq!(seen, [(3, 9), (7, 42)]);
+    }
+
+    #[test]
+    fn numa_node_is_encoded_as_node_plus_one() {
+        assert_eq!(numa_allocation_type(None), 0);
+        assert_eq!(numa_allocation_type(Some(0)), 1);
+        assert_eq!(numa_allocation_type(Some(5)), 6);
+    }
+
     /// Регрессия (аудит 2026-07-10, orphan-слот bug): для РЕАЛЬНО завершённого
     /// процесса `is_process_alive` обязана вернуть `false` — иначе
     /// liveness-детекция никогда не сработает.
@@ -36,7 +36,7 @@ fn test_message_count_before_write_pos() {
     let name_clone = name.clone();
 
     let server_thread = thread::spawn(move || -> xshm::Result<()> {
-        let mut server = SharedServer::start(&name_clone)?;
+        let server = SharedServer::start(&name_clone)?;
         server.wait_for_client(Some(Duration::from_secs(5)))?;
         server_ready_clone.store(true, Ordering::Release);
 
@@ -139,7 +139,7 @@ fn test_invalid_magic_rejected() {
 fn test_generation_on_reconnect() {
     let name = unique_name("GEN_TEST");
 
-    let mut server = SharedServer::start(&name).expect("server start");
+    let server = SharedServer::start(&name).expect("server start");
 
     // Первое подключение
     let client1_thread = thread::spawn({
@@ -171,7 +171,7 @@ fn test_generation_on_reconnect() {
     // В текущей реализации нужно пересоздать сервер для нового клиента
     drop(server);
 
-    let mut server2 = SharedServer::start(&name).expect("server2 start");
+    let server2 = SharedServer::start(&name).expect("server2 start");
 
     // Второе подключение
     let client2_thread = thread::spawn({
@@ -207,7 +207,7 @@ fn test_bidirectional_ordering_stress() {
     let server_thread = thread::spawn({
         let name = name.clone();
         move || -> xshm::Result<(usize, usize)> {
-            let mut server = SharedServer::start(&name)?;
+            let server = SharedServer::start(&name)?;
             server.wait_for_client(Some(Duration::from_secs(5)))?;
 
             let mut sent = 0usize;
@@ -28,7 +28,7 @@ fn stress_server_to_client() {
     let server_thread = thread::spawn({
         let name = name.clone();
         move || -> xshm::Result<(usize, usize)> {
-            let mut server = SharedServer::start(&name)?;
+            let server = SharedServer::start(&name)?;
             server.wait_for_client(Some(Duration::from_secs(5)))?;
 
             let mut overwritten_total = 0usize;
@@ -143,7 +143,7 @@ fn stress_client_to_server() {
     let server_thread = thread::spawn({
         let name = name.clone();
         move || -> xshm::Result<usize> {
-            let mut server = SharedServer::start(&name)?;
+            let server = SharedServer::start(&name)?;
             server.wait_for_client(Some(Duration::from_secs(5)))?;
             let mut recv_buf = Vec::new();
             let mut expected = 0u32;
@@ -262,7 +262,7 @@ fn stress_bidirectional() {
     let server_thread = thread::spawn({
         let name = name.clone();
         move || -> xshm::Result<()> {
-            let mut server = SharedServer::start(&name)?;
+            let server = SharedServer::start(&name)?;
             server.wait_for_client(Some(Duration::from_secs(5)))?;
 
             let mut recv_buf = Vec::new();